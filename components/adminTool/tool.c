@@ -27,6 +27,7 @@ static enum
     ACTION_POLL,
     ACTION_READ,
     ACTION_WATCH,
+    ACTION_MEMSTATS,
 }
 Action = ACTION_UNSPECIFIED;
 
@@ -48,12 +49,14 @@ static enum
     OBJECT_TRANSFORM,
     OBJECT_BUFFER_SIZE,
     OBJECT_BACKUP_PERIOD,
+    OBJECT_ROLLUP,
     OBJECT_JSON_EXTRACTION,
     OBJECT_OBSERVATION,
     OBJECT_MIN,
     OBJECT_MAX,
     OBJECT_MEAN,
     OBJECT_STD_DEVIATION,
+    OBJECT_STATS,
 }
 Object;
 
@@ -94,12 +97,14 @@ static void HandleHelpRequest
         "    dhub set transform PATH TYPE\n"
         "    dhub set bufferSize PATH VALUE\n"
         "    dhub set backupPeriod PATH VALUE\n"
+        "    dhub set rollup PATH SECONDS COUNT\n"
         "    dhub set jsonExtraction PATH VALUE\n"
         "    dhub remove OBJECT PATH\n"
         "    dhub push PATH [[--json] VALUE]\n"
         "    dhub watch [--json] PATH\n"
         "    dhub get OBJECT PATH [START]\n"
         "    dhub read PATH [START]\n"
+        "    dhub memstats\n"
         "    dhub help\n"
         "    dhub -h\n"
         "    dhub --help\n"
@@ -175,6 +180,14 @@ static void HandleHelpRequest
         "            an Observation resource at PATH if one does not already exist\n"
         "            there.\n"
         "\n"
+        "    dhub set rollup PATH SECONDS COUNT\n"
+        "            Adds or resizes the rollup tier of an Observation that summarizes\n"
+        "            the values it accepts into buckets SECONDS wide, retaining COUNT\n"
+        "            completed buckets.  COUNT 0 removes the tier.  An Observation can\n"
+        "            have up to four rollup tiers.  PATH is expected to be under /obs/.\n"
+        "            Setting this will create an Observation resource at PATH if one\n"
+        "            does not already exist there.\n"
+        "\n"
         "    dhub set jsonExtraction PATH VALUE\n"
         "            Specifies what an Observation should should extract from JSON\n"
         "            values it receives.  PATH is expected to be under /obs/.\n"
@@ -193,7 +206,8 @@ static void HandleHelpRequest
         "            Valid values for OBJECT are the same as for 'dhub get', with\n"
         "            the notable addition of 'obs', which is used to delete an\n"
         "            entire Observation resource, including all the settings\n"
-        "            attached to it.\n"
+        "            attached to it.  A rollup tier is removed using\n"
+        "            'dhub remove rollup PATH SECONDS'.\n"
         "\n"
         "    dhub push PATH [[--json] VALUE]\n"
         "            Pushes a VALUE to the the resource at PATH. If VALUE is omitted,\n"
@@ -220,18 +234,24 @@ static void HandleHelpRequest
         "              changeBy\n"
         "              transform\n"
         "              jsonExtraction\n"
+        "              rollup\n"
         "              min\n"
         "              max\n"
         "              mean\n"
         "              stddev\n"
+        "              stats\n"
         "\n"
         "            For the source, default, and override objects, the PATH must be\n"
         "            absolute (beginning with '/'). The other objects are only found\n"
         "            on Observations, so their PATH can be relative to /obs/.\n"
         "\n"
+        "            The rollup object is followed by the width of the tier's buckets\n"
+        "            in seconds (e.g., 'dhub get rollup PATH 60'), and prints the\n"
+        "            number of completed buckets retained (0 if there's no such tier).\n"
+        "\n"
         "            When getting statistical measurements on an Observations' buffer\n"
-        "            of data samples (min, max, mean, and stddev), a start time (START)\n"
-        "            can optionally be specified.  If START is specified, then START is\n"
+        "            of data samples (min, max, mean, stddev, and stats), a start time\n"
+        "            (START) can optionally be specified.  If START is specified, then START is\n"
         "            the time in seconds since the Unix Epoch (Jan 1, 1970, 00:00:00)\n"
         "            at which reading will start.  If START is less than 30 years\n"
         "            after the Epoch (946684800), then START will be subtracted from\n"
@@ -239,6 +259,10 @@ static void HandleHelpRequest
         "            the statistic using only data received within the last 2 minutes.\n"
         "            If START is not specified, the entire buffer will be used.\n"
         "\n"
+        "            The stats object is printed as a JSON object containing the count,\n"
+        "            min, max, mean, stddev, and sum of the values, and the timestamps\n"
+        "            of the first and last samples used.\n"
+        "\n"
         "    dhub read PATH [START]\n"
         "            Reads the contents of the data sample buffer of the Observation\n"
         "            at PATH. PATH may be absolute or relative to /obs/. The data is\n"
@@ -255,6 +279,21 @@ static void HandleHelpRequest
         "            than 2 minutes old.  If START is not specified, the entire buffer\n"
         "            will be read.\n"
         "\n"
+        "    dhub memstats\n"
+        "            Prints statistics on the Data Hub's memory pools for string and\n"
+        "            JSON values, as a JSON object.  For each pool, the largest value\n"
+        "            it holds (maxBytes), the number of values in use (inUse) and the\n"
+        "            peak number in use (peak) are printed, as well as the number of\n"
+        "            values allocated from it since start-up (allocs) and their total\n"
+        "            size (bytes).  The number of distinct values that are shared\n"
+        "            (interned) and the number of times a value was shared instead of\n"
+        "            being allocated again (internHits) are printed too, followed by\n"
+        "            the bytes allocated for buffered samples, their indexes and rollup\n"
+        "            tiers, and the backups being written (buffers), now (bytes) and at\n"
+        "            their peak (peak).  Of those, the bytes held by buffer snapshots\n"
+        "            (snapshotBytes) and journal batches (batchBytes) waiting to be\n"
+        "            written, and their combined peak (peak), are printed as backups.\n"
+        "\n"
         "    dhub help\n"
         "    dhub -h\n"
         "    dhub --help\n"
@@ -294,7 +333,15 @@ static const char* ValueArg = NULL;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Start timestamp argument for 'read' and 'get min/max/mean/stddev' commands.
+ * Ptr to the COUNT command-line argument of 'set rollup', or NULL if there wasn't one provided.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* CountArg = NULL;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start timestamp argument for 'read' and 'get min/max/mean/stddev/stats' commands.
  */
 //--------------------------------------------------------------------------------------------------
 static double StartArg = NAN;  // Not-a-number by default
@@ -1268,6 +1315,64 @@ static void GetIntegerSetting
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parse the SECONDS argument of a rollup command (the width of a rollup tier's buckets).
+ *
+ * @return The number of seconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ParseBucketSeconds
+(
+    const char* secondsStr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int value;
+    if ((le_utf8_ParseInt(&value, secondsStr) != LE_OK) || (value <= 0))
+    {
+        fprintf(stderr, "Bucket width must be a positive integer number of seconds.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return (uint32_t)value;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add, resize, or remove (count 0) a rollup tier.
+ *
+ * @note Has the side-effect of creating the Observation if it does not yet exist.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetRollupSetting
+(
+    const char* path,
+    const char* secondsStr,
+    const char* countStr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint32_t bucketSeconds = ParseBucketSeconds(secondsStr);
+
+    int count;
+    if ((le_utf8_ParseInt(&count, countStr) != LE_OK) || (count < 0))
+    {
+        fprintf(stderr, "Non-negative integer bucket count required.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (admin_CreateObs(path) != LE_OK)
+    {
+        fprintf(stderr, "Invalid resource path for Observation.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    admin_SetBufferRollup(path, bucketSeconds, (uint32_t)count);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get a buffer statistic.
@@ -1299,6 +1404,166 @@ static void GetBufferStat
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print a number as a member of a JSON object, after a comma.  JSON has no way to write NaN or
+ * infinity, so those are printed as null.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PrintJsonNumberMember
+(
+    const char* name,   ///< Name of the member.
+    double value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (isfinite(value))
+    {
+        printf(",\"%s\":%lf", name, value);
+    }
+    else
+    {
+        printf(",\"%s\":null", name);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a summary of all the buffer statistics, printed as a JSON object.
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetBufferStats
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (PathArg == NULL)
+    {
+        fprintf(stderr, "Missing PATH argument.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t count;
+    double min;
+    double max;
+    double mean;
+    double stdDev;
+    double sum;
+    double firstTimestamp;
+    double lastTimestamp;
+
+    le_result_t result = query_GetStats(PathArg,
+                                        StartArg,
+                                        &count,
+                                        &min,
+                                        &max,
+                                        &mean,
+                                        &stdDev,
+                                        &sum,
+                                        &firstTimestamp,
+                                        &lastTimestamp);
+    if (result == LE_NOT_FOUND)
+    {
+        fprintf(stderr, "'%s' is not an Observation.\n", PathArg);
+        exit(EXIT_FAILURE);
+    }
+    else if (result == LE_UNAVAILABLE)
+    {
+        fprintf(stderr, "No numerical data buffered at resource path '%s'.\n", PathArg);
+        exit(EXIT_FAILURE);
+    }
+    else if (result != LE_OK)
+    {
+        fprintf(stderr,
+                "**ERROR: Failed (%s) to get buffer statistics for '%s'.\n",
+                LE_RESULT_TXT(result),
+                PathArg);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("{\"count\":%u", count);
+    PrintJsonNumberMember("min", min);
+    PrintJsonNumberMember("max", max);
+    PrintJsonNumberMember("mean", mean);
+    PrintJsonNumberMember("stddev", stdDev);
+    PrintJsonNumberMember("sum", sum);
+    PrintJsonNumberMember("first", firstTimestamp);
+    PrintJsonNumberMember("last", lastTimestamp);
+    printf("}\n");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print statistics on the Data Hub's string value memory pools and buffer memory, as a JSON
+ * object.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PrintMemoryStats
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    printf("{\"stringPools\":[");
+
+    uint32_t maxStringBytes;
+    uint32_t numInUse;
+    uint32_t peakNumInUse;
+    uint64_t numAllocs;
+    uint64_t totalStringBytes;
+
+    for (uint32_t i = 0;
+         admin_GetStringPoolStats(i,
+                                  &maxStringBytes,
+                                  &numInUse,
+                                  &peakNumInUse,
+                                  &numAllocs,
+                                  &totalStringBytes) == LE_OK;
+         i++)
+    {
+        printf("%s{\"maxBytes\":%u,\"inUse\":%u,\"peak\":%u,\"allocs\":%" PRIu64
+               ",\"bytes\":%" PRIu64 "}",
+               (i > 0) ? "," : "",
+               maxStringBytes,
+               numInUse,
+               peakNumInUse,
+               numAllocs,
+               totalStringBytes);
+    }
+
+    uint32_t numInterned;
+    uint64_t numHits;
+
+    admin_GetStringInternStats(&numInterned, &numHits);
+
+    printf("],\"interned\":%u,\"internHits\":%" PRIu64, numInterned, numHits);
+
+    uint64_t bufferBytes;
+    uint64_t peakBufferBytes;
+
+    admin_GetBufferMemoryStats(&bufferBytes, &peakBufferBytes);
+
+    printf(",\"buffers\":{\"bytes\":%" PRIu64 ",\"peak\":%" PRIu64 "}",
+           bufferBytes,
+           peakBufferBytes);
+
+    uint64_t snapshotBytes;
+    uint64_t batchBytes;
+    uint64_t peakBackupBytes;
+
+    admin_GetBackupMemoryStats(&snapshotBytes, &batchBytes, &peakBackupBytes);
+
+    printf(",\"backups\":{\"snapshotBytes\":%" PRIu64 ",\"batchBytes\":%" PRIu64
+           ",\"peak\":%" PRIu64 "}}\n",
+           snapshotBytes,
+           batchBytes,
+           peakBackupBytes);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the default value of a resource.
@@ -1564,6 +1829,21 @@ static void ValueArgHandler
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Command-line argument handler call-back for the COUNT argument to 'set rollup'.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CountArgHandler
+(
+    const char* arg
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CountArg = arg;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Command-line argument handler call-back for a PATH argument.
@@ -1607,12 +1887,14 @@ static void PathArgHandler
         case OBJECT_TRANSFORM:
         case OBJECT_BUFFER_SIZE:
         case OBJECT_BACKUP_PERIOD:
+        case OBJECT_ROLLUP:
         case OBJECT_JSON_EXTRACTION:
         case OBJECT_OBSERVATION:
         case OBJECT_MIN:
         case OBJECT_MAX:
         case OBJECT_MEAN:
         case OBJECT_STD_DEVIATION:
+        case OBJECT_STATS:
 
             PathArg = ValidateObservationPath(arg);
             break;
@@ -1702,6 +1984,10 @@ static void ObjectTypeArgHandler
     {
         Object = OBJECT_BACKUP_PERIOD;
     }
+    else if (strcmp(arg, "rollup") == 0)
+    {
+        Object = OBJECT_ROLLUP;
+    }
     else if (strcmp(arg, "jsonExtraction") == 0)
     {
         Object = OBJECT_JSON_EXTRACTION;
@@ -1726,6 +2012,10 @@ static void ObjectTypeArgHandler
     {
         Object = OBJECT_STD_DEVIATION;
     }
+    else if (strcmp(arg, "stats") == 0)
+    {
+        Object = OBJECT_STATS;
+    }
     else
     {
         fprintf(stderr, "Unknown object type '%s'.\n", arg);
@@ -1751,24 +2041,37 @@ static void ObjectTypeArgHandler
         else if (   (Object == OBJECT_MIN)
                  || (Object == OBJECT_MAX)
                  || (Object == OBJECT_MEAN)
-                 || (Object == OBJECT_STD_DEVIATION)  )
+                 || (Object == OBJECT_STD_DEVIATION)
+                 || (Object == OBJECT_STATS)  )
         {
             fprintf(stderr, "Can't 'set' a buffer statistic.\n");
             exit(EXIT_FAILURE);
         }
+        else if (Object == OBJECT_ROLLUP)
+        {
+            // The "set rollup" command needs the SECONDS and the COUNT.
+            le_arg_AddPositionalCallback(ValueArgHandler);
+            le_arg_AddPositionalCallback(CountArgHandler);
+        }
         else
         {
             // Everything else needs a VALUE.
             le_arg_AddPositionalCallback(ValueArgHandler);
         }
     }
+    else if (Object == OBJECT_ROLLUP)
+    {
+        // Getting or removing a rollup tier needs the SECONDS to say which one.
+        le_arg_AddPositionalCallback(ValueArgHandler);
+    }
     else if (Action == ACTION_GET)
     {
         // If we are getting a buffer statistic,
         if (   (Object == OBJECT_MIN)
             || (Object == OBJECT_MAX)
             || (Object == OBJECT_MEAN)
-            || (Object == OBJECT_STD_DEVIATION)  )
+            || (Object == OBJECT_STD_DEVIATION)
+            || (Object == OBJECT_STATS)  )
         {
             // Accept an optional START argument.
             le_arg_AddPositionalCallback(StartArgHandler);
@@ -1851,6 +2154,10 @@ static void CommandArgHandler
         le_arg_AddPositionalCallback(StartArgHandler);
         le_arg_AllowLessPositionalArgsThanCallbacks();
     }
+    else if (strcmp(arg, "memstats") == 0)
+    {
+        Action = ACTION_MEMSTATS;
+    }
     else
     {
         fprintf(stderr, "Unrecognized command '%s'.  Try 'dhub help' for assistance.\n", arg);
@@ -1963,6 +2270,11 @@ COMPONENT_INIT
                     GetIntegerSetting(admin_GetBufferBackupPeriod);
                     break;
 
+                case OBJECT_ROLLUP:
+
+                    printf("%u\n", admin_GetBufferRollup(PathArg, ParseBucketSeconds(ValueArg)));
+                    break;
+
                 case OBJECT_JSON_EXTRACTION:
                 {
                     char spec[ADMIN_MAX_JSON_EXTRACTOR_LEN];
@@ -2003,6 +2315,11 @@ COMPONENT_INIT
 
                     GetBufferStat(query_GetStdDev);
                     break;
+
+                case OBJECT_STATS:
+
+                    GetBufferStats();
+                    break;
             }
             break;
 
@@ -2062,6 +2379,11 @@ COMPONENT_INIT
                     SetIntegerSetting(PathArg, ValueArg, admin_SetBufferBackupPeriod);
                     break;
 
+                case OBJECT_ROLLUP:
+
+                    SetRollupSetting(PathArg, ValueArg, CountArg);
+                    break;
+
                 case OBJECT_JSON_EXTRACTION:
 
                     admin_SetJsonExtraction(PathArg, ValueArg);
@@ -2076,6 +2398,7 @@ COMPONENT_INIT
                 case OBJECT_MAX:
                 case OBJECT_MEAN:
                 case OBJECT_STD_DEVIATION:
+                case OBJECT_STATS:
 
                     fprintf(stderr, "Can't 'set' a buffered data statistic.\n");
                     exit(EXIT_FAILURE);
@@ -2141,6 +2464,11 @@ COMPONENT_INIT
                     fprintf(stderr, "This cannot be removed. Do you mean to set it to zero?\n");
                     exit(EXIT_FAILURE);
 
+                case OBJECT_ROLLUP:
+
+                    admin_SetBufferRollup(PathArg, ParseBucketSeconds(ValueArg), 0);
+                    break;
+
                 case OBJECT_JSON_EXTRACTION:
 
                     admin_SetJsonExtraction(PathArg, "");
@@ -2155,6 +2483,7 @@ COMPONENT_INIT
                 case OBJECT_MAX:
                 case OBJECT_MEAN:
                 case OBJECT_STD_DEVIATION:
+                case OBJECT_STATS:
 
                     fprintf(stderr, "Buffered data statistics cannot be removed.\n");
                     exit(EXIT_FAILURE);
@@ -2185,6 +2514,11 @@ COMPONENT_INIT
 
             return;  // Return instead of falling-through to exit. Wait for completion callback.
 
+        case ACTION_MEMSTATS:
+
+            PrintMemoryStats();
+            break;
+
         default:
 
             LE_FATAL("Unimplemented action.");
@@ -10,6 +10,7 @@
 #include "ioService.h"
 #include "resource.h"
 #include "handler.h"
+#include "obs.h"
 #include "json.h"
 
 typedef struct
@@ -74,9 +75,7 @@ void admin_PushTrigger
 
     if (entry != NULL)
     {
-        resTree_Push(entry,
-                     IO_DATA_TYPE_TRIGGER,
-                     dataSample_CreateTrigger(timestamp));
+        resTree_PushTrigger(entry, timestamp);
     }
     else
     {
@@ -109,9 +108,7 @@ void admin_PushBoolean
 
     if (entry != NULL)
     {
-        resTree_Push(entry,
-                     IO_DATA_TYPE_BOOLEAN,
-                     dataSample_CreateBoolean(timestamp, value));
+        resTree_PushBoolean(entry, timestamp, value);
     }
     else
     {
@@ -144,9 +141,7 @@ void admin_PushNumeric
 
     if (entry != NULL)
     {
-        resTree_Push(entry,
-                     IO_DATA_TYPE_NUMERIC,
-                     dataSample_CreateNumeric(timestamp, value));
+        resTree_PushNumeric(entry, timestamp, value);
     }
     else
     {
@@ -1165,6 +1160,236 @@ uint32_t admin_GetBufferMaxCount
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable compression of a given Observation's buffer.  When enabled, numeric samples
+ * are buffered in compressed blocks, which typically take a few bytes per sample instead of
+ * sixteen.  Samples already in the buffer are kept.
+ */
+//--------------------------------------------------------------------------------------------------
+void admin_SetBufferCompression
+(
+    const char* path,
+        ///< [IN] Path within the /obs/ namespace.
+    bool isCompressed
+        ///< [IN] true = compress, false = don't compress (the default).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t obsEntry = GetObservation(path);
+
+    if (obsEntry == NULL)
+    {
+        LE_ERROR("Malformed observation path '%s'.", path);
+    }
+    else
+    {
+        resTree_SetBufferCompression(obsEntry, isCompressed);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether compression is enabled for a given Observation's buffer.
+ *
+ * @return true if enabled, false if not or the Observation does not exist.
+ */
+//--------------------------------------------------------------------------------------------------
+bool admin_IsBufferCompressed
+(
+    const char* path
+        ///< [IN] Path within the /obs/ namespace.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t resEntry = FindObservation(path);
+
+    if (resEntry == NULL)
+    {
+        return false;
+    }
+    else
+    {
+        return resTree_IsBufferCompressed(resEntry);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the tolerance of the swinging door compression of a given Observation's buffer.  When set,
+ * numeric samples are only buffered if they are needed to reconstruct the signal to within the
+ * tolerance, by linear interpolation between the buffered samples.
+ */
+//--------------------------------------------------------------------------------------------------
+void admin_SetBufferTolerance
+(
+    const char* path,
+        ///< [IN] Path within the /obs/ namespace.
+    double tolerance
+        ///< [IN] Maximum reconstruction error (> 0). NAN or 0 = disable.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t obsEntry = GetObservation(path);
+
+    if (obsEntry == NULL)
+    {
+        LE_ERROR("Malformed observation path '%s'.", path);
+    }
+    else
+    {
+        resTree_SetBufferTolerance(obsEntry, tolerance);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the tolerance of the swinging door compression of a given Observation's buffer.
+ *
+ * @return The tolerance, or NAN if not set or the Observation does not exist.
+ */
+//--------------------------------------------------------------------------------------------------
+double admin_GetBufferTolerance
+(
+    const char* path
+        ///< [IN] Path within the /obs/ namespace.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t resEntry = FindObservation(path);
+
+    if (resEntry == NULL)
+    {
+        return NAN;
+    }
+    else
+    {
+        return resTree_GetBufferTolerance(resEntry);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable run-length encoding of a given Observation's buffer.  When enabled, a
+ * numerical sample with the same value as the newest buffered sample extends that sample's run
+ * instead of taking a buffer entry of its own.
+ */
+//--------------------------------------------------------------------------------------------------
+void admin_SetBufferRunLengthEncoding
+(
+    const char* path,
+        ///< [IN] Path within the /obs/ namespace.
+    bool isEnabled
+        ///< [IN] true = store runs, false = store every sample (the default).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t obsEntry = GetObservation(path);
+
+    if (obsEntry == NULL)
+    {
+        LE_ERROR("Malformed observation path '%s'.", path);
+    }
+    else
+    {
+        resTree_SetBufferRunLengthEncoding(obsEntry, isEnabled);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether run-length encoding is enabled for a given Observation's buffer.
+ *
+ * @return true if enabled, false if not or the Observation does not exist.
+ */
+//--------------------------------------------------------------------------------------------------
+bool admin_IsBufferRunLengthEncoded
+(
+    const char* path
+        ///< [IN] Path within the /obs/ namespace.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t resEntry = FindObservation(path);
+
+    if (resEntry == NULL)
+    {
+        return false;
+    }
+    else
+    {
+        return resTree_IsBufferRunLengthEncoded(resEntry);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add, resize, or remove one of an Observation's rollup tiers.  The tier summarizes the numerical
+ * values accepted by the Observation into buckets of a given width (aligned to multiples of that
+ * width since the Epoch), and retains a given number of completed buckets.  When full, the tier
+ * drops its oldest bucket to make room for a new one.
+ */
+//--------------------------------------------------------------------------------------------------
+void admin_SetBufferRollup
+(
+    const char* path,
+        ///< [IN] Path within the /obs/ namespace.
+    uint32_t bucketSeconds,
+        ///< [IN] Width of the tier's buckets, in seconds (> 0).
+    uint32_t count
+        ///< [IN] The number of completed buckets to retain (0 = remove the tier).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t obsEntry = GetObservation(path);
+
+    if (obsEntry == NULL)
+    {
+        LE_ERROR("Malformed observation path '%s'.", path);
+    }
+    else
+    {
+        resTree_SetBufferRollup(obsEntry, bucketSeconds, count);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of completed buckets retained by one of an Observation's rollup tiers.
+ *
+ * @return The number of buckets, or 0 if the Observation has no tier with that bucket width or
+ *         does not exist.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t admin_GetBufferRollup
+(
+    const char* path,
+        ///< [IN] Path within the /obs/ namespace.
+    uint32_t bucketSeconds
+        ///< [IN] Width of the tier's buckets, in seconds.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t resEntry = FindObservation(path);
+
+    if (resEntry == NULL)
+    {
+        return 0;
+    }
+    else
+    {
+        return resTree_GetBufferRollup(resEntry, bucketSeconds);
+    }
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the minimum time between backups of an Observation's buffer to non-volatile storage.
@@ -1224,6 +1449,168 @@ uint32_t admin_GetBufferBackupPeriod
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the maximum number of bytes per hour to write to buffer backup files, to limit the wear on
+ * the flash.  Backups that would go over the budget are deferred until it allows them again, so
+ * their Observations' buffers are backed up less often than their backup periods specify.
+ */
+//--------------------------------------------------------------------------------------------------
+void admin_SetBackupWriteBudget
+(
+    uint32_t bytesPerHour
+        ///< [IN] The budget (0 = unlimited, the default)
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_SetBackupWriteBudget(bytesPerHour);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the maximum number of bytes per hour to write to buffer backup files.
+ * See admin_SetBackupWriteBudget() for more information.
+ *
+ * @return The budget (in bytes per hour) or 0 if unlimited.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t admin_GetBackupWriteBudget
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return obs_GetBackupWriteBudget();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the writing of buffer backup files, for sizing the endurance of the flash.
+ */
+//--------------------------------------------------------------------------------------------------
+void admin_GetBackupWriteStats
+(
+    uint64_t* totalBytesPtr,
+        ///< [OUT] Bytes written since the Data Hub started.
+    uint64_t* lastHourBytesPtr,
+        ///< [OUT] Bytes written during the last hour.
+    uint32_t* commitCountPtr
+        ///< [OUT] Number of times backups were synced to storage since start-up.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_GetBackupWriteStats(totalBytesPtr, lastHourBytesPtr, commitCountPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on one of the pools that the values of String and JSON data samples are allocated
+ * from.
+ *
+ * @return
+ *  - LE_OK if successful,
+ *  - LE_OUT_OF_RANGE if there is no pool with that index.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t admin_GetStringPoolStats
+(
+    uint32_t index,
+        ///< [IN] Index of the pool (0 = smallest values).
+    uint32_t* maxStringBytesPtr,
+        ///< [OUT] Largest value (incl. null terminator) held by the pool.
+    uint32_t* numInUsePtr,
+        ///< [OUT] Number of values from the pool currently in use.
+    uint32_t* peakNumInUsePtr,
+        ///< [OUT] Largest number of values from the pool in use at once.
+    uint64_t* numAllocsPtr,
+        ///< [OUT] Number of values allocated from the pool since start-up.
+    uint64_t* totalStringBytesPtr
+        ///< [OUT] Total size of those values (incl. null terminators).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    dataSample_SizeClassStats_t stats;
+
+    le_result_t result = dataSample_GetSizeClassStats(index, &stats);
+    if (result != LE_OK)
+    {
+        return result;
+    }
+
+    *maxStringBytesPtr = stats.maxStringBytes;
+    *numInUsePtr = stats.numInUse;
+    *peakNumInUsePtr = stats.maxNumInUse;
+    *numAllocsPtr = stats.numAllocs;
+    *totalStringBytesPtr = stats.totalStringBytes;
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the sharing (interning) of identical String and JSON data sample values.
+ */
+//--------------------------------------------------------------------------------------------------
+void admin_GetStringInternStats
+(
+    uint32_t* numInternedPtr,
+        ///< [OUT] Number of distinct values currently shared.
+    uint64_t* numHitsPtr
+        ///< [OUT] Number of times a value was shared instead of allocated since start-up.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t numInterned;
+
+    dataSample_GetInternStats(&numInterned, numHitsPtr);
+
+    *numInternedPtr = ((numInterned > UINT32_MAX) ? UINT32_MAX : (uint32_t)numInterned);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the memory allocated for the arrays of buffered samples, including their
+ * indexes, rollup tiers, and the snapshots and journal batches being written to backup files.
+ */
+//--------------------------------------------------------------------------------------------------
+void admin_GetBufferMemoryStats
+(
+    uint64_t* numBytesPtr,
+        ///< [OUT] Number of bytes currently allocated.
+    uint64_t* peakNumBytesPtr
+        ///< [OUT] Largest number of bytes allocated at once since start-up.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_GetBufferMemoryStats(numBytesPtr, peakNumBytesPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the memory held by buffer backups that are waiting to be written to storage.
+ */
+//--------------------------------------------------------------------------------------------------
+void admin_GetBackupMemoryStats
+(
+    uint64_t* snapshotBytesPtr,
+        ///< [OUT] Bytes held by buffer snapshots to be written in full.
+    uint64_t* batchBytesPtr,
+        ///< [OUT] Bytes held by batches to be appended to backup journals.
+    uint64_t* peakNumBytesPtr
+        ///< [OUT] Largest number of bytes held by both at once since start-up.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_GetBackupMemoryStats(snapshotBytesPtr, batchBytesPtr, peakNumBytesPtr);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Check if a given resource is a mandatory output.  If so, it means that this is an output resource
@@ -0,0 +1,4156 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file backup.c
+ *
+ * Backups of Observations' data sample buffers to non-volatile storage, and their restoration.
+ *
+ * Data sample buffer backup files are kept under BACKUP_DIR.  Their file system paths relative
+ * to BACKUP_DIR are the same as their resource paths relative to the /obs/ namespace in the
+ * resource tree.
+ *
+ * The data sample buffer backup file format looks like this (little-endian byte order):
+ *
+ * - file format version byte = 0
+ * - data type byte containing one of the following ASCII characters:
+ *       t = trigger
+ *       b = Boolean
+ *       n = numeric
+ *       s = string
+ *       j = JSON
+ * - number of records = 4-byte unsigned integer
+ * - array of records, sorted oldest-first, each containing:
+ *       - timestamp (8-byte IEEE double-precision floating point value)
+ *       - value, depending on data type, as follows:
+ *             t -> no value
+ *             b -> 1 byte, 0 = false, 1 = true
+ *             n -> 8-byte IEEE double-precision floating point value
+ *             s -> 4-byte unsigned integer length, followed by string content (no null-terminator)
+ *             j -> 4-byte unsigned integer length, followed by JSON string content (no term char)
+ *
+ * Compressed numeric buffers are backed up in a different format (version 1), which saves their
+ * compressed blocks as they are:
+ *
+ * - file format version byte = 1
+ * - data type byte = 'n'
+ * - number of records = 4-byte unsigned integer
+ * - number of records to skip at the start of the first block = 4-byte unsigned integer
+ * - number of blocks = 4-byte unsigned integer
+ * - array of blocks, oldest-first, each containing:
+ *       - number of records in the block = 4-byte unsigned integer
+ *       - number of bytes of encoded records = 4-byte unsigned integer
+ *       - the encoded records (see gorilla.c)
+ *
+ * Run-length encoded buffers are backed up in the same format as version 0, but with file format
+ * version byte = 2, data type 'b' or 'n', and each record (run) followed by:
+ *       - number of samples in the run = 4-byte unsigned integer
+ *       - timestamp of the newest sample in the run (8-byte IEEE double-precision floating point)
+ *
+ * Versions 0 and 2 are still read, but uncompressed buffers are now backed up in a format that can
+ * be mapped into memory and copied straight into the buffer's arrays when restoring (version 3).
+ * Each array starts at an offset that is a multiple of the size of its elements:
+ *
+ * - header (32 bytes):
+ *       - file format version byte = 3
+ *       - data type byte (as for version 0)
+ *       - flags byte = 1 if the records are runs (data type 'b' or 'n' only), else 0
+ *       - reserved byte = 0
+ *       - number of records = 4-byte unsigned integer
+ *       - timestamp of the oldest sample (8-byte IEEE double-precision floating point, NAN if none)
+ *       - timestamp of the newest sample (8-byte IEEE double-precision floating point, NAN if none)
+ *       - number of bytes after the header = 4-byte unsigned integer
+ *       - CRC-32 of the bytes after the header = 4-byte unsigned integer
+ * - timestamps of the records, oldest-first (8-byte IEEE double-precision floating point each)
+ * - if runs, timestamps of the newest samples in the runs (8-byte IEEE double-precision each)
+ * - if 'n', the values (8-byte IEEE double-precision floating point each)
+ * - if runs, numbers of samples in the runs (4-byte unsigned integer each)
+ * - if 's' or 'j', offsets of the ends of the strings in the string contents (4-byte unsigned
+ *   integer each)
+ * - if 'b', the values (1 byte each, 0 = false, 1 = true)
+ * - if 's' or 'j', the string contents: each string, null-terminated, one after the other
+ *
+ * Backup files are only rewritten in full now and then.  In between, what has been added to the
+ * buffer since the last backup is appended to a journal kept next to the backup file (with suffix
+ * JOURNAL_SUFFIX), so the amount written to flash each backup period is proportional to the number
+ * of new samples rather than to the size of the buffer.  Once the journal holds more records than
+ * the buffer, the backup file is rewritten and a new journal is started.  The journal looks like
+ * this:
+ *
+ * - journal format version byte = 0
+ * - format version byte of the backup file that the journal follows
+ * - number of records in that backup file = 4-byte unsigned integer
+ * - timestamp of the newest sample in that backup file (8-byte IEEE double-precision floating
+ *   point value, NAN if none)
+ * - CRC-32 of the above = 4-byte unsigned integer
+ * - array of batches, oldest-first, one per backup, each containing:
+ *       - number of bytes in the payload = 4-byte unsigned integer
+ *       - payload:
+ *             - number of records in the buffer after the batch = 4-byte unsigned integer
+ *             - 1 if the first record replaces the newest record before the batch, else 0 (byte)
+ *             - number of records in the batch = 4-byte unsigned integer
+ *             - array of records, oldest-first, in the same format as in the backup file
+ *       - CRC-32 of the payload = 4-byte unsigned integer
+ *
+ * A record is replaced when the sample it holds has changed since it was journaled: its run got
+ * longer, or swinging door compression replaced it.  When restoring, a batch that is incomplete or
+ * fails its CRC check ends the journal, and a journal whose header doesn't match the backup file
+ * (because it was started before the backup file was last rewritten) is ignored.
+ *
+ * An Observation's rollup tiers (see obs_SetBufferRollup()) are saved next to its backup file
+ * (with suffix ROLLUP_SUFFIX) whenever the backup file is rewritten.  The rows summarizing samples
+ * accepted since then are rebuilt from the restored buffer.  The rollup file looks like this:
+ *
+ * - rollup file format version byte = 0
+ * - data type byte of the summarized values ('b' or 'n')
+ * - number of tiers = 1 byte
+ * - reserved byte = 0
+ * - timestamp of the newest sample summarized (8-byte IEEE double-precision floating point value,
+ *   NAN if none)
+ * - array of tiers, finest first, each containing:
+ *       - width of the buckets, in seconds = 4-byte unsigned integer
+ *       - number of completed rows to retain = 4-byte unsigned integer
+ *       - number of completed rows = 4-byte unsigned integer
+ *       - array of rows, oldest-first, followed by the row of the bucket being filled (with a
+ *         count of 0 if none), each containing:
+ *             - start of the bucket (8-byte IEEE double-precision floating point value)
+ *             - number of values = 4-byte unsigned integer
+ *             - minimum, maximum, mean, and sum of squared differences from the mean (8-byte IEEE
+ *               double-precision floating point values)
+ * - CRC-32 of the above = 4-byte unsigned integer
+ *
+ * Backups of all the Observations are done together by a single commit timer.  When the backup
+ * period of an Observation with changes to back up has elapsed, it is written along with every
+ * other Observation that is due at the same time, and then the backup directory is synced once
+ * for the whole group.  Backup and rollup files aren't synced one by one: each is written under a
+ * temporary name (with TEMP_SUFFIX added) and renamed into place, so a reader only ever sees a
+ * complete file.  The number of bytes written per hour can be limited by a write budget, in which
+ * case backups that would go over the budget are deferred until it allows them again.
+ *
+ * The files are written by a separate backup writer thread, so that pushes aren't held up by file
+ * I/O.  A full backup takes a snapshot of the buffer (sharing its string and JSON samples, and
+ * copying the rest), and a journal append encodes its batch, which is then handed to the writer
+ * thread along with the file paths.  The writer thread works through its jobs in order, and hands
+ * each one back when done, so that failures can be reported to the Observation and the snapshot
+ * released in this thread.  Anything that reads or deletes backup files waits for the writer
+ * thread to catch up first.
+ *
+ * Backups aren't restored as the Observations are created (which would hold up start-up until
+ * every backup had been read), but are queued and restored a few at a time from the event loop,
+ * between the IPC messages.  An Observation that is pushed to, configured, or queried before its
+ * turn comes is restored on the spot.  Unused backup files aren't cleaned up until every backup
+ * has been restored, because they can't be told apart from the backups still waiting.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "dataHub.h"
+#include "nan.h"
+#include "dataSample.h"
+#include "resource.h"
+#include "resTree.h"
+#include "obs.h"
+#include "gorilla.h"
+#include "obsInternal.h"
+#include "backup.h"
+#include <ftw.h>
+#include <sys/mman.h>
+
+#ifdef LEGATO_EMBEDDED
+ #define BACKUP_DIR "/home/root/dataHubBackup/"
+#else
+ #define BACKUP_DIR "backup/"
+#endif
+#define BACKUP_DIR_PATH_LEN (sizeof(BACKUP_DIR) - 1)
+#define BACKUP_SUFFIX ".bak"
+#define BACKUP_SUFFIX_LEN (sizeof(BACKUP_SUFFIX) - 1)
+
+/// Suffix of the journal kept next to each backup file (must be the same length as BACKUP_SUFFIX).
+#define JOURNAL_SUFFIX ".jnl"
+
+/// Suffix of the rollup file kept next to each backup file (must be the same length as
+/// BACKUP_SUFFIX).
+#define ROLLUP_SUFFIX ".rup"
+
+#define MAX_BACKUP_FILE_PATH_BYTES (  BACKUP_DIR_PATH_LEN \
+                                    + IO_MAX_RESOURCE_PATH_LEN \
+                                    + BACKUP_SUFFIX_LEN \
+                                    + 1 /* for null terminator */ )
+
+/// Suffix added to the path of a backup or rollup file while a new version of it is being written.
+#define TEMP_SUFFIX ".new"
+#define TEMP_SUFFIX_LEN (sizeof(TEMP_SUFFIX) - 1)
+
+/// Largest number of bytes in a backup file record (a string or JSON sample with its run).
+#define MAX_RECORD_BYTES (8 + 4 + IO_MAX_STRING_VALUE_LEN + 4 + 8)
+
+/// Time to wait for other Observations to become due before committing an overdue backup (ms).
+#define BACKUP_COMMIT_DELAY_MS 100
+
+/// Number of milliseconds in an hour.
+#define MS_PER_HOUR 3600000
+
+/// Number of minutes of write statistics kept (one hour's worth).
+#define WRITE_STATS_MINUTES 60
+
+/// Longest time to spend restoring backups before letting the event loop run again (ms).
+#define RESTORE_SLICE_MS 10
+
+/// Record replayed from a backup journal.
+typedef struct
+{
+    dataSample_Ref_t sampleRef; ///< Data sample (the first sample of its run).
+    uint32_t runCount;  ///< Number of samples in the run (1 if not run-length encoded).
+    double runEnd;      ///< Timestamp of the newest sample in the run.
+}
+JournalRecord_t;
+
+/// Number of bytes in the header of a backup journal.
+#define JOURNAL_HEADER_BYTES (1 + 1 + 4 + 8 + 4)
+
+/// Number of bytes in the header of the payload of a backup journal batch.
+#define JOURNAL_BATCH_HEADER_BYTES (4 + 1 + 4)
+
+/// Number of bytes in the header of a rollup file.
+#define ROLLUP_HEADER_BYTES (1 + 1 + 1 + 1 + 8)
+
+/// Number of bytes in the header of each tier in a rollup file.
+#define ROLLUP_TIER_HEADER_BYTES (4 + 4 + 4)
+
+/// Number of bytes in each row in a rollup file.
+#define ROLLUP_ROW_BYTES (8 + 4 + 8 + 8 + 8 + 8)
+
+/// Format version of backup files that hold the arrays of an uncompressed buffer as they are, so
+/// that they can be mapped into memory when restoring.
+#define COLUMN_BACKUP_VERSION 3
+
+/// Flag set in the header of a version 3 backup file if its entries are runs.
+#define COLUMN_FLAG_RUNS 0x01
+
+/// Header of a version 3 backup file.  The arrays follow it, each aligned to the size of its
+/// elements (see the top of this file).
+typedef struct
+{
+    uint8_t version;        ///< File format version (COLUMN_BACKUP_VERSION).
+    uint8_t dataTypeCode;   ///< Data type code (see GetDataTypeCode()).
+    uint8_t flags;          ///< COLUMN_FLAG_RUNS, or 0.
+    uint8_t reserved;       ///< Always 0.
+    uint32_t count;         ///< Number of entries (samples or runs).
+    double oldestTimestamp; ///< Timestamp of the oldest sample (NAN if none).
+    double newestTimestamp; ///< Timestamp of the newest sample (NAN if none).
+    uint32_t payloadBytes;  ///< Number of bytes after the header.
+    uint32_t payloadCrc;    ///< CRC-32 of the bytes after the header.
+}
+ColumnFileHeader_t;
+
+/// Arrays of a version 3 backup file, in the order they are laid out in it.  The string contents
+/// come last, after all of these.
+typedef enum
+{
+    COLUMN_TIMESTAMPS,  ///< Timestamps of the entries (their oldest samples, for runs).
+    COLUMN_RUN_ENDS,    ///< Timestamps of the newest samples in the runs (runs only).
+    COLUMN_NUMBERS,     ///< Numeric values (numeric only).
+    COLUMN_RUN_COUNTS,  ///< Numbers of samples in the runs (runs only).
+    COLUMN_STRING_ENDS, ///< Offsets of the ends of the strings in the contents (string, JSON).
+    COLUMN_BOOLEANS,    ///< Boolean values (Boolean only).
+    COLUMN_COUNT        ///< Number of arrays.
+}
+Column_t;
+
+/// Arrays of a version 3 backup file that has been mapped into memory (NULL if not in the file).
+typedef struct
+{
+    const double* timestamps;   ///< Timestamps of the entries.
+    const double* runEnds;      ///< Timestamps of the newest samples in the runs.
+    const double* numbers;      ///< Numeric values.
+    const uint32_t* runCounts;  ///< Numbers of samples in the runs.
+    const uint32_t* stringEnds; ///< Offsets of the ends of the strings in the string contents.
+    const uint8_t* booleans;    ///< Boolean values.
+    const char* strings;        ///< String contents.
+}
+MappedColumns_t;
+
+
+/// Kinds of jobs done by the backup writer thread.
+typedef enum
+{
+    BACKUP_JOB_WRITE,   ///< Write a backup file from a snapshot, and start a new journal after it.
+    BACKUP_JOB_APPEND,  ///< Append a batch to a journal.
+    BACKUP_JOB_DELETE,  ///< Delete a backup file, its journal, and its rollup file.
+    BACKUP_JOB_SYNC,    ///< Flush everything written since the last sync out to the storage.
+}
+BackupJobType_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Job for the backup writer thread.  Everything the job needs is captured when it is created, so
+ * the Observation can go on changing (or be deleted) while the job is being done.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_dls_Link_t link;     ///< Used to link into the Observation's backupJobList.
+    Observation_t* obsPtr;  ///< Observation to report back to (NULL if none, or deleted).
+    BackupJobType_t type;   ///< What to do.
+    char path[MAX_BACKUP_FILE_PATH_BYTES];  ///< Backup file path.
+    char journalPath[MAX_BACKUP_FILE_PATH_BYTES];   ///< Journal file path.
+    char rollupPath[MAX_BACKUP_FILE_PATH_BYTES];    ///< Rollup file path.
+    io_DataType_t dataType; ///< Type of the samples in the snapshot.
+    uint8_t version;        ///< Backup file format version.
+    SampleBuffer_t snapshot;    ///< Snapshot of the buffer to write (BACKUP_JOB_WRITE only).
+    uint8_t header[JOURNAL_HEADER_BYTES];   ///< Header of the new journal (BACKUP_JOB_WRITE only).
+    uint8_t* rollupPtr;     ///< Rollup file contents, or NULL if no tiers (BACKUP_JOB_WRITE only).
+    size_t rollupSize;      ///< Number of bytes in the rollup file contents.
+    uint8_t* batchPtr;      ///< Batch to append to the journal (BACKUP_JOB_APPEND only).
+    size_t batchSize;       ///< Number of bytes in the batch.
+    bool isOk;              ///< true if the job was done successfully (set by the writer thread).
+    size_t expectedBytes;   ///< Number of bytes charged to the write budget when it was queued.
+    size_t byteCount;       ///< Number of bytes written (set by the writer thread).
+    size_t heldBytes;       ///< Number of bytes of snapshot, rollup or batch memory held.
+}
+BackupJob_t;
+
+
+/// List of Observations with buffer changes waiting to be backed up, least recently backed up
+/// first.
+static le_dls_List_t PendingBackupList = LE_DLS_LIST_INIT;
+
+/// Timer used to commit the pending backups.
+static le_timer_Ref_t CommitTimer = NULL;
+
+/// Pool of backup writer thread jobs.
+static le_mem_PoolRef_t BackupJobPool = NULL;
+
+/// Thread that writes the backup files.
+static le_thread_Ref_t WriterThread = NULL;
+
+/// Thread that runs the Observations, to which the backup writer thread hands back its jobs.
+static le_thread_Ref_t MainThread = NULL;
+
+/// Posted by the backup writer thread once started, and when it has caught up with its jobs.
+static le_sem_Ref_t WriterSemaphore = NULL;
+
+/// Number of bytes written since the last sync (backup writer thread only).
+static size_t UnsyncedBytes = 0;
+
+/// Maximum number of bytes to write to backup files per hour, or 0 if unlimited.
+static uint32_t WriteBudget = 0;
+
+/// Number of bytes that can be written to backup files before the WriteBudget is exceeded.
+/// Refills at the WriteBudget rate up to one hour's worth, and goes negative when overspent.
+static double WriteAllowance = 0;
+
+/// Time at which the WriteAllowance was last refilled (ms, relative clock).
+static uint32_t AllowanceTime = 0;
+
+/// Number of bytes written to backup files since start-up.
+static uint64_t TotalBytesWritten = 0;
+
+/// Number of backup commits since start-up.
+static uint32_t CommitCount = 0;
+
+/// Number of bytes held by queued jobs for buffer snapshots (with their rollup file contents) and
+/// for journal batches, and the most held by queued jobs at once.
+static size_t QueuedSnapshotBytes = 0;
+static size_t QueuedBatchBytes = 0;
+static size_t PeakQueuedBytes = 0;
+
+/// Number of bytes written to backup files during each of the last WRITE_STATS_MINUTES minutes,
+/// indexed by minute of the relative clock modulo WRITE_STATS_MINUTES.
+static uint64_t MinuteBytes[WRITE_STATS_MINUTES];
+
+/// Minute of the relative clock that the newest entry in MinuteBytes is for.
+static uint32_t LastWriteMinute = 0;
+
+/// List of Observations whose buffers are waiting to be restored from backup, oldest first.
+static le_dls_List_t PendingRestoreList = LE_DLS_LIST_INIT;
+
+/// true if RestorePendingBackups() has been queued to the event loop.
+static bool IsRestoreQueued = false;
+
+/// true while a backup is being restored (so the restored samples don't count as pushes).
+static bool IsRestoring = false;
+
+/// Number of backups restored since start-up.
+static uint32_t RestoreCount = 0;
+
+/// Total time spent restoring backups since start-up (ms).
+static uint32_t RestoreTime = 0;
+
+/// Time at which the backups were initialized (ms, relative clock).
+static uint32_t StartTime = 0;
+
+/// true if unused backup files are to be cleaned up once all the backups have been restored.
+static bool IsCleanupPending = false;
+
+/// true if there may be backup files that no Observation is using (the backup directory is
+/// walked to clean them up only if so).
+static bool MayHaveUnusedBackupFiles = true;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the file system path to use for the backup file for a given Observation's data sample buffer.
+ *
+ * @return LE_OK if successful.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetBackupFilePath
+(
+    char* pathBuffPtr,  ///< [OUT] Ptr to where the path will be written.
+    size_t pathBuffSize,    ///< Size of the buffer in bytes.
+    Observation_t* obsPtr,
+    const char* suffix  ///< BACKUP_SUFFIX, JOURNAL_SUFFIX for the journal, or ROLLUP_SUFFIX.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t len;
+    LE_ASSERT(LE_OK == le_utf8_Copy(pathBuffPtr, BACKUP_DIR, pathBuffSize, &len));
+
+    pathBuffPtr += len;
+    pathBuffSize -= len;
+
+    resTree_EntryRef_t obsNamespace = resTree_FindEntry(resTree_GetRoot(), "obs");
+    LE_ASSERT(obsNamespace != NULL);
+
+    ssize_t result = resTree_GetPath(pathBuffPtr,
+                                     pathBuffSize,
+                                     obsNamespace,
+                                     res_GetResTreeEntry(&obsPtr->resource));
+    if (result <= 0)
+    {
+        LE_CRIT("Failed to fetch Observation path for '%s' (%s).",
+                resTree_GetEntryName(res_GetResTreeEntry(&obsPtr->resource)),
+                LE_RESULT_TXT(result));
+
+        return result;
+    }
+
+    pathBuffPtr += result;
+    pathBuffSize -= result;
+
+    return le_utf8_Copy(pathBuffPtr, suffix, pathBuffSize, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the path of the temporary file that a new version of a backup or rollup file is written to.
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetTempFilePath
+(
+    char* tempPathPtr,  ///< [OUT] Buffer of MAX_BACKUP_FILE_PATH_BYTES + TEMP_SUFFIX_LEN bytes.
+    const char* path    ///< Path of the file.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    LE_ASSERT(snprintf(tempPathPtr,
+                       MAX_BACKUP_FILE_PATH_BYTES + TEMP_SUFFIX_LEN,
+                       "%s" TEMP_SUFFIX,
+                       path) < (int)(MAX_BACKUP_FILE_PATH_BYTES + TEMP_SUFFIX_LEN));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Opens a stream to write a new version of a backup or rollup file into.  It is written to a
+ * temporary file, which only takes the file's place when CommitFileStream() is called.
+ *
+ * @return The stream, or NULL if failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static FILE* CreateFileStream
+(
+    const char* path    ///< Path of the file.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char tempPath[MAX_BACKUP_FILE_PATH_BYTES + TEMP_SUFFIX_LEN];
+    GetTempFilePath(tempPath, path);
+
+    FILE* file = fopen(tempPath, "w");
+    if (file == NULL)
+    {
+        LE_CRIT("Unable to open file '%s' for writing (%m).", tempPath);
+    }
+
+    return file;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Closes a stream opened by CreateFileStream() and renames its temporary file into the place of
+ * the file.  The file isn't synced here; that is left to the sync that ends the group commit.
+ *
+ * @return true if successful, false if failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool CommitFileStream
+(
+    FILE* file,
+    const char* path    ///< Path of the file.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char tempPath[MAX_BACKUP_FILE_PATH_BYTES + TEMP_SUFFIX_LEN];
+    GetTempFilePath(tempPath, path);
+
+    if (fclose(file) != 0)
+    {
+        LE_CRIT("Failed to write '%s' (%m).", tempPath);
+        return false;
+    }
+
+    if (rename(tempPath, path) != 0)
+    {
+        LE_CRIT("Failed to rename '%s' to '%s' (%m).", tempPath, path);
+        return false;
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes a buffer load of data to a buffered file stream opened by CreateFileStream().
+ *
+ * On error, logs an error message and closes the file, leaving the temporary file to be
+ * overwritten by the next attempt.
+ *
+ * @return true if successful, false if failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool WriteToStream
+(
+    FILE* file,
+    const void* buffPtr,
+    size_t buffSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t recordsWritten = fwrite(buffPtr, buffSize, 1, file);
+    if (recordsWritten != 1)
+    {
+        LE_CRIT("Failed to write (%m).");
+        fclose(file);
+        return false;
+    }
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads a buffer load of data from a backup file.
+ *
+ * On error, logs an error message and closes the file.
+ *
+ * @return LE_OK if successful, LE_UNDERFLOW if the end of file was reached, LE_FAULT if failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadFromFile
+(
+    void* buffPtr,
+    size_t buffSize,
+    FILE* file
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t bytesRead = fread(buffPtr, 1, buffSize, file);
+
+    le_result_t result = LE_OK;
+
+    if (bytesRead < buffSize)
+    {
+        if (feof(file))
+        {
+            result = LE_UNDERFLOW;
+        }
+        else
+        {
+            LE_CRIT("Failed to read (%m).");
+            result = LE_FAULT;
+        }
+
+        le_atomFile_CancelStream(file);
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the data type code byte to be written into a backup file.
+ *
+ * @return the data type code byte.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t GetDataTypeCode
+(
+    io_DataType_t dataType  ///< Type of the samples in the buffer.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    switch (dataType)
+    {
+        case IO_DATA_TYPE_TRIGGER:  return 't';
+        case IO_DATA_TYPE_BOOLEAN:  return 'b';
+        case IO_DATA_TYPE_NUMERIC:  return 'n';
+        case IO_DATA_TYPE_STRING:   return 's';
+        case IO_DATA_TYPE_JSON:     return 'j';
+    }
+
+    LE_FATAL("Invalid data type %d.", dataType);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the data type represented by the code byte read from a backup file.
+ *
+ * @return true if successful, false on error.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool GetDataTypeFromCode
+(
+    io_DataType_t* dataTypePtr, ///< [OUT] Ptr to where the result will be put on success.
+    uint8_t code
+)
+//--------------------------------------------------------------------------------------------------
+{
+    switch (code)
+    {
+        case 't': *dataTypePtr = IO_DATA_TYPE_TRIGGER; return true;
+        case 'b': *dataTypePtr = IO_DATA_TYPE_BOOLEAN; return true;
+        case 'n': *dataTypePtr = IO_DATA_TYPE_NUMERIC; return true;
+        case 's': *dataTypePtr = IO_DATA_TYPE_STRING;  return true;
+        case 'j': *dataTypePtr = IO_DATA_TYPE_JSON;    return true;
+    }
+
+    LE_CRIT("Invalid data type code %d.", (int)code);
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copies a field into a backup file record being encoded, and counts its bytes.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PutField
+(
+    uint8_t* buffPtr,   ///< [OUT] Record being encoded, or NULL if just getting its size.
+    size_t* sizePtr,    ///< [IN/OUT] Number of bytes in the record so far.
+    const void* fieldPtr,
+    size_t fieldSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (buffPtr != NULL)
+    {
+        memcpy(buffPtr + *sizePtr, fieldPtr, fieldSize);
+    }
+
+    *sizePtr += fieldSize;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encodes a given sample (or run) of an Observation's buffer (or of a snapshot of it) as a backup
+ * file record.
+ *
+ * @return The number of bytes in the record (at most MAX_RECORD_BYTES).
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t EncodeRecord
+(
+    SampleBuffer_t* bufferPtr,
+    io_DataType_t dataType, ///< Type of the samples in the buffer.
+    size_t index,       ///< Index of the sample in the buffer (0 = oldest).
+    uint8_t* buffPtr    ///< [OUT] Where to put the record, or NULL to just get its size.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t slot = obs_GetSlot(bufferPtr, index);
+    size_t size = 0;
+
+    double timestamp = obs_GetBufferedTimestamp(bufferPtr, index);
+    PutField(buffPtr, &size, &timestamp, sizeof(timestamp));
+
+    switch (dataType)
+    {
+        case IO_DATA_TYPE_TRIGGER:
+
+            // No Value.
+            break;
+
+        case IO_DATA_TYPE_BOOLEAN:
+        {
+            bool value = bufferPtr->values.booleans[slot];
+            PutField(buffPtr, &size, &value, sizeof(value));
+            break;
+        }
+        case IO_DATA_TYPE_NUMERIC:
+        {
+            double value = (bufferPtr->compressed ?
+                            bufferPtr->decodedPtr->numbers[obs_LoadDecodedBlock(bufferPtr, index)] :
+                            bufferPtr->values.numbers[slot]);
+            PutField(buffPtr, &size, &value, sizeof(value));
+            break;
+        }
+        case IO_DATA_TYPE_STRING:
+        case IO_DATA_TYPE_JSON:
+        {
+            const char* valuePtr = ((dataType == IO_DATA_TYPE_STRING) ?
+                                        dataSample_GetString(bufferPtr->values.samples[slot]) :
+                                        dataSample_GetJson(bufferPtr->values.samples[slot]));
+            uint32_t stringLen = strlen(valuePtr);
+            PutField(buffPtr, &size, &stringLen, 4);
+            PutField(buffPtr, &size, valuePtr, stringLen);
+            break;
+        }
+    }
+
+    // Add the size and end of the run.
+    if (bufferPtr->runLength)
+    {
+        PutField(buffPtr, &size, &bufferPtr->runCounts[slot], 4);
+        PutField(buffPtr, &size, &bufferPtr->runEnds[slot], sizeof(double));
+    }
+
+    return size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the number of bytes per entry in one of the arrays of a version 3 backup file.
+ *
+ * @return The number of bytes (0 if the array isn't in the file).
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t GetColumnElementSize
+(
+    Column_t column,
+    io_DataType_t dataType,
+    bool hasRuns    ///< true if the entries are runs.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    bool isNumeric = (dataType == IO_DATA_TYPE_NUMERIC);
+    bool isBoolean = (dataType == IO_DATA_TYPE_BOOLEAN);
+    bool isString = ((dataType == IO_DATA_TYPE_STRING) || (dataType == IO_DATA_TYPE_JSON));
+
+    switch (column)
+    {
+        case COLUMN_TIMESTAMPS:     return sizeof(double);
+        case COLUMN_RUN_ENDS:       return (hasRuns ? sizeof(double) : 0);
+        case COLUMN_NUMBERS:        return (isNumeric ? sizeof(double) : 0);
+        case COLUMN_RUN_COUNTS:     return (hasRuns ? sizeof(uint32_t) : 0);
+        case COLUMN_STRING_ENDS:    return (isString ? sizeof(uint32_t) : 0);
+        case COLUMN_BOOLEANS:       return (isBoolean ? sizeof(bool) : 0);
+        case COLUMN_COUNT:          break;
+    }
+
+    LE_FATAL("Invalid column %d.", column);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the offsets of the arrays of a version 3 backup file from the end of its header.
+ *
+ * Each array is aligned to the size of its elements without any padding, because the header is a
+ * multiple of 8 bytes long and the arrays are laid out in decreasing order of element size.
+ *
+ * @return The offset of the string contents, which follow the arrays.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t GetColumnOffsets
+(
+    size_t* offsets,    ///< [OUT] Offset of each array (COLUMN_COUNT of them).
+    io_DataType_t dataType,
+    bool hasRuns,       ///< true if the entries are runs.
+    size_t count        ///< Number of entries.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t offset = 0;
+
+    for (Column_t column = 0; column < COLUMN_COUNT; column++)
+    {
+        offsets[column] = offset;
+        offset += count * GetColumnElementSize(column, dataType, hasRuns);
+    }
+
+    return offset;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes a snapshot of an Observation's uncompressed buffer to a given backup file in the format
+ * that can be mapped into memory (version 3): the header, then each of the snapshot's arrays as it
+ * is, then the contents of its strings (if any).
+ *
+ * On error, logs an error message and closes the file.
+ *
+ * @return true if successful, false if failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool WriteColumnsToFile
+(
+    FILE* file,
+    SampleBuffer_t* snapshotPtr,
+    io_DataType_t dataType  ///< Type of the samples in the snapshot.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t count = snapshotPtr->count;
+    bool hasRuns = snapshotPtr->runLength;
+    bool isString = ((dataType == IO_DATA_TYPE_STRING) || (dataType == IO_DATA_TYPE_JSON));
+
+    // Strings are stored null-terminated, one after the other, so that they can be used right
+    // where they are once the file is mapped into memory.  The offsets of their ends make up one
+    // of the arrays.
+    size_t stringCount = (isString ? count : 0);
+    const char** strings = obs_AllocBufferArray(stringCount * sizeof(const char*));
+    uint32_t* stringEnds = obs_AllocBufferArray(stringCount * sizeof(uint32_t));
+    size_t stringBytes = 0;
+
+    for (size_t i = 0; i < stringCount; i++)
+    {
+        strings[i] = ((dataType == IO_DATA_TYPE_STRING) ?
+                          dataSample_GetString(snapshotPtr->values.samples[i]) :
+                          dataSample_GetJson(snapshotPtr->values.samples[i]));
+        stringBytes += strlen(strings[i]) + 1;
+        stringEnds[i] = stringBytes;
+    }
+
+    // The snapshot's arrays start at slot 0, so they can be written as they are.
+    const void* columns[COLUMN_COUNT] =
+    {
+        [COLUMN_TIMESTAMPS] = snapshotPtr->timestamps,
+        [COLUMN_RUN_ENDS] = snapshotPtr->runEnds,
+        [COLUMN_NUMBERS] = snapshotPtr->values.numbers,
+        [COLUMN_RUN_COUNTS] = snapshotPtr->runCounts,
+        [COLUMN_STRING_ENDS] = stringEnds,
+        [COLUMN_BOOLEANS] = snapshotPtr->values.booleans,
+    };
+    size_t columnBytes[COLUMN_COUNT];
+
+    // The header holds the CRC of everything after it, so that has to be computed first.
+    uint32_t crc = LE_CRC_START_CRC32;
+    size_t payloadBytes = stringBytes;
+
+    for (Column_t column = 0; column < COLUMN_COUNT; column++)
+    {
+        columnBytes[column] = count * GetColumnElementSize(column, dataType, hasRuns);
+        if (columnBytes[column] > 0)
+        {
+            crc = le_crc_Crc32((uint8_t*)columns[column], columnBytes[column], crc);
+            payloadBytes += columnBytes[column];
+        }
+    }
+    for (size_t i = 0; i < stringCount; i++)
+    {
+        size_t start = ((i > 0) ? stringEnds[i - 1] : 0);
+        crc = le_crc_Crc32((uint8_t*)strings[i], stringEnds[i] - start, crc);
+    }
+
+    ColumnFileHeader_t header =
+    {
+        .version = COLUMN_BACKUP_VERSION,
+        .dataTypeCode = GetDataTypeCode(dataType),
+        .flags = (hasRuns ? COLUMN_FLAG_RUNS : 0),
+        .reserved = 0,
+        .count = count,
+        .oldestTimestamp = ((count > 0) ? obs_GetBufferedTimestamp(snapshotPtr, 0) : NAN),
+        .newestTimestamp = ((count > 0) ?
+                            obs_GetBufferedEndTimestamp(snapshotPtr, count - 1) : NAN),
+        .payloadBytes = payloadBytes,
+        .payloadCrc = crc,
+    };
+
+    bool isOk = WriteToStream(file, &header, sizeof(header));
+
+    for (Column_t column = 0; isOk && (column < COLUMN_COUNT); column++)
+    {
+        if (columnBytes[column] > 0)
+        {
+            isOk = WriteToStream(file, columns[column], columnBytes[column]);
+        }
+    }
+    for (size_t i = 0; isOk && (i < stringCount); i++)
+    {
+        size_t start = ((i > 0) ? stringEnds[i - 1] : 0);
+        isOk = WriteToStream(file, strings[i], stringEnds[i] - start);
+    }
+
+    obs_FreeBufferArray(strings);
+    obs_FreeBufferArray(stringEnds);
+
+    return isOk;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the compressed blocks of a snapshot of an Observation's buffer to a given backup file,
+ * after the number of samples to skip in the first block and the number of blocks.
+ *
+ * On error, logs an error message and closes the file.
+ *
+ * @return true if successful, false if failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool WriteBlocksToFile
+(
+    FILE* file,
+    const SampleBuffer_t* bufferPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint32_t skipCount = bufferPtr->blockHead;
+    if (!WriteToStream(file, &skipCount, 4))
+    {
+        return false;
+    }
+
+    uint32_t blockCount = bufferPtr->blockCount;
+    if (!WriteToStream(file, &blockCount, 4))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < bufferPtr->blockCount; i++)
+    {
+        const CompressedBlock_t* blockPtr = bufferPtr->blocks[i];
+
+        uint32_t sampleCount = blockPtr->count;
+        if (!WriteToStream(file, &sampleCount, 4))
+        {
+            return false;
+        }
+
+        uint32_t byteCount = blockPtr->byteCount;
+        if (!WriteToStream(file, &byteCount, 4))
+        {
+            return false;
+        }
+
+        if (!WriteToStream(file, blockPtr->bytes, blockPtr->byteCount))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads all the compressed blocks from a given (version 1) backup file and adds their numeric
+ * samples to a given Observation's data sample buffer.  Closes the file when done.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadBlocksFromFile
+(
+    Observation_t* obsPtr,
+    FILE* file,
+    size_t count    ///< The expected number of samples to read.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    dataSample_Ref_t dataSample = NULL;
+    uint32_t skipCount;
+    uint32_t blockCount;
+
+    if (   (ReadFromFile(&skipCount, 4, file) != LE_OK)
+        || (ReadFromFile(&blockCount, 4, file) != LE_OK)  )
+    {
+        LE_CRIT("Failed to read compressed block list header.");
+        goto error;
+    }
+
+    for (uint32_t i = 0; i < blockCount; i++)
+    {
+        uint32_t sampleCount;
+        uint32_t byteCount;
+
+        // A corrupted block can make the decoder run off the end of the bytes read, by up to one
+        // sample, before that is detected.
+        uint8_t bytes[COMPRESSED_BLOCK_BYTES + GORILLA_BYTES(GORILLA_MAX_SAMPLE_BITS)] = {0};
+
+        if (   (ReadFromFile(&sampleCount, 4, file) != LE_OK)
+            || (ReadFromFile(&byteCount, 4, file) != LE_OK)  )
+        {
+            LE_CRIT("Failed to read compressed block header.");
+            goto error;
+        }
+        if ((sampleCount > COMPRESSED_BLOCK_SAMPLES) || (byteCount > COMPRESSED_BLOCK_BYTES))
+        {
+            LE_CRIT("Compressed block size (%zu samples in %zu bytes) is larger than permitted.",
+                    (size_t)sampleCount,
+                    (size_t)byteCount);
+            le_atomFile_CancelStream(file);
+            goto error;
+        }
+        if (ReadFromFile(bytes, byteCount, file) != LE_OK)
+        {
+            LE_CRIT("Failed to read compressed block of %zu bytes.", (size_t)byteCount);
+            goto error;
+        }
+
+        gorilla_State_t decoder;
+        gorilla_Init(&decoder);
+
+        for (uint32_t j = 0; j < sampleCount; j++)
+        {
+            double timestamp;
+            double value;
+            gorilla_Decode(&decoder, bytes, &timestamp, &value);
+
+            if (decoder.bitCount > (byteCount * 8))
+            {
+                LE_CRIT("Compressed block is truncated.");
+                le_atomFile_CancelStream(file);
+                goto error;
+            }
+
+            // Skip the samples that had already been dropped from the first block.
+            if ((i == 0) && (j < skipCount))
+            {
+                continue;
+            }
+
+            if (count == 0)
+            {
+                LE_CRIT("Backup file contains extra samples.");
+                le_atomFile_CancelStream(file);
+                goto error;
+            }
+
+            count--;
+
+            // As for uncompressed backups, the last (newest) sample is pushed to the Observation
+            // once the whole file has been checked, so it becomes the current value.
+            if (dataSample != NULL)
+            {
+                obs_AddToBuffer(obsPtr, dataSample);
+                le_mem_Release(dataSample);
+            }
+            dataSample = dataSample_CreateNumeric(timestamp, value);
+        }
+    }
+
+    // End of file should be reached now.
+    uint8_t byte;
+    le_result_t result = ReadFromFile(&byte, 1, file);
+    if (result == LE_OK)
+    {
+        LE_CRIT("Backup file contains extra data.");
+        le_atomFile_CancelStream(file);
+        goto error;
+    }
+    if (result != LE_UNDERFLOW)
+    {
+        goto error;
+    }
+    if (count != 0)
+    {
+        LE_CRIT("Backup file was truncated. Expected %zu more samples.", count);
+        goto error;
+    }
+
+    if (dataSample != NULL)
+    {
+        res_Push(&obsPtr->resource, IO_DATA_TYPE_NUMERIC, "", dataSample);
+    }
+    return;
+
+error:
+
+    if (dataSample != NULL)
+    {
+        le_mem_Release(dataSample);
+    }
+
+    // On error, dump the buffer contents in case we read some corrupted samples from the file.
+    obs_TruncateBuffer(obsPtr, 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads all the data samples (or runs, for a version 2 backup file) from a given backup file and
+ * adds them to a given Observation's data sample buffer.  Closes the file when done.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadSamplesFromFile
+(
+    Observation_t* obsPtr,
+    FILE* file,
+    size_t count,   ///< The expected number of samples (or runs) to read.
+    bool hasRuns    ///< true if each record is followed by the size and end of its run.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    io_DataType_t dataType = obsPtr->bufferedType;
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    dataSample_Ref_t dataSample = NULL;
+
+    for (;;)
+    {
+        // Read the timestamp.
+        double timestamp;
+        le_result_t result = ReadFromFile(&timestamp, sizeof(timestamp), file);
+        if (result != LE_OK)
+        {
+            if (result == LE_UNDERFLOW)
+            {
+                // End of file reached, check that we've received all we should.
+                if (count == 0)
+                {
+                    // The file contained exactly the number of samples we expected.
+                    // The last data sample read from the file (which is the newest)
+                    // should be pushed to the Observation so it becomes the current value.
+                    res_Push(&obsPtr->resource, dataType, "", dataSample);
+                    return;
+                }
+                else
+                {
+                    LE_CRIT("Backup file was truncated. Expected %zu more samples.", count);
+                }
+            }
+
+            goto error;
+        }
+
+        // We succeeded in reading another timestamp, so we had better be expecting more samples.
+        if (count == 0)
+        {
+            LE_CRIT("Backup file contains extra samples.");
+            le_atomFile_CancelStream(file);
+            goto error;
+        }
+
+        count--;
+
+        switch (dataType)
+        {
+            case IO_DATA_TYPE_TRIGGER:
+
+                // No Value.
+                dataSample = dataSample_CreateTrigger(timestamp);
+                break;
+
+            case IO_DATA_TYPE_BOOLEAN:
+            {
+                bool value;
+                if (ReadFromFile(&value, sizeof(value), file) != LE_OK)
+                {
+                    LE_CRIT("Failed to read boolean value.");
+                    goto error;
+                }
+                dataSample = dataSample_CreateBoolean(timestamp, value);
+                break;
+            }
+            case IO_DATA_TYPE_NUMERIC:
+            {
+                double value;
+                if (ReadFromFile(&value, sizeof(value), file) != LE_OK)
+                {
+                    LE_CRIT("Failed to read numeric value.");
+                    goto error;
+                }
+                dataSample = dataSample_CreateNumeric(timestamp, value);
+                break;
+            }
+            case IO_DATA_TYPE_STRING:
+            {
+                char value[IO_MAX_STRING_VALUE_LEN + 1];
+
+                uint32_t stringLen;
+                if (ReadFromFile(&stringLen, 4, file) != LE_OK)
+                {
+                    LE_CRIT("Failed to read string length.");
+                    goto error;
+                }
+                if (stringLen > (sizeof(value) - 1))
+                {
+                    LE_CRIT("String length (%zu) is larger than permitted (%zu).",
+                            (size_t)stringLen,
+                            sizeof(value) - 1);
+                    le_atomFile_CancelStream(file);
+                    goto error;
+                }
+                if (ReadFromFile(value, stringLen, file) != LE_OK)
+                {
+                    LE_CRIT("Failed to read string value of length %zu.", (size_t)stringLen);
+                    goto error;
+                }
+                value[stringLen] = '\0';
+                dataSample = dataSample_CreateString(timestamp, value);
+                break;
+            }
+            case IO_DATA_TYPE_JSON:
+            {
+                char value[IO_MAX_STRING_VALUE_LEN + 1];
+
+                uint32_t stringLen;
+                if (ReadFromFile(&stringLen, 4, file) != LE_OK)
+                {
+                    LE_CRIT("Failed to read JSON object length.");
+                    goto error;
+                }
+                if (stringLen > (sizeof(value) - 1))
+                {
+                    LE_CRIT("JSON string length (%zu) is larger than permitted (%zu).",
+                            (size_t)stringLen,
+                            sizeof(value) - 1);
+                    le_atomFile_CancelStream(file);
+                    goto error;
+                }
+                if (ReadFromFile(value, stringLen, file) != LE_OK)
+                {
+                    LE_CRIT("Failed to read JSON value of length %zu.", (size_t)stringLen);
+                    goto error;
+                }
+                value[stringLen] = '\0';
+                dataSample = dataSample_CreateJson(timestamp, value);
+                break;
+            }
+        }
+
+        uint32_t runCount = 1;
+        double runEnd = timestamp;
+        if (hasRuns)
+        {
+            if (   (ReadFromFile(&runCount, 4, file) != LE_OK)
+                || (ReadFromFile(&runEnd, sizeof(runEnd), file) != LE_OK)  )
+            {
+                LE_CRIT("Failed to read run.");
+                le_mem_Release(dataSample);
+                goto error;
+            }
+            if ((runCount == 0) || !(runEnd >= timestamp))
+            {
+                LE_CRIT("Invalid run of %zu samples ending at %lf.", (size_t)runCount, runEnd);
+                le_mem_Release(dataSample);
+                le_atomFile_CancelStream(file);
+                goto error;
+            }
+        }
+
+        // Add the sample to the buffer, unless this is the last (newest) sample, in which case
+        // we will push it to the Observation later when we confirm that the file doesn't have
+        // more than expected in it (which would mean that all these samples are probably corrupt
+        // and need to be discarded).  For the last run, that is its newest sample, which the
+        // rest of the run is added to the buffer ahead of.
+        if ((count != 0) || (runCount > 1))
+        {
+            obs_AddToBuffer(obsPtr, dataSample);
+            le_mem_Release(dataSample);
+
+            uint32_t extraCount = ((count != 0) ? (runCount - 1) : (runCount - 2));
+            if (bufferPtr->runLength && (bufferPtr->count > 0))
+            {
+                obs_ExtendNewestRun(obsPtr, runEnd, extraCount);
+            }
+
+            dataSample = NULL;
+            if (count == 0)
+            {
+                double value = obs_GetBufferedNumber(obsPtr, bufferPtr->count - 1);
+
+                if (dataType == IO_DATA_TYPE_BOOLEAN)
+                {
+                    dataSample = dataSample_CreateBoolean(runEnd, (value != 0));
+                }
+                else
+                {
+                    dataSample = dataSample_CreateNumeric(runEnd, value);
+                }
+            }
+        }
+    }
+
+error:
+
+    // On error, dump the buffer contents in case we read some corrupted samples from the file.
+    obs_TruncateBuffer(obsPtr, 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Finds the arrays of a version 3 backup file that has been mapped into memory.
+ *
+ * @return The number of bytes after the header that come before the string contents.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t MapColumns
+(
+    MappedColumns_t* columnsPtr,    ///< [OUT] The arrays.
+    const ColumnFileHeader_t* headerPtr,    ///< Header of the file (mapped into memory).
+    io_DataType_t dataType
+)
+//--------------------------------------------------------------------------------------------------
+{
+    bool hasRuns = ((headerPtr->flags & COLUMN_FLAG_RUNS) != 0);
+    const uint8_t* payloadPtr = (const uint8_t*)(headerPtr + 1);
+    const void* columns[COLUMN_COUNT];
+    size_t offsets[COLUMN_COUNT];
+
+    size_t stringsOffset = GetColumnOffsets(offsets, dataType, hasRuns, headerPtr->count);
+
+    for (Column_t column = 0; column < COLUMN_COUNT; column++)
+    {
+        columns[column] = ((GetColumnElementSize(column, dataType, hasRuns) > 0) ?
+                               (payloadPtr + offsets[column]) :
+                               NULL);
+    }
+
+    columnsPtr->timestamps = columns[COLUMN_TIMESTAMPS];
+    columnsPtr->runEnds = columns[COLUMN_RUN_ENDS];
+    columnsPtr->numbers = columns[COLUMN_NUMBERS];
+    columnsPtr->runCounts = columns[COLUMN_RUN_COUNTS];
+    columnsPtr->stringEnds = columns[COLUMN_STRING_ENDS];
+    columnsPtr->booleans = columns[COLUMN_BOOLEANS];
+    columnsPtr->strings = (const char*)(payloadPtr + stringsOffset);
+
+    return stringsOffset;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks that a version 3 backup file that has been mapped into memory is intact and holds a valid
+ * buffer, before anything is taken from it.
+ *
+ * @return true if the file can be restored, false if not.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool CheckMappedFile
+(
+    const ColumnFileHeader_t* headerPtr,    ///< Header of the file (mapped into memory).
+    size_t fileSize,
+    io_DataType_t* dataTypePtr  ///< [OUT] Data type of the samples in the file.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    io_DataType_t dataType;
+    if (!GetDataTypeFromCode(&dataType, headerPtr->dataTypeCode))
+    {
+        return false;
+    }
+
+    bool hasRuns = ((headerPtr->flags & COLUMN_FLAG_RUNS) != 0);
+    if (((headerPtr->flags & ~COLUMN_FLAG_RUNS) != 0) || (headerPtr->reserved != 0))
+    {
+        LE_CRIT("Backup file has unrecognized flags 0x%02x.", (unsigned int)headerPtr->flags);
+        return false;
+    }
+    if (   hasRuns
+        && (dataType != IO_DATA_TYPE_NUMERIC)
+        && (dataType != IO_DATA_TYPE_BOOLEAN)  )
+    {
+        LE_CRIT("Run-length backup file has non-numerical data type code '%c'.",
+                (char)headerPtr->dataTypeCode);
+        return false;
+    }
+
+    // Check the size of the file before looking at anything after the header.
+    size_t count = headerPtr->count;
+    size_t payloadBytes = fileSize - sizeof(*headerPtr);
+    if (headerPtr->payloadBytes != payloadBytes)
+    {
+        LE_CRIT("Backup file has %zu bytes after its header (expected %zu).",
+                payloadBytes,
+                (size_t)headerPtr->payloadBytes);
+        return false;
+    }
+
+    // Every entry has a timestamp, at least, which also keeps the offsets from overflowing.
+    if (count > (payloadBytes / sizeof(double)))
+    {
+        LE_CRIT("Backup file is too short to hold %zu samples.", count);
+        return false;
+    }
+
+    bool isString = ((dataType == IO_DATA_TYPE_STRING) || (dataType == IO_DATA_TYPE_JSON));
+
+    MappedColumns_t columns;
+    size_t stringsOffset = MapColumns(&columns, headerPtr, dataType);
+    if ((stringsOffset > payloadBytes) || (!isString && (stringsOffset != payloadBytes)))
+    {
+        LE_CRIT("Backup file size doesn't match its %zu samples.", count);
+        return false;
+    }
+
+    if (le_crc_Crc32((uint8_t*)(headerPtr + 1), payloadBytes, LE_CRC_START_CRC32)
+        != headerPtr->payloadCrc)
+    {
+        LE_CRIT("Backup file failed its CRC check.");
+        return false;
+    }
+
+    // The file is intact, but the buffer also relies on its samples being in order and valid.
+    if ((count > 0) && !(columns.timestamps[0] == headerPtr->oldestTimestamp))
+    {
+        LE_CRIT("Backup file's oldest timestamp doesn't match its header.");
+        return false;
+    }
+
+    size_t stringBytes = payloadBytes - stringsOffset;
+    size_t stringStart = 0;
+    double prevEnd = headerPtr->oldestTimestamp;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        double timestamp = columns.timestamps[i];
+        double end = (hasRuns ? columns.runEnds[i] : timestamp);
+        if (!(timestamp >= prevEnd) || !(end >= timestamp))
+        {
+            LE_CRIT("Backup file sample %zu is out of order.", i);
+            return false;
+        }
+        prevEnd = end;
+
+        if (hasRuns && (columns.runCounts[i] == 0))
+        {
+            LE_CRIT("Backup file sample %zu is an empty run.", i);
+            return false;
+        }
+
+        if ((dataType == IO_DATA_TYPE_BOOLEAN) && (columns.booleans[i] > 1))
+        {
+            LE_CRIT("Backup file sample %zu has invalid Boolean value %d.",
+                    i,
+                    (int)columns.booleans[i]);
+            return false;
+        }
+
+        if (isString)
+        {
+            size_t stringEnd = columns.stringEnds[i];
+            if (   (stringEnd <= stringStart)
+                || (stringEnd > stringBytes)
+                || ((stringEnd - stringStart - 1) > IO_MAX_STRING_VALUE_LEN)
+                || (   memchr(columns.strings + stringStart, '\0', stringEnd - stringStart)
+                    != (columns.strings + stringEnd - 1))  )
+            {
+                LE_CRIT("Backup file sample %zu has an invalid string.", i);
+                return false;
+            }
+            stringStart = stringEnd;
+        }
+    }
+
+    if (stringStart != stringBytes)
+    {
+        LE_CRIT("Backup file contains extra data.");
+        return false;
+    }
+
+    if ((count > 0) && !(prevEnd == headerPtr->newestTimestamp))
+    {
+        LE_CRIT("Backup file's newest timestamp doesn't match its header.");
+        return false;
+    }
+
+    *dataTypePtr = dataType;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates a data sample from an entry of a version 3 backup file that has been mapped into memory.
+ * Strings are null-terminated in the file, so they are copied straight from where they are.
+ *
+ * @return The data sample.
+ */
+//--------------------------------------------------------------------------------------------------
+static dataSample_Ref_t CreateMappedSample
+(
+    const MappedColumns_t* columnsPtr,  ///< Arrays of the file.
+    io_DataType_t dataType,
+    size_t index,       ///< Index of the entry in the file (0 = oldest).
+    double timestamp    ///< Timestamp to give the sample.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    switch (dataType)
+    {
+        case IO_DATA_TYPE_TRIGGER:
+
+            return dataSample_CreateTrigger(timestamp);
+
+        case IO_DATA_TYPE_BOOLEAN:
+
+            return dataSample_CreateBoolean(timestamp, (columnsPtr->booleans[index] != 0));
+
+        case IO_DATA_TYPE_NUMERIC:
+
+            return dataSample_CreateNumeric(timestamp, columnsPtr->numbers[index]);
+
+        case IO_DATA_TYPE_STRING:
+        case IO_DATA_TYPE_JSON:
+        {
+            const char* valuePtr = (columnsPtr->strings
+                                    + ((index > 0) ? columnsPtr->stringEnds[index - 1] : 0));
+
+            return ((dataType == IO_DATA_TYPE_STRING) ?
+                        dataSample_CreateString(timestamp, valuePtr) :
+                        dataSample_CreateJson(timestamp, valuePtr));
+        }
+    }
+
+    LE_FATAL("Invalid data type %d.", dataType);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restores an Observation's buffer from a version 3 backup file that has been mapped into memory
+ * and checked.  If the buffer stores its samples the same way the file does (which it does unless
+ * its settings have been changed), the file's arrays are copied straight into the buffer's, and
+ * the running aggregates and indexes are rebuilt once at the end.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadMappedColumns
+(
+    Observation_t* obsPtr,
+    const ColumnFileHeader_t* headerPtr,    ///< Header of the file (mapped into memory).
+    io_DataType_t dataType
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    bool hasRuns = ((headerPtr->flags & COLUMN_FLAG_RUNS) != 0);
+    size_t count = headerPtr->count;
+
+    MappedColumns_t columns;
+    MapColumns(&columns, headerPtr, dataType);
+
+    // Runs can't be split back into their samples, so the buffer has to stay run-length encoded.
+    if (hasRuns)
+    {
+        obsPtr->runLengthBuffer = true;
+    }
+    obs_SetBufferedType(obsPtr, dataType);
+
+    // The maximum count must be at least the number in the file.
+    if (obsPtr->maxCount == 0)
+    {
+        obsPtr->maxCount = count;
+    }
+    // NOTE: Don't enable backups, though, because we don't know the frequency to choose
+    //       and flash wear can permanently damage a device.
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Everything but the newest sample goes into the buffer first.  The newest sample is then
+    // pushed to the Observation, so it becomes the current value.  For the newest run, that is its
+    // newest sample, which the rest of the run goes into the buffer ahead of.
+    uint32_t newestWeight = (hasRuns ? columns.runCounts[count - 1] : 1);
+    size_t loadCount = ((newestWeight > 1) ? count : (count - 1));
+
+    if (bufferPtr->compressed || (bufferPtr->runLength != hasRuns))
+    {
+        // The buffer doesn't store its samples the way the file does, so add them one at a time.
+        for (size_t i = 0; i < loadCount; i++)
+        {
+            dataSample_Ref_t sampleRef = CreateMappedSample(&columns,
+                                                            dataType,
+                                                            i,
+                                                            columns.timestamps[i]);
+            obs_AddToBuffer(obsPtr, sampleRef);
+            le_mem_Release(sampleRef);
+        }
+    }
+    else if (loadCount > 0)
+    {
+        // If the maximum count has been reduced since the file was written, the oldest samples
+        // are left out, as they would be dropped anyway.
+        size_t skipCount = ((loadCount > obsPtr->maxCount) ? (loadCount - obsPtr->maxCount) : 0);
+        size_t copyCount = loadCount - skipCount;
+
+        // Leave room for the newest sample.
+        size_t capacity = copyCount + 1;
+        if (capacity < MIN_BUFFER_CAPACITY)
+        {
+            capacity = MIN_BUFFER_CAPACITY;
+        }
+        if (capacity > obsPtr->maxCount)
+        {
+            capacity = obsPtr->maxCount;
+        }
+        obs_ResizeBuffer(obsPtr, capacity);
+
+        memcpy(bufferPtr->timestamps, columns.timestamps + skipCount, copyCount * sizeof(double));
+
+        switch (dataType)
+        {
+            case IO_DATA_TYPE_TRIGGER:
+
+                // No value.
+                break;
+
+            case IO_DATA_TYPE_BOOLEAN:
+
+                for (size_t i = 0; i < copyCount; i++)
+                {
+                    bufferPtr->values.booleans[i] = (columns.booleans[skipCount + i] != 0);
+                }
+                break;
+
+            case IO_DATA_TYPE_NUMERIC:
+
+                memcpy(bufferPtr->values.numbers,
+                       columns.numbers + skipCount,
+                       copyCount * sizeof(double));
+                break;
+
+            case IO_DATA_TYPE_STRING:
+            case IO_DATA_TYPE_JSON:
+
+                for (size_t i = 0; i < copyCount; i++)
+                {
+                    bufferPtr->values.samples[i] = CreateMappedSample(&columns,
+                                                                      dataType,
+                                                                      skipCount + i,
+                                                                      bufferPtr->timestamps[i]);
+                }
+                break;
+        }
+
+        if (hasRuns)
+        {
+            memcpy(bufferPtr->runEnds, columns.runEnds + skipCount, copyCount * sizeof(double));
+            memcpy(bufferPtr->runCounts,
+                   columns.runCounts + skipCount,
+                   copyCount * sizeof(uint32_t));
+
+            if (loadCount == count)
+            {
+                bufferPtr->runCounts[copyCount - 1]--;
+            }
+        }
+
+        bufferPtr->count = copyCount;
+        bufferPtr->firstSeq += skipCount;
+
+        obs_RebuildAggregates(obsPtr);
+        obs_CacheJsonChunks(obsPtr);
+    }
+
+    res_Push(&obsPtr->resource,
+             dataType,
+             "",
+             CreateMappedSample(&columns, dataType, count - 1, headerPtr->newestTimestamp));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restores an Observation's buffer from a given (version 3) backup file, by mapping the file into
+ * memory.  The whole file is checked before anything is taken from it, so a file that is damaged
+ * anywhere is discarded.  Closes the file when done.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadMappedFile
+(
+    Observation_t* obsPtr,
+    FILE* file
+)
+//--------------------------------------------------------------------------------------------------
+{
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0)
+    {
+        LE_CRIT("Failed to stat backup file (%m).");
+        le_atomFile_CancelStream(file);
+        return;
+    }
+    size_t fileSize = st.st_size;
+
+    if (fileSize < sizeof(ColumnFileHeader_t))
+    {
+        LE_CRIT("Backup file header was truncated.");
+        le_atomFile_CancelStream(file);
+        return;
+    }
+
+    // The file stays locked while it is mapped.
+    void* filePtr = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (filePtr == MAP_FAILED)
+    {
+        LE_CRIT("Failed to map backup file into memory (%m).");
+        le_atomFile_CancelStream(file);
+        return;
+    }
+
+    const ColumnFileHeader_t* headerPtr = filePtr;
+    io_DataType_t dataType;
+    if (CheckMappedFile(headerPtr, fileSize, &dataType))
+    {
+        LoadMappedColumns(obsPtr, headerPtr, dataType);
+    }
+
+    munmap(filePtr, fileSize);
+    le_atomFile_CancelStream(file);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copies a field out of a backup file record being decoded.
+ *
+ * @return true if successful, false if the field runs past the end of the bytes available.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool GetField
+(
+    const uint8_t* bytesPtr,    ///< Bytes being decoded.
+    size_t byteCount,   ///< Number of bytes available.
+    size_t* sizePtr,    ///< [IN/OUT] Number of bytes decoded so far.
+    void* fieldPtr,     ///< [OUT] Where to put the field (NULL to skip over it).
+    size_t fieldSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (fieldSize > (byteCount - *sizePtr))
+    {
+        return false;
+    }
+
+    if (fieldPtr != NULL)
+    {
+        memcpy(fieldPtr, bytesPtr + *sizePtr, fieldSize);
+    }
+
+    *sizePtr += fieldSize;
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decodes a backup file record (see EncodeRecord()) held in memory.
+ *
+ * @return The number of bytes in the record, or 0 if it is malformed.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t DecodeRecord
+(
+    io_DataType_t dataType,
+    bool hasRuns,       ///< true if the record is followed by the size and end of its run.
+    const uint8_t* bytesPtr,
+    size_t byteCount,   ///< Number of bytes available.
+    dataSample_Ref_t* sampleRefPtr, ///< [OUT] The data sample (NULL to just check the record).
+    uint32_t* runCountPtr,  ///< [OUT] Number of samples in the run.
+    double* runEndPtr   ///< [OUT] Timestamp of the newest sample in the run.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t size = 0;
+    dataSample_Ref_t sampleRef = NULL;
+
+    double timestamp;
+    if (!GetField(bytesPtr, byteCount, &size, &timestamp, sizeof(timestamp)))
+    {
+        return 0;
+    }
+
+    switch (dataType)
+    {
+        case IO_DATA_TYPE_TRIGGER:
+
+            // No Value.
+            if (sampleRefPtr != NULL)
+            {
+                sampleRef = dataSample_CreateTrigger(timestamp);
+            }
+            break;
+
+        case IO_DATA_TYPE_BOOLEAN:
+        {
+            uint8_t value;
+            if (!GetField(bytesPtr, byteCount, &size, &value, 1) || (value > 1))
+            {
+                return 0;
+            }
+            if (sampleRefPtr != NULL)
+            {
+                sampleRef = dataSample_CreateBoolean(timestamp, (value != 0));
+            }
+            break;
+        }
+        case IO_DATA_TYPE_NUMERIC:
+        {
+            double value;
+            if (!GetField(bytesPtr, byteCount, &size, &value, sizeof(value)))
+            {
+                return 0;
+            }
+            if (sampleRefPtr != NULL)
+            {
+                sampleRef = dataSample_CreateNumeric(timestamp, value);
+            }
+            break;
+        }
+        case IO_DATA_TYPE_STRING:
+        case IO_DATA_TYPE_JSON:
+        {
+            uint32_t stringLen;
+            if (   !GetField(bytesPtr, byteCount, &size, &stringLen, 4)
+                || (stringLen > IO_MAX_STRING_VALUE_LEN)  )
+            {
+                return 0;
+            }
+            const char* stringPtr = (const char*)(bytesPtr + size);
+            if (!GetField(bytesPtr, byteCount, &size, NULL, stringLen))
+            {
+                return 0;
+            }
+            if (sampleRefPtr != NULL)
+            {
+                char value[IO_MAX_STRING_VALUE_LEN + 1];
+                memcpy(value, stringPtr, stringLen);
+                value[stringLen] = '\0';
+                sampleRef = ((dataType == IO_DATA_TYPE_STRING) ?
+                                dataSample_CreateString(timestamp, value) :
+                                dataSample_CreateJson(timestamp, value));
+            }
+            break;
+        }
+    }
+
+    uint32_t runCount = 1;
+    double runEnd = timestamp;
+    if (hasRuns)
+    {
+        if (   !GetField(bytesPtr, byteCount, &size, &runCount, 4)
+            || !GetField(bytesPtr, byteCount, &size, &runEnd, sizeof(runEnd))
+            || (runCount == 0)
+            || !(runEnd >= timestamp)  )
+        {
+            if (sampleRef != NULL)
+            {
+                le_mem_Release(sampleRef);
+            }
+            return 0;
+        }
+    }
+
+    if (sampleRefPtr != NULL)
+    {
+        *sampleRefPtr = sampleRef;
+        *runCountPtr = runCount;
+        *runEndPtr = runEnd;
+    }
+
+    return size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record that everything in an Observation's buffer has been backed up.
+ */
+//--------------------------------------------------------------------------------------------------
+static void MarkBackedUp
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    obsPtr->backupSeq = bufferPtr->firstSeq + bufferPtr->count;
+
+    if (bufferPtr->count > 0)
+    {
+        obsPtr->backupNewestEnd = obs_GetBufferedEndTimestamp(bufferPtr, bufferPtr->count - 1);
+        obsPtr->backupNewestWeight = obs_GetBufferedWeight(bufferPtr, bufferPtr->count - 1);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the header of a journal following a backup file that holds the current contents of an
+ * Observation's buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static void BuildJournalHeader
+(
+    Observation_t* obsPtr,
+    uint8_t version,    ///< Format version of the backup file.
+    uint8_t* headerPtr  ///< [OUT] Where to put the JOURNAL_HEADER_BYTES of the header.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    size_t size = 0;
+
+    uint8_t journalVersion = 0;
+    PutField(headerPtr, &size, &journalVersion, 1);
+    PutField(headerPtr, &size, &version, 1);
+
+    uint32_t count = bufferPtr->count;
+    PutField(headerPtr, &size, &count, 4);
+
+    double newestEnd = ((count > 0) ? obs_GetBufferedEndTimestamp(bufferPtr, count - 1) : NAN);
+    PutField(headerPtr, &size, &newestEnd, sizeof(newestEnd));
+
+    uint32_t crc = le_crc_Crc32(headerPtr, size, LE_CRC_START_CRC32);
+    PutField(headerPtr, &size, &crc, 4);
+
+    LE_ASSERT(size == JOURNAL_HEADER_BYTES);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encodes a row of a rollup tier into the contents of a rollup file, and counts its bytes.
+ */
+//--------------------------------------------------------------------------------------------------
+static void EncodeRollupRow
+(
+    uint8_t* bytesPtr,  ///< [OUT] Contents being encoded.
+    size_t* sizePtr,    ///< [IN/OUT] Number of bytes encoded so far.
+    const RollupRow_t* rowPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    PutField(bytesPtr, sizePtr, &rowPtr->startTime, 8);
+    PutField(bytesPtr, sizePtr, &rowPtr->count, 4);
+    PutField(bytesPtr, sizePtr, &rowPtr->min, 8);
+    PutField(bytesPtr, sizePtr, &rowPtr->max, 8);
+    PutField(bytesPtr, sizePtr, &rowPtr->mean, 8);
+    PutField(bytesPtr, sizePtr, &rowPtr->m2, 8);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encodes the contents of the rollup file of an Observation, to be written along with a full
+ * backup of its buffer (see the top of this file).
+ *
+ * @return Pointer to the contents (to be freed by the caller using obs_FreeBufferArray()), or NULL
+ *         if the Observation has no rollup tiers.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t* EncodeRollups
+(
+    Observation_t* obsPtr,
+    size_t* sizePtr     ///< [OUT] Number of bytes in the contents.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    *sizePtr = 0;
+
+    if (obsPtr->rollupCount == 0)
+    {
+        return NULL;
+    }
+
+    size_t byteCount = ROLLUP_HEADER_BYTES + 4;
+    for (size_t i = 0; i < obsPtr->rollupCount; i++)
+    {
+        byteCount += ROLLUP_TIER_HEADER_BYTES + ((obsPtr->rollups[i].count + 1) * ROLLUP_ROW_BYTES);
+    }
+
+    uint8_t* bytesPtr = obs_AllocBufferArray(byteCount);
+
+    size_t size = 0;
+
+    uint8_t byte = 0;
+    PutField(bytesPtr, &size, &byte, 1);
+    byte = GetDataTypeCode(obsPtr->rollupType);
+    PutField(bytesPtr, &size, &byte, 1);
+    byte = obsPtr->rollupCount;
+    PutField(bytesPtr, &size, &byte, 1);
+    byte = 0;
+    PutField(bytesPtr, &size, &byte, 1);
+
+    // Every sample accepted so far has been summarized, and the newest of them is still the newest
+    // in the buffer, so the rows for any samples accepted after this can be rebuilt from it.
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    double newest = ((bufferPtr->count > 0) ?
+                         obs_GetBufferedEndTimestamp(bufferPtr, bufferPtr->count - 1) : NAN);
+    PutField(bytesPtr, &size, &newest, 8);
+
+    for (size_t i = 0; i < obsPtr->rollupCount; i++)
+    {
+        RollupTier_t* tierPtr = &obsPtr->rollups[i];
+
+        uint32_t value = tierPtr->bucketSeconds;
+        PutField(bytesPtr, &size, &value, 4);
+        value = tierPtr->maxCount;
+        PutField(bytesPtr, &size, &value, 4);
+        value = tierPtr->count;
+        PutField(bytesPtr, &size, &value, 4);
+
+        // The completed rows, then the row being filled.
+        for (size_t j = 0; j < tierPtr->count; j++)
+        {
+            EncodeRollupRow(bytesPtr, &size, obs_GetRollupRow(tierPtr, j));
+        }
+        EncodeRollupRow(bytesPtr, &size, &tierPtr->open);
+    }
+
+    uint32_t crc = le_crc_Crc32(bytesPtr, size, LE_CRC_START_CRC32);
+    PutField(bytesPtr, &size, &crc, 4);
+
+    LE_ASSERT(size == byteCount);
+
+    *sizePtr = size;
+
+    return bytesPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes to the journal of an Observation's backup file.  The write only reaches the storage when
+ * the backups are committed (see CommitBackups()).
+ *
+ * @return true if successful, false if failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool WriteToJournal
+(
+    const char* path,   ///< Journal file path.
+    int flags,          ///< O_CREAT | O_TRUNC to start a new journal, 0 to append to it.
+    const uint8_t* bytesPtr,
+    size_t byteCount
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int fd = open(path, O_WRONLY | O_APPEND | flags, 0600);
+    if (fd < 0)
+    {
+        LE_CRIT("Unable to open file '%s' for writing (%m).", path);
+        return false;
+    }
+
+    bool isOk = true;
+
+    ssize_t bytesWritten = obs_WriteToFd(fd, bytesPtr, byteCount);
+    if (bytesWritten != (ssize_t)byteCount)
+    {
+        LE_CRIT("Failed to write %zu bytes to '%s' (%m).", byteCount, path);
+        isOk = false;
+    }
+
+    close(fd);
+
+    return isOk;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Flush everything written to the backup files out to the storage, by syncing the backup
+ * directory once for the whole group commit.  The files were renamed into the directory (or
+ * appended to, or deleted) without being synced themselves, so this relies on the file system
+ * writing a file's data before the metadata that refers to it, as journalling flash and disk file
+ * systems do.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SyncBackups
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int fd = open(BACKUP_DIR, O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+    {
+        LE_CRIT("Failed to open '" BACKUP_DIR "' (%m).");
+        return;
+    }
+
+    if (fsync(fd) != 0)
+    {
+        LE_CRIT("Failed to sync '" BACKUP_DIR "' (%m).");
+    }
+
+    close(fd);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Bring the per-minute backup write statistics up to the current minute, clearing the minutes
+ * in which nothing was written.
+ *
+ * @return The index of the current minute in MinuteBytes.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t UpdateWriteMinute
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint32_t minute = le_clk_GetRelativeTime().sec / 60;
+
+    if (minute - LastWriteMinute >= WRITE_STATS_MINUTES)
+    {
+        memset(MinuteBytes, 0, sizeof(MinuteBytes));
+    }
+    else
+    {
+        while (LastWriteMinute != minute)
+        {
+            LastWriteMinute++;
+            MinuteBytes[LastWriteMinute % WRITE_STATS_MINUTES] = 0;
+        }
+    }
+
+    LastWriteMinute = minute;
+
+    return minute % WRITE_STATS_MINUTES;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Computes the size of the backup file that will be written from a snapshot of an Observation's
+ * buffer, so that it can be charged to the write budget before it is written.
+ *
+ * @return The number of bytes.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t GetBackupFileSize
+(
+    const SampleBuffer_t* snapshotPtr,
+    io_DataType_t dataType, ///< Type of the samples in the snapshot.
+    uint8_t version         ///< Backup file format version.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (version == COLUMN_BACKUP_VERSION)
+    {
+        size_t offsets[COLUMN_COUNT];
+        size_t size = sizeof(ColumnFileHeader_t) + GetColumnOffsets(offsets,
+                                                                    dataType,
+                                                                    snapshotPtr->runLength,
+                                                                    snapshotPtr->count);
+
+        if ((dataType == IO_DATA_TYPE_STRING) || (dataType == IO_DATA_TYPE_JSON))
+        {
+            for (size_t i = 0; i < snapshotPtr->count; i++)
+            {
+                dataSample_Ref_t sampleRef = snapshotPtr->values.samples[i];
+                size += strlen((dataType == IO_DATA_TYPE_STRING) ?
+                                   dataSample_GetString(sampleRef) :
+                                   dataSample_GetJson(sampleRef)) + 1;
+            }
+        }
+
+        return size;
+    }
+
+    // Version byte, data type code, sample count, skip count and block count, then each block
+    // with its sample count and byte count.
+    size_t size = 1 + 1 + 4 + 4 + 4;
+
+    for (size_t i = 0; i < snapshotPtr->blockCount; i++)
+    {
+        size += 4 + 4 + snapshotPtr->blocks[i]->byteCount;
+    }
+
+    return size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes the rollup file of a backup job, or deletes it if the Observation has no rollup tiers.
+ * Runs in the backup writer thread.
+ *
+ * @return true if successful, false if failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool WriteRollupFile
+(
+    BackupJob_t* jobPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (jobPtr->rollupPtr == NULL)
+    {
+        if ((unlink(jobPtr->rollupPath) != 0) && (errno != ENOENT))
+        {
+            LE_CRIT("Failed to delete rollup file '%s' (%m).", jobPtr->rollupPath);
+            return false;
+        }
+        return true;
+    }
+
+    FILE* file = CreateFileStream(jobPtr->rollupPath);
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    if (   !WriteToStream(file, jobPtr->rollupPtr, jobPtr->rollupSize)
+        || !CommitFileStream(file, jobPtr->rollupPath)  )
+    {
+        return false;
+    }
+    jobPtr->byteCount += jobPtr->rollupSize;
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Writes a backup file from the buffer snapshot of a backup job, followed by its rollup file and a
+ * new, empty journal.  Runs in the backup writer thread.
+ *
+ * @return true if successful, false if failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool WriteBackupFile
+(
+    BackupJob_t* jobPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    LE_DEBUG("Backing up to '%s'...", jobPtr->path);
+
+    // Create the backup directory, if it doesn't exist already.
+    struct stat st = {0};
+    if (stat(BACKUP_DIR, &st) == -1)
+    {
+        LE_DEBUG("Creating directory '" BACKUP_DIR "'.");
+
+        if ((mkdir(BACKUP_DIR, 0700) == -1) && (errno != EEXIST))
+        {
+            LE_CRIT("Unable to create directory '" BACKUP_DIR "' (%m).");
+            return false;
+        }
+    }
+
+    // Open a new version of the file for writing.
+    FILE* file = CreateFileStream(jobPtr->path);
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    // Uncompressed buffers are written with their own header.
+    if (jobPtr->version == COLUMN_BACKUP_VERSION)
+    {
+        if (!WriteColumnsToFile(file, &jobPtr->snapshot, jobPtr->dataType))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // Write in the version byte.
+        if (!WriteToStream(file, &jobPtr->version, 1))
+        {
+            return false;
+        }
+
+        // Write the data type code.
+        uint8_t byte = GetDataTypeCode(jobPtr->dataType);
+        if (!WriteToStream(file, &byte, 1))
+        {
+            return false;
+        }
+
+        // Write in the number of samples.
+        uint32_t count = jobPtr->snapshot.count;
+        if (!WriteToStream(file, &count, 4))
+        {
+            return false;
+        }
+
+        // Write all the compressed blocks to the file.
+        if (!WriteBlocksToFile(file, &jobPtr->snapshot))
+        {
+            return false;
+        }
+    }
+
+    // Commit the file.
+    long fileSize = ftell(file);
+    if (!CommitFileStream(file, jobPtr->path))
+    {
+        return false;
+    }
+    jobPtr->byteCount = fileSize;
+
+    // Save the rollup tiers along with it.
+    if (!WriteRollupFile(jobPtr))
+    {
+        return false;
+    }
+
+    // Start a new journal to follow it.
+    if (!WriteToJournal(jobPtr->journalPath,
+                        O_CREAT | O_TRUNC,
+                        jobPtr->header,
+                        sizeof(jobPtr->header)))
+    {
+        return false;
+    }
+    jobPtr->byteCount += sizeof(jobPtr->header);
+
+    LE_DEBUG("Backup complete.");
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reports a finished backup job back to the Observation that it was for, and releases it.
+ * Runs in the thread that runs the Observations (the backup writer thread queues it there).
+ */
+//--------------------------------------------------------------------------------------------------
+static void FinishBackupJob
+(
+    void* param1Ptr,    ///< The job.
+    void* param2Ptr     ///< Not used.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    BackupJob_t* jobPtr = param1Ptr;
+    Observation_t* obsPtr = jobPtr->obsPtr;
+
+    if (obsPtr != NULL)
+    {
+        le_dls_Remove(&obsPtr->backupJobList, &jobPtr->link);
+
+        // The backup file or its journal may have been partly written, so start over with a full
+        // backup next time.
+        if (!jobPtr->isOk)
+        {
+            obsPtr->journalValid = false;
+        }
+    }
+
+    // Files that couldn't be deleted are left for the next clean-up.
+    if ((jobPtr->type == BACKUP_JOB_DELETE) && !jobPtr->isOk)
+    {
+        MayHaveUnusedBackupFiles = true;
+    }
+
+    // The write budget was charged with the number of bytes expected to be written when the job was
+    // queued, so correct that now that the number actually written is known.
+    if ((jobPtr->type == BACKUP_JOB_WRITE) || (jobPtr->type == BACKUP_JOB_APPEND))
+    {
+        WriteAllowance += (double)jobPtr->expectedBytes - (double)jobPtr->byteCount;
+    }
+
+    if ((jobPtr->type == BACKUP_JOB_SYNC) && (jobPtr->byteCount > 0))
+    {
+        TotalBytesWritten += jobPtr->byteCount;
+        CommitCount++;
+        MinuteBytes[UpdateWriteMinute()] += jobPtr->byteCount;
+
+        LE_DEBUG("Committed %zu bytes of backups.", jobPtr->byteCount);
+    }
+
+    if (jobPtr->type == BACKUP_JOB_WRITE)
+    {
+        obs_ReleaseBufferSnapshot(&jobPtr->snapshot, jobPtr->dataType);
+    }
+
+    if (jobPtr->type == BACKUP_JOB_WRITE)
+    {
+        QueuedSnapshotBytes -= jobPtr->heldBytes;
+    }
+    else
+    {
+        QueuedBatchBytes -= jobPtr->heldBytes;
+    }
+
+    obs_FreeBufferArray(jobPtr->batchPtr);
+    obs_FreeBufferArray(jobPtr->rollupPtr);
+
+    le_mem_Release(jobPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Does a backup job.  Runs in the backup writer thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunBackupJob
+(
+    void* param1Ptr,    ///< The job.
+    void* param2Ptr     ///< Not used.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    BackupJob_t* jobPtr = param1Ptr;
+
+    switch (jobPtr->type)
+    {
+        case BACKUP_JOB_WRITE:
+
+            jobPtr->isOk = WriteBackupFile(jobPtr);
+            UnsyncedBytes += jobPtr->byteCount;
+            break;
+
+        case BACKUP_JOB_APPEND:
+
+            jobPtr->isOk = WriteToJournal(jobPtr->journalPath,
+                                          0,
+                                          jobPtr->batchPtr,
+                                          jobPtr->batchSize);
+            if (jobPtr->isOk)
+            {
+                jobPtr->byteCount = jobPtr->batchSize;
+                UnsyncedBytes += jobPtr->byteCount;
+            }
+            break;
+
+        case BACKUP_JOB_DELETE:
+
+            jobPtr->isOk = true;
+            if ((unlink(jobPtr->path) != 0) && (errno != ENOENT))
+            {
+                LE_ERROR("Failed to delete backup file '%s' (%m).", jobPtr->path);
+                jobPtr->isOk = false;
+            }
+            if ((unlink(jobPtr->journalPath) != 0) && (errno != ENOENT))
+            {
+                LE_ERROR("Failed to delete journal '%s' (%m).", jobPtr->journalPath);
+                jobPtr->isOk = false;
+            }
+            if ((unlink(jobPtr->rollupPath) != 0) && (errno != ENOENT))
+            {
+                LE_ERROR("Failed to delete rollup file '%s' (%m).", jobPtr->rollupPath);
+                jobPtr->isOk = false;
+            }
+            break;
+
+        case BACKUP_JOB_SYNC:
+
+            if (UnsyncedBytes > 0)
+            {
+                SyncBackups();
+            }
+            jobPtr->byteCount = UnsyncedBytes;
+            UnsyncedBytes = 0;
+            jobPtr->isOk = true;
+            break;
+    }
+
+    le_event_QueueFunctionToThread(MainThread, FinishBackupJob, jobPtr, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates a job for the backup writer thread.  Unless the job is a sync, it is for a given
+ * Observation, and is given the paths of its backup file, journal, and rollup file.
+ *
+ * @return Pointer to the job, or NULL if the Observation's backup file path couldn't be built.
+ */
+//--------------------------------------------------------------------------------------------------
+static BackupJob_t* CreateBackupJob
+(
+    Observation_t* obsPtr,  ///< The Observation (NULL for BACKUP_JOB_SYNC).
+    BackupJobType_t type
+)
+//--------------------------------------------------------------------------------------------------
+{
+    BackupJob_t* jobPtr = le_mem_ForceAlloc(BackupJobPool);
+
+    memset(jobPtr, 0, sizeof(*jobPtr));
+    jobPtr->link = LE_DLS_LINK_INIT;
+    jobPtr->type = type;
+
+    if (obsPtr != NULL)
+    {
+        if (   (GetBackupFilePath(jobPtr->path, sizeof(jobPtr->path), obsPtr, BACKUP_SUFFIX)
+                != LE_OK)
+            || (GetBackupFilePath(jobPtr->journalPath,
+                                  sizeof(jobPtr->journalPath),
+                                  obsPtr,
+                                  JOURNAL_SUFFIX) != LE_OK)
+            || (GetBackupFilePath(jobPtr->rollupPath,
+                                  sizeof(jobPtr->rollupPath),
+                                  obsPtr,
+                                  ROLLUP_SUFFIX) != LE_OK)  )
+        {
+            le_mem_Release(jobPtr);
+            return NULL;
+        }
+
+        // Keep track of the jobs that will report back to the Observation, so they can be told
+        // if it gets deleted first.
+        if (type != BACKUP_JOB_DELETE)
+        {
+            jobPtr->obsPtr = obsPtr;
+            le_dls_Queue(&obsPtr->backupJobList, &jobPtr->link);
+        }
+    }
+
+    return jobPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queues a job to the backup writer thread.  Jobs are done in the order they are queued.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueueBackupJob
+(
+    BackupJob_t* jobPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if ((QueuedSnapshotBytes + QueuedBatchBytes) > PeakQueuedBytes)
+    {
+        PeakQueuedBytes = QueuedSnapshotBytes + QueuedBatchBytes;
+    }
+
+    le_event_QueueFunctionToThread(WriterThread, RunBackupJob, jobPtr, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Posts the backup writer semaphore.  Runs in the backup writer thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PostWriterSemaphore
+(
+    void* param1Ptr,    ///< Not used.
+    void* param2Ptr     ///< Not used.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_sem_Post(WriterSemaphore);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Waits for the backup writer thread to finish all the jobs queued so far, before the backup
+ * files are read or cleaned up.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FlushBackupWriter
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_event_QueueFunctionToThread(WriterThread, PostWriterSemaphore, NULL, NULL);
+    le_sem_Wait(WriterSemaphore);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main function of the backup writer thread.
+ */
+//--------------------------------------------------------------------------------------------------
+static void* BackupWriterMain
+(
+    void* contextPtr    ///< Not used.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Let obs_Init() know that jobs can be queued now.
+    le_sem_Post(WriterSemaphore);
+
+    le_event_RunLoop();
+
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete the backup file (and journal) of a given Observation's data sample buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DeleteBackup
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    BackupJob_t* jobPtr = CreateBackupJob(obsPtr, BACKUP_JOB_DELETE);
+    if (jobPtr != NULL)
+    {
+        QueueBackupJob(jobPtr);
+    }
+
+    obsPtr->journalValid = false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Appends what has changed in an Observation's buffer since it was last backed up to the journal
+ * of its backup file, as one batch.
+ *
+ * @return true if the batch was queued (or nothing has changed), false if the backup file has to
+ *         be rewritten in full instead: because the journal doesn't follow it, or would then hold
+ *         more records than the buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool AppendToJournal
+(
+    Observation_t* obsPtr,
+    size_t* byteCountPtr    ///< [OUT] Number of bytes queued to be written.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    *byteCountPtr = 0;
+
+    if (   (!obsPtr->journalValid)
+        || (obsPtr->backupSeq > bufferPtr->firstSeq + bufferPtr->count)  )
+    {
+        return false;
+    }
+
+    // Start at the oldest sample that hasn't been backed up yet, or at the newest one that has
+    // if it has changed since (its run got longer, or swinging door compression replaced it).
+    size_t first = 0;
+    uint8_t replacesNewest = 0;
+    if (obsPtr->backupSeq > bufferPtr->firstSeq)
+    {
+        first = obsPtr->backupSeq - bufferPtr->firstSeq;
+
+        if (   (obs_GetBufferedEndTimestamp(bufferPtr, first - 1) != obsPtr->backupNewestEnd)
+            || (obs_GetBufferedWeight(bufferPtr, first - 1) != obsPtr->backupNewestWeight)  )
+        {
+            first--;
+            replacesNewest = 1;
+        }
+    }
+
+    uint32_t recordCount = bufferPtr->count - first;
+    if (recordCount == 0)
+    {
+        return true;
+    }
+
+    // Once the journal has grown as large as the buffer, it's time to compact it.
+    if ((obsPtr->journalCount + recordCount) > bufferPtr->count)
+    {
+        return false;
+    }
+
+    BackupJob_t* jobPtr = CreateBackupJob(obsPtr, BACKUP_JOB_APPEND);
+    if (jobPtr == NULL)
+    {
+        return false;
+    }
+
+    uint32_t payloadSize = JOURNAL_BATCH_HEADER_BYTES;
+    for (size_t i = first; i < bufferPtr->count; i++)
+    {
+        payloadSize += EncodeRecord(bufferPtr, obsPtr->bufferedType, i, NULL);
+    }
+
+    uint8_t* batchPtr = obs_AllocBufferArray(4 + payloadSize + 4);
+
+    size_t size = 0;
+    PutField(batchPtr, &size, &payloadSize, 4);
+
+    uint32_t count = bufferPtr->count;
+    PutField(batchPtr, &size, &count, 4);
+    PutField(batchPtr, &size, &replacesNewest, 1);
+    PutField(batchPtr, &size, &recordCount, 4);
+
+    for (size_t i = first; i < bufferPtr->count; i++)
+    {
+        size += EncodeRecord(bufferPtr, obsPtr->bufferedType, i, batchPtr + size);
+    }
+
+    uint32_t crc = le_crc_Crc32(batchPtr + 4, payloadSize, LE_CRC_START_CRC32);
+    PutField(batchPtr, &size, &crc, 4);
+
+    jobPtr->batchPtr = batchPtr;
+    jobPtr->batchSize = size;
+    jobPtr->expectedBytes = size;
+    jobPtr->heldBytes = size;
+    QueuedBatchBytes += jobPtr->heldBytes;
+    QueueBackupJob(jobPtr);
+
+    *byteCountPtr = size;
+
+    obsPtr->journalCount += recordCount;
+    MarkBackedUp(obsPtr);
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a record replayed from a backup journal to an Observation's buffer, now that it is known
+ * not to be the newest one.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddJournalRecord
+(
+    Observation_t* obsPtr,
+    JournalRecord_t* recordPtr  ///< [IN/OUT] The record (its sample is released).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    obs_AddToBuffer(obsPtr, recordPtr->sampleRef);
+    le_mem_Release(recordPtr->sampleRef);
+    recordPtr->sampleRef = NULL;
+
+    if (bufferPtr->runLength && (bufferPtr->count > 0) && (recordPtr->runCount > 1))
+    {
+        obs_ExtendNewestRun(obsPtr, recordPtr->runEnd, recordPtr->runCount - 1);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pushes the newest record replayed from a backup journal to an Observation, so that it becomes
+ * the current value.  For a run, that is its newest sample, which the rest of the run is added to
+ * the buffer ahead of.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PushJournalRecord
+(
+    Observation_t* obsPtr,
+    JournalRecord_t* recordPtr  ///< [IN/OUT] The record (its sample is pushed).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    dataSample_Ref_t sampleRef = recordPtr->sampleRef;
+
+    recordPtr->sampleRef = NULL;
+
+    if (recordPtr->runCount > 1)
+    {
+        obs_AddToBuffer(obsPtr, sampleRef);
+        le_mem_Release(sampleRef);
+
+        if (bufferPtr->runLength && (bufferPtr->count > 0))
+        {
+            obs_ExtendNewestRun(obsPtr, recordPtr->runEnd, recordPtr->runCount - 2);
+        }
+
+        double value = obs_GetBufferedNumber(obsPtr, bufferPtr->count - 1);
+
+        if (obsPtr->bufferedType == IO_DATA_TYPE_BOOLEAN)
+        {
+            sampleRef = dataSample_CreateBoolean(recordPtr->runEnd, (value != 0));
+        }
+        else
+        {
+            sampleRef = dataSample_CreateNumeric(recordPtr->runEnd, value);
+        }
+    }
+
+    res_Push(&obsPtr->resource, obsPtr->bufferedType, "", sampleRef);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Applies one batch read from a backup journal to an Observation's buffer.  The newest record of
+ * the batch is held back, to be added when the next batch is applied or pushed when the journal
+ * has been read to the end.
+ *
+ * @return true if successful, false if the batch is malformed (and was not applied).
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ApplyJournalBatch
+(
+    Observation_t* obsPtr,
+    const uint8_t* payloadPtr,
+    size_t payloadSize,
+    JournalRecord_t* newestPtr, ///< [IN/OUT] Newest record held back (sampleRef NULL if none).
+    size_t* recordCountPtr      ///< [IN/OUT] Number of records applied so far.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    bool hasRuns = bufferPtr->runLength;
+
+    uint32_t count;
+    uint8_t replacesNewest;
+    uint32_t recordCount;
+    size_t size = 0;
+    if (   !GetField(payloadPtr, payloadSize, &size, &count, 4)
+        || !GetField(payloadPtr, payloadSize, &size, &replacesNewest, 1)
+        || !GetField(payloadPtr, payloadSize, &size, &recordCount, 4)
+        || (replacesNewest > 1)
+        || (recordCount == 0)
+        || (recordCount > count)  )
+    {
+        LE_CRIT("Malformed journal batch header.");
+        return false;
+    }
+
+    // Check that all the records are intact before applying any of them.
+    for (uint32_t i = 0; i < recordCount; i++)
+    {
+        size_t recordSize = DecodeRecord(obsPtr->bufferedType,
+                                         hasRuns,
+                                         payloadPtr + size,
+                                         payloadSize - size,
+                                         NULL,
+                                         NULL,
+                                         NULL);
+        if (recordSize == 0)
+        {
+            LE_CRIT("Malformed record %u in journal batch.", (unsigned int)i);
+            return false;
+        }
+        size += recordSize;
+    }
+    if (size != payloadSize)
+    {
+        LE_CRIT("Journal batch has %zu bytes after its records.", payloadSize - size);
+        return false;
+    }
+
+    // The maximum count must be at least the number the batch leaves in the buffer.
+    if (obsPtr->maxCount < count)
+    {
+        obsPtr->maxCount = count;
+    }
+
+    size = JOURNAL_BATCH_HEADER_BYTES;
+    for (uint32_t i = 0; i < recordCount; i++)
+    {
+        JournalRecord_t record;
+        size += DecodeRecord(obsPtr->bufferedType,
+                             hasRuns,
+                             payloadPtr + size,
+                             payloadSize - size,
+                             &record.sampleRef,
+                             &record.runCount,
+                             &record.runEnd);
+
+        // The first record may be a new version of the newest record before the batch.
+        if ((i == 0) && replacesNewest)
+        {
+            if (newestPtr->sampleRef != NULL)
+            {
+                le_mem_Release(newestPtr->sampleRef);
+                newestPtr->sampleRef = NULL;
+            }
+            else if (bufferPtr->count > 0)
+            {
+                obs_RemoveNewestFromBuffer(obsPtr);
+            }
+        }
+
+        if (newestPtr->sampleRef != NULL)
+        {
+            AddJournalRecord(obsPtr, newestPtr);
+        }
+
+        *newestPtr = record;
+    }
+
+    *recordCountPtr += recordCount;
+
+    // Drop whatever had been dropped from the buffer by the time the batch was written, counting
+    // the newest record, which is still held back.
+    obs_TruncateBuffer(obsPtr, count - 1);
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads from the journal of an Observation's backup file.
+ *
+ * @return true if successful, false if the end of the file was reached or reading failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ReadFromJournal
+(
+    int fd,
+    void* buffPtr,
+    size_t buffSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint8_t* bytePtr = buffPtr;
+
+    while (buffSize > 0)
+    {
+        ssize_t bytesRead = read(fd, bytePtr, buffSize);
+        if (bytesRead <= 0)
+        {
+            if ((bytesRead == -1) && (errno == EINTR))
+            {
+                continue;
+            }
+            if (bytesRead == -1)
+            {
+                LE_CRIT("Failed to read journal (%m).");
+            }
+            return false;
+        }
+        bytePtr += bytesRead;
+        buffSize -= bytesRead;
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Replays the journal of an Observation's backup file, which has just been restored, adding the
+ * samples in each of its intact batches to the buffer.
+ *
+ * A batch that is incomplete or fails its CRC check (e.g., because power was lost while it was
+ * being written) ends the journal, and is cut off so that the next batch can be appended.  A
+ * journal that doesn't follow the backup file (e.g., because power was lost after the backup file
+ * was rewritten but before the journal was restarted) is ignored.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReplayJournal
+(
+    Observation_t* obsPtr,
+    uint8_t version     ///< Format version of the backup file.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char path[MAX_BACKUP_FILE_PATH_BYTES];
+    if (GetBackupFilePath(path, sizeof(path), obsPtr, JOURNAL_SUFFIX) != LE_OK)
+    {
+        return;
+    }
+
+    int fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        LE_DEBUG("Unable to open '%s' (%m).", path);
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        LE_CRIT("Failed to stat '%s' (%m).", path);
+        close(fd);
+        return;
+    }
+    size_t fileSize = st.st_size;
+
+    uint8_t header[JOURNAL_HEADER_BYTES];
+    uint8_t expectedHeader[JOURNAL_HEADER_BYTES];
+    BuildJournalHeader(obsPtr, version, expectedHeader);
+    if (   !ReadFromJournal(fd, header, sizeof(header))
+        || (memcmp(header, expectedHeader, sizeof(header)) != 0)  )
+    {
+        LE_WARN("Ignoring journal '%s', which doesn't follow its backup file.", path);
+        close(fd);
+        return;
+    }
+
+    size_t offset = sizeof(header);
+    size_t recordCount = 0;
+    JournalRecord_t newest = { .sampleRef = NULL };
+
+    while ((fileSize - offset) >= (4 + JOURNAL_BATCH_HEADER_BYTES + 4))
+    {
+        uint32_t payloadSize;
+        if (   !ReadFromJournal(fd, &payloadSize, 4)
+            || (payloadSize < JOURNAL_BATCH_HEADER_BYTES)
+            || (payloadSize > (fileSize - offset - 8))  )
+        {
+            break;
+        }
+
+        // Read the payload and its CRC.
+        uint8_t* payloadPtr = obs_AllocBufferArray(payloadSize + 4);
+
+        bool isOk = ReadFromJournal(fd, payloadPtr, payloadSize + 4);
+        if (isOk)
+        {
+            uint32_t crc;
+            memcpy(&crc, payloadPtr + payloadSize, 4);
+
+            isOk = (   (crc == le_crc_Crc32(payloadPtr, payloadSize, LE_CRC_START_CRC32))
+                    && ApplyJournalBatch(obsPtr, payloadPtr, payloadSize, &newest, &recordCount));
+        }
+
+        obs_FreeBufferArray(payloadPtr);
+
+        if (!isOk)
+        {
+            break;
+        }
+
+        offset += 4 + payloadSize + 4;
+    }
+
+    bool isValid = true;
+
+    // Cut off whatever follows the last intact batch.
+    if (offset < fileSize)
+    {
+        LE_WARN("Discarding %zu bytes of torn or corrupt batches at the end of journal '%s'.",
+                fileSize - offset,
+                path);
+
+        if (ftruncate(fd, offset) != 0)
+        {
+            LE_CRIT("Failed to truncate '%s' (%m).", path);
+            isValid = false;
+        }
+    }
+
+    close(fd);
+
+    if (newest.sampleRef != NULL)
+    {
+        PushJournalRecord(obsPtr, &newest);
+    }
+
+    obsPtr->journalValid = isValid;
+    obsPtr->journalCount = recordCount;
+    MarkBackedUp(obsPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Perform a backup to non-volatile storage of an observation's data sample buffer.  The files are
+ * written by the backup writer thread, and only reach the storage once it is told to sync them.
+ *
+ * @return The number of bytes that the backup writer thread is expected to write.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t Backup
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Update the time of last backup.
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    obsPtr->lastBackupTime = now.sec;
+
+    // If possible, just append what has changed since the last backup to the journal.
+    size_t batchSize;
+    if (AppendToJournal(obsPtr, &batchSize))
+    {
+        LE_DEBUG("Backup journaled.");
+        return batchSize;
+    }
+
+    BackupJob_t* jobPtr = CreateBackupJob(obsPtr, BACKUP_JOB_WRITE);
+    if (jobPtr == NULL)
+    {
+        return 0;
+    }
+
+    // Compressed buffers are saved in compressed form (version 1), and the rest with their arrays
+    // as they are (version 3), so they can be mapped into memory when restoring.
+    jobPtr->version = (obsPtr->buffer.compressed ? 1 : COLUMN_BACKUP_VERSION);
+
+    // Note: The Resource's data type is not updated until after a new sample is buffered, so
+    //       use the type of the samples in the buffer.
+    jobPtr->dataType = obsPtr->bufferedType;
+
+    jobPtr->heldBytes = obs_TakeBufferSnapshot(obsPtr, &jobPtr->snapshot);
+    BuildJournalHeader(obsPtr, jobPtr->version, jobPtr->header);
+    jobPtr->rollupPtr = EncodeRollups(obsPtr, &jobPtr->rollupSize);
+    jobPtr->heldBytes += jobPtr->rollupSize;
+    QueuedSnapshotBytes += jobPtr->heldBytes;
+
+    size_t byteCount = GetBackupFileSize(&jobPtr->snapshot, jobPtr->dataType, jobPtr->version)
+                     + jobPtr->rollupSize
+                     + sizeof(jobPtr->header);
+    jobPtr->expectedBytes = byteCount;
+
+    QueueBackupJob(jobPtr);
+
+    // The new journal follows the new backup file.  If the writer thread fails to write them, it
+    // reports back, and the next backup starts over.
+    obsPtr->journalValid = true;
+    obsPtr->journalCount = 0;
+    MarkBackedUp(obsPtr);
+
+    LE_DEBUG("Backup queued.");
+
+    return byteCount;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Refill the backup write allowance at the rate of the write budget.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RefillWriteAllowance
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint32_t now = obs_GetRelativeTimeMs();
+
+    if (WriteBudget > 0)
+    {
+        WriteAllowance += (double)WriteBudget * (uint32_t)(now - AllowanceTime) / MS_PER_HOUR;
+
+        if (WriteAllowance > WriteBudget)
+        {
+            WriteAllowance = WriteBudget;
+        }
+    }
+
+    AllowanceTime = now;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of bytes written to backup files during the last hour.
+ *
+ * @return The number of bytes.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t GetLastHourBytes
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    UpdateWriteMinute();
+
+    uint64_t byteCount = 0;
+
+    for (size_t i = 0; i < WRITE_STATS_MINUTES; i++)
+    {
+        byteCount += MinuteBytes[i];
+    }
+
+    return byteCount;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Schedule the next backup commit for when the first pending backup becomes due, or stop the
+ * commit timer if there are no pending backups.  If the write budget has been spent, the commit
+ * is deferred until the budget allows more to be written.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_ScheduleCommit
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (le_timer_IsRunning(CommitTimer))
+    {
+        le_timer_Stop(CommitTimer);
+    }
+
+    if (le_dls_IsEmpty(&PendingBackupList))
+    {
+        return;
+    }
+
+    // Find the time at which the first pending backup is due.
+    uint32_t dueTime = UINT32_MAX;
+
+    le_dls_Link_t* linkPtr = le_dls_Peek(&PendingBackupList);
+    while (linkPtr != NULL)
+    {
+        Observation_t* obsPtr = CONTAINER_OF(linkPtr, Observation_t, backupLink);
+
+        uint32_t nextBackupTime = obsPtr->lastBackupTime + obsPtr->backupPeriod;
+        if (nextBackupTime < dueTime)
+        {
+            dueTime = nextBackupTime;
+        }
+
+        linkPtr = le_dls_PeekNext(&PendingBackupList, linkPtr);
+    }
+
+    // Overdue backups are committed after a short delay, so that others can join them.
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    uint64_t timerInterval = BACKUP_COMMIT_DELAY_MS;
+    if (dueTime > now.sec)
+    {
+        timerInterval = (uint64_t)(dueTime - now.sec) * 1000;
+    }
+
+    // If the write budget has been spent, wait until enough of it has been refilled.
+    if (WriteBudget > 0)
+    {
+        RefillWriteAllowance();
+
+        if (WriteAllowance <= 0)
+        {
+            uint64_t refillInterval = (-WriteAllowance * MS_PER_HOUR) / WriteBudget + 1;
+            if (refillInterval > timerInterval)
+            {
+                timerInterval = refillInterval;
+            }
+        }
+    }
+
+    if (timerInterval > MS_PER_HOUR)
+    {
+        timerInterval = MS_PER_HOUR;
+    }
+
+    LE_ASSERT(le_timer_SetMsInterval(CommitTimer, timerInterval) == LE_OK);
+    LE_ASSERT(le_timer_Start(CommitTimer) == LE_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue a backup of an Observation's data sample buffer, to be committed when its backup period
+ * has elapsed since its previous backup.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_Request
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (!obsPtr->isBackupPending)
+    {
+        le_dls_Queue(&PendingBackupList, &obsPtr->backupLink);
+        obsPtr->isBackupPending = true;
+
+        backup_ScheduleCommit();
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove an Observation from the list of pending backups, if it's in there.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CancelBackup
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (obsPtr->isBackupPending)
+    {
+        le_dls_Remove(&PendingBackupList, &obsPtr->backupLink);
+        obsPtr->isBackupPending = false;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Disable backups of a given Observation's data sample buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_Disable
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CancelBackup(obsPtr);
+
+    obsPtr->lastBackupTime = 0;
+
+    DeleteBackup(obsPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer expiry handler function for the backup commit timer.
+ *
+ * Backs up all the pending Observations whose backup period has elapsed, as far as the write
+ * budget allows, and then has them all synced to non-volatile storage at once.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CommitBackups
+(
+    le_timer_Ref_t timer
+)
+//--------------------------------------------------------------------------------------------------
+{
+    RefillWriteAllowance();
+
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+    size_t obsCount = 0;
+
+    le_dls_Link_t* linkPtr = le_dls_Peek(&PendingBackupList);
+    while ((linkPtr != NULL) && ((WriteBudget == 0) || (WriteAllowance > 0)))
+    {
+        Observation_t* obsPtr = CONTAINER_OF(linkPtr, Observation_t, backupLink);
+
+        linkPtr = le_dls_PeekNext(&PendingBackupList, linkPtr);
+
+        if (obsPtr->lastBackupTime + obsPtr->backupPeriod <= now.sec)
+        {
+            CancelBackup(obsPtr);
+
+            // Charge the write budget right away, so that the rest of the group (and any commit
+            // done before the writer thread catches up) stays within it.  Each job corrects the
+            // charge with the number of bytes actually written when it reports back.
+            WriteAllowance -= Backup(obsPtr);
+            obsCount++;
+        }
+    }
+
+    // Sync the group once it has been written.
+    if (obsCount > 0)
+    {
+        QueueBackupJob(CreateBackupJob(NULL, BACKUP_JOB_SYNC));
+
+        LE_DEBUG("Committing backups of %zu Observations.", obsCount);
+    }
+
+    backup_ScheduleCommit();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop backing up an Observation that is being deleted.  Its backup files are deleted, and any
+ * backup or restore of it still to be done is forgotten.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_Remove
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // If the backup hasn't been restored yet, it never will be.
+    if (obsPtr->isRestorePending)
+    {
+        le_dls_Remove(&PendingRestoreList, &obsPtr->restoreLink);
+        obsPtr->isRestorePending = false;
+    }
+
+    // If the observation had backups enabled, delete the backup file.
+    if (obsPtr->backupPeriod > 0)
+    {
+        DeleteBackup(obsPtr);
+    }
+
+    // If a backup is pending, forget about it.
+    CancelBackup(obsPtr);
+
+    // Backup writer thread jobs still in progress mustn't report back to this Observation.
+    while (!le_dls_IsEmpty(&obsPtr->backupJobList))
+    {
+        BackupJob_t* jobPtr = CONTAINER_OF(le_dls_Pop(&obsPtr->backupJobList), BackupJob_t, link);
+        jobPtr->obsPtr = NULL;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the backups of Observations' buffers.  Called by obs_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_Init
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    BackupJobPool = le_mem_CreatePool("Backup Job", sizeof(BackupJob_t));
+
+    // Start the backup writer thread, and wait for it to be ready for jobs.
+    MainThread = le_thread_GetCurrent();
+    WriterSemaphore = le_sem_Create("BackupWriter", 0);
+    WriterThread = le_thread_Create("BackupWriter", BackupWriterMain, NULL);
+    le_thread_Start(WriterThread);
+    le_sem_Wait(WriterSemaphore);
+
+    CommitTimer = le_timer_Create("backupCommit");
+    LE_ASSERT(le_timer_SetHandler(CommitTimer, CommitBackups) == LE_OK);
+
+    StartTime = obs_GetRelativeTimeMs();
+    AllowanceTime = StartTime;
+    LastWriteMinute = le_clk_GetRelativeTime().sec / 60;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore an Observation's data buffer from non-volatile backup, if one exists.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RestoreBackup
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Make sure the backup writer thread isn't still writing (or deleting) the files.
+    FlushBackupWriter();
+
+    // If there's no backup directory yet, then we know there are no backups, so don't
+    // try opening one (which would result in an error message in the logs because the lock file
+    // can't be created).
+    struct stat st = {0};
+    if (stat(BACKUP_DIR, &st) == -1)
+    {
+        LE_DEBUG("Backup directory '" BACKUP_DIR "' not found. (%m)");
+        return;
+    }
+
+    char path[MAX_BACKUP_FILE_PATH_BYTES];
+    if (GetBackupFilePath(path, sizeof(path), obsPtr, BACKUP_SUFFIX) != LE_OK)
+    {
+        return;
+    }
+
+    LE_INFO("Loading observation buffer from file '%s'.", path);
+
+    // Open the file for reading.
+    le_result_t result;
+    FILE* file = le_atomFile_OpenStream(path, LE_FLOCK_READ, &result);
+    if (result != LE_OK)
+    {
+        LE_DEBUG("Unable to open '%s' for reading (%s).", path, LE_RESULT_TXT(result));
+        return;
+    }
+
+    // Read the version byte.
+    uint8_t byte;
+    if (ReadFromFile(&byte, 1, file) != LE_OK)
+    {
+        LE_ERROR("Failed to read version byte.");
+        return;
+    }
+    uint8_t version = byte;
+    if (version > COLUMN_BACKUP_VERSION)
+    {
+        LE_CRIT("Backup file format version %d unrecognized.", (int)byte);
+        le_atomFile_CancelStream(file);
+        return;
+    }
+
+    // Version 3 files are mapped into memory and read as a whole.
+    if (version == COLUMN_BACKUP_VERSION)
+    {
+        ReadMappedFile(obsPtr, file);
+        ReplayJournal(obsPtr, version);
+        return;
+    }
+
+    // Read the data type code.
+    if (ReadFromFile(&byte, 1, file) != LE_OK)
+    {
+        LE_ERROR("Failed to read data type code.");
+        return;
+    }
+    io_DataType_t dataType;
+    if (!GetDataTypeFromCode(&dataType, byte))
+    {
+        le_atomFile_CancelStream(file);
+        return;
+    }
+    if ((version == 1) && (dataType != IO_DATA_TYPE_NUMERIC))
+    {
+        LE_CRIT("Compressed backup file has non-numeric data type code '%c'.", (char)byte);
+        le_atomFile_CancelStream(file);
+        return;
+    }
+    if (   (version == 2)
+        && (dataType != IO_DATA_TYPE_NUMERIC)
+        && (dataType != IO_DATA_TYPE_BOOLEAN)  )
+    {
+        LE_CRIT("Run-length backup file has non-numerical data type code '%c'.", (char)byte);
+        le_atomFile_CancelStream(file);
+        return;
+    }
+
+    // Runs can't be split back into their samples, so the buffer has to stay run-length encoded.
+    if (version == 2)
+    {
+        obsPtr->runLengthBuffer = true;
+    }
+    obs_SetBufferedType(obsPtr, dataType);
+
+    // Read the number of samples.
+    uint32_t count;
+    if (ReadFromFile(&count, 4, file) != LE_OK)
+    {
+        LE_ERROR("Failed to read number of samples.");
+        return;
+    }
+
+    // The maximum count must be at least the number we read.
+    if (obsPtr->maxCount == 0)
+    {
+        obsPtr->maxCount = count;
+    }
+    // NOTE: Don't enable backups, though, because we don't know the frequency to choose
+    //       and flash wear can permanently damage a device.
+
+    // Read all the data samples from the file.
+    if (version == 1)
+    {
+        ReadBlocksFromFile(obsPtr, file, count);
+    }
+    else
+    {
+        ReadSamplesFromFile(obsPtr, file, count, (version == 2));
+    }
+
+    // Then add what has been journaled since the file was written.
+    ReplayJournal(obsPtr, version);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decodes a row of a rollup tier from the contents of a rollup file.
+ *
+ * @return true if successful, false if the row runs past the end of the contents.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool DecodeRollupRow
+(
+    const uint8_t* bytesPtr,    ///< Contents being decoded.
+    size_t byteCount,   ///< Number of bytes available.
+    size_t* sizePtr,    ///< [IN/OUT] Number of bytes decoded so far.
+    RollupRow_t* rowPtr ///< [OUT] The row (NULL to skip over it).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (rowPtr == NULL)
+    {
+        return GetField(bytesPtr, byteCount, sizePtr, NULL, ROLLUP_ROW_BYTES);
+    }
+
+    return (   GetField(bytesPtr, byteCount, sizePtr, &rowPtr->startTime, 8)
+            && GetField(bytesPtr, byteCount, sizePtr, &rowPtr->count, 4)
+            && GetField(bytesPtr, byteCount, sizePtr, &rowPtr->min, 8)
+            && GetField(bytesPtr, byteCount, sizePtr, &rowPtr->max, 8)
+            && GetField(bytesPtr, byteCount, sizePtr, &rowPtr->mean, 8)
+            && GetField(bytesPtr, byteCount, sizePtr, &rowPtr->m2, 8)  );
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks that the tiers in the contents of a rollup file fill them exactly, before any of them
+ * are restored.
+ *
+ * @return true if they do, false if the contents are malformed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool CheckRollupTiers
+(
+    const uint8_t* bytesPtr,    ///< Contents of the rollup file, without the CRC.
+    size_t byteCount,   ///< Number of bytes in the contents.
+    size_t tierCount
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t size = ROLLUP_HEADER_BYTES;
+
+    for (size_t i = 0; i < tierCount; i++)
+    {
+        uint32_t bucketSeconds;
+        uint32_t maxCount;
+        uint32_t rowCount;
+        if (   !GetField(bytesPtr, byteCount, &size, &bucketSeconds, 4)
+            || !GetField(bytesPtr, byteCount, &size, &maxCount, 4)
+            || !GetField(bytesPtr, byteCount, &size, &rowCount, 4)
+            || (bucketSeconds == 0)
+            || (maxCount == 0)
+            || (rowCount > ((byteCount - size) / ROLLUP_ROW_BYTES))  )
+        {
+            return false;
+        }
+
+        // The completed rows, then the row being filled.
+        for (size_t j = 0; j <= rowCount; j++)
+        {
+            if (!DecodeRollupRow(bytesPtr, byteCount, &size, NULL))
+            {
+                return false;
+            }
+        }
+    }
+
+    return (size == byteCount);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore an Observation's rollup tiers from the rollup file next to its backup file, if there is
+ * one, then add the samples in the restored buffer that were accepted after the file was written.
+ * Tiers that the Observation doesn't have yet are added.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RestoreRollups
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char path[MAX_BACKUP_FILE_PATH_BYTES];
+    if (GetBackupFilePath(path, sizeof(path), obsPtr, ROLLUP_SUFFIX) != LE_OK)
+    {
+        return;
+    }
+
+    // Don't try opening a file that doesn't exist (which would result in an error message in the
+    // logs if the lock file can't be created).
+    struct stat st = {0};
+    if (stat(path, &st) == -1)
+    {
+        return;
+    }
+
+    le_result_t result;
+    FILE* file = le_atomFile_OpenStream(path, LE_FLOCK_READ, &result);
+    if (result != LE_OK)
+    {
+        LE_DEBUG("Unable to open '%s' for reading (%s).", path, LE_RESULT_TXT(result));
+        return;
+    }
+
+    if (fstat(fileno(file), &st) != 0)
+    {
+        LE_CRIT("Failed to stat rollup file (%m).");
+        le_atomFile_CancelStream(file);
+        return;
+    }
+
+    size_t fileSize = st.st_size;
+    if (fileSize < (ROLLUP_HEADER_BYTES + 4))
+    {
+        LE_CRIT("Rollup file '%s' was truncated.", path);
+        le_atomFile_CancelStream(file);
+        return;
+    }
+
+    uint8_t* bytesPtr = obs_AllocBufferArray(fileSize);
+
+    if (ReadFromFile(bytesPtr, fileSize, file) != LE_OK)
+    {
+        LE_ERROR("Failed to read rollup file '%s'.", path);
+        obs_FreeBufferArray(bytesPtr);
+        return;
+    }
+    le_atomFile_CancelStream(file);
+
+    size_t byteCount = fileSize - 4;
+
+    uint32_t crc;
+    memcpy(&crc, bytesPtr + byteCount, 4);
+
+    uint8_t version = bytesPtr[0];
+    uint8_t tierCount = bytesPtr[2];
+    io_DataType_t dataType;
+
+    if (crc != le_crc_Crc32(bytesPtr, byteCount, LE_CRC_START_CRC32))
+    {
+        LE_CRIT("Rollup file '%s' failed its CRC check.", path);
+    }
+    else if (version != 0)
+    {
+        LE_CRIT("Rollup file format version %d unrecognized.", (int)version);
+    }
+    else if (   !GetDataTypeFromCode(&dataType, bytesPtr[1])
+             || ((dataType != IO_DATA_TYPE_NUMERIC) && (dataType != IO_DATA_TYPE_BOOLEAN))
+             || (tierCount > MAX_ROLLUP_TIERS)
+             || !CheckRollupTiers(bytesPtr, byteCount, tierCount)  )
+    {
+        LE_CRIT("Rollup file '%s' is malformed.", path);
+    }
+    else
+    {
+        // Skip the version, data type code, tier count, and reserved bytes.
+        size_t size = 4;
+
+        double newest;
+        GetField(bytesPtr, byteCount, &size, &newest, 8);
+
+        obsPtr->rollupType = dataType;
+
+        for (size_t i = 0; i < tierCount; i++)
+        {
+            uint32_t bucketSeconds;
+            uint32_t maxCount;
+            uint32_t rowCount;
+            GetField(bytesPtr, byteCount, &size, &bucketSeconds, 4);
+            GetField(bytesPtr, byteCount, &size, &maxCount, 4);
+            GetField(bytesPtr, byteCount, &size, &rowCount, 4);
+
+            // Like the buffer's maximum count, tiers that haven't been configured yet are added.
+            RollupTier_t* tierPtr = obs_AddRollupTier(obsPtr, bucketSeconds, maxCount);
+
+            // If there are more rows than the tier retains, the oldest ones drop off.
+            for (size_t j = 0; j <= rowCount; j++)
+            {
+                RollupRow_t row;
+                DecodeRollupRow(bytesPtr, byteCount, &size, &row);
+
+                if (tierPtr != NULL)
+                {
+                    tierPtr->open = row;
+                    if (j < rowCount)
+                    {
+                        obs_CompleteRollupRow(tierPtr);
+                    }
+                }
+            }
+        }
+
+        // Catch up with the samples accepted since the file was written.
+        obs_SeedRollups(obsPtr, newest);
+    }
+
+    obs_FreeBufferArray(bytesPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore an Observation's data buffer (and rollup tiers) from backup now, if that is still waiting
+ * to be done.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_EnsureRestored
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (!obsPtr->isRestorePending)
+    {
+        return;
+    }
+
+    le_dls_Remove(&PendingRestoreList, &obsPtr->restoreLink);
+    obsPtr->isRestorePending = false;
+
+    uint32_t startTime = obs_GetRelativeTimeMs();
+
+    // The restored sample may be routed to other Observations, which get restored first.
+    bool wasRestoring = IsRestoring;
+    IsRestoring = true;
+    RestoreBackup(obsPtr);
+    RestoreRollups(obsPtr);
+    IsRestoring = wasRestoring;
+
+    RestoreCount++;
+    RestoreTime += obs_GetRelativeTimeMs() - startTime;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a backup is being restored, so that the samples being restored can be told apart
+ * from pushes.
+ *
+ * @return true if a backup is being restored.
+ */
+//--------------------------------------------------------------------------------------------------
+bool backup_IsRestoring
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return IsRestoring;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restores the backups waiting in the PendingRestoreList, for up to RESTORE_SLICE_MS, then queues
+ * itself to the event loop again if there are more.  Once they have all been restored, logs how
+ * long that took, and does any clean-up of unused backup files that was put off until then.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RestorePendingBackups
+(
+    void* param1Ptr,    ///< Not used.
+    void* param2Ptr     ///< Not used.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    IsRestoreQueued = false;
+
+    uint32_t sliceStart = obs_GetRelativeTimeMs();
+
+    le_dls_Link_t* linkPtr;
+    while ((linkPtr = le_dls_Peek(&PendingRestoreList)) != NULL)
+    {
+        if ((obs_GetRelativeTimeMs() - sliceStart) >= RESTORE_SLICE_MS)
+        {
+            IsRestoreQueued = true;
+            le_event_QueueFunction(RestorePendingBackups, NULL, NULL);
+            return;
+        }
+
+        backup_EnsureRestored(CONTAINER_OF(linkPtr, Observation_t, restoreLink));
+    }
+
+    LE_INFO("Restored %" PRIu32 " buffer backups in %" PRIu32 " ms"
+            " (%" PRIu32 " ms after start-up).",
+            RestoreCount,
+            RestoreTime,
+            obs_GetRelativeTimeMs() - StartTime);
+
+    if (IsCleanupPending)
+    {
+        obs_DeleteUnusedBackupFiles();
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore an Observation's data buffer from non-volatile backup, if one exists.
+ *
+ * The backup is queued to be restored in the background, unless the Observation is used first,
+ * in which case it is restored then.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_RestoreBackup
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    if (obsPtr->isRestorePending)
+    {
+        return;
+    }
+
+    obsPtr->isRestorePending = true;
+    le_dls_Queue(&PendingRestoreList, &obsPtr->restoreLink);
+
+    // The backup file may be left unused if the Observation doesn't get its backups enabled.
+    MayHaveUnusedBackupFiles = true;
+
+    if (!IsRestoreQueued)
+    {
+        IsRestoreQueued = true;
+        le_event_QueueFunction(RestorePendingBackups, NULL, NULL);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Make sure an Observation's data buffer has been restored from non-volatile backup, if it had
+ * one, before the Observation is used.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_CompleteRestore
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    backup_EnsureRestored(CONTAINER_OF(resPtr, Observation_t, resource));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the maximum number of bytes per hour to write to buffer backup files.
+ * See admin_SetBackupWriteBudget() for more information.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetBackupWriteBudget
+(
+    uint32_t bytesPerHour   ///< The budget, or 0 for unlimited.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (bytesPerHour != WriteBudget)
+    {
+        RefillWriteAllowance();
+
+        // Start with a full hour's worth of allowance, less what has been written in the last hour.
+        WriteBudget = bytesPerHour;
+        WriteAllowance = (double)bytesPerHour - GetLastHourBytes();
+
+        backup_ScheduleCommit();
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the maximum number of bytes per hour to write to buffer backup files.
+ *
+ * @return The budget, or 0 if unlimited.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t obs_GetBackupWriteBudget
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return WriteBudget;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the writing of buffer backup files.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_GetBackupWriteStats
+(
+    uint64_t* totalBytesPtr,    ///< [OUT] Bytes written since start-up.
+    uint64_t* lastHourBytesPtr, ///< [OUT] Bytes written during the last hour.
+    uint32_t* commitCountPtr    ///< [OUT] Number of backup commits since start-up.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    *totalBytesPtr = TotalBytesWritten;
+    *lastHourBytesPtr = GetLastHourBytes();
+    *commitCountPtr = CommitCount;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the memory held by backups waiting to be written by the backup writer thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_GetBackupMemoryStats
+(
+    uint64_t* snapshotBytesPtr, ///< [OUT] Bytes held by buffer snapshots and rollup file contents.
+    uint64_t* batchBytesPtr,    ///< [OUT] Bytes held by journal batches.
+    uint64_t* peakBytesPtr      ///< [OUT] Most bytes held by both at once since start-up.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    *snapshotBytesPtr = QueuedSnapshotBytes;
+    *batchBytesPtr = QueuedBatchBytes;
+    *peakBytesPtr = PeakQueuedBytes;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function that gets called for each file system object (file, directory, symlink, etc.) found
+ * under the backup directory.
+ *
+ * @return 0 to continue the file system tree walk, non-zero to stop.
+ */
+//--------------------------------------------------------------------------------------------------
+static int BackupDirTreeWalkCallback
+(
+    const char *fpath,      ///< File system path of the object.
+    const struct stat *sb,  ///< Ptr to the stat() info for the object.
+    int typeflag,           ///< What type of file system object we're looking at.
+    struct FTW *ftwbuf      ///< Ptr to buffer containing the basename and the nesting level.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    switch (typeflag)
+    {
+        case FTW_F:  // regular file
+        {
+            // Compute the resource tree entry path of the associated Observation.
+            const char* relPath = fpath + BACKUP_DIR_PATH_LEN;
+            const char* suffixPtr = strstr(relPath, BACKUP_SUFFIX);
+            if (suffixPtr == NULL)
+            {
+                suffixPtr = strstr(relPath, JOURNAL_SUFFIX);
+            }
+            if (suffixPtr == NULL)
+            {
+                suffixPtr = strstr(relPath, ROLLUP_SUFFIX);
+            }
+            if (suffixPtr == NULL)
+            {
+                LE_WARN("Unexpected file in backup directory. Skipping '%s'.", fpath);
+                return 0;
+            }
+            // Copy all but the suffix into the observation path.
+            size_t obsPathBytes = (suffixPtr - relPath) + sizeof("/obs/");
+            char obsPath[HUB_MAX_RESOURCE_PATH_BYTES];
+            if (obsPathBytes >= sizeof(obsPath))
+            {
+                LE_ERROR("Length of path too long. Skipping '%s'.", fpath);
+                return 0;
+            }
+            (void)snprintf(obsPath, obsPathBytes, "/obs/%s", relPath);
+
+            // If that Observation doesn't exist, or its backup period is 0, delete the file.
+            resTree_EntryRef_t entryRef = resTree_FindEntry(resTree_GetRoot(), obsPath);
+            if (   (entryRef == NULL)
+                || (resTree_GetEntryType(entryRef) != ADMIN_ENTRY_TYPE_OBSERVATION)
+                || (resTree_GetBufferBackupPeriod(entryRef) == 0)  )
+            {
+                if (unlink(fpath) != 0)
+                {
+                    LE_CRIT("Failed to delete '%s' (%m).", fpath);
+                }
+            }
+
+            return 0;
+        }
+        case FTW_D:  // directory and FTW_DEPTH was NOT specified
+
+            // This should never happen, because we specified FTW_DEPTH.
+            LE_CRIT("Received FTW_D flag for '%s'!", fpath);
+            return 0;
+
+        case FTW_DNR:   // directory that can't be read
+
+            LE_ERROR("Can't read directory '%s'", fpath);
+            return 0;
+
+        case FTW_DP:    // directory and FTW_DEPTH was specified
+        {
+            // If the directory is empty, delete it.
+            int result = rmdir(fpath);
+            if ((result == -1) && (errno != ENOTEMPTY) && (errno != EEXIST))
+            {
+                LE_CRIT("Failed to remove directory '%s' (%m).", fpath);
+            }
+            return 0;
+        }
+        case FTW_NS:     // stat() call failed on fpath
+
+            LE_CRIT("Failed to stat '%s'", fpath);
+            return 0;
+
+        case FTW_SL:     // symbolic link and FTW_PHYS specified
+
+            // This should never happen, because we didn't specify FTW_PHYS.
+            LE_CRIT("Received FTW_SL flag for '%s'!", fpath);
+            return 0;
+
+        case FTW_SLN:    // symbolic link pointing to a nonexistent file
+
+            LE_CRIT("Broken symlink found at '%s'", fpath);
+            return 0;
+    }
+
+    LE_CRIT("Unexpected type flag %d.", typeflag);
+
+    return -1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete buffer backup files that aren't being used.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_DeleteUnusedBackupFiles
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Backups waiting to be restored can't be told apart from unused ones, so wait until they
+    // have all been restored.
+    if (!le_dls_IsEmpty(&PendingRestoreList))
+    {
+        LE_DEBUG("Putting off buffer backup file clean-up until all backups are restored.");
+        IsCleanupPending = true;
+        return;
+    }
+    IsCleanupPending = false;
+
+    // Don't walk the backup directory unless something may have been left behind since the
+    // last time.
+    if (!MayHaveUnusedBackupFiles)
+    {
+        return;
+    }
+    MayHaveUnusedBackupFiles = false;
+
+    LE_DEBUG("Cleaning up unused buffer backup files.");
+
+    FlushBackupWriter();
+
+    // Walk the directory tree under the backup directory.
+    // For each file, compute the resource tree entry path of the associated Observation.
+    // If that Observation doesn't exist, delete the file.
+    // If the directory is empty (after examining all files in it), delete the directory.
+    // Note: The number of file descriptors allowed to be used is selected to prevent
+    // running into the app's open file descriptor limit, while avoiding a lot of opening
+    // and closing of directories.  Normally we don't expect a lot of depth in the Observation
+    // resource naming heirarchy, so there shouldn't be a lot of depth in the backup directory.
+    int result = nftw(BACKUP_DIR,
+                      BackupDirTreeWalkCallback,
+                      4 /* max fds */,
+                      FTW_DEPTH /* depth-first traversal */);
+    if (result != 0)
+    {
+        if (errno == ENOENT)
+        {
+            LE_DEBUG("No backup directory. Skipping backup file clean-up.");
+        }
+        else
+        {
+            LE_CRIT("Failed to traverse backup directory '%s' (%m)", BACKUP_DIR);
+        }
+    }
+}
+
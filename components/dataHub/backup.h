@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file backup.h
+ *
+ * Interface provided by the buffer backups (backup.c) to the rest of the Observation module.
+ * Requires obsInternal.h.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef BACKUP_H_INCLUDE_GUARD
+#define BACKUP_H_INCLUDE_GUARD
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the backups of Observations' buffers.  Called by obs_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_Init
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue a backup of an Observation's data sample buffer, to be committed when its backup period
+ * has elapsed since its previous backup.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_Request
+(
+    Observation_t* obsPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Schedule the next backup commit for when the first pending backup becomes due, or stop the
+ * commit timer if there are no pending backups.  If the write budget has been spent, the commit
+ * is deferred until the budget allows more to be written.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_ScheduleCommit
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Disable backups of a given Observation's data sample buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_Disable
+(
+    Observation_t* obsPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop backing up an Observation that is being deleted.  Its backup files are deleted, and any
+ * backup or restore of it still to be done is forgotten.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_Remove
+(
+    Observation_t* obsPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore an Observation's data buffer from backup now, if that is still waiting to be done.
+ */
+//--------------------------------------------------------------------------------------------------
+void backup_EnsureRestored
+(
+    Observation_t* obsPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a backup is being restored, so that the samples being restored can be told apart
+ * from pushes.
+ *
+ * @return true if a backup is being restored.
+ */
+//--------------------------------------------------------------------------------------------------
+bool backup_IsRestoring
+(
+    void
+);
+
+
+#endif // BACKUP_H_INCLUDE_GUARD
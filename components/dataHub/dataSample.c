@@ -15,10 +15,68 @@
 typedef double Timestamp_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Interning of string values is enabled by default.  Build with DATA_SAMPLE_INTERN_STRINGS set to
+ * 0 to disable it, in which case every String or JSON Data Sample created gets its own copy of
+ * the string (but equality checks still benefit from the stored hash).
+ */
+//--------------------------------------------------------------------------------------------------
+#ifndef DATA_SAMPLE_INTERN_STRINGS
+#define DATA_SAMPLE_INTERN_STRINGS 1
+#endif
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of buckets in the table of interned strings.  Legato hash maps don't grow, so this should
+ * be in the order of the number of distinct string values expected to be buffered at once, to keep
+ * the chains short.  Build with DATA_SAMPLE_INTERN_TABLE_SIZE set to override it.
+ */
+//--------------------------------------------------------------------------------------------------
+#ifndef DATA_SAMPLE_INTERN_TABLE_SIZE
+#define DATA_SAMPLE_INTERN_TABLE_SIZE 1024
+#endif
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Key used to look up a string value in the table of interned strings.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t hash;        ///< Hash of the string's contents.
+    size_t length;      ///< Length of the string, in bytes, excluding the null terminator.
+    const char* chars;  ///< Ptr to the string's contents.
+}
+StringKey_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * An immutable, reference-counted string value. String and JSON Data Samples refer to one of
+ * these instead of holding their own copy of the string, so that identical values can share the
+ * same memory and can be compared without looking at their contents.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    StringKey_t key;    ///< Hash, length and ptr to chars (below).
+    bool isInterned;    ///< true if this value is in the InternTable.
+    char chars[];       ///< The null-terminated string (allocated to fit its size class).
+}
+StringValue_t;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Data sample class. An object of this type can hold various different types of timestamped
  * data sample.
+ *
+ * This is a small, fixed-size header holding the timestamp and either an immediate (Boolean or
+ * numeric) value or a reference to a shared String Value.  This keeps copying, re-timestamping
+ * and re-typing samples O(1), no matter how big their values are.
  */
 //--------------------------------------------------------------------------------------------------
 typedef struct DataSample
@@ -32,32 +90,48 @@ typedef struct DataSample
     {
         bool boolean;
         double numeric;
-        char string[0]; ///< A string type data sample has space for the array after this struct.
-                        ///< @warning This union MUST BE the LAST MEMBER of DataSample_t.
+        StringValue_t* stringPtr;   ///< Reference to the (possibly shared) string value.
     } value;
 }
 DataSample_t;
 
-/// The maximum number of bytes in a small string, including the null terminator.
-/// Strings longer than this are considered "huge".
-#define SMALL_STRING_BYTES 300
+/// Pool of Data Sample objects that don't hold strings.
+static le_mem_PoolRef_t NonStringSamplePool = NULL;
 
-/// The number of bytes to allocate in a (small) String Data Sample Pool block.
-#define SMALL_STRING_SAMPLE_OBJECT_BYTES (offsetof(DataSample_t, value) + SMALL_STRING_BYTES)
+/// Pool of Data Sample objects that hold strings (i.e., references to String Values).
+static le_mem_PoolRef_t StringSamplePool = NULL;
 
-/// The number of bytes to allocate in a Huge String Data Sample Pool block.
-#define HUGE_STRING_SAMPLE_OBJECT_BYTES (offsetof(DataSample_t, value) + HUB_MAX_STRING_BYTES)
+/// Table of interned String Values. Key = ptr to StringKey_t, Value = ptr to StringValue_t.
+static le_hashmap_Ref_t InternTable = NULL;
 
-/// Pool of Data Sample objects that don't hold strings.
-static le_mem_PoolRef_t NonStringSamplePool = NULL;
+/// Number of times a string was found in the InternTable instead of being allocated again.
+static uint64_t InternHits = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * String Values are allocated from a set of pools, one per size class, so that
+ * the space wasted on any given string is bounded by its size class rather than by the largest
+ * permitted string.  Each class holds strings up to a power of two in length (including the null
+ * terminator), and the last class holds anything up to HUB_MAX_STRING_BYTES.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t maxStringBytes;      ///< Largest string (incl. null terminator) that fits in this class.
+    le_mem_PoolRef_t pool;      ///< Pool that the String Values in this class come from.
+    uint64_t numAllocs;         ///< Total number of String Values ever allocated from this class.
+    uint64_t totalStringBytes;  ///< Sum of string sizes (incl. terminators) of those values.
+}
+StringSizeClass_t;
+
+/// The smallest string size class, in bytes (including the null terminator).
+#define MIN_STRING_CLASS_BYTES 32
 
-/// Pool of Data Sample objects that hold strings.
-static le_mem_PoolRef_t SmallStringSamplePool = NULL;
+/// The number of string size classes: 32, 64, 128, ... 32768 bytes, plus HUB_MAX_STRING_BYTES.
+#define NUM_STRING_SIZE_CLASSES 12
 
-/// Pool of Data Sample objects that hold huge strings.
-/// @note This needs to be a separate pool because otherwise the majority case of small strings
-///       results in massive unnecessary memory consumption (internal fragmentation).
-static le_mem_PoolRef_t HugeStringSamplePool = NULL;
+/// The string size classes, ordered from smallest to largest.
+static StringSizeClass_t StringSizeClasses[NUM_STRING_SIZE_CLASSES];
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -92,8 +166,8 @@ static size_t ComputeEscapedCharLength
             break;
 
         default:
-            /* Unicode codepoint */
-            return 5;
+            /* Unicode codepoint (\uXXXX) */
+            return 6;
             break;
     }
 }
@@ -279,6 +353,65 @@ le_result_t dataSample_StringToJson
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy as much of a string as fits into a buffer, escaped for use inside a JSON string, so that a
+ * long string can be serialized a piece at a time, by calling this again with the rest of it.
+ *
+ * Only whole (escaped) characters are copied and no null-terminator is added.  The number of
+ * bytes written to the destination buffer is returned in numBytesPtr.
+ *
+ * If srcStr contains an invalid or truncated UTF-8 character, that character and the rest of
+ * the string are skipped.
+ *
+ * @return The number of bytes of srcStr that were consumed (the whole string once it's all done).
+ */
+//--------------------------------------------------------------------------------------------------
+size_t dataSample_StringToJsonPiece
+(
+    char* destStr,          ///< [OUT] Destination buffer for the escaped characters.
+    const char* srcStr,     ///< [IN] UTF-8 source string.
+    const size_t destSize,  ///< [IN] Size of the destination buffer in bytes.
+    size_t* numBytesPtr     ///< [OUT] Number of bytes written to destStr.
+)
+{
+    LE_ASSERT( (destStr != NULL) && (srcStr != NULL) && (numBytesPtr != NULL) );
+
+    size_t i = 0;
+    size_t j = 0;
+    while (srcStr[i] != '\0')
+    {
+        size_t charLength = le_utf8_NumBytesInChar(srcStr[i]);
+        size_t escapedCharLength = ComputeEscapedCharLength(srcStr[i]);
+
+        if (   (charLength == 0)
+            || (escapedCharLength == 0)
+            || (strnlen(&srcStr[i], charLength) < charLength))
+        {
+            // This is an error in the string format.  Skip the rest of the string.
+            i += strlen(&srcStr[i]);
+            break;
+        }
+
+        if (escapedCharLength + j > destSize)
+        {
+            // It will not fit in the available space, so stop.
+            break;
+        }
+
+        // EscapeCharacter() may write a null-terminator after the escaped character.
+        char escapedChar[8];
+        i += EscapeCharacter(&srcStr[i], escapedChar);
+        memcpy(&destStr[j], escapedChar, escapedCharLength);
+        j += escapedCharLength;
+    }
+
+    *numBytesPtr = j;
+
+    return i;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * JSON to String conversion
@@ -372,6 +505,109 @@ le_result_t dataSample_JsonToString
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the hash of a string's contents (32-bit FNV-1a).
+ *
+ * @return The hash.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t ComputeStringHash
+(
+    const char* chars,
+    size_t length
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t)chars[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash function for the InternTable.
+ *
+ * @return The hash that was computed when the key was created.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t HashStringKey
+(
+    const void* keyPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return ((const StringKey_t*)keyPtr)->hash;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Equality function for the InternTable.
+ *
+ * @return true if the two keys refer to strings with the same contents.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool AreStringKeysEqual
+(
+    const void* firstPtr,
+    const void* secondPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const StringKey_t* firstKeyPtr = firstPtr;
+    const StringKey_t* secondKeyPtr = secondPtr;
+
+    return (   (firstKeyPtr->hash == secondKeyPtr->hash)
+            && (firstKeyPtr->length == secondKeyPtr->length)
+            && (memcmp(firstKeyPtr->chars, secondKeyPtr->chars, firstKeyPtr->length) == 0));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Destructor function for String Values.  Removes the value from the InternTable, if it's there.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StringValueDestructor
+(
+    void* objPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    StringValue_t* valuePtr = objPtr;
+
+    if (valuePtr->isInterned)
+    {
+        le_hashmap_Remove(InternTable, &valuePtr->key);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Destructor function for String Data Samples.  Releases the String Value.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StringSampleDestructor
+(
+    void* objPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    DataSample_t* samplePtr = objPtr;
+
+    le_mem_Release(samplePtr->value.stringPtr);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Initialize the Data Sample module.
@@ -385,26 +621,120 @@ void dataSample_Init
 {
     NonStringSamplePool = le_mem_CreatePool("Data Sample", sizeof(DataSample_t));
 
-    SmallStringSamplePool = le_mem_CreatePool("Small String Sample",
-                                              SMALL_STRING_SAMPLE_OBJECT_BYTES);
+    StringSamplePool = le_mem_CreatePool("String Sample", sizeof(DataSample_t));
+    le_mem_SetDestructor(StringSamplePool, StringSampleDestructor);
+
+    InternTable = le_hashmap_Create("Interned Strings",
+                                    DATA_SAMPLE_INTERN_TABLE_SIZE,
+                                    HashStringKey,
+                                    AreStringKeysEqual);
+
+    size_t maxStringBytes = MIN_STRING_CLASS_BYTES;
+
+    for (size_t i = 0; i < NUM_STRING_SIZE_CLASSES; i++)
+    {
+        if ((i == NUM_STRING_SIZE_CLASSES - 1) || (maxStringBytes > HUB_MAX_STRING_BYTES))
+        {
+            maxStringBytes = HUB_MAX_STRING_BYTES;
+        }
+
+        char poolName[32];
+        int len = snprintf(poolName, sizeof(poolName), "String Value %zu", maxStringBytes);
+        LE_ASSERT((len >= 0) && ((size_t)len < sizeof(poolName)));
+
+        StringSizeClasses[i].maxStringBytes = maxStringBytes;
+        StringSizeClasses[i].pool = le_mem_CreatePool(poolName,
+                                                      sizeof(StringValue_t) + maxStringBytes);
+        le_mem_SetDestructor(StringSizeClasses[i].pool, StringValueDestructor);
+        StringSizeClasses[i].numAllocs = 0;
+        StringSizeClasses[i].totalStringBytes = 0;
+
+        maxStringBytes *= 2;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the smallest size class that can hold a string of a given size.
+ *
+ * @return Ptr to the size class, or NULL if the string is too big for any of them.
+ */
+//--------------------------------------------------------------------------------------------------
+static StringSizeClass_t* GetStringSizeClass
+(
+    size_t stringBytes  ///< Size of the string, including the null terminator.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    for (size_t i = 0; i < NUM_STRING_SIZE_CLASSES; i++)
+    {
+        if (stringBytes <= StringSizeClasses[i].maxStringBytes)
+        {
+            return &StringSizeClasses[i];
+        }
+    }
 
-    HugeStringSamplePool = le_mem_CreatePool("Huge String Sample",
-                                             HUGE_STRING_SAMPLE_OBJECT_BYTES);
+    return NULL;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * @return True if a given string is shorter than SMALL_STRING_BYTES, including its null terminator.
+ * Get a String Value holding a copy of a given string.  If an identical string has been interned
+ * already, a new reference to that String Value is returned instead of allocating a new one.
+ *
+ * @return Ptr to the String Value (the caller must release it when done with it).
  */
 //--------------------------------------------------------------------------------------------------
-static inline bool IsSmallString
+static StringValue_t* GetStringValue
 (
     const char* string
 )
 //--------------------------------------------------------------------------------------------------
 {
-    return (strnlen(string, SMALL_STRING_BYTES) < SMALL_STRING_BYTES);
+    StringKey_t key;
+
+    key.length = strnlen(string, HUB_MAX_STRING_BYTES);
+    key.hash = ComputeStringHash(string, key.length);
+    key.chars = string;
+
+    StringValue_t* valuePtr;
+
+#if DATA_SAMPLE_INTERN_STRINGS
+    valuePtr = le_hashmap_Get(InternTable, &key);
+    if (valuePtr != NULL)
+    {
+        InternHits++;
+        le_mem_AddRef(valuePtr);
+        return valuePtr;
+    }
+#endif
+
+    StringSizeClass_t* classPtr = GetStringSizeClass(key.length + 1);
+    if (classPtr == NULL)
+    {
+        LE_FATAL("String value longer than max permitted size of %d", HUB_MAX_STRING_BYTES);
+    }
+
+    valuePtr = le_mem_ForceAlloc(classPtr->pool);
+
+    memcpy(valuePtr->chars, string, key.length);
+    valuePtr->chars[key.length] = '\0';
+    valuePtr->key = key;
+    valuePtr->key.chars = valuePtr->chars;
+
+#if DATA_SAMPLE_INTERN_STRINGS
+    valuePtr->isInterned = true;
+    le_hashmap_Put(InternTable, &valuePtr->key, valuePtr);
+#else
+    valuePtr->isInterned = false;
+#endif
+
+    classPtr->numAllocs++;
+    classPtr->totalStringBytes += key.length + 1;
+
+    return valuePtr;
 }
 
 
@@ -426,13 +756,7 @@ static inline DataSample_t* CreateSample
 {
     DataSample_t* samplePtr = le_mem_ForceAlloc(pool);
 
-    if (timestamp == IO_NOW)
-    {
-        le_clk_Time_t currentTime = le_clk_GetAbsoluteTime();
-        timestamp = (((double)(currentTime.usec)) / 1000000) + currentTime.sec;
-    }
-
-    samplePtr->timestamp = timestamp;
+    dataSample_SetTimestamp(samplePtr, timestamp);
 
     return samplePtr;
 }
@@ -523,25 +847,8 @@ dataSample_Ref_t dataSample_CreateString
 )
 //--------------------------------------------------------------------------------------------------
 {
-    le_mem_PoolRef_t pool;
-    size_t maxSize;
-    if (IsSmallString(value))
-    {
-        pool = SmallStringSamplePool;
-        maxSize = SMALL_STRING_BYTES;
-    }
-    else
-    {
-        pool = HugeStringSamplePool;
-        maxSize = HUB_MAX_STRING_BYTES;
-    }
-
-    DataSample_t* samplePtr = CreateSample(pool, timestamp);
-
-    if (LE_OK != le_utf8_Copy(samplePtr->value.string, value, maxSize, NULL))
-    {
-        LE_FATAL("String value longer than max permitted size of %d", maxSize);
-    }
+    DataSample_t* samplePtr = CreateSample(StringSamplePool, timestamp);
+    samplePtr->value.stringPtr = GetStringValue(value);
 
     return samplePtr;
 }
@@ -641,7 +948,7 @@ const char* dataSample_GetString
 )
 //--------------------------------------------------------------------------------------------------
 {
-    return sampleRef->value.string;
+    return sampleRef->value.stringPtr->chars;
 }
 
 
@@ -662,7 +969,7 @@ const char* dataSample_GetJson
 {
     // The data type is not actually stored in the data sample itself, and
     // JSON values are stored in the same way that strings are.
-    return sampleRef->value.string;
+    return sampleRef->value.stringPtr->chars;
 }
 
 
@@ -731,13 +1038,13 @@ const le_result_t dataSample_ConvertToString
         case IO_DATA_TYPE_STRING:
         {
             // Already in String format, just copy it into the buffer.
-            return le_utf8_Copy(valueBuffPtr, sampleRef->value.string, valueBuffSize, NULL);
+            return le_utf8_Copy(valueBuffPtr, sampleRef->value.stringPtr->chars, valueBuffSize, NULL);
         }
 
         case IO_DATA_TYPE_JSON:
         {
             // We need to unescape the string
-            return dataSample_JsonToString(valueBuffPtr, sampleRef->value.string, valueBuffSize, NULL);
+            return dataSample_JsonToString(valueBuffPtr, sampleRef->value.stringPtr->chars, valueBuffSize, NULL);
         }
     }
 
@@ -814,7 +1121,7 @@ const le_result_t dataSample_ConvertToJson
             valueBuffPtr[0] = '"';
             valueBuffPtr++;
             valueBuffSize--;
-            result = dataSample_StringToJson(valueBuffPtr, sampleRef->value.string, valueBuffSize, &len);
+            result = dataSample_StringToJson(valueBuffPtr, sampleRef->value.stringPtr->chars, valueBuffSize, &len);
             if ((result != LE_OK) || (len >= (valueBuffSize - 1)))  // need 1 more for the last '"'
             {
                 return LE_OVERFLOW;
@@ -826,7 +1133,7 @@ const le_result_t dataSample_ConvertToJson
         case IO_DATA_TYPE_JSON:
 
             // Already in JSON format, just copy it into the buffer.
-            return le_utf8_Copy(valueBuffPtr, sampleRef->value.string, valueBuffSize, NULL);
+            return le_utf8_Copy(valueBuffPtr, sampleRef->value.stringPtr->chars, valueBuffSize, NULL);
     }
 
     LE_ERROR("Invalid data type %d.", dataType);
@@ -921,27 +1228,45 @@ dataSample_Ref_t dataSample_Copy
 )
 //--------------------------------------------------------------------------------------------------
 {
-    le_mem_PoolRef_t pool;
+    dataSample_Ref_t duplicate;
 
     if ((dataType == IO_DATA_TYPE_STRING) || (dataType == IO_DATA_TYPE_JSON))
     {
-        if (IsSmallString(original->value.string))
-        {
-            pool = SmallStringSamplePool;
-        }
-        else
-        {
-            pool = HugeStringSamplePool;
-        }
+        // String Values are immutable, so the copy can share the original's.
+        duplicate = le_mem_ForceAlloc(StringSamplePool);
+        le_mem_AddRef(original->value.stringPtr);
     }
     else
     {
-        pool = NonStringSamplePool;
+        duplicate = le_mem_ForceAlloc(NonStringSamplePool);
     }
 
-    dataSample_Ref_t duplicate = le_mem_ForceAlloc(pool);
+    memcpy(duplicate, original, sizeof(DataSample_t));
+
+    return duplicate;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create a copy of a Data Sample with a different timestamp.
+ *
+ * This is O(1); the copy shares the original's String Value, if it has one.
+ *
+ * @return Pointer to the new copy.
+ */
+//--------------------------------------------------------------------------------------------------
+dataSample_Ref_t dataSample_CopyWithTimestamp
+(
+    io_DataType_t dataType,
+    dataSample_Ref_t original,
+    double timestamp
+)
+//--------------------------------------------------------------------------------------------------
+{
+    dataSample_Ref_t duplicate = dataSample_Copy(dataType, original);
 
-    memcpy(duplicate, original, le_mem_GetObjectSize(pool));
+    duplicate->timestamp = timestamp;
 
     return duplicate;
 }
@@ -949,7 +1274,7 @@ dataSample_Ref_t dataSample_Copy
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the timestamp of a Data Sample.
+ * Set the timestamp of a Data Sample.  IO_NOW (0) means use the current time.
  */
 //--------------------------------------------------------------------------------------------------
 void dataSample_SetTimestamp
@@ -959,5 +1284,138 @@ void dataSample_SetTimestamp
 )
 //--------------------------------------------------------------------------------------------------
 {
+    if (timestamp == IO_NOW)
+    {
+        le_clk_Time_t currentTime = le_clk_GetAbsoluteTime();
+        timestamp = (((double)(currentTime.usec)) / 1000000) + currentTime.sec;
+    }
+
     sample->timestamp = timestamp;
 }
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change the value of a Boolean Data Sample in place.
+ *
+ * @warning Only do this if you hold the only reference to the Data Sample
+ *          (le_mem_GetRefCount() == 1), because anything else holding it expects it not to change.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataSample_SetBoolean
+(
+    dataSample_Ref_t sample,
+    bool value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    sample->value.boolean = value;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change the value of a Numeric Data Sample in place.
+ *
+ * @warning Only do this if you hold the only reference to the Data Sample
+ *          (le_mem_GetRefCount() == 1), because anything else holding it expects it not to change.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataSample_SetNumeric
+(
+    dataSample_Ref_t sample,
+    double value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    sample->value.numeric = value;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether two String or JSON Data Samples have the same value.
+ *
+ * This is O(1) unless the two values have the same hash and length but were not interned.
+ *
+ * @return true if the values are identical.
+ *
+ * @warning You had better be sure that these are both String or both JSON Data Samples.
+ */
+//--------------------------------------------------------------------------------------------------
+bool dataSample_AreStringsEqual
+(
+    dataSample_Ref_t firstRef,
+    dataSample_Ref_t secondRef
+)
+//--------------------------------------------------------------------------------------------------
+{
+    StringValue_t* firstPtr = firstRef->value.stringPtr;
+    StringValue_t* secondPtr = secondRef->value.stringPtr;
+
+    if (firstPtr == secondPtr)
+    {
+        return true;
+    }
+
+    // Identical interned strings always share the same String Value.
+    if (firstPtr->isInterned && secondPtr->isInterned)
+    {
+        return false;
+    }
+
+    return AreStringKeysEqual(&firstPtr->key, &secondPtr->key);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics for one of the String and JSON Data Sample size classes.
+ *
+ * @return
+ *  - LE_OK if successful,
+ *  - LE_OUT_OF_RANGE if the index is not a valid size class index.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t dataSample_GetSizeClassStats
+(
+    size_t index,                           ///< [IN] Size class index (0 = smallest class).
+    dataSample_SizeClassStats_t* statsPtr   ///< [OUT] Ptr to where the stats will be put.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (index >= NUM_STRING_SIZE_CLASSES)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    StringSizeClass_t* classPtr = &StringSizeClasses[index];
+
+    le_mem_PoolStats_t poolStats;
+    le_mem_GetStats(classPtr->pool, &poolStats);
+
+    statsPtr->maxStringBytes = classPtr->maxStringBytes;
+    statsPtr->numInUse = poolStats.numBlocksInUse;
+    statsPtr->maxNumInUse = poolStats.maxNumBlocksUsed;
+    statsPtr->numAllocs = classPtr->numAllocs;
+    statsPtr->totalStringBytes = classPtr->totalStringBytes;
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the interning of String and JSON Data Sample values.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataSample_GetInternStats
+(
+    size_t* numInternedPtr, ///< [OUT] Number of distinct values currently interned.
+    uint64_t* numHitsPtr    ///< [OUT] Number of times a value was shared instead of allocated.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    *numInternedPtr = le_hashmap_Size(InternTable);
+    *numHitsPtr = InternHits;
+}
@@ -19,7 +19,8 @@
 //--------------------------------------------------------------------------------------------------
 /**
  * Data Samples are reference counted memory pool objects that hold a timestamp and an
- * optional value.
+ * optional value.  String and JSON values are immutable and may be shared by several samples, so
+ * copying a sample is cheap no matter how big its value is.
  *
  * Use le_mem_AddRef() and le_mem_Release() to control the reference counts.
  *
@@ -29,6 +30,23 @@
 typedef struct DataSample* dataSample_Ref_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Statistics for one of the size classes that the values of String and JSON Data Samples are
+ * allocated from.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t maxStringBytes;      ///< Largest string (incl. null terminator) that fits in the class.
+    size_t numInUse;            ///< Number of string values from this class currently in use.
+    size_t maxNumInUse;         ///< Peak number of string values from this class in use at once.
+    uint64_t numAllocs;         ///< Total number of string values ever allocated from this class.
+    uint64_t totalStringBytes;  ///< Sum of string sizes (incl. terminators) of those values.
+}
+dataSample_SizeClassStats_t;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Initialize the Data Sample module.
@@ -268,7 +286,24 @@ dataSample_Ref_t dataSample_Copy
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the timestamp of a Data Sample.
+ * Create a copy of a Data Sample with a different timestamp.
+ *
+ * This is O(1); the copy shares the original's string value, if it has one.
+ *
+ * @return Pointer to the new copy.
+ */
+//--------------------------------------------------------------------------------------------------
+dataSample_Ref_t dataSample_CopyWithTimestamp
+(
+    io_DataType_t dataType,
+    dataSample_Ref_t original,
+    double timestamp
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the timestamp of a Data Sample.  IO_NOW (0) means use the current time.
  */
 //--------------------------------------------------------------------------------------------------
 void dataSample_SetTimestamp
@@ -277,6 +312,36 @@ void dataSample_SetTimestamp
     double timestamp
 );
 
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change the value of a Boolean Data Sample in place.
+ *
+ * @warning Only do this if you hold the only reference to the Data Sample
+ *          (le_mem_GetRefCount() == 1), because anything else holding it expects it not to change.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataSample_SetBoolean
+(
+    dataSample_Ref_t sample,
+    bool value
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change the value of a Numeric Data Sample in place.
+ *
+ * @warning Only do this if you hold the only reference to the Data Sample
+ *          (le_mem_GetRefCount() == 1), because anything else holding it expects it not to change.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataSample_SetNumeric
+(
+    dataSample_Ref_t sample,
+    double value
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Copies the string in srcStr to the start of destStr and returns the number of bytes copied (not
@@ -318,4 +383,69 @@ le_result_t dataSample_StringToJson
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy as much of a string as fits into a buffer, escaped for use inside a JSON string, so that a
+ * long string can be serialized a piece at a time.  No null-terminator is added.
+ *
+ * If srcStr contains an invalid or truncated UTF-8 character, the rest of the string is skipped.
+ *
+ * @return The number of bytes of srcStr that were consumed.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t dataSample_StringToJsonPiece
+(
+    char* destStr,          ///< [OUT] Destination buffer for the escaped characters.
+    const char* srcStr,     ///< [IN] UTF-8 source string.
+    const size_t destSize,  ///< [IN] Size of the destination buffer in bytes.
+    size_t* numBytesPtr     ///< [OUT] Number of bytes written to destStr.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether two String or JSON Data Samples have the same value.
+ *
+ * This is O(1) unless the two values have the same hash and length but were not interned.
+ *
+ * @return true if the values are identical.
+ *
+ * @warning You had better be sure that these are both String or both JSON Data Samples.
+ */
+//--------------------------------------------------------------------------------------------------
+bool dataSample_AreStringsEqual
+(
+    dataSample_Ref_t firstRef,
+    dataSample_Ref_t secondRef
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics for one of the String and JSON Data Sample size classes.
+ *
+ * @return
+ *  - LE_OK if successful,
+ *  - LE_OUT_OF_RANGE if the index is not a valid size class index.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t dataSample_GetSizeClassStats
+(
+    size_t index,                           ///< [IN] Size class index (0 = smallest class).
+    dataSample_SizeClassStats_t* statsPtr   ///< [OUT] Ptr to where the stats will be put.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the interning of String and JSON Data Sample values.
+ */
+//--------------------------------------------------------------------------------------------------
+void dataSample_GetInternStats
+(
+    size_t* numInternedPtr, ///< [OUT] Number of distinct values currently interned.
+    uint64_t* numHitsPtr    ///< [OUT] Number of times a value was shared instead of allocated.
+);
+
+
 #endif // DATA_SAMPLE_H_INCLUDE_GUARD
@@ -0,0 +1,342 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file gorilla.c
+ *
+ * Lossless compression of streams of (timestamp, numeric value) pairs.
+ *
+ * Streams are bit strings, packed most significant bit first.  The first sample is stored as the
+ * raw 64-bit patterns of its timestamp and value.  Each following sample is stored as:
+ *
+ * - its timestamp's delta-of-delta.  Timestamps are taken as their 64-bit patterns, which for
+ *   positive doubles of the same magnitude are integers that increase with time, so a steady
+ *   sampling period gives a constant delta (in units of the timestamp's least significant bit,
+ *   about 0.24 us for present-day times).  The delta-of-delta is stored as
+ *       '0'                     if it is zero
+ *       '10'   + 7-bit value    if it is in [-63, 64]
+ *       '110'  + 12-bit value   if it is in [-2047, 2048]
+ *       '1110' + 24-bit value   if it is in [-(2^23 - 1), 2^23]
+ *       '1111' + 64-bit value   otherwise
+ *   where the values are offset to be non-negative;
+ *
+ * - its value's XOR with the previous value's 64-bit pattern, stored as
+ *       '0'                     if it is zero (the value didn't change)
+ *       '10' + meaningful bits  if the meaningful bits fit in the previous XOR's window
+ *       '11' + 5-bit count of leading zeros + 6-bit count of meaningful bits (minus one)
+ *            + meaningful bits  otherwise.
+ *
+ * @Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "gorilla.h"
+
+
+/// Value of gorilla_State_t.prevLeading when there is no previous XOR window.
+#define NO_WINDOW 0xFF
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append bits to a stream.
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteBits
+(
+    uint8_t* bytesPtr,
+    size_t* bitCountPtr,    ///< [IN/OUT] Number of bits in the stream.
+    uint64_t bits,          ///< Bits to append, in the least significant bitCount bits.
+    unsigned int bitCount   ///< Number of bits to append (<= 64).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t pos = *bitCountPtr;
+
+    *bitCountPtr += bitCount;
+
+    while (bitCount > 0)
+    {
+        unsigned int room = 8 - (pos % 8);
+        unsigned int n = (bitCount < room) ? bitCount : room;
+
+        bitCount -= n;
+
+        uint8_t chunk = (bits >> bitCount) & ((1u << n) - 1);
+        bytesPtr[pos / 8] |= chunk << (room - n);
+
+        pos += n;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read bits from a stream.
+ *
+ * @return The bits, in the least significant bitCount bits.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t ReadBits
+(
+    const uint8_t* bytesPtr,
+    size_t* bitCountPtr,    ///< [IN/OUT] Number of bits read from the stream.
+    unsigned int bitCount   ///< Number of bits to read (<= 64).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t pos = *bitCountPtr;
+    uint64_t bits = 0;
+
+    *bitCountPtr += bitCount;
+
+    while (bitCount > 0)
+    {
+        unsigned int room = 8 - (pos % 8);
+        unsigned int n = (bitCount < room) ? bitCount : room;
+
+        bitCount -= n;
+
+        uint8_t chunk = (bytesPtr[pos / 8] >> (room - n)) & ((1u << n) - 1);
+        bits = (bits << n) | chunk;
+
+        pos += n;
+    }
+
+    return bits;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the 64-bit pattern of a double.
+ *
+ * @return The bit pattern.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline uint64_t ToBits
+(
+    double value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the double with a given 64-bit pattern.
+ *
+ * @return The double.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline double FromBits
+(
+    uint64_t bits
+)
+//--------------------------------------------------------------------------------------------------
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the state of an encoder or decoder, to start at the beginning of a stream.
+ */
+//--------------------------------------------------------------------------------------------------
+void gorilla_Init
+(
+    gorilla_State_t* statePtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    memset(statePtr, 0, sizeof(*statePtr));
+
+    statePtr->prevLeading = NO_WINDOW;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a sample to a stream.
+ *
+ * @warning The stream's bytes after the last bit written must be zero, and there must be room for
+ *          at least GORILLA_MAX_SAMPLE_BITS more bits.
+ */
+//--------------------------------------------------------------------------------------------------
+void gorilla_Encode
+(
+    gorilla_State_t* statePtr,  ///< [IN/OUT] Encoder state.
+    uint8_t* bytesPtr,          ///< [IN/OUT] Stream to append to.
+    double timestamp,
+    double value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t timestampBits = ToBits(timestamp);
+    uint64_t valueBits = ToBits(value);
+
+    if (statePtr->count == 0)
+    {
+        WriteBits(bytesPtr, &statePtr->bitCount, timestampBits, 64);
+        WriteBits(bytesPtr, &statePtr->bitCount, valueBits, 64);
+    }
+    else
+    {
+        // Unsigned arithmetic wraps around, so this is lossless even if the difference overflows.
+        uint64_t delta = timestampBits - statePtr->prevTimestamp;
+        int64_t deltaOfDelta = (int64_t)(delta - statePtr->prevDelta);
+
+        if (deltaOfDelta == 0)
+        {
+            WriteBits(bytesPtr, &statePtr->bitCount, 0x0, 1);
+        }
+        else if ((deltaOfDelta >= -63) && (deltaOfDelta <= 64))
+        {
+            WriteBits(bytesPtr, &statePtr->bitCount, 0x2, 2);
+            WriteBits(bytesPtr, &statePtr->bitCount, deltaOfDelta + 63, 7);
+        }
+        else if ((deltaOfDelta >= -2047) && (deltaOfDelta <= 2048))
+        {
+            WriteBits(bytesPtr, &statePtr->bitCount, 0x6, 3);
+            WriteBits(bytesPtr, &statePtr->bitCount, deltaOfDelta + 2047, 12);
+        }
+        else if ((deltaOfDelta >= -8388607) && (deltaOfDelta <= 8388608))
+        {
+            WriteBits(bytesPtr, &statePtr->bitCount, 0xE, 4);
+            WriteBits(bytesPtr, &statePtr->bitCount, deltaOfDelta + 8388607, 24);
+        }
+        else
+        {
+            WriteBits(bytesPtr, &statePtr->bitCount, 0xF, 4);
+            WriteBits(bytesPtr, &statePtr->bitCount, (uint64_t)deltaOfDelta, 64);
+        }
+
+        statePtr->prevDelta = delta;
+
+        uint64_t xor = valueBits ^ statePtr->prevValue;
+
+        if (xor == 0)
+        {
+            WriteBits(bytesPtr, &statePtr->bitCount, 0x0, 1);
+        }
+        else
+        {
+            unsigned int leading = __builtin_clzll(xor);
+            unsigned int trailing = __builtin_ctzll(xor);
+
+            // The leading zero count has to fit in 5 bits.
+            if (leading > 31)
+            {
+                leading = 31;
+            }
+
+            if (   (statePtr->prevLeading != NO_WINDOW)
+                && (leading >= statePtr->prevLeading)
+                && (trailing >= statePtr->prevTrailing)  )
+            {
+                unsigned int meaningful = 64 - statePtr->prevLeading - statePtr->prevTrailing;
+
+                WriteBits(bytesPtr, &statePtr->bitCount, 0x2, 2);
+                WriteBits(bytesPtr,
+                          &statePtr->bitCount,
+                          xor >> statePtr->prevTrailing,
+                          meaningful);
+            }
+            else
+            {
+                unsigned int meaningful = 64 - leading - trailing;
+
+                WriteBits(bytesPtr, &statePtr->bitCount, 0x3, 2);
+                WriteBits(bytesPtr, &statePtr->bitCount, leading, 5);
+                WriteBits(bytesPtr, &statePtr->bitCount, meaningful - 1, 6);
+                WriteBits(bytesPtr, &statePtr->bitCount, xor >> trailing, meaningful);
+
+                statePtr->prevLeading = leading;
+                statePtr->prevTrailing = trailing;
+            }
+        }
+    }
+
+    statePtr->prevTimestamp = timestampBits;
+    statePtr->prevValue = valueBits;
+    statePtr->count++;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the next sample from a stream.
+ *
+ * @warning The caller must know how many samples the stream holds; reading past the end of the
+ *          stream returns garbage.
+ */
+//--------------------------------------------------------------------------------------------------
+void gorilla_Decode
+(
+    gorilla_State_t* statePtr,  ///< [IN/OUT] Decoder state.
+    const uint8_t* bytesPtr,    ///< Stream to read from.
+    double* timestampPtr,       ///< [OUT] Timestamp of the sample.
+    double* valuePtr            ///< [OUT] Value of the sample.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (statePtr->count == 0)
+    {
+        statePtr->prevTimestamp = ReadBits(bytesPtr, &statePtr->bitCount, 64);
+        statePtr->prevValue = ReadBits(bytesPtr, &statePtr->bitCount, 64);
+    }
+    else
+    {
+        int64_t deltaOfDelta;
+
+        if (ReadBits(bytesPtr, &statePtr->bitCount, 1) == 0)
+        {
+            deltaOfDelta = 0;
+        }
+        else if (ReadBits(bytesPtr, &statePtr->bitCount, 1) == 0)
+        {
+            deltaOfDelta = (int64_t)ReadBits(bytesPtr, &statePtr->bitCount, 7) - 63;
+        }
+        else if (ReadBits(bytesPtr, &statePtr->bitCount, 1) == 0)
+        {
+            deltaOfDelta = (int64_t)ReadBits(bytesPtr, &statePtr->bitCount, 12) - 2047;
+        }
+        else if (ReadBits(bytesPtr, &statePtr->bitCount, 1) == 0)
+        {
+            deltaOfDelta = (int64_t)ReadBits(bytesPtr, &statePtr->bitCount, 24) - 8388607;
+        }
+        else
+        {
+            deltaOfDelta = (int64_t)ReadBits(bytesPtr, &statePtr->bitCount, 64);
+        }
+
+        statePtr->prevDelta += (uint64_t)deltaOfDelta;
+        statePtr->prevTimestamp += statePtr->prevDelta;
+
+        if (ReadBits(bytesPtr, &statePtr->bitCount, 1) != 0)
+        {
+            if (ReadBits(bytesPtr, &statePtr->bitCount, 1) != 0)
+            {
+                statePtr->prevLeading = ReadBits(bytesPtr, &statePtr->bitCount, 5);
+                unsigned int meaningful = ReadBits(bytesPtr, &statePtr->bitCount, 6) + 1;
+                statePtr->prevTrailing = 64 - statePtr->prevLeading - meaningful;
+            }
+
+            unsigned int meaningful = 64 - statePtr->prevLeading - statePtr->prevTrailing;
+            uint64_t xor = ReadBits(bytesPtr, &statePtr->bitCount, meaningful);
+
+            statePtr->prevValue ^= xor << statePtr->prevTrailing;
+        }
+    }
+
+    statePtr->count++;
+
+    *timestampPtr = FromBits(statePtr->prevTimestamp);
+    *valuePtr = FromBits(statePtr->prevValue);
+}
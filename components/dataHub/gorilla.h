@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file gorilla.h
+ *
+ * Lossless compression of streams of (timestamp, numeric value) pairs, based on the encoding
+ * used by Facebook's Gorilla time series database: timestamps are stored as variable-length
+ * deltas-of-deltas and values as variable-length XORs with the previous value.  Regularly spaced,
+ * slowly-varying sensor readings typically take a few bytes per sample instead of sixteen.
+ *
+ * Streams are written into (and read from) caller-provided byte arrays, one sample at a time.
+ * Decoding must start from the beginning of a stream, so long series are best split into blocks.
+ *
+ * @Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef GORILLA_H_INCLUDE_GUARD
+#define GORILLA_H_INCLUDE_GUARD
+
+
+/// Maximum number of bits that encoding a single sample can add to a stream.
+#define GORILLA_MAX_SAMPLE_BITS 145
+
+/// Number of bytes needed to hold a given number of bits of a stream.
+#define GORILLA_BYTES(bitCount) (((bitCount) + 7) / 8)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of an encoder or decoder, which is what it needs to know about the samples before the
+ * next one.  Encoding and decoding the same stream go through exactly the same states.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t bitCount;        ///< Number of bits written to (or read from) the stream so far.
+    size_t count;           ///< Number of samples written to (or read from) the stream so far.
+    uint64_t prevTimestamp; ///< Bit pattern of the previous sample's timestamp.
+    uint64_t prevDelta;     ///< Difference between the previous two timestamps' bit patterns.
+    uint64_t prevValue;     ///< Bit pattern of the previous sample's value.
+    uint8_t prevLeading;    ///< Leading zero bits of the previous XOR's meaningful bits.
+    uint8_t prevTrailing;   ///< Trailing zero bits of the previous XOR's meaningful bits.
+}
+gorilla_State_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the state of an encoder or decoder, to start at the beginning of a stream.
+ */
+//--------------------------------------------------------------------------------------------------
+void gorilla_Init
+(
+    gorilla_State_t* statePtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a sample to a stream.
+ *
+ * @warning The stream's bytes after the last bit written must be zero, and there must be room for
+ *          at least GORILLA_MAX_SAMPLE_BITS more bits.
+ */
+//--------------------------------------------------------------------------------------------------
+void gorilla_Encode
+(
+    gorilla_State_t* statePtr,  ///< [IN/OUT] Encoder state.
+    uint8_t* bytesPtr,          ///< [IN/OUT] Stream to append to.
+    double timestamp,
+    double value
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the next sample from a stream.
+ *
+ * @warning The caller must know how many samples the stream holds; reading past the end of the
+ *          stream returns garbage.
+ */
+//--------------------------------------------------------------------------------------------------
+void gorilla_Decode
+(
+    gorilla_State_t* statePtr,  ///< [IN/OUT] Decoder state.
+    const uint8_t* bytesPtr,    ///< Stream to read from.
+    double* timestampPtr,       ///< [OUT] Timestamp of the sample.
+    double* valuePtr            ///< [OUT] Value of the sample.
+);
+
+
+#endif // GORILLA_H_INCLUDE_GUARD
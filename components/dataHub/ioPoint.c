@@ -185,12 +185,17 @@ void ioPoint_DoTypeCoercion
     {
         case IO_DATA_TYPE_TRIGGER:
 
-            // If the pushed sample is not a trigger, then create a new trigger sample with the
-            // same timestamp as the original sample.  Otherwise no type conversion required.
-            if (fromType != IO_DATA_TYPE_TRIGGER)
+            // A trigger only has a timestamp, so Boolean and numeric samples can be used as triggers
+            // as they are.  String and JSON samples are replaced by a new trigger sample with the
+            // same timestamp as the original sample, so their values aren't kept alive needlessly.
+            if ((fromType == IO_DATA_TYPE_STRING) || (fromType == IO_DATA_TYPE_JSON))
             {
                 toSample = dataSample_CreateTrigger(timestamp);
             }
+            else
+            {
+                *dataTypePtr = toType;
+            }
             break;
 
         case IO_DATA_TYPE_BOOLEAN:
@@ -269,6 +274,19 @@ void ioPoint_DoTypeCoercion
 
         case IO_DATA_TYPE_STRING:
         {
+            if (fromType == IO_DATA_TYPE_STRING)
+            {
+                break;  // No conversion required.
+            }
+
+            // A JSON value that isn't a JSON string (e.g., an object or array) converts to a string
+            // with exactly the same contents, so the sample can be used as a String as it is.
+            if ((fromType == IO_DATA_TYPE_JSON) && (dataSample_GetJson(fromSample)[0] != '"'))
+            {
+                *dataTypePtr = toType;
+                break;
+            }
+
             char newValue[HUB_MAX_STRING_BYTES];
             if (dataSample_ConvertToString(fromSample, fromType, newValue, sizeof(newValue)) == LE_OK)
             {
@@ -284,6 +302,11 @@ void ioPoint_DoTypeCoercion
 
         case IO_DATA_TYPE_JSON:
         {
+            if (fromType == IO_DATA_TYPE_JSON)
+            {
+                break;  // No conversion required.
+            }
+
             char newValue[HUB_MAX_STRING_BYTES];
             if (dataSample_ConvertToJson(fromSample, fromType, newValue, sizeof(newValue)) == LE_OK)
             {
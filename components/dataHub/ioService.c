@@ -326,11 +326,8 @@ void io_PushTrigger
         return;
     }
 
-    // Create a Data Sample object for this new sample.
-    dataSample_Ref_t sampleRef = dataSample_CreateTrigger(timestamp);
-
-    // Push the sample to the Resource.
-    resTree_Push(resRef, IO_DATA_TYPE_TRIGGER, sampleRef);
+    // Push the value to the Resource (this reuses a recently pushed Data Sample if possible).
+    resTree_PushTrigger(resRef, timestamp);
 }
 
 
@@ -359,11 +356,8 @@ void io_PushBoolean
         return;
     }
 
-    // Create a Data Sample object for this new sample.
-    dataSample_Ref_t sampleRef = dataSample_CreateBoolean(timestamp, value);
-
-    // Push the sample to the Resource.
-    resTree_Push(resRef, IO_DATA_TYPE_BOOLEAN, sampleRef);
+    // Push the value to the Resource (this reuses a recently pushed Data Sample if possible).
+    resTree_PushBoolean(resRef, timestamp, value);
 }
 
 
@@ -392,11 +386,8 @@ void io_PushNumeric
         return;
     }
 
-    // Create a Data Sample object for this new sample.
-    dataSample_Ref_t sampleRef = dataSample_CreateNumeric(timestamp, value);
-
-    // Push the sample to the Resource.
-    resTree_Push(resRef, IO_DATA_TYPE_NUMERIC, sampleRef);
+    // Push the value to the Resource (this reuses a recently pushed Data Sample if possible).
+    resTree_PushNumeric(resRef, timestamp, value);
 }
 
 
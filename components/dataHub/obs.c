@@ -4,28 +4,8 @@
  *
  * Implementation of Observations.
  *
- * Data sample buffer backup files are kept under BACKUP_DIR.  Their file system paths relative
- * to BACKUP_DIR are the same as their resource paths relative to the /obs/ namespace in the
- * resource tree.
- *
- * The data sample buffer backup file format looks like this (little-endian byte order):
- *
- * - file format version byte = 0
- * - data type byte containing one of the following ASCII characters:
- *       t = trigger
- *       b = Boolean
- *       n = numeric
- *       s = string
- *       j = JSON
- * - number of records = 4-byte unsigned integer
- * - array of records, sorted oldest-first, each containing:
- *       - timestamp (8-byte IEEE double-precision floating point value)
- *       - value, depending on data type, as follows:
- *             t -> no value
- *             b -> 1 byte, 0 = false, 1 = true
- *             n -> 8-byte IEEE double-precision floating point value
- *             s -> 4-byte unsigned integer length, followed by string content (no null-terminator)
- *             j -> 4-byte unsigned integer length, followed by JSON string content (no term char)
+ * The backups of Observations' data sample buffers to non-volatile storage are done by
+ * backup.c.
  *
  * Copyright (C) Sierra Wireless Inc.
  */
@@ -40,75 +20,153 @@
 #include "resTree.h"
 #include "json.h"
 #include "obs.h"
-#include <ftw.h>
-
-#ifdef LEGATO_EMBEDDED
- #define BACKUP_DIR "/home/root/dataHubBackup/"
-#else
- #define BACKUP_DIR "backup/"
-#endif
-#define BACKUP_DIR_PATH_LEN (sizeof(BACKUP_DIR) - 1)
-#define BACKUP_SUFFIX ".bak"
-#define BACKUP_SUFFIX_LEN (sizeof(BACKUP_SUFFIX) - 1)
-
-#define MAX_BACKUP_FILE_PATH_BYTES (  BACKUP_DIR_PATH_LEN \
-                                    + IO_MAX_RESOURCE_PATH_LEN \
-                                    + BACKUP_SUFFIX_LEN \
-                                    + 1 /* for null terminator */ )
+#include "gorilla.h"
+#include "obsInternal.h"
+#include "backup.h"
+#include <sys/mman.h>
+
 
 /// Number of seconds in 30 years.
 #define THIRTY_YEARS 946684800.0
 
-/// Observation Resource.  Allocated from the Observation Pool.
+
+/// Format version of buffer export snapshots.
+#define EXPORT_VERSION 1
+
+/// Header of a buffer export snapshot (see query_ExportBuffer()).  The array of timestamps
+/// follows it, then the array of values, both of 8-byte doubles.
 typedef struct
 {
-    res_Resource_t resource;    ///< The base class (MUST BE FIRST).
+    char magic[4];          ///< "DHXS".
+    uint32_t version;       ///< Snapshot format version (EXPORT_VERSION).
+    uint32_t dataType;      ///< IO_DATA_TYPE_NUMERIC or IO_DATA_TYPE_BOOLEAN.
+    uint32_t reserved;      ///< Always 0.
+    uint64_t count;         ///< Number of samples.
+    uint64_t timestampsOffset;  ///< Offset of the array of timestamps from the start.
+    uint64_t valuesOffset;  ///< Offset of the array of values from the start.
+}
+ExportHeader_t;
 
-    double highLimit; ///< Filter deadband/liveband high limit; NAN = disabled.
-    double lowLimit;  ///< Filter deadband/liveband low limit; NAN = disabled.
-    double changeBy;  ///< Drop values that differ by less than this from current; NAN/0 = disabled.
+/// Number of consecutive samples in each chunk of a buffer that is cached in serialized (JSON) form
+/// for read operations.  Chunk n holds the samples with sequence numbers starting at
+/// (n * JSON_CHUNK_SAMPLES), and goes in slot (n % jsonChunkSlots) of the Observation's cache.
+/// There are enough slots for every chunk in the buffer (see GetJsonChunkSlotCount()).
+#define JSON_CHUNK_SAMPLES 32
 
-    double minPeriod; ///< Min number of seconds before accepting another value; NAN/0 = disabled.
-    uint32_t lastPushTime; ///< Time at which last push was accepted (ms, relative clock).
+/// Maximum number of bytes of JSON in a cached chunk, so that it fits wherever a single element
+/// of a read operation's output would (with a comma before it).  Bigger chunks aren't cached.
+#define JSON_CHUNK_MAX_BYTES (READ_OP_ELEMENT_BYTES - 1)
 
-    obs_TransformType_t transformType; ///< Buffer transform type
+/// Number of pools that cached chunks are allocated from.  Pool i holds chunks of up to
+/// (JSON_CHUNK_MIN_POOL_BYTES << i) bytes of JSON, except the last, which holds up to
+/// JSON_CHUNK_MAX_BYTES.
+#define JSON_CHUNK_POOL_COUNT 4
 
-    size_t maxCount;  ///< Maximum number of entries to buffer.
-    size_t count;     ///< Current number of entries in the buffer.
+/// Number of bytes of JSON that fit in the chunks of the smallest JSON chunk pool.
+#define JSON_CHUNK_MIN_POOL_BYTES 256
 
-    io_DataType_t bufferedType; ///< Data type of samples currently in the buffer.
+/// Number of pools that compressed buffer blocks are allocated from.  Pool i holds blocks of up to
+/// (COMPRESSED_BLOCK_MIN_POOL_BYTES << i) bytes of encoded samples, except the last, which holds up
+/// to COMPRESSED_BLOCK_BYTES.  The newest block of a buffer comes from the last pool, and moves to
+/// the smallest one that fits once it is full.
+#define COMPRESSED_BLOCK_POOL_COUNT 6
 
-    uint32_t backupPeriod; ///< Min time (in seconds) between non-volatile backups of the buffer.
-    uint32_t lastBackupTime; ///< Time at which last push was accepted (seconds, relative clock).
-    le_timer_Ref_t backupTimer; ///< Reference to the timer used to trigger the next backup.
+/// Number of bytes of encoded samples that fit in the blocks of the smallest compressed block pool.
+#define COMPRESSED_BLOCK_MIN_POOL_BYTES 64
 
-    le_sls_List_t sampleList; ///< Queue of buffered data samples (oldest first, newest last).
 
-    le_dls_List_t readOpList; ///< List of ongoing Read Operations on the buffered samples.
+/// Sequence number used by read operations to indicate that there is nothing more to read.
+#define NO_MORE_SAMPLES UINT64_MAX
 
-    char jsonExtraction[ADMIN_MAX_JSON_EXTRACTOR_LEN + 1]; ///< JSON extraction specifier (or "").
-}
-Observation_t;
 
+/// Each data sample in a read operation looks like the following:
+/// {"t":1537483647.125371,"v":true}
+/// String and JSON values can be up to IO_MAX_STRING_VALUE_LEN bytes long (more, once escaped),
+/// so they are written a piece at a time, after the rest of the sample.  Everything else in a
+/// read operation's output comes in elements of no more than this many bytes: the largest is a
+/// time bucket with a timestamp and four doubles, which can each be hundreds of bytes long if
+/// printed in full, non-scientific notation (though they typically won't be).
+#define READ_OP_ELEMENT_BYTES 2048
+
+/// Number of bytes of a read operation's output to gather up before writing them out.  An element
+/// that starts before this point is finished past it, so the write buffer is READ_OP_ELEMENT_BYTES
+/// longer than this.
+#define READ_OP_CHUNK_BYTES 2048
+
+/// CBOR (RFC 8949) major types, in the top three bits of an item's initial byte.
+#define CBOR_MAJOR_TYPE_TEXT 0x60
+#define CBOR_MAJOR_TYPE_MAP 0xa0
+
+/// CBOR initial bytes used in SenML-CBOR read operations.
+#define CBOR_INDEFINITE_ARRAY 0x9f
+#define CBOR_BREAK 0xff
+#define CBOR_FALSE 0xf4
+#define CBOR_TRUE 0xf5
+#define CBOR_DOUBLE 0xfb
+
+/// SenML (RFC 8428) CBOR labels, encoded as CBOR integers.
+#define SENML_LABEL_BASE_NAME 0x21  // -2
+#define SENML_LABEL_VALUE 0x02
+#define SENML_LABEL_STRING_VALUE 0x03
+#define SENML_LABEL_BOOLEAN_VALUE 0x04
+#define SENML_LABEL_TIME 0x06
 
 
-/// Object used to link a Data Sample into an Observation's buffer.
-/// Holds a reference on the Data Sample object.
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time buckets that a buffer read operation aggregates samples into.  Bucket k covers the time
+ * span [origin + k * bucketSeconds, origin + (k + 1) * bucketSeconds).
+ */
+//--------------------------------------------------------------------------------------------------
 typedef struct
 {
-    le_sls_Link_t link;  ///< Used to link into a Observation's sampleList.
-    dataSample_Ref_t sampleRef; ///< Reference to the Data Sample object.
+    query_Aggregate_t aggregates;   ///< Aggregates to write for each bucket.
+    double origin;          ///< Start time of the first bucket (seconds since the Epoch).
+    double bucketSeconds;   ///< Width of each bucket, in seconds.
+    double endTime;         ///< Samples at/after this time (seconds since the Epoch) are skipped.
 }
-BufferEntry_t;
+ReadBuckets_t;
 
 
-/// Each data sample in a read operation looks like the following:
-/// {"t":1537483647.125371,"v":true}
-/// The largest value is IO_MAX_STRING_VALUE_LEN bytes long.
-/// The timestamp is a double-precision floating point number. Doubles can be
-/// hundreds of bytes long if the maximum precision is used in non-scientific notation,
-/// but in this case they typically won't be more than 6 decimal places.
-#define READ_OP_BUFF_BYTES (IO_MAX_STRING_VALUE_LEN + 48)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Downsampling state of a buffer read operation.  The samples in the sequence number range
+ * [firstSeq, endSeq) are divided into bucketCount buckets of (nearly) equal numbers of samples,
+ * and a few representative samples are written for each bucket.
+ *
+ * For Largest-Triangle-Three-Buckets, the first and last buckets hold just the first and last
+ * samples, and each of the other buckets is represented by the sample that forms the largest
+ * triangle with the previously written sample and the average of the next bucket.
+ *
+ * For min/max decimation, each bucket is represented by its minimum and maximum samples.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    query_Downsampling_t method;    ///< Downsampling algorithm.
+    uint64_t firstSeq;      ///< Sequence number of the first sample in the range.
+    uint64_t endSeq;        ///< Sequence number after the last sample in the range.
+    size_t bucketCount;     ///< Number of buckets (0 if not downsampling).
+    size_t nextBucket;      ///< Index of the next bucket to load.
+    double prevTimestamp;   ///< Timestamp of the last sample written (LTTB only).
+    double prevValue;       ///< Value of the last sample written (LTTB only), NAN if none yet.
+}
+ReadDownsampling_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * What a buffer read operation writes.  If none of these are set, it writes the raw samples.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    ReadBuckets_t buckets;  ///< Time buckets to aggregate into (aggregates = 0 if not).
+    ReadDownsampling_t downsampling; ///< Downsampling state (bucketCount = 0 if not).
+    uint32_t rollupSeconds; ///< Bucket width of the rollup tier to read (0 if not).
+    query_Format_t format;  ///< Format to write the raw samples in.
+}
+ReadMode_t;
 
 
 //--------------------------------------------------------------------------------------------------
@@ -122,9 +180,15 @@ typedef struct
     Observation_t* obsPtr;  ///< Ptr to Observation whose buffer is being read.
     le_fdMonitor_Ref_t fdMonitor; ///< Used to get notification when the FD is clear to write.
     int fd; ///< fd to write to.
-    BufferEntry_t* nextEntryPtr; ///< Buff entry to load into write buff next (ref counted).
-    enum { START, SAMPLE, COMMA, END } state; ///< What are we supposed to write next?
-    char writeBuffer[READ_OP_BUFF_BYTES];  ///< Buffer currently being written.
+    uint64_t nextSeq; ///< Sequence number of sample to load next, or NO_MORE_SAMPLES.
+    ReadMode_t mode;  ///< What to write.
+    enum { START, SAMPLE, END, DONE } state; ///< What are we supposed to write next?
+    size_t elementCount; ///< Number of samples (or buckets, or rows) loaded so far.
+    dataSample_Ref_t spillSampleRef; ///< Sample whose value is still to be written (or NULL).
+    const char* spillTextPtr; ///< Next character of the sample's value to write.
+    bool spillEscaped;  ///< true if the value is a string to be escaped for JSON.
+    const char* spillTailPtr; ///< Next character to write after the value.
+    char writeBuffer[READ_OP_CHUNK_BYTES + READ_OP_ELEMENT_BYTES];  ///< Chunk being written.
     size_t writeLen; ///< Number of characters (excl. null terminator) in the writeBuffer.
     size_t writeOffset;   ///< Offset into the writeBuffer to write from next.
     query_ReadCompletionFunc_t handlerPtr; ///< Completion callback.
@@ -133,1354 +197,4713 @@ typedef struct
 ReadOperation_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Header in front of each array allocated by obs_AllocBufferArray(), so the number of bytes it
+ * holds can be subtracted from the count again when it is freed.  The padding members keep the
+ * array itself aligned for any of the element types stored in it.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef union
+{
+    size_t byteCount;   ///< Number of bytes in the array that follows.
+    double alignDouble;
+    uint64_t alignUint64;
+    void* alignPointer;
+}
+BufferArrayHeader_t;
+
+
 /// Pool of Observation objects.
 static le_mem_PoolRef_t ObservationPool = NULL;
 
-/// Pool of Buffer Entry objects.
-static le_mem_PoolRef_t BufferEntryPool = NULL;
-
 /// Pool to allocate ReadOperation_t object from.
 static le_mem_PoolRef_t ReadOperationPool = NULL;
 
+/// Pools to allocate cached JSON chunks (JsonChunk_t) from, smallest first.
+static le_mem_PoolRef_t JsonChunkPools[JSON_CHUNK_POOL_COUNT];
+
+/// Pools to allocate compressed buffer blocks (CompressedBlock_t) from, smallest first.
+static le_mem_PoolRef_t CompressedBlockPools[COMPRESSED_BLOCK_POOL_COUNT];
+
+/// Pool of decoded compressed buffer blocks (DecodedBlock_t).
+static le_mem_PoolRef_t DecodedBlockPool = NULL;
+
+/// Number of bytes allocated by obs_AllocBufferArray() and not freed yet, and the most there have
+/// been at once.  Guarded by BufferArrayMutex, because the backup writer thread allocates arrays.
+static size_t BufferArrayBytes = 0;
+static size_t PeakBufferArrayBytes = 0;
+static le_mutex_Ref_t BufferArrayMutex = NULL;
+
+/// Time at which this module was initialized (ms, relative clock).
+static uint32_t StartTime = 0;
+
+/// true once the first pushed sample accepted by an Observation has been logged.
+static bool IsFirstPushLogged = false;
+
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the relative time in milliseconds.
- *
- * @return the relative time (ms).
+ * Add a value to the aggregates of a block of a compressed buffer.  NAN values are left out.
  */
 //--------------------------------------------------------------------------------------------------
-static uint32_t GetRelativeTimeMs
+static void AddToBlockStats
 (
-    void
+    BlockStats_t* statsPtr,
+    double value
 )
 //--------------------------------------------------------------------------------------------------
 {
-    le_clk_Time_t structuredTime = le_clk_GetRelativeTime();
+    if (isnan(value))
+    {
+        return;
+    }
 
-    return (structuredTime.sec * 1000 + structuredTime.usec / 1000);
+    // Welford's algorithm.
+    (statsPtr->count)++;
+    double delta = value - statsPtr->mean;
+    statsPtr->mean += delta / statsPtr->count;
+    statsPtr->m2 += delta * (value - statsPtr->mean);
+    statsPtr->min = fmin(statsPtr->min, value);
+    statsPtr->max = fmax(statsPtr->max, value);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the file system path to use for the backup file for a given Observation's data sample buffer.
- *
- * @return LE_OK if successful.
+ * Combine the aggregates of a part of a compressed buffer into the aggregates of a larger range.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t GetBackupFilePath
+static void MergeBlockStats
 (
-    char* pathBuffPtr,  ///< [OUT] Ptr to where the path will be written.
-    size_t pathBuffSize,    ///< Size of the buffer in bytes.
-    Observation_t* obsPtr
+    BlockStats_t* totalPtr,         ///< [IN/OUT] Aggregates of the range.
+    const BlockStats_t* partPtr     ///< Aggregates of the part to add to the range.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    size_t len;
-    LE_ASSERT(LE_OK == le_utf8_Copy(pathBuffPtr, BACKUP_DIR, pathBuffSize, &len));
+    if (partPtr->count == 0)
+    {
+        return;
+    }
+
+    // Chan et al.'s pairwise update, which is as stable as Welford's algorithm.
+    size_t count = totalPtr->count + partPtr->count;
+    double delta = partPtr->mean - totalPtr->mean;
+    totalPtr->mean += (delta * partPtr->count) / count;
+    totalPtr->m2 += partPtr->m2
+                    + ((delta * delta) * ((double)totalPtr->count * partPtr->count) / count);
+    totalPtr->count = count;
+    totalPtr->min = fmin(totalPtr->min, partPtr->min);
+    totalPtr->max = fmax(totalPtr->max, partPtr->max);
+}
 
-    pathBuffPtr += len;
-    pathBuffSize -= len;
 
-    resTree_EntryRef_t obsNamespace = resTree_FindEntry(resTree_GetRoot(), "obs");
-    LE_ASSERT(obsNamespace != NULL);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Make sure the block of a compressed buffer that holds a given sample is decoded.
+ *
+ * @return The position of the sample in the decoded block's arrays.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t obs_LoadDecodedBlock
+(
+    SampleBuffer_t* bufferPtr,
+    size_t index    ///< Index of the sample in the buffer (0 = oldest).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    DecodedBlock_t* decodedPtr = bufferPtr->decodedPtr;
+
+    size_t position = bufferPtr->blockHead + index;
+    const CompressedBlock_t* blockPtr = bufferPtr->blocks[position / COMPRESSED_BLOCK_SAMPLES];
+    size_t offset = position % COMPRESSED_BLOCK_SAMPLES;
 
-    ssize_t result = resTree_GetPath(pathBuffPtr,
-                                     pathBuffSize,
-                                     obsNamespace,
-                                     res_GetResTreeEntry(&obsPtr->resource));
-    if (result <= 0)
+    if ((decodedPtr->blockPtr != blockPtr) || (offset >= decodedPtr->count))
     {
-        LE_CRIT("Failed to fetch Observation path for '%s' (%s).",
-                resTree_GetEntryName(res_GetResTreeEntry(&obsPtr->resource)),
-                LE_RESULT_TXT(result));
+        gorilla_State_t decoder;
+        gorilla_Init(&decoder);
 
-        return result;
-    }
+        for (size_t i = 0; i < blockPtr->count; i++)
+        {
+            gorilla_Decode(&decoder,
+                           blockPtr->bytes,
+                           &decodedPtr->timestamps[i],
+                           &decodedPtr->numbers[i]);
+        }
 
-    pathBuffPtr += result;
-    pathBuffSize -= result;
+        decodedPtr->blockPtr = blockPtr;
+        decodedPtr->count = blockPtr->count;
+    }
 
-    return le_utf8_Copy(pathBuffPtr, BACKUP_SUFFIX, pathBuffSize, NULL);
+    return offset;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Delete the observation's buffer backup file, if it exists.
+ * Get buffer entry numerical value.  This works for numeric or Boolean types only.
+ *
+ * @return The value.
  */
 //--------------------------------------------------------------------------------------------------
-static void DeleteBackup
+double obs_GetBufferedNumber
 (
-    Observation_t* obsPtr
+    Observation_t* obsPtr,
+    size_t index    ///< Index of the sample in the buffer (0 = oldest).
 )
 //--------------------------------------------------------------------------------------------------
 {
-    char path[IO_MAX_RESOURCE_PATH_LEN];
-    le_result_t result = GetBackupFilePath(path, sizeof(path), obsPtr);
-    if (result == LE_OK)
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    if (bufferPtr->compressed)
     {
-        unlink(path);
+        return bufferPtr->decodedPtr->numbers[obs_LoadDecodedBlock(bufferPtr, index)];
+    }
+    else if (obsPtr->bufferedType == IO_DATA_TYPE_NUMERIC)
+    {
+        return bufferPtr->values.numbers[obs_GetSlot(bufferPtr, index)];
+    }
+    else if (obsPtr->bufferedType == IO_DATA_TYPE_BOOLEAN)
+    {
+        if (bufferPtr->values.booleans[obs_GetSlot(bufferPtr, index)])
+        {
+            return 1.0;
+        }
+        else
+        {
+            return 0.0;
+        }
+    }
+    else
+    {
+        LE_CRIT("Non-numerical data type %d.", obsPtr->bufferedType);
+        return NAN;
     }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Buffer Entry destructor.
+ * Check whether an Observation's numeric samples are buffered using swinging door compression.
+ *
+ * @return true if a tolerance is set and the buffer holds numeric samples.
  */
 //--------------------------------------------------------------------------------------------------
-static void BufferEntryDestructor
+static inline bool IsSwingingDoorEnabled
 (
-    void* objectPtr
+    Observation_t* obsPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    BufferEntry_t* buffEntryPtr = objectPtr;
-
-    le_mem_Release(buffEntryPtr->sampleRef);
+    return ((obsPtr->bufferedType == IO_DATA_TYPE_NUMERIC) && !isnan(obsPtr->bufferTolerance));
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Terminate a read operation.
+ * Check whether an Observation's buffer min or max must be tracked for its transform.
+ * Compressed buffers don't track them, to save memory (their per-block aggregates are combined
+ * instead), and neither do swinging door buffers, whose newest sample can be replaced (the buffer
+ * is searched instead).
+ *
+ * @return true if a MIN or MAX transform is applied to a buffer that tracks them.
  */
 //--------------------------------------------------------------------------------------------------
-static void EndRead
+static inline bool IsExtremaTracked
 (
-    ReadOperation_t* opPtr,
-    le_result_t result
+    Observation_t* obsPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    if (opPtr->nextEntryPtr != NULL)
-    {
-        le_mem_Release(opPtr->nextEntryPtr);
-        opPtr->nextEntryPtr = NULL;
-    }
-
-    le_fdMonitor_Delete(opPtr->fdMonitor);
-
-    close(opPtr->fd);
-
-    opPtr->handlerPtr(result, opPtr->contextPtr);
-
-    le_dls_Remove(&opPtr->obsPtr->readOpList, &opPtr->link);
-
-    le_mem_Release(opPtr);
+    return (   (   (obsPtr->transformType == OBS_TRANSFORM_TYPE_MIN)
+                || (obsPtr->transformType == OBS_TRANSFORM_TYPE_MAX)  )
+            && !obsPtr->buffer.compressed
+            && !IsSwingingDoorEnabled(obsPtr));
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Observation destructor.
+ * Add a sample that has just been added to the newest end of an Observation's buffer to the back
+ * of its extrema queue, dropping the candidates before it that can no longer become the min (or
+ * max).
  */
 //--------------------------------------------------------------------------------------------------
-static void ObservationDestructor
+static void PushExtremaCandidate
 (
-    void* objectPtr
+    Observation_t* obsPtr,
+    size_t index,   ///< Index of the sample in the buffer (0 = oldest).
+    double value    ///< Value of the sample (not NAN).
 )
 //--------------------------------------------------------------------------------------------------
 {
-    Observation_t* obsPtr = objectPtr;
-
-    // Delete all the buffered data samples.
-    le_sls_Link_t* linkPtr;
-    while (NULL != (linkPtr = le_sls_Pop(&obsPtr->sampleList)))
-    {
-        BufferEntry_t* buffEntryPtr = CONTAINER_OF(linkPtr, BufferEntry_t, link);
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    ExtremaQueue_t* queuePtr = &obsPtr->extrema;
 
-        le_mem_Release(buffEntryPtr);
-    }
-
-    obsPtr->count = 0;
-    obsPtr->maxCount = 0;
+    // Samples at the back of the queue that are no more extreme than the new one can never
+    // become the min (or max), because they will be dropped from the buffer before it is.
+    bool isMax = (obsPtr->transformType == OBS_TRANSFORM_TYPE_MAX);
 
-    // If the observation had backups enabled, delete the backup file.
-    if (obsPtr->backupPeriod > 0)
+    while (queuePtr->count > 0)
     {
-        DeleteBackup(obsPtr);
-    }
+        size_t backPos = (queuePtr->head + queuePtr->count - 1) % bufferPtr->capacity;
+        double backValue = obs_GetBufferedNumber(obsPtr,
+                                                 queuePtr->seqs[backPos] - bufferPtr->firstSeq);
 
-    // If there are read operations in progress, end them.
-    while (le_dls_IsEmpty(&obsPtr->readOpList) == false)
-    {
-        EndRead(CONTAINER_OF(le_dls_Peek(&obsPtr->readOpList), ReadOperation_t, link),
-                LE_COMM_ERROR);
+        if (isMax ? (backValue > value) : (backValue < value))
+        {
+            break;
+        }
+
+        queuePtr->count--;
     }
 
-    res_Destruct(&obsPtr->resource);
+    size_t pos = (queuePtr->head + queuePtr->count) % bufferPtr->capacity;
+    queuePtr->seqs[pos] = bufferPtr->firstSeq + index;
+    queuePtr->count++;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the first (oldest) buffer entry in an Observation's data sample buffer.
- *
- * @return Pointer to the buffer entry or NULL if the buffer is empty.
+ * Update an Observation's running aggregates to include a sample that has just been added to
+ * the newest end of its buffer.
  */
 //--------------------------------------------------------------------------------------------------
-static BufferEntry_t* GetOldestBufferEntry
+static void AddToRunningAggregates
 (
     Observation_t* obsPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    le_sls_Link_t* linkPtr = le_sls_Peek(&obsPtr->sampleList);
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    RunningStats_t* statsPtr = &obsPtr->runningStats;
+
+    size_t index = bufferPtr->count - 1;
+    double value = obs_GetBufferedNumber(obsPtr, index);
 
-    if (linkPtr != NULL)
+    if (isnan(value))
     {
-        return CONTAINER_OF(linkPtr, BufferEntry_t, link);
+        return;
     }
-    else
+
+    // Welford's algorithm.
+    statsPtr->count++;
+    double delta = value - statsPtr->mean;
+    statsPtr->mean += delta / statsPtr->count;
+    statsPtr->m2 += delta * (value - statsPtr->mean);
+    if (statsPtr->m2 > statsPtr->m2Peak)
     {
-        return NULL;
+        statsPtr->m2Peak = statsPtr->m2;
+    }
+
+    if (IsExtremaTracked(obsPtr))
+    {
+        PushExtremaCandidate(obsPtr, index, value);
     }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the next (newer) buffer entry in an Observation's data sample buffer.
- *
- * @return A pointer to the buffer entry, or NULL if there are no newer samples in the buffer.
+ * Update an Observation's running mean and variance to exclude a sample that is about to be
+ * dropped from the oldest end of its buffer.  A run of samples is removed as a whole.
  */
 //--------------------------------------------------------------------------------------------------
-static BufferEntry_t* GetNextBufferEntry
+static void RemoveFromRunningStats
 (
     Observation_t* obsPtr,
-    BufferEntry_t* buffEntryPtr
+    size_t index    ///< Index of the sample in the buffer (0 = oldest).
 )
 //--------------------------------------------------------------------------------------------------
 {
-    le_sls_Link_t* linkPtr = le_sls_PeekNext(&obsPtr->sampleList, &buffEntryPtr->link);
+    RunningStats_t* statsPtr = &obsPtr->runningStats;
+
+    double value = obs_GetBufferedNumber(obsPtr, index);
+    uint32_t weight = obs_GetBufferedWeight(&obsPtr->buffer, index);
+
+    if (isnan(value))
+    {
+        return;
+    }
+
+    statsPtr->count -= weight;
+    statsPtr->removals++;
 
-    if (linkPtr != NULL)
+    if (statsPtr->count == 0)
     {
-        return CONTAINER_OF(linkPtr, BufferEntry_t, link);
+        statsPtr->mean = 0;
+        statsPtr->m2 = 0;
     }
     else
     {
-        return NULL;
+        // Welford's algorithm, in reverse (with the run's samples all removed at once).
+        double delta = value - statsPtr->mean;
+        statsPtr->mean -= (delta * weight) / statsPtr->count;
+        statsPtr->m2 -= delta * (value - statsPtr->mean) * weight;
     }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Load the write buffer with a JSON representation of the next sample to be read.
+ * Recompute an Observation's running mean and variance from scratch.
  *
- * @return true if successful, false if there are no more samples.
+ * Removing values from Welford's sums accumulates rounding error, so this is done each time as
+ * many values have been removed as the buffer holds, which keeps the amortized cost of a push
+ * constant.  It is also done when the variance collapses by orders of magnitude (e.g., after a
+ * burst of outliers leaves the buffer), because the error left over from the larger sums would
+ * then swamp the remaining variance.
  */
 //--------------------------------------------------------------------------------------------------
-static bool LoadReadOpBuffer
+static void RebuildRunningStats
 (
-    ReadOperation_t* opPtr
+    Observation_t* obsPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    opPtr->writeLen = 0;
-    opPtr->writeOffset = 0;
-    opPtr->writeBuffer[0] = '\0';
+    RunningStats_t* statsPtr = &obsPtr->runningStats;
 
-    do
+    memset(statsPtr, 0, sizeof(*statsPtr));
+
+    for (size_t i = 0; i < obsPtr->buffer.count; i++)
     {
-        if (opPtr->nextEntryPtr == NULL)
-        {
-            return false;
-        }
+        double value = obs_GetBufferedNumber(obsPtr, i);
 
-        // If the buffer entry's ref count should be 2.  If it is only 1, then we know it has
-        // fallen off the end of the observation's buffer, which means that all entries in the
-        // observation's buffer are now newer than this one.
-        if (le_mem_GetRefCount(opPtr->nextEntryPtr) == 1)
+        if (!isnan(value))
         {
-            le_mem_Release(opPtr->nextEntryPtr);
-            opPtr->nextEntryPtr = GetOldestBufferEntry(opPtr->obsPtr);
-            if (opPtr->nextEntryPtr != NULL)
-            {
-                le_mem_AddRef(opPtr->nextEntryPtr);
-            }
-            else
-            {
-                return false;
-            }
-        }
+            uint32_t weight = obs_GetBufferedWeight(&obsPtr->buffer, i);
 
-        int len = snprintf(opPtr->writeBuffer,
-                           sizeof(opPtr->writeBuffer),
-                           "{\"t\":%lf,\"v\":",
-                           dataSample_GetTimestamp(opPtr->nextEntryPtr->sampleRef));
-        if (len >= sizeof(opPtr->writeBuffer))
-        {
-            LE_CRIT("Buffer overflow. Skipping entry.");
-            // Leave the writeLen 0 so we'll loop around and try the next sample.
+            statsPtr->count += weight;
+            double delta = value - statsPtr->mean;
+            statsPtr->mean += (delta * weight) / statsPtr->count;
+            statsPtr->m2 += delta * (value - statsPtr->mean) * weight;
         }
-        else
-        {
-            // Copy the JSON version of the contents of the current buffer entry's data into
-            // the write buffer, if there's space (leaving room for an additional '}' at the end).
-            le_result_t result = dataSample_ConvertToJson(opPtr->nextEntryPtr->sampleRef,
-                                                          res_GetDataType(&(opPtr->obsPtr->resource)),
-                                                          opPtr->writeBuffer + len,
-                                                          sizeof(opPtr->writeBuffer) - len - 1);
-            if (result != LE_OK)
-            {
-                LE_ERROR("JSON value doesn't fit in write buffer. Skipping.");
-                // Leave the writeLen 0 so we'll loop around and try the next sample.
-            }
-            else
-            {
-                len += strlen(opPtr->writeBuffer + len);
+    }
 
-                opPtr->writeBuffer[len] = '}';
-                opPtr->writeBuffer[len + 1] = '\0';
+    statsPtr->m2Peak = statsPtr->m2;
+}
 
-                opPtr->writeLen = len + 1;
-            }
-        }
 
-        // Advance the nextEntryPtr to the next entry in the Observation's data sample list.
-        BufferEntry_t* nextEntryPtr = GetNextBufferEntry(opPtr->obsPtr, opPtr->nextEntryPtr);
-        le_mem_Release(opPtr->nextEntryPtr);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Rebuild an Observation's extrema queue from scratch, after samples have been put into its
+ * buffer without going through AddToRunningAggregates().
+ */
+//--------------------------------------------------------------------------------------------------
+static void RebuildExtremaQueue
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ExtremaQueue_t* queuePtr = &obsPtr->extrema;
+
+    queuePtr->head = 0;
+    queuePtr->count = 0;
 
-        if (nextEntryPtr != NULL)
-        {
-            opPtr->nextEntryPtr = nextEntryPtr;
-            le_mem_AddRef(nextEntryPtr);
-        }
-        else
-        {
-            opPtr->nextEntryPtr = NULL;
-        }
+    if (!IsExtremaTracked(obsPtr))
+    {
+        return;
+    }
 
-    } while (opPtr->writeLen == 0); // Loop if the write buffer is still empty.
+    for (size_t i = 0; i < obsPtr->buffer.count; i++)
+    {
+        double value = obs_GetBufferedNumber(obsPtr, i);
 
-    return true;
+        if (!isnan(value))
+        {
+            PushExtremaCandidate(obsPtr, i, value);
+        }
+    }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Write to an unbuffered file descriptor.
+ * Get the numerical value in a given slot of an Observation's numeric or Boolean buffer.
  *
- * @return The number of bytes written.  -1 on error (errno is set).
+ * @return The value.
  */
 //--------------------------------------------------------------------------------------------------
-static ssize_t WriteToFd
+static inline double GetSlotNumber
 (
-    int fd,
-    const void* buffPtr,
-    size_t byteCount
+    Observation_t* obsPtr,
+    size_t slot
 )
 //--------------------------------------------------------------------------------------------------
 {
-    ssize_t result;
-
-    LE_ASSERT(buffPtr != NULL);
-
-    do
+    if (obsPtr->bufferedType == IO_DATA_TYPE_NUMERIC)
     {
-        result = write(fd, buffPtr, byteCount);
-
-    } while ((result == -1) && (errno == EINTR));
+        return obsPtr->buffer.values.numbers[slot];
+    }
 
-    return result;
+    return (obsPtr->buffer.values.booleans[slot] ? 1.0 : 0.0);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Continue a read operation.
+ * Get the value of a node in one of an Observation's range index segment trees.  Nodes numbered
+ * from the buffer capacity upwards are leaves, which are the values in the buffer slots.
+ *
+ * @return The value (NAN if none).
  */
 //--------------------------------------------------------------------------------------------------
-static void ContinueReadOp
+static inline double GetTreeNode
 (
-    ReadOperation_t* opPtr
+    Observation_t* obsPtr,
+    const double* nodes,    ///< Internal nodes of the tree.
+    size_t node
 )
 //--------------------------------------------------------------------------------------------------
 {
-    ssize_t result;
-    for (;;)
+    size_t capacity = obsPtr->buffer.capacity;
+
+    if (node < capacity)
     {
-        const char* writeBuffPtr = NULL;
-        size_t writeLen = 0;
+        return nodes[node];
+    }
 
-        // Figure out what to write based on the state.
-        switch (opPtr->state)
-        {
-            case START:
+    return GetSlotNumber(obsPtr, node - capacity);
+}
 
-                writeBuffPtr = "[";
-                writeLen = 1;
 
-                break;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Recompute the internal nodes of an Observation's range index segment trees on the path from
+ * a given buffer slot to the root, after the value in that slot has changed.
+ */
+//--------------------------------------------------------------------------------------------------
+static void UpdateRangeIndexTrees
+(
+    Observation_t* obsPtr,
+    size_t slot
+)
+//--------------------------------------------------------------------------------------------------
+{
+    RangeIndex_t* indexPtr = &obsPtr->rangeIndex;
 
-            case SAMPLE:
+    // Note: fmin() and fmax() ignore NAN operands.
+    for (size_t node = (slot + obsPtr->buffer.capacity) / 2; node > 0; node /= 2)
+    {
+        indexPtr->minNodes[node] = fmin(GetTreeNode(obsPtr, indexPtr->minNodes, 2 * node),
+                                        GetTreeNode(obsPtr, indexPtr->minNodes, 2 * node + 1));
+        indexPtr->maxNodes[node] = fmax(GetTreeNode(obsPtr, indexPtr->maxNodes, 2 * node),
+                                        GetTreeNode(obsPtr, indexPtr->maxNodes, 2 * node + 1));
+    }
+}
 
-                writeBuffPtr = opPtr->writeBuffer + opPtr->writeOffset;
-                writeLen = opPtr->writeLen - opPtr->writeOffset;
 
-                break;
-
-            case COMMA:
+//--------------------------------------------------------------------------------------------------
+/**
+ * Recompute all the internal nodes of an Observation's range index segment trees.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RebuildRangeIndexTrees
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    RangeIndex_t* indexPtr = &obsPtr->rangeIndex;
 
-                writeBuffPtr = ",";
-                writeLen = 1;
+    for (size_t node = obsPtr->buffer.capacity - 1; node > 0; node--)
+    {
+        indexPtr->minNodes[node] = fmin(GetTreeNode(obsPtr, indexPtr->minNodes, 2 * node),
+                                        GetTreeNode(obsPtr, indexPtr->minNodes, 2 * node + 1));
+        indexPtr->maxNodes[node] = fmax(GetTreeNode(obsPtr, indexPtr->maxNodes, 2 * node),
+                                        GetTreeNode(obsPtr, indexPtr->maxNodes, 2 * node + 1));
+    }
+}
 
-                break;
 
-            case END:
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the minimum or maximum of the values in a contiguous range of buffer slots from one of an
+ * Observation's range index segment trees.
+ *
+ * @return The value, or NAN if there are no non-NAN values in the range.
+ */
+//--------------------------------------------------------------------------------------------------
+static double QueryRangeIndexTree
+(
+    Observation_t* obsPtr,
+    bool isMax,         ///< true = query the max tree, false = query the min tree.
+    size_t startSlot,   ///< First slot in the range.
+    size_t endSlot      ///< Slot after the last slot in the range.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const double* nodes = isMax ? obsPtr->rangeIndex.maxNodes : obsPtr->rangeIndex.minNodes;
+    size_t capacity = obsPtr->buffer.capacity;
 
-                writeBuffPtr = "]";
-                writeLen = 1;
+    double result = NAN;
 
-                break;
+    for (size_t left = startSlot + capacity, right = endSlot + capacity;
+         left < right;
+         left /= 2, right /= 2)
+    {
+        if (left & 1)
+        {
+            double value = GetTreeNode(obsPtr, nodes, left++);
+            result = isMax ? fmax(result, value) : fmin(result, value);
         }
-
-        // Write and check for errors.
-        result = WriteToFd(opPtr->fd, writeBuffPtr, writeLen);
-        if (result == -1)
+        if (right & 1)
         {
-            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
-            {
-                // Return and wait for this function to be called again by the FD Monitor.
-                return;
-            }
+            double value = GetTreeNode(obsPtr, nodes, --right);
+            result = isMax ? fmax(result, value) : fmin(result, value);
+        }
+    }
 
-            LE_ERROR("Error writing (%m).");
-            EndRead(opPtr, LE_COMM_ERROR);
+    return result;
+}
 
-            return;
-        }
 
-        // Advance to the next state.
-        switch (opPtr->state)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Recompute an Observation's range index sums from the oldest buffered sample, re-centering
+ * the shift on the current mean.  This keeps the magnitude of the cumulative sums bounded as
+ * samples flow through the buffer, and is done each time as many samples have been dropped as
+ * the buffer holds, so the amortized cost of a push is constant.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RebuildRangeIndexSums
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    RangeIndex_t* indexPtr = &obsPtr->rangeIndex;
+
+    if (obsPtr->runningStats.count > 0)
+    {
+        indexPtr->shift = obsPtr->runningStats.mean;
+    }
+
+    double sum = 0;
+    double sumOfSquares = 0;
+    uint32_t count = 0;
+
+    for (size_t i = 0; i < bufferPtr->count; i++)
+    {
+        size_t slot = obs_GetSlot(bufferPtr, i);
+        double value = GetSlotNumber(obsPtr, slot);
+
+        if (!isnan(value))
         {
-            case START:
+            uint32_t weight = obs_GetBufferedWeight(bufferPtr, i);
+            double diff = value - indexPtr->shift;
+            sum += diff * weight;
+            sumOfSquares += diff * diff * weight;
+            count += weight;
+        }
 
-                // If there's a sample in the write buffer,
-                if (opPtr->writeLen > 0)
-                {
-                    opPtr->state = SAMPLE;
-                }
-                else
-                {
-                    opPtr->state = END;
-                }
-                break;
+        indexPtr->sums[slot] = sum;
+        indexPtr->sumsOfSquares[slot] = sumOfSquares;
+        indexPtr->counts[slot] = count;
+    }
 
-            case SAMPLE:
+    indexPtr->baseSum = 0;
+    indexPtr->baseSumOfSquares = 0;
+    indexPtr->baseCount = 0;
+    indexPtr->drops = 0;
+}
 
-                // Update the write offset.
-                opPtr->writeOffset += result;
 
-                // If the write buffer has been written entirely,
-                if (opPtr->writeOffset == opPtr->writeLen)
-                {
-                    // Try to load the next sample into the write buffer.
-                    if (LoadReadOpBuffer(opPtr))
-                    {
-                        opPtr->state = COMMA;
-                    }
-                    else
-                    {
-                        opPtr->state = END;
-                    }
-                }
-                // Note: If the write buffer has not been written entirely, stay in the SAMPLE
-                // state and loop back around to write more.
-                break;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update an Observation's range index to include a sample that has just been added to the newest
+ * end of its buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddToRangeIndex
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    RangeIndex_t* indexPtr = &obsPtr->rangeIndex;
+
+    // Compressed buffers have no per-slot index (queries scan the blocks instead), but the shift
+    // is still needed for the sums those scans produce.
+    if (bufferPtr->compressed)
+    {
+        if (isnan(indexPtr->shift))
+        {
+            indexPtr->shift = obs_GetBufferedNumber(obsPtr, bufferPtr->count - 1);
+        }
+        return;
+    }
 
-            case COMMA:
+    size_t slot = obs_GetSlot(bufferPtr, bufferPtr->count - 1);
+    double value = GetSlotNumber(obsPtr, slot);
 
-                opPtr->state = SAMPLE;
-                break;
+    double sum = indexPtr->baseSum;
+    double sumOfSquares = indexPtr->baseSumOfSquares;
+    uint32_t count = indexPtr->baseCount;
 
-            case END:
+    if (bufferPtr->count > 1)
+    {
+        size_t prevSlot = obs_GetSlot(bufferPtr, bufferPtr->count - 2);
 
-                EndRead(opPtr, LE_OK);
+        sum = indexPtr->sums[prevSlot];
+        sumOfSquares = indexPtr->sumsOfSquares[prevSlot];
+        count = indexPtr->counts[prevSlot];
+    }
 
-                return;
+    if (!isnan(value))
+    {
+        if (isnan(indexPtr->shift))
+        {
+            indexPtr->shift = value;
         }
+
+        double diff = value - indexPtr->shift;
+        sum += diff;
+        sumOfSquares += diff * diff;
+        count++;
     }
+
+    indexPtr->sums[slot] = sum;
+    indexPtr->sumsOfSquares[slot] = sumOfSquares;
+    indexPtr->counts[slot] = count;
+
+    UpdateRangeIndexTrees(obsPtr, slot);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Event handler call-back for events on a read operation's write file descriptor.
+ * Rebuild the running aggregates and indexes of an Observation's buffer from scratch, after its
+ * arrays have been filled in directly rather than a sample at a time.
  */
 //--------------------------------------------------------------------------------------------------
-static void ReadOpFdEventHandler
+void obs_RebuildAggregates
 (
-    int fd,
-    short events
+    Observation_t* obsPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    ReadOperation_t* opPtr = le_fdMonitor_GetContextPtr();
-
-    // Check for error or hang-up.
-    if ((events & POLLERR) || (events & POLLHUP) || (events & POLLRDHUP))
-    {
-        LE_ERROR("Error or hang-up on output stream.");
-        EndRead(opPtr, LE_COMM_ERROR);
-    }
-    // Note: The only other reason for this function to be called is POLLOUT (writeable).
-    else
+    if (obs_IsBufferNumerical(obsPtr))
     {
-        ContinueReadOp(opPtr);
+        RebuildRunningStats(obsPtr);
+        RebuildRangeIndexSums(obsPtr);
+        RebuildRangeIndexTrees(obsPtr);
+        RebuildExtremaQueue(obsPtr);
     }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Start a read operation on a given Observation's buffer.
+ * Get the aggregates of the values from a given sample to the newest end of an Observation's
+ * compressed buffer, to get what the range index would provide for an uncompressed one.  Whole
+ * blocks contribute their stored aggregates, so only a block that the range starts part way
+ * through (including an oldest block that has had samples dropped from it) has to be decoded.
  */
 //--------------------------------------------------------------------------------------------------
-static void StartRead
+static void ScanCompressedRange
 (
     Observation_t* obsPtr,
-    BufferEntry_t* startPtr, ///< Ptr to buffer entry to start at, or NULL if read data set empty.
-    int outputFile, ///< File descriptor to write the data to.
-    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
-    void* contextPtr    ///< Value to be passed to completion callback.
+    size_t startIndex,          ///< Index of the first sample in the range (0 = oldest).
+    BlockStats_t* statsPtr      ///< [OUT] Aggregates of the non-NAN values in the range.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    // Set the fd non-blocking
-    if (0 != fcntl(outputFile, F_SETFL, O_NONBLOCK))
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    memset(statsPtr, 0, sizeof(*statsPtr));
+    statsPtr->min = NAN;
+    statsPtr->max = NAN;
+
+    if (startIndex >= bufferPtr->count)
     {
-        LE_ERROR("Failed to activate non-blocking mode (%m).");
-        handlerPtr(LE_COMM_ERROR, contextPtr);
         return;
     }
 
-    ReadOperation_t* opPtr = le_mem_ForceAlloc(ReadOperationPool);
-
-    opPtr->link = LE_DLS_LINK_INIT;
-    le_dls_Queue(&obsPtr->readOpList, &opPtr->link);
+    size_t position = bufferPtr->blockHead + startIndex;
+    size_t blockIndex = position / COMPRESSED_BLOCK_SAMPLES;
 
-    opPtr->obsPtr = obsPtr;
+    size_t offset = position % COMPRESSED_BLOCK_SAMPLES;
 
-    opPtr->fdMonitor = le_fdMonitor_Create("Read", outputFile, ReadOpFdEventHandler, POLLOUT);
-    le_fdMonitor_SetContextPtr(opPtr->fdMonitor, opPtr);
-    opPtr->fd = outputFile;
-    opPtr->nextEntryPtr = startPtr;
-    // We hold a ref count on the buffer entry to prevent it from being released.
-    if (startPtr != NULL)
+    if (offset != 0)
     {
-        le_mem_AddRef(startPtr);
-    }
-    opPtr->handlerPtr = handlerPtr;
-    opPtr->contextPtr = contextPtr;
+        // Load the block by its newest sample, so the decoded copy is sure to include it.
+        size_t blockCount = bufferPtr->blocks[blockIndex]->count;
+        obs_LoadDecodedBlock(bufferPtr, startIndex + (blockCount - offset) - 1);
+        const DecodedBlock_t* decodedPtr = bufferPtr->decodedPtr;
 
-    opPtr->state = START;
-    (void)LoadReadOpBuffer(opPtr);
+        for (size_t i = offset; i < blockCount; i++)
+        {
+            AddToBlockStats(statsPtr, decodedPtr->numbers[i]);
+        }
 
-    ContinueReadOp(opPtr);
+        blockIndex++;
+    }
+
+    for (; blockIndex < bufferPtr->blockCount; blockIndex++)
+    {
+        MergeBlockStats(statsPtr, &bufferPtr->blocks[blockIndex]->stats);
+    }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Adds a given data sample to the buffer of a given Observation.
+ * Get the count, sum and sum of squares of the (shifted) non-NAN values from a given sample to
+ * the newest end of an Observation's buffer.
+ *
+ * @return The number of non-NAN values.
  */
 //--------------------------------------------------------------------------------------------------
-static void AddToBuffer
+static size_t GetRangeSums
 (
     Observation_t* obsPtr,
-    dataSample_Ref_t sampleRef
+    size_t startIndex,          ///< Index of the first sample in the range (0 = oldest).
+    double* sumPtr,             ///< [OUT] Sum of (value - shift).
+    double* sumOfSquaresPtr     ///< [OUT] Sum of (value - shift)^2.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    BufferEntry_t* buffEntryPtr;
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    RangeIndex_t* indexPtr = &obsPtr->rangeIndex;
 
-    // If the new sample is timestamped older than the newest sample already in the buffer,
-    // then we have a serious problem, because buffer traversal operations could get stuck in loops.
-    le_sls_Link_t* linkPtr = le_sls_PeekTail(&obsPtr->sampleList);
-    if (linkPtr != NULL)
+    if (bufferPtr->compressed)
     {
-        buffEntryPtr = CONTAINER_OF(linkPtr, BufferEntry_t, link);
+        BlockStats_t stats;
+        ScanCompressedRange(obsPtr, startIndex, &stats);
 
-        double oldEntryTimestamp = dataSample_GetTimestamp(buffEntryPtr->sampleRef);
-        double newEntryTimestamp = dataSample_GetTimestamp(sampleRef);
+        // Re-express the aggregates as sums of values offset by the shift.
+        double diff = stats.mean - indexPtr->shift;
+        *sumPtr = diff * stats.count;
+        *sumOfSquaresPtr = stats.m2 + ((diff * diff) * stats.count);
 
-        if (oldEntryTimestamp > newEntryTimestamp)
-        {
-            LE_ERROR("New sample has older timestamp than (older) sample already in the buffer!");
-            LE_ERROR("Dropping new sample timestamped %lf (< %lf in buffer)!",
-                     newEntryTimestamp,
-                     oldEntryTimestamp);
-            return;
-        }
+        return stats.count;
     }
 
-    buffEntryPtr = le_mem_ForceAlloc(BufferEntryPool);
+    size_t lastSlot = obs_GetSlot(bufferPtr, bufferPtr->count - 1);
 
-    le_mem_AddRef(sampleRef);
-    buffEntryPtr->sampleRef = sampleRef;
-    buffEntryPtr->link = LE_SLS_LINK_INIT;
-    le_sls_Queue(&obsPtr->sampleList, &buffEntryPtr->link);
+    double sum = indexPtr->baseSum;
+    double sumOfSquares = indexPtr->baseSumOfSquares;
+    uint32_t count = indexPtr->baseCount;
+
+    if (startIndex > 0)
+    {
+        size_t prevSlot = obs_GetSlot(bufferPtr, startIndex - 1);
 
-    (obsPtr->count)++;
+        sum = indexPtr->sums[prevSlot];
+        sumOfSquares = indexPtr->sumsOfSquares[prevSlot];
+        count = indexPtr->counts[prevSlot];
+    }
+
+    *sumPtr = indexPtr->sums[lastSlot] - sum;
+    *sumOfSquaresPtr = indexPtr->sumsOfSquares[lastSlot] - sumOfSquares;
+
+    return indexPtr->counts[lastSlot] - count;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * If the number of entries in a given Observation's buffer is larger than the number given,
- * discard enough of the oldest entries to correct that condition.
+ * Get the minimum or maximum of the values from a given sample to the newest end of an
+ * Observation's buffer.
+ *
+ * @return The value, or NAN if there are no non-NAN values in the range.
  */
 //--------------------------------------------------------------------------------------------------
-static void TruncateBuffer
+static double GetRangeExtremum
 (
     Observation_t* obsPtr,
-    size_t count
+    size_t startIndex,  ///< Index of the first sample in the range (0 = oldest).
+    bool isMax          ///< true = get the maximum, false = get the minimum.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    while (obsPtr->count > count)
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    if (bufferPtr->compressed)
     {
-        le_sls_Link_t* linkPtr = le_sls_Pop(&obsPtr->sampleList);
+        BlockStats_t stats;
+        ScanCompressedRange(obsPtr, startIndex, &stats);
+
+        return isMax ? stats.max : stats.min;
+    }
+
+    size_t startSlot = obs_GetSlot(bufferPtr, startIndex);
+    size_t endSlot = startSlot + (bufferPtr->count - startIndex);
 
-        le_mem_Release(CONTAINER_OF(linkPtr, BufferEntry_t, link));
+    // If the range wraps around the end of the arrays, it has to be queried in two parts.
+    if (endSlot > bufferPtr->capacity)
+    {
+        double first = QueryRangeIndexTree(obsPtr, isMax, startSlot, bufferPtr->capacity);
+        double second = QueryRangeIndexTree(obsPtr, isMax, 0, endSlot - bufferPtr->capacity);
 
-        (obsPtr->count)--;
+        return isMax ? fmax(first, second) : fmin(first, second);
     }
+
+    return QueryRangeIndexTree(obsPtr, isMax, startSlot, endSlot);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Update the value of a data sample by replacing it, if necessary
+ * Get the standard deviation of the values from a given sample to the newest end of an
+ * Observation's buffer, given the range sums already fetched using GetRangeSums().
+ *
+ * @return The standard deviation.
  */
 //--------------------------------------------------------------------------------------------------
-static dataSample_Ref_t UpdateSample
+static double GetRangeStdDev
 (
-    dataSample_Ref_t sampleRef,
-    io_DataType_t dataType,
-    void *valuePtr
+    Observation_t* obsPtr,
+    size_t startIndex,      ///< Index of the first sample in the range (0 = oldest).
+    size_t count,           ///< Number of non-NAN values in the range (must be non-zero).
+    double sum,             ///< Sum of (value - shift) over the range.
+    double sumOfSquares     ///< Sum of (value - shift)^2 over the range.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    dataSample_Ref_t sample = sampleRef;
-    double timestamp = dataSample_GetTimestamp(sampleRef);
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
 
-    switch (dataType)
+    // Compressed buffers' block aggregates carry the sum of squared differences directly.
+    if (bufferPtr->compressed)
     {
-        case IO_DATA_TYPE_BOOLEAN:
+        BlockStats_t stats;
+        ScanCompressedRange(obsPtr, startIndex, &stats);
+
+        return sqrt(fmax(stats.m2, 0) / count);
+    }
+
+    // The sums are of values offset by the shift, which doesn't change the variance.
+    double sumOfSquaredDifferences = sumOfSquares - ((sum * sum) / count);
+
+    // The difference of cumulative sums carries rounding error proportional to their magnitude.
+    // If that could be significant compared to the result (e.g., when a burst of large values
+    // earlier in the buffer is followed by a steady signal), compute it exactly instead.
+    if (sumOfSquaredDifferences
+        < (obsPtr->rangeIndex.sumsOfSquares[obs_GetSlot(bufferPtr, bufferPtr->count - 1)] * 1e-9))
+    {
+        double exactSum = 0;
+
+        for (size_t index = startIndex; index < bufferPtr->count; index++)
         {
-            bool value = *((double *)valuePtr) > 0.0 ? true : false;
-            if (dataSample_GetBoolean(sampleRef) != value)
+            double value = obs_GetBufferedNumber(obsPtr, index);
+
+            if (!isnan(value))
             {
-                sample = dataSample_CreateBoolean(timestamp, value);
+                exactSum += value * obs_GetBufferedWeight(bufferPtr, index);
             }
-            break;
         }
 
-        case IO_DATA_TYPE_NUMERIC:
+        const double mean = (exactSum / count);
+
+        sumOfSquaredDifferences = 0;
+
+        for (size_t index = startIndex; index < bufferPtr->count; index++)
         {
-            double value = *((double *)valuePtr);
-            if (dataSample_GetNumeric(sampleRef) != value)
+            double value = obs_GetBufferedNumber(obsPtr, index);
+
+            if (!isnan(value))
             {
-                sample = dataSample_CreateNumeric(timestamp, value);
+                double diff = value - mean;
+                sumOfSquaredDifferences += (diff * diff) * obs_GetBufferedWeight(bufferPtr, index);
             }
         }
-
-        default:
-            break;
     }
 
-    if (sample != sampleRef)
+    // Rounding errors can leave a tiny negative result when all values are equal.
+    if (sumOfSquaredDifferences < 0)
     {
-        le_mem_Release(sampleRef);
+        sumOfSquaredDifferences = 0;
     }
 
-    return sample;
+    return sqrt(sumOfSquaredDifferences / count);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Writes a buffer load of data to a buffered file stream.
- *
- * On error, logs an error message and closes the file.
+ * Get the time-weighted mean and standard deviation of the signal reconstructed by linear
+ * interpolation between the samples from a given sample to the newest end of an Observation's
+ * buffer.  This is what a swinging door buffer reconstructs to within its tolerance, whereas the
+ * plain mean of its samples is skewed towards the periods when the signal changed the most.
+ * Intervals next to a NAN value are left out.
  *
- * @return true if successful, false if failed.
+ * @return true if successful, false if the samples span no time (or only NAN values do).
  */
 //--------------------------------------------------------------------------------------------------
-static bool WriteToStream
+static bool GetInterpolatedMoments
 (
-    FILE* file,
-    const void* buffPtr,
-    size_t buffSize
+    Observation_t* obsPtr,
+    size_t startIndex,  ///< Index of the first sample in the range (0 = oldest).
+    double* meanPtr,    ///< [OUT] Time-weighted mean.
+    double* stdDevPtr   ///< [OUT] Time-weighted standard deviation.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    size_t recordsWritten = fwrite(buffPtr, buffSize, 1, file);
-    if (recordsWritten != 1)
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    double duration = 0;
+    double integral = 0;
+
+    for (size_t index = startIndex + 1; index < bufferPtr->count; index++)
     {
-        LE_CRIT("Failed to write (%m).");
-        le_atomFile_CancelStream(file);
-        return false;
+        double interval = obs_GetBufferedTimestamp(bufferPtr, index)
+                        - obs_GetBufferedTimestamp(bufferPtr, index - 1);
+        double area = interval
+                    * (  obs_GetBufferedNumber(obsPtr, index - 1)
+                       + obs_GetBufferedNumber(obsPtr, index)) / 2;
+
+        if (!isnan(area))
+        {
+            duration += interval;
+            integral += area;
+        }
     }
-    return true;
-}
 
+    if (!(duration > 0))
+    {
+        return false;
+    }
 
-//--------------------------------------------------------------------------------------------------
-/**
- * Reads a buffer load of data from a backup file.
- *
- * On error, logs an error message and closes the file.
- *
- * @return LE_OK if successful, LE_UNDERFLOW if the end of file was reached, LE_FAULT if failed.
- */
-//--------------------------------------------------------------------------------------------------
-static le_result_t ReadFromFile
-(
-    void* buffPtr,
-    size_t buffSize,
-    FILE* file
-)
-//--------------------------------------------------------------------------------------------------
-{
-    size_t bytesRead = fread(buffPtr, 1, buffSize, file);
+    double mean = integral / duration;
 
-    le_result_t result = LE_OK;
+    // The integral of the square of a linear function over an interval is the interval times a
+    // third of (a^2 + ab + b^2), where a and b are its values at the ends.
+    double squaresIntegral = 0;
 
-    if (bytesRead < buffSize)
+    for (size_t index = startIndex + 1; index < bufferPtr->count; index++)
     {
-        if (feof(file))
-        {
-            result = LE_UNDERFLOW;
-        }
-        else
+        double interval = obs_GetBufferedTimestamp(bufferPtr, index)
+                        - obs_GetBufferedTimestamp(bufferPtr, index - 1);
+        double a = obs_GetBufferedNumber(obsPtr, index - 1) - mean;
+        double b = obs_GetBufferedNumber(obsPtr, index) - mean;
+        double area = interval * ((a * a) + (a * b) + (b * b)) / 3;
+
+        if (!isnan(area))
         {
-            LE_CRIT("Failed to read (%m).");
-            result = LE_FAULT;
+            squaresIntegral += area;
         }
-
-        le_atomFile_CancelStream(file);
     }
 
-    return result;
+    *meanPtr = mean;
+    *stdDevPtr = sqrt(squaresIntegral / duration);
+
+    return true;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Gets the data type code byte to be written into a backup file.
+ * Get the number of bytes of value storage needed for each buffered sample of a given data type.
  *
- * @return the data type code byte.
+ * @return The number of bytes (0 for triggers).
  */
 //--------------------------------------------------------------------------------------------------
-static uint8_t GetDataTypeCode
+static size_t GetBufferedValueSize
 (
-    Observation_t* obsPtr
+    io_DataType_t dataType
 )
 //--------------------------------------------------------------------------------------------------
 {
-    switch (res_GetDataType(&obsPtr->resource))
+    switch (dataType)
     {
-        case IO_DATA_TYPE_TRIGGER:  return 't';
-        case IO_DATA_TYPE_BOOLEAN:  return 'b';
-        case IO_DATA_TYPE_NUMERIC:  return 'n';
-        case IO_DATA_TYPE_STRING:   return 's';
-        case IO_DATA_TYPE_JSON:     return 'j';
+        case IO_DATA_TYPE_TRIGGER:  return 0;
+        case IO_DATA_TYPE_BOOLEAN:  return sizeof(bool);
+        case IO_DATA_TYPE_NUMERIC:  return sizeof(double);
+        case IO_DATA_TYPE_STRING:   return sizeof(dataSample_Ref_t);
+        case IO_DATA_TYPE_JSON:     return sizeof(dataSample_Ref_t);
     }
 
-    LE_FATAL("Invalid data type %d.", res_GetDataType(&obsPtr->resource));
+    LE_FATAL("Invalid data type %d.", dataType);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Gets the data type represented by the code byte read from a backup file.
+ * Allocate one of the arrays used to store an Observation's buffered samples.
  *
- * @return true if successful, false on error.
+ * Buffer capacities are configurable at run-time, so these arrays can't come from fixed-size
+ * memory pools.  Like le_mem_ForceAlloc(), this never returns NULL unless zero bytes are requested.
+ * The bytes are counted in the buffer memory statistics until the array is freed by
+ * obs_FreeBufferArray().
+ *
+ * @return Pointer to the array, or NULL if byteCount is zero.
  */
 //--------------------------------------------------------------------------------------------------
-static bool GetDataTypeFromCode
+void* obs_AllocBufferArray
 (
-    io_DataType_t* dataTypePtr, ///< [OUT] Ptr to where the result will be put on success.
-    uint8_t code
+    size_t byteCount
 )
 //--------------------------------------------------------------------------------------------------
 {
-    switch (code)
+    if (byteCount == 0)
     {
-        case 't': *dataTypePtr = IO_DATA_TYPE_TRIGGER; return true;
-        case 'b': *dataTypePtr = IO_DATA_TYPE_BOOLEAN; return true;
-        case 'n': *dataTypePtr = IO_DATA_TYPE_NUMERIC; return true;
-        case 's': *dataTypePtr = IO_DATA_TYPE_STRING;  return true;
-        case 'j': *dataTypePtr = IO_DATA_TYPE_JSON;    return true;
+        return NULL;
     }
 
-    LE_CRIT("Invalid data type code %d.", (int)code);
+    BufferArrayHeader_t* headerPtr = malloc(sizeof(BufferArrayHeader_t) + byteCount);
+    LE_ASSERT(headerPtr != NULL);
+    headerPtr->byteCount = byteCount;
+
+    le_mutex_Lock(BufferArrayMutex);
+    BufferArrayBytes += byteCount;
+    if (BufferArrayBytes > PeakBufferArrayBytes)
+    {
+        PeakBufferArrayBytes = BufferArrayBytes;
+    }
+    le_mutex_Unlock(BufferArrayMutex);
 
-    return false;
+    return headerPtr + 1;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Writes all the data samples for a given Observation to a given backup file.
- *
- * On error, logs an error message and closes the file.
- *
- * @return true if successful, false if failed.
+ * Free an array allocated by obs_AllocBufferArray().
  */
 //--------------------------------------------------------------------------------------------------
-static bool WriteSamplesToFile
+void obs_FreeBufferArray
 (
-    FILE* file,
-    Observation_t* obsPtr
+    void* arrayPtr  ///< The array (may be NULL).
 )
 //--------------------------------------------------------------------------------------------------
 {
-    io_DataType_t dataType = obsPtr->bufferedType;
-
-    BufferEntry_t* buffEntryPtr = GetOldestBufferEntry(obsPtr);
-
-    while (buffEntryPtr != NULL)
+    if (arrayPtr == NULL)
     {
-        // Write the timestamp.
-        double timestamp = dataSample_GetTimestamp(buffEntryPtr->sampleRef);
-        if (!WriteToStream(file, &timestamp, sizeof(timestamp)))
-        {
-            return false;
-        }
+        return;
+    }
 
-        switch (dataType)
-        {
-            case IO_DATA_TYPE_TRIGGER:
+    BufferArrayHeader_t* headerPtr = (BufferArrayHeader_t*)arrayPtr - 1;
 
-                // No Value.
-                break;
+    le_mutex_Lock(BufferArrayMutex);
+    LE_ASSERT(BufferArrayBytes >= headerPtr->byteCount);
+    BufferArrayBytes -= headerPtr->byteCount;
+    le_mutex_Unlock(BufferArrayMutex);
 
-            case IO_DATA_TYPE_BOOLEAN:
-            {
-                bool value = dataSample_GetBoolean(buffEntryPtr->sampleRef);
-                if (!WriteToStream(file, &value, sizeof(value)))
-                {
-                    return false;
-                }
-                break;
-            }
-            case IO_DATA_TYPE_NUMERIC:
-            {
-                double value = dataSample_GetNumeric(buffEntryPtr->sampleRef);
-                if (!WriteToStream(file, &value, sizeof(value)))
-                {
-                    return false;
-                }
-                break;
-            }
-            case IO_DATA_TYPE_STRING:
-            {
-                const char* valuePtr = dataSample_GetString(buffEntryPtr->sampleRef);
-                uint32_t stringLen = strlen(valuePtr);
-                if (!WriteToStream(file, &stringLen, 4))
-                {
-                    return false;
-                }
-                if (!WriteToStream(file, valuePtr, stringLen))
-                {
-                    return false;
-                }
-                break;
-            }
-            case IO_DATA_TYPE_JSON:
-            {
-                const char* valuePtr = dataSample_GetJson(buffEntryPtr->sampleRef);
-                uint32_t stringLen = strlen(valuePtr);
-                if (!WriteToStream(file, &stringLen, 4))
-                {
-                    return false;
-                }
-                if (!WriteToStream(file, valuePtr, stringLen))
-                {
-                    return false;
-                }
-                break;
-            }
-        }
+    free(headerPtr);
+}
 
-        buffEntryPtr = GetNextBufferEntry(obsPtr, buffEntryPtr);
-    }
 
-    return true;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the memory allocated for Observation buffer arrays, which hold the buffered
+ * samples, their indexes and rollup tiers, and the snapshots and journal batches being written to
+ * backup files.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_GetBufferMemoryStats
+(
+    uint64_t* bytesPtr,     ///< [OUT] Bytes allocated now.
+    uint64_t* peakBytesPtr  ///< [OUT] Most bytes allocated at once since start-up.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_mutex_Lock(BufferArrayMutex);
+    *bytesPtr = BufferArrayBytes;
+    *peakBytesPtr = PeakBufferArrayBytes;
+    le_mutex_Unlock(BufferArrayMutex);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Reads all the data samples from a given backup file and adds them to a given Observation's
- * data sample buffer.  Closes the file when done.
+ * Copy the contents of one of an Observation's per-slot buffer arrays into a newly allocated
+ * array with a given number of slots, oldest sample first, starting at slot 0.
+ *
+ * @return Pointer to the new array (NULL if no bytes needed).
  */
 //--------------------------------------------------------------------------------------------------
-static void ReadSamplesFromFile
+static void* CopyBufferArray
 (
-    Observation_t* obsPtr,
-    FILE* file,
-    size_t count    ///< The expected number of samples to read.
+    const SampleBuffer_t* bufferPtr,
+    const void* oldArrayPtr,    ///< Array to copy (may be NULL if empty).
+    size_t elementSize, ///< Number of bytes per slot.
+    size_t capacity     ///< Number of slots to allocate in the new array.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    if (count == 0)
+    uint8_t* newArrayPtr = obs_AllocBufferArray(capacity * elementSize);
+
+    // The samples occupy at most two contiguous runs of slots: from the head to the end of the
+    // array, then (if the buffer has wrapped around) from the start of the array.  An array that
+    // isn't needed for the buffer's current form (zero slots) has nothing to copy.
+    size_t count = ((capacity > 0) ? bufferPtr->count : 0);
+    size_t firstRun = bufferPtr->capacity - bufferPtr->head;
+    if (firstRun > count)
     {
-        return;
+        firstRun = count;
     }
+    size_t secondRun = count - firstRun;
 
-    io_DataType_t dataType = obsPtr->bufferedType;
-
-    dataSample_Ref_t dataSample = NULL;
+    if ((firstRun > 0) && (elementSize > 0))
+    {
+        memcpy(newArrayPtr,
+               (const uint8_t*)oldArrayPtr + (bufferPtr->head * elementSize),
+               firstRun * elementSize);
+    }
+    if ((secondRun > 0) && (elementSize > 0))
+    {
+        memcpy(newArrayPtr + (firstRun * elementSize), oldArrayPtr, secondRun * elementSize);
+    }
 
-    for (;;)
+    // Clear the unused slots, so that nothing reads uninitialized memory (e.g., as the segment
+    // tree leaves of slots that have no sample in them yet).
+    if ((capacity > bufferPtr->count) && (elementSize > 0))
     {
-        // Read the timestamp.
-        double timestamp;
-        le_result_t result = ReadFromFile(&timestamp, sizeof(timestamp), file);
-        if (result != LE_OK)
-        {
-            if (result == LE_UNDERFLOW)
-            {
-                // End of file reached, check that we've received all we should.
-                if (count == 0)
-                {
-                    // The file contained exactly the number of samples we expected.
-                    // The last data sample read from the file (which is the newest)
-                    // should be pushed to the Observation so it becomes the current value.
-                    res_Push(&obsPtr->resource, dataType, "", dataSample);
-                    return;
-                }
-                else
-                {
-                    LE_CRIT("Backup file was truncated. Expected %zu more samples.", count);
-                }
-            }
+        memset(newArrayPtr + (bufferPtr->count * elementSize),
+               0,
+               (capacity - bufferPtr->count) * elementSize);
+    }
 
-            goto error;
-        }
+    return newArrayPtr;
+}
 
-        // We succeeded in reading another timestamp, so we had better be expecting more samples.
-        if (count == 0)
-        {
-            LE_CRIT("Backup file contains extra samples.");
-            le_atomFile_CancelStream(file);
-            goto error;
-        }
 
-        count--;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Move the contents of one of an Observation's per-slot buffer arrays into a newly allocated
+ * array with a given number of slots, oldest sample first, starting at slot 0.  The old array is
+ * freed.
+ *
+ * @return Pointer to the new array (NULL if no bytes needed).
+ */
+//--------------------------------------------------------------------------------------------------
+static void* MoveBufferArray
+(
+    const SampleBuffer_t* bufferPtr,
+    void* oldArrayPtr,  ///< Array to move (may be NULL if empty).
+    size_t elementSize, ///< Number of bytes per slot.
+    size_t capacity     ///< Number of slots to allocate in the new array.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    void* newArrayPtr = CopyBufferArray(bufferPtr, oldArrayPtr, elementSize, capacity);
 
-        switch (dataType)
-        {
-            case IO_DATA_TYPE_TRIGGER:
+    obs_FreeBufferArray(oldArrayPtr);
 
-                // No Value.
-                dataSample = dataSample_CreateTrigger(timestamp);
-                break;
+    return newArrayPtr;
+}
 
-            case IO_DATA_TYPE_BOOLEAN:
-            {
-                bool value;
-                if (ReadFromFile(&value, sizeof(value), file) != LE_OK)
-                {
-                    LE_CRIT("Failed to read boolean value.");
-                    goto error;
-                }
-                dataSample = dataSample_CreateBoolean(timestamp, value);
-                break;
-            }
-            case IO_DATA_TYPE_NUMERIC:
-            {
-                double value;
-                if (ReadFromFile(&value, sizeof(value), file) != LE_OK)
-                {
-                    LE_CRIT("Failed to read numeric value.");
-                    goto error;
-                }
-                dataSample = dataSample_CreateNumeric(timestamp, value);
-                break;
-            }
-            case IO_DATA_TYPE_STRING:
-            {
-                char value[IO_MAX_STRING_VALUE_LEN + 1];
 
-                uint32_t stringLen;
-                if (ReadFromFile(&stringLen, 4, file) != LE_OK)
-                {
-                    LE_CRIT("Failed to read string length.");
-                    goto error;
-                }
-                if (stringLen > (sizeof(value) - 1))
-                {
-                    LE_CRIT("String length (%zu) is larger than permitted (%zu).",
-                            (size_t)stringLen,
-                            sizeof(value) - 1);
-                    le_atomFile_CancelStream(file);
-                    goto error;
-                }
-                if (ReadFromFile(value, stringLen, file) != LE_OK)
-                {
-                    LE_CRIT("Failed to read string value of length %zu.", (size_t)stringLen);
-                    goto error;
-                }
-                value[stringLen] = '\0';
-                dataSample = dataSample_CreateString(timestamp, value);
-                break;
-            }
-            case IO_DATA_TYPE_JSON:
-            {
-                char value[IO_MAX_STRING_VALUE_LEN + 1];
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change the number of slots allocated for an Observation's buffer.  The buffered samples are
+ * moved into the new arrays, oldest first, starting at slot 0.
+ *
+ * @warning The buffer must not contain more samples than the new capacity.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ResizeBuffer
+(
+    Observation_t* obsPtr,
+    size_t capacity
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    RangeIndex_t* indexPtr = &obsPtr->rangeIndex;
 
-                uint32_t stringLen;
-                if (ReadFromFile(&stringLen, 4, file) != LE_OK)
-                {
-                    LE_CRIT("Failed to read JSON object length.");
-                    goto error;
-                }
-                if (stringLen > (sizeof(value) - 1))
-                {
-                    LE_CRIT("JSON string length (%zu) is larger than permitted (%zu).",
-                            (size_t)stringLen,
-                            sizeof(value) - 1);
-                    le_atomFile_CancelStream(file);
-                    goto error;
-                }
-                if (ReadFromFile(value, stringLen, file) != LE_OK)
-                {
-                    LE_CRIT("Failed to read JSON value of length %zu.", (size_t)stringLen);
-                    goto error;
-                }
-                value[stringLen] = '\0';
-                dataSample = dataSample_CreateJson(timestamp, value);
-                break;
-            }
-        }
+    LE_ASSERT(bufferPtr->count <= capacity);
+
+    // The extrema queue shares the buffer's capacity, so it has to be moved too.
+    ExtremaQueue_t* queuePtr = &obsPtr->extrema;
+    uint64_t* seqs = NULL;
+    if (IsExtremaTracked(obsPtr))
+    {
+        seqs = obs_AllocBufferArray(capacity * sizeof(uint64_t));
 
-        // Add the sample to the buffer, unless this is the last (newest) sample, in which case
-        // we will push it to the Observation later when we confirm that the file doesn't have
-        // more than expected in it (which would mean that all these samples are probably corrupt
-        // and need to be discarded).
-        if (count != 0)
+        for (size_t i = 0; i < queuePtr->count; i++)
         {
-            AddToBuffer(obsPtr, dataSample);
+            seqs[i] = queuePtr->seqs[(queuePtr->head + i) % bufferPtr->capacity];
         }
     }
+    else
+    {
+        queuePtr->count = 0;
+    }
+    obs_FreeBufferArray(queuePtr->seqs);
+    queuePtr->seqs = seqs;
+    queuePtr->head = 0;
+
+    // The range index (uncompressed numeric and Boolean buffers only) has per-slot sums to be
+    // moved too.  The segment trees are rebuilt below, once the values are in their new slots.
+    size_t indexCapacity = (   (obs_IsBufferNumerical(obsPtr) && !bufferPtr->compressed)
+                            ? capacity : 0);
+    indexPtr->sums = MoveBufferArray(bufferPtr, indexPtr->sums, sizeof(double), indexCapacity);
+    indexPtr->sumsOfSquares = MoveBufferArray(bufferPtr,
+                                              indexPtr->sumsOfSquares,
+                                              sizeof(double),
+                                              indexCapacity);
+    indexPtr->counts = MoveBufferArray(bufferPtr,
+                                       indexPtr->counts,
+                                       sizeof(uint32_t),
+                                       indexCapacity);
+    obs_FreeBufferArray(indexPtr->minNodes);
+    obs_FreeBufferArray(indexPtr->maxNodes);
+    indexPtr->minNodes = obs_AllocBufferArray(indexCapacity * sizeof(double));
+    indexPtr->maxNodes = obs_AllocBufferArray(indexCapacity * sizeof(double));
+
+    bufferPtr->timestamps = MoveBufferArray(bufferPtr,
+                                            bufferPtr->timestamps,
+                                            sizeof(double),
+                                            capacity);
+    bufferPtr->values.bytes = MoveBufferArray(bufferPtr,
+                                              bufferPtr->values.bytes,
+                                              GetBufferedValueSize(obsPtr->bufferedType),
+                                              capacity);
+    size_t runCapacity = (bufferPtr->runLength ? capacity : 0);
+    bufferPtr->runEnds = MoveBufferArray(bufferPtr,
+                                         bufferPtr->runEnds,
+                                         sizeof(double),
+                                         runCapacity);
+    bufferPtr->runCounts = MoveBufferArray(bufferPtr,
+                                           bufferPtr->runCounts,
+                                           sizeof(uint32_t),
+                                           runCapacity);
+    bufferPtr->capacity = capacity;
+    bufferPtr->head = 0;
+
+    if (indexCapacity > 0)
+    {
+        RebuildRangeIndexTrees(obsPtr);
+    }
 
-error:
+    // Compressed blocks are freed as their samples are dropped, which leaves only the array of
+    // blocks and the decoded block to be freed once the buffer is empty.
+    if (capacity == 0)
+    {
+        LE_ASSERT(bufferPtr->blockCount == 0);
 
-    // On error, dump the buffer contents in case we read some corrupted samples from the file.
-    TruncateBuffer(obsPtr, 0);
+        obs_FreeBufferArray(bufferPtr->blocks);
+        bufferPtr->blocks = NULL;
+        bufferPtr->blockSlots = 0;
+        if (bufferPtr->decodedPtr != NULL)
+        {
+            le_mem_Release(bufferPtr->decodedPtr);
+            bufferPtr->decodedPtr = NULL;
+        }
+    }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Perform a backup to non-volatile storage of an observation's data sample buffer.
+ * Get the number of bytes of encoded samples that fit in the blocks of one of the compressed block
+ * pools.
+ *
+ * @return The number of bytes.
  */
 //--------------------------------------------------------------------------------------------------
-static void Backup
+static size_t GetCompressedBlockPoolBytes
 (
-    Observation_t* obsPtr
+    size_t poolIndex    ///< Index of the pool in CompressedBlockPools.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    // If the backup timer exists, delete it.
-    if (obsPtr->backupTimer != NULL)
+    size_t byteCount = (size_t)COMPRESSED_BLOCK_MIN_POOL_BYTES << poolIndex;
+
+    if ((poolIndex == COMPRESSED_BLOCK_POOL_COUNT - 1) || (byteCount > COMPRESSED_BLOCK_BYTES))
     {
-        le_timer_Delete(obsPtr->backupTimer);
-        obsPtr->backupTimer = NULL;
+        byteCount = COMPRESSED_BLOCK_BYTES;
     }
 
-    // Update the time of last backup.
-    le_clk_Time_t now = le_clk_GetRelativeTime();
-    obsPtr->lastBackupTime = now.sec;
+    return byteCount;
+}
+
 
-    // Get the backup file path.
-    char path[MAX_BACKUP_FILE_PATH_BYTES];
-    if (GetBackupFilePath(path, sizeof(path), obsPtr) != LE_OK)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allocate a compressed buffer block from the smallest pool that has room for a given number of
+ * bytes of encoded samples.  Blocks are reference counted, so that full blocks (which never change)
+ * can be shared with buffer snapshots instead of being copied.
+ *
+ * @return Ptr to the block (contents not initialized).
+ */
+//--------------------------------------------------------------------------------------------------
+static CompressedBlock_t* AllocCompressedBlock
+(
+    size_t byteCount    ///< Number of bytes of encoded samples it must hold.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t poolIndex = 0;
+    while (GetCompressedBlockPoolBytes(poolIndex) < byteCount)
     {
-        return;
+        poolIndex++;
     }
 
-    LE_DEBUG("Backing up to '%s'...", path);
-
-    // Create the backup directory, if it doesn't exist already.
-    struct stat st = {0};
-    if (stat(BACKUP_DIR, &st) == -1)
-    {
-        LE_DEBUG("Creating directory '" BACKUP_DIR "'.");
+    return le_mem_ForceAlloc(CompressedBlockPools[poolIndex]);
+}
 
-        if (mkdir(BACKUP_DIR, 0700) == -1)
-        {
-            LE_CRIT("Unable to create directory '" BACKUP_DIR "' (%m).");
-            return;
-        }
-    }
 
-    // Open the file for writing, truncating it to zero length to start.
-    le_result_t result;
-    FILE* file = le_atomFile_CreateStream(path,
-                                          LE_FLOCK_WRITE,
-                                          LE_FLOCK_REPLACE_IF_EXIST,
-                                          0600,
-                                          &result);
-    if (result != LE_OK)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release one of a compressed buffer's blocks.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FreeCompressedBlock
+(
+    SampleBuffer_t* bufferPtr,
+    CompressedBlock_t* blockPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (bufferPtr->decodedPtr->blockPtr == blockPtr)
     {
-        LE_CRIT("Unable to open file '%s' for writing (%s).", path, LE_RESULT_TXT(result));
-        return;
+        bufferPtr->decodedPtr->blockPtr = NULL;
     }
 
-    // Write in the version byte.
-    uint8_t byte = 0;
-    if (!WriteToStream(file, &byte, 1))
-    {
-        return;
-    }
+    le_mem_Release(blockPtr);
+}
 
-    // Write the data type code.
-    byte = GetDataTypeCode(obsPtr);
-    if (byte == 0)
-    {
-        le_atomFile_CancelStream(file);
-        return;
-    }
-    if (!WriteToStream(file, &byte, 1))
-    {
-        return;
-    }
 
-    // Write in the number of samples.
-    uint32_t count = obsPtr->count;
-    if (!WriteToStream(file, &count, 4))
+//--------------------------------------------------------------------------------------------------
+/**
+ * Drop a number of samples from the oldest end of a compressed buffer, freeing the blocks that
+ * no longer hold any samples.  The buffer's count must already have been reduced.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DropCompressedSamples
+(
+    SampleBuffer_t* bufferPtr,
+    size_t dropCount
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t freeCount;
+
+    if (bufferPtr->count == 0)
     {
-        return;
+        freeCount = bufferPtr->blockCount;
+        bufferPtr->blockHead = 0;
     }
-
-    // Write all the data samples to the file.
-    if (!WriteSamplesToFile(file, obsPtr))
+    else
     {
-        return;
+        bufferPtr->blockHead += dropCount;
+        freeCount = bufferPtr->blockHead / COMPRESSED_BLOCK_SAMPLES;
+        bufferPtr->blockHead %= COMPRESSED_BLOCK_SAMPLES;
     }
 
-    // Commit the file.
-    result = le_atomFile_CloseStream(file);
-    if (result != LE_OK)
+    for (size_t i = 0; i < freeCount; i++)
     {
-        LE_CRIT("Failed to save '%s' (%s).", path, LE_RESULT_TXT(result));
+        FreeCompressedBlock(bufferPtr, bufferPtr->blocks[i]);
     }
 
-    LE_DEBUG("Backup complete.");
+    bufferPtr->blockCount -= freeCount;
+    memmove(bufferPtr->blocks,
+            bufferPtr->blocks + freeCount,
+            bufferPtr->blockCount * sizeof(CompressedBlock_t*));
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Disable backups of a given Observation's data sample buffer.
+ * Reset an Observation's running aggregates and range index sums for an empty buffer.
  */
 //--------------------------------------------------------------------------------------------------
-static void DisableBackups
+static void ResetAggregates
 (
     Observation_t* obsPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    if (obsPtr->backupTimer != NULL)
-    {
-        le_timer_Stop(obsPtr->backupTimer);
-        le_timer_Delete(obsPtr->backupTimer);
-        obsPtr->backupTimer = NULL;
-    }
+    RangeIndex_t* indexPtr = &obsPtr->rangeIndex;
 
-    obsPtr->lastBackupTime = 0;
+    memset(&obsPtr->runningStats, 0, sizeof(obsPtr->runningStats));
 
-    DeleteBackup(obsPtr);
+    indexPtr->baseSum = 0;
+    indexPtr->baseSumOfSquares = 0;
+    indexPtr->baseCount = 0;
+    indexPtr->shift = NAN;
+    indexPtr->drops = 0;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Timer expiry handler function for Observation data sample buffer backup timers.
- *
- * Saves the contents of an Observation's data sample buffer to non-volatile storage.
+ * Get the number of bytes of JSON that fit in the chunks of one of the JSON chunk pools.
  *
- * @note The timer should only be running if a data sample arrived in the buffer before the
- *       backup period had elapsed since the previous backup.
+ * @return The number of bytes.
  */
 //--------------------------------------------------------------------------------------------------
-static void BackupTimerExpired
+static size_t GetJsonChunkPoolBytes
 (
-    le_timer_Ref_t timer
+    size_t poolIndex    ///< Index of the pool in JsonChunkPools.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    Observation_t* obsPtr = le_timer_GetContextPtr(timer);
+    size_t jsonBytes = (size_t)JSON_CHUNK_MIN_POOL_BYTES << poolIndex;
 
-    Backup(obsPtr);
+    if ((poolIndex == JSON_CHUNK_POOL_COUNT - 1) || (jsonBytes > JSON_CHUNK_MAX_BYTES))
+    {
+        jsonBytes = JSON_CHUNK_MAX_BYTES;
+    }
+
+    return jsonBytes;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Initialize the Observation module.
+ * Get the number of slots an Observation's JSON chunk cache needs to hold every chunk of its
+ * buffer: one per JSON_CHUNK_SAMPLES samples of the maximum count, plus one for a chunk that the
+ * oldest sample is part way through, and one for a chunk that is only complete once a sample is
+ * added to a full buffer (before the oldest is dropped).
  *
- * @warning This must be called before any other function in this module is called.
+ * @return The number of slots.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_Init
+static size_t GetJsonChunkSlotCount
 (
-    void
+    Observation_t* obsPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    ObservationPool = le_mem_CreatePool("Observation", sizeof(Observation_t));
-    le_mem_SetDestructor(ObservationPool, ObservationDestructor);
-
-    BufferEntryPool = le_mem_CreatePool("Buffer Entry", sizeof(BufferEntry_t));
-    le_mem_SetDestructor(BufferEntryPool, BufferEntryDestructor);
-
-    ReadOperationPool = le_mem_CreatePool("Read Op", sizeof(ReadOperation_t));
+    return (obsPtr->maxCount / JSON_CHUNK_SAMPLES) + 2;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Create an Observation object.  This allocates the object and initializes the class members,
- * but not the parent class members.
+ * Get the slot of an Observation's JSON chunk cache that holds the chunk starting with a given
+ * sample.  The cache must have been allocated.
  *
- * @return Pointer to the new object.
+ * @return Ptr to the slot.
  */
 //--------------------------------------------------------------------------------------------------
-res_Resource_t* obs_Create
+static JsonChunk_t** GetJsonChunkSlot
 (
-    resTree_EntryRef_t entryRef ///< The resource tree entry to attach this Resource to.
+    Observation_t* obsPtr,
+    uint64_t seq    ///< Sequence number of the first sample in the chunk.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    Observation_t* obsPtr = le_mem_ForceAlloc(ObservationPool);
-
-    res_Construct(&obsPtr->resource, entryRef);
-
-    obsPtr->lowLimit = NAN;
-    obsPtr->highLimit = NAN;
-    obsPtr->changeBy = NAN;
-    obsPtr->minPeriod = NAN;
-
-    obsPtr->maxCount = 0;
-    obsPtr->count = 0;
-
-    obsPtr->transformType = OBS_TRANSFORM_TYPE_NONE;
-
-    obsPtr->bufferedType = IO_DATA_TYPE_TRIGGER;
-
-    obsPtr->backupPeriod = 0;
-    obsPtr->lastBackupTime = 0;
-    obsPtr->backupTimer = NULL;
-
-    obsPtr->sampleList = LE_SLS_LIST_INIT;
-
-    obsPtr->readOpList = LE_DLS_LIST_INIT;
-
-    obsPtr->jsonExtraction[0] = '\0';
-
-    return &obsPtr->resource;
+    return &obsPtr->jsonChunks[(seq / JSON_CHUNK_SAMPLES) % obsPtr->jsonChunkSlots];
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Restore an Observation's data buffer from non-volatile backup, if one exists.
+ * Release the cached JSON chunks of an Observation's buffer that samples have just been dropped
+ * from, because they can't be read in full anymore.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_RestoreBackup
+static void EvictJsonChunks
 (
-    res_Resource_t* resPtr
+    Observation_t* obsPtr,
+    uint64_t oldFirstSeq    ///< Sequence number of the oldest sample before the drop.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
-
-    // If there's no backup directory yet, then we know there are no backups, so don't
-    // try opening one (which would result in an error message in the logs because the lock file
-    // can't be created).
-    struct stat st = {0};
-    if (stat(BACKUP_DIR, &st) == -1)
+    if (obsPtr->jsonChunks == NULL)
     {
-        LE_DEBUG("Backup directory '" BACKUP_DIR "' not found. (%m)");
         return;
     }
 
-    char path[MAX_BACKUP_FILE_PATH_BYTES];
-    if (GetBackupFilePath(path, sizeof(path), obsPtr) != LE_OK)
+    uint64_t firstSeq = obsPtr->buffer.firstSeq;
+
+    for (uint64_t seq = oldFirstSeq - (oldFirstSeq % JSON_CHUNK_SAMPLES);
+         seq < firstSeq;
+         seq += JSON_CHUNK_SAMPLES)
     {
-        return;
+        JsonChunk_t** slotPtr = GetJsonChunkSlot(obsPtr, seq);
+
+        if ((*slotPtr != NULL) && ((*slotPtr)->firstSeq == seq))
+        {
+            le_mem_Release(*slotPtr);
+            *slotPtr = NULL;
+        }
     }
+}
 
-    LE_INFO("Loading observation buffer from file '%s'.", path);
 
-    // Open the file for reading.
-    le_result_t result;
-    FILE* file = le_atomFile_OpenStream(path, LE_FLOCK_READ, &result);
-    if (result != LE_OK)
-    {
-        LE_DEBUG("Unable to open '%s' for reading (%s).", path, LE_RESULT_TXT(result));
-        return;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release all the cached JSON chunks of an Observation's buffer, and the cache itself.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FlushJsonChunks
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (obsPtr->jsonChunks == NULL)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < obsPtr->jsonChunkSlots; i++)
+    {
+        if (obsPtr->jsonChunks[i] != NULL)
+        {
+            le_mem_Release(obsPtr->jsonChunks[i]);
+        }
+    }
+
+    obs_FreeBufferArray(obsPtr->jsonChunks);
+    obsPtr->jsonChunks = NULL;
+    obsPtr->jsonChunkSlots = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * If the number of entries in a given Observation's buffer is larger than the number given,
+ * discard enough of the oldest entries to correct that condition.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_TruncateBuffer
+(
+    Observation_t* obsPtr,
+    size_t count
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    if (bufferPtr->count <= count)
+    {
+        return;
+    }
+
+    size_t dropCount = bufferPtr->count - count;
+
+    // String and JSON samples hold references that need to be released.
+    // Numeric and Boolean samples have to be removed from the running aggregates.
+    switch (obsPtr->bufferedType)
+    {
+        case IO_DATA_TYPE_TRIGGER:
+
+            break;
+
+        case IO_DATA_TYPE_BOOLEAN:
+        case IO_DATA_TYPE_NUMERIC:
+        {
+            for (size_t i = 0; i < dropCount; i++)
+            {
+                RemoveFromRunningStats(obsPtr, i);
+            }
+
+            if (bufferPtr->compressed)
+            {
+                break;
+            }
+
+            // The newest dropped sample's cumulative sums are now those before the oldest.
+            RangeIndex_t* indexPtr = &obsPtr->rangeIndex;
+            size_t lastDroppedSlot = obs_GetSlot(bufferPtr, dropCount - 1);
+            indexPtr->baseSum = indexPtr->sums[lastDroppedSlot];
+            indexPtr->baseSumOfSquares = indexPtr->sumsOfSquares[lastDroppedSlot];
+            indexPtr->baseCount = indexPtr->counts[lastDroppedSlot];
+            indexPtr->drops += dropCount;
+            break;
+        }
+
+        case IO_DATA_TYPE_STRING:
+        case IO_DATA_TYPE_JSON:
+
+            for (size_t i = 0; i < dropCount; i++)
+            {
+                le_mem_Release(bufferPtr->values.samples[obs_GetSlot(bufferPtr, i)]);
+            }
+            break;
+    }
+
+    uint64_t oldFirstSeq = bufferPtr->firstSeq;
+
+    bufferPtr->count = count;
+    bufferPtr->firstSeq += dropCount;
+
+    EvictJsonChunks(obsPtr, oldFirstSeq);
+
+    if (bufferPtr->compressed)
+    {
+        DropCompressedSamples(bufferPtr, dropCount);
+    }
+    else
+    {
+        bufferPtr->head = obs_GetSlot(bufferPtr, dropCount);
+    }
+
+    // Drop extrema candidates that are no longer in the buffer.
+    ExtremaQueue_t* queuePtr = &obsPtr->extrema;
+    while ((queuePtr->count > 0) && (queuePtr->seqs[queuePtr->head] < bufferPtr->firstSeq))
+    {
+        queuePtr->head = (queuePtr->head + 1) % bufferPtr->capacity;
+        queuePtr->count--;
+    }
+
+    // Don't let rounding errors from removing values accumulate forever.
+    if (count == 0)
+    {
+        ResetAggregates(obsPtr);
+        memset(&obsPtr->door, 0, sizeof(obsPtr->door));
+    }
+    else if (obs_IsBufferNumerical(obsPtr))
+    {
+        if (   (obsPtr->runningStats.removals >= count)
+            || (obsPtr->runningStats.m2 < (obsPtr->runningStats.m2Peak * 1e-6))  )
+        {
+            RebuildRunningStats(obsPtr);
+        }
+
+        if ((obsPtr->rangeIndex.drops >= count) && !bufferPtr->compressed)
+        {
+            RebuildRangeIndexSums(obsPtr);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change the data type of the samples stored in an Observation's buffer.  The buffer must be
+ * empty.  Its storage is freed, to be reallocated for the new type when the next sample arrives.
+ * Numeric samples are stored compressed if compression is enabled for the Observation.  Otherwise,
+ * numeric (without swinging door compression) and Boolean samples are stored as runs if
+ * run-length encoding is enabled.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetBufferedType
+(
+    Observation_t* obsPtr,
+    io_DataType_t dataType
+)
+//--------------------------------------------------------------------------------------------------
+{
+    LE_ASSERT(obsPtr->buffer.count == 0);
+
+    obs_ResizeBuffer(obsPtr, 0);
+
+    obsPtr->bufferedType = dataType;
+
+    // The backup has to be rewritten in full before anything more can be journaled.
+    obsPtr->journalValid = false;
+
+    obsPtr->buffer.compressed = ((dataType == IO_DATA_TYPE_NUMERIC) && obsPtr->compressBuffer);
+    obsPtr->buffer.runLength = (   obsPtr->runLengthBuffer
+                                && obs_IsBufferNumerical(obsPtr)
+                                && !obsPtr->buffer.compressed
+                                && !IsSwingingDoorEnabled(obsPtr));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find an Observation's rollup tier with a given bucket width.
+ *
+ * @return Pointer to the tier, or NULL if not found.
+ */
+//--------------------------------------------------------------------------------------------------
+static RollupTier_t* FindRollupTier
+(
+    Observation_t* obsPtr,
+    uint32_t bucketSeconds
+)
+//--------------------------------------------------------------------------------------------------
+{
+    for (size_t i = 0; i < obsPtr->rollupCount; i++)
+    {
+        if (obsPtr->rollups[i].bucketSeconds == bucketSeconds)
+        {
+            return &obsPtr->rollups[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the coarsest of an Observation's rollup tiers whose buckets are no wider than a given
+ * resolution.
+ *
+ * @return Pointer to the tier, or NULL if there's no tier that fine.
+ */
+//--------------------------------------------------------------------------------------------------
+static RollupTier_t* SelectRollupTier
+(
+    Observation_t* obsPtr,
+    uint32_t resolution     ///< Maximum bucket width, in seconds.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    RollupTier_t* tierPtr = NULL;
+
+    // The tiers are sorted finest first.
+    for (size_t i = 0; i < obsPtr->rollupCount; i++)
+    {
+        if (obsPtr->rollups[i].bucketSeconds <= resolution)
+        {
+            tierPtr = &obsPtr->rollups[i];
+        }
+    }
+
+    return tierPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a value to a rollup row.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddToRollupRow
+(
+    RollupRow_t* rowPtr,
+    double value    ///< Value to add (must not be NAN).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (rowPtr->count == 0)
+    {
+        rowPtr->min = value;
+        rowPtr->max = value;
+        rowPtr->mean = 0;
+        rowPtr->m2 = 0;
+    }
+    else
+    {
+        rowPtr->min = fmin(rowPtr->min, value);
+        rowPtr->max = fmax(rowPtr->max, value);
+    }
+
+    rowPtr->count++;
+
+    double delta = value - rowPtr->mean;
+    rowPtr->mean += delta / rowPtr->count;
+    rowPtr->m2 += delta * (value - rowPtr->mean);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Merge one rollup row into another, as if all of its values had been added to the other.
+ */
+//--------------------------------------------------------------------------------------------------
+static void MergeRollupRow
+(
+    RollupRow_t* destPtr,
+    const RollupRow_t* srcPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (srcPtr->count == 0)
+    {
+        return;
+    }
+
+    if (destPtr->count == 0)
+    {
+        *destPtr = *srcPtr;
+        return;
+    }
+
+    double destCount = destPtr->count;
+    double srcCount = srcPtr->count;
+    double count = destCount + srcCount;
+    double delta = srcPtr->mean - destPtr->mean;
+
+    destPtr->min = fmin(destPtr->min, srcPtr->min);
+    destPtr->max = fmax(destPtr->max, srcPtr->max);
+    destPtr->mean += delta * (srcCount / count);
+    destPtr->m2 += srcPtr->m2 + (delta * delta * ((destCount * srcCount) / count));
+    destPtr->count += srcPtr->count;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Move the row of the bucket currently being filled into a rollup tier's ring of completed rows,
+ * dropping the oldest row if the ring is full.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_CompleteRollupRow
+(
+    RollupTier_t* tierPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (tierPtr->count == tierPtr->maxCount)
+    {
+        tierPtr->head = (tierPtr->head + 1) % tierPtr->maxCount;
+        tierPtr->count--;
+        tierPtr->firstSeq++;
+    }
+
+    tierPtr->rows[(tierPtr->head + tierPtr->count) % tierPtr->maxCount] = tierPtr->open;
+    tierPtr->count++;
+
+    tierPtr->open.count = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change the number of completed rows retained by a rollup tier, dropping the oldest rows if
+ * there are too many.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResizeRollupTier
+(
+    RollupTier_t* tierPtr,
+    size_t maxCount
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (tierPtr->count > maxCount)
+    {
+        size_t dropCount = tierPtr->count - maxCount;
+
+        tierPtr->head = (tierPtr->head + dropCount) % tierPtr->maxCount;
+        tierPtr->count = maxCount;
+        tierPtr->firstSeq += dropCount;
+    }
+
+    RollupRow_t* rowsPtr = obs_AllocBufferArray(maxCount * sizeof(RollupRow_t));
+
+    for (size_t i = 0; i < tierPtr->count; i++)
+    {
+        rowsPtr[i] = *obs_GetRollupRow(tierPtr, i);
+    }
+
+    obs_FreeBufferArray(tierPtr->rows);
+
+    tierPtr->rows = rowsPtr;
+    tierPtr->head = 0;
+    tierPtr->maxCount = maxCount;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Discard all the rows of all of an Observation's rollup tiers.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearRollups
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    for (size_t i = 0; i < obsPtr->rollupCount; i++)
+    {
+        RollupTier_t* tierPtr = &obsPtr->rollups[i];
+
+        tierPtr->firstSeq += tierPtr->count;
+        tierPtr->head = 0;
+        tierPtr->count = 0;
+        tierPtr->open.count = 0;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a value to the bucket currently being filled in a rollup tier, completing that bucket first
+ * if the value's timestamp is past the end of it.  Values older than that bucket are dropped.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddToRollupTier
+(
+    RollupTier_t* tierPtr,
+    double timestamp,   ///< Seconds since the Epoch.
+    double value,       ///< Value to add (must not be NAN).
+    uint32_t weight     ///< Number of samples with this value (more than 1 for a run).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    double startTime = floor(timestamp / tierPtr->bucketSeconds) * tierPtr->bucketSeconds;
+
+    if (tierPtr->open.count > 0)
+    {
+        // Drop samples that are older than the bucket being filled.
+        if (startTime < tierPtr->open.startTime)
+        {
+            return;
+        }
+
+        if (startTime > tierPtr->open.startTime)
+        {
+            obs_CompleteRollupRow(tierPtr);
+        }
+    }
+
+    if (weight == 1)
+    {
+        if (tierPtr->open.count == 0)
+        {
+            tierPtr->open.startTime = startTime;
+        }
+
+        AddToRollupRow(&tierPtr->open, value);
+    }
+    else
+    {
+        RollupRow_t run =
+        {
+            .startTime = startTime,
+            .count = weight,
+            .min = value,
+            .max = value,
+            .mean = value,
+            .m2 = 0
+        };
+
+        MergeRollupRow(&tierPtr->open, &run);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an accepted data sample to the buckets currently being filled in all of an Observation's
+ * rollup tiers, completing any buckets that the sample's timestamp is past the end of.
+ *
+ * Every tier is fed directly from the sample rather than from the next finer tier, so that the
+ * buckets being filled are always complete.  Only numeric and Boolean samples are summarized.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddToRollups
+(
+    Observation_t* obsPtr,
+    io_DataType_t dataType,
+    dataSample_Ref_t sampleRef
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (obsPtr->rollupCount == 0)
+    {
+        return;
+    }
+
+    double value;
+
+    switch (dataType)
+    {
+        case IO_DATA_TYPE_BOOLEAN:
+
+            value = (dataSample_GetBoolean(sampleRef) ? 1 : 0);
+            break;
+
+        case IO_DATA_TYPE_NUMERIC:
+
+            value = dataSample_GetNumeric(sampleRef);
+            break;
+
+        default:
+
+            return;
+    }
+
+    // If the data type has changed, the old summaries can't be combined with the new ones.
+    if (obsPtr->rollupType != dataType)
+    {
+        ClearRollups(obsPtr);
+
+        obsPtr->rollupType = dataType;
+    }
+
+    if (isnan(value))
+    {
+        return;
+    }
+
+    double timestamp = dataSample_GetTimestamp(sampleRef);
+
+    for (size_t i = 0; i < obsPtr->rollupCount; i++)
+    {
+        AddToRollupTier(&obsPtr->rollups[i], timestamp, value, 1);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the numerical values in an Observation's buffer that are newer than a given time to one of
+ * its rollup tiers, as if they were being accepted again.  A run counts all of its samples at the
+ * timestamp of its first one.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SeedRollupTier
+(
+    Observation_t* obsPtr,
+    RollupTier_t* tierPtr,
+    double afterTime    ///< Seconds since the Epoch, or NAN for the whole buffer.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (!obs_IsBufferNumerical(obsPtr))
+    {
+        return;
+    }
+
+    // If the data type has changed, the old summaries can't be combined with the new ones.
+    if (obsPtr->rollupType != obsPtr->bufferedType)
+    {
+        ClearRollups(obsPtr);
+
+        obsPtr->rollupType = obsPtr->bufferedType;
+    }
+
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    for (size_t i = 0; i < bufferPtr->count; i++)
+    {
+        double timestamp = obs_GetBufferedTimestamp(bufferPtr, i);
+
+        if (!isnan(afterTime) && (timestamp <= afterTime))
+        {
+            continue;
+        }
+
+        double value = obs_GetBufferedNumber(obsPtr, i);
+
+        if (!isnan(value))
+        {
+            AddToRollupTier(tierPtr, timestamp, value, obs_GetBufferedWeight(bufferPtr, i));
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the numerical values in an Observation's buffer that are newer than a given time to all of
+ * its rollup tiers, as if they were being accepted again.  Used to catch the tiers restored from
+ * backup up with the samples accepted after the tiers were backed up.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SeedRollups
+(
+    Observation_t* obsPtr,
+    double afterTime    ///< Seconds since the Epoch, or NAN for the whole buffer.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    for (size_t i = 0; i < obsPtr->rollupCount; i++)
+    {
+        SeedRollupTier(obsPtr, &obsPtr->rollups[i], afterTime);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the oldest row of a rollup tier whose bucket starts at or after a given time.
+ *
+ * @return The index of the row (0 = oldest), or the number of rows if there isn't one.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t FindRollupIndex
+(
+    RollupTier_t* tierPtr,
+    double startTime    ///< Seconds since the Epoch, or NAN for the oldest.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (isnan(startTime))
+    {
+        return 0;
+    }
+
+    // Rows are in order of their start times, so binary search.
+    size_t low = 0;
+    size_t high = obs_GetRollupRowCount(tierPtr);
+
+    while (low < high)
+    {
+        size_t middle = low + ((high - low) / 2);
+
+        if (obs_GetRollupRow(tierPtr, middle)->startTime < startTime)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Terminate a read operation.
+ */
+//--------------------------------------------------------------------------------------------------
+static void EndRead
+(
+    ReadOperation_t* opPtr,
+    le_result_t result
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_fdMonitor_Delete(opPtr->fdMonitor);
+
+    close(opPtr->fd);
+
+    if (opPtr->spillSampleRef != NULL)
+    {
+        le_mem_Release(opPtr->spillSampleRef);
+    }
+
+    opPtr->handlerPtr(result, opPtr->contextPtr);
+
+    le_dls_Remove(&opPtr->obsPtr->readOpList, &opPtr->link);
+
+    le_mem_Release(opPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert the value of a sample in an Observation's buffer to JSON.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_OVERFLOW if the buffer provided is too small to hold the value.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ConvertBufferedValueToJson
+(
+    Observation_t* obsPtr,
+    size_t index,           ///< Index of the sample in the buffer (0 = oldest).
+    char* valueBuffPtr,     ///< [OUT] Ptr to buffer where value will be stored.
+    size_t valueBuffSize    ///< [IN] Size of value buffer, in bytes.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    switch (obsPtr->bufferedType)
+    {
+        case IO_DATA_TYPE_TRIGGER:
+
+            return le_utf8_Copy(valueBuffPtr, "null", valueBuffSize, NULL);
+
+        case IO_DATA_TYPE_BOOLEAN:
+
+            return le_utf8_Copy(valueBuffPtr,
+                                obs_GetBufferedNumber(obsPtr, index) ? "true" : "false",
+                                valueBuffSize,
+                                NULL);
+
+        case IO_DATA_TYPE_NUMERIC:
+        {
+            int len = snprintf(valueBuffPtr,
+                               valueBuffSize,
+                               "%lf",
+                               obs_GetBufferedNumber(obsPtr, index));
+            if ((len < 0) || ((size_t)len >= valueBuffSize))
+            {
+                return LE_OVERFLOW;
+            }
+            return LE_OK;
+        }
+
+        case IO_DATA_TYPE_STRING:
+        case IO_DATA_TYPE_JSON:
+        {
+            dataSample_Ref_t sampleRef = bufferPtr->values.samples[obs_GetSlot(bufferPtr, index)];
+
+            return dataSample_ConvertToJson(sampleRef,
+                                            obsPtr->bufferedType,
+                                            valueBuffPtr,
+                                            valueBuffSize);
+        }
+    }
+
+    LE_FATAL("Invalid data type %d.", obsPtr->bufferedType);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print a JSON representation of a sample in an Observation's buffer into a character buffer.
+ * E.g.,
+ *
+ * @code
+ * {"t":1537483647.125000,"v":true}
+ * @endcode
+ *
+ * @return The number of characters printed (excl. null terminator), or 0 if it didn't fit.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PrintBufferedSample
+(
+    Observation_t* obsPtr,
+    size_t index,       ///< Index of the sample in the buffer (0 = oldest).
+    char* buffPtr,      ///< [OUT] Ptr to buffer to print into.
+    size_t buffSize     ///< Size of the buffer, in bytes.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int len = snprintf(buffPtr,
+                       buffSize,
+                       "{\"t\":%lf,\"v\":",
+                       obs_GetBufferedTimestamp(&obsPtr->buffer, index));
+    if ((len < 0) || ((size_t)len >= buffSize))
+    {
+        return 0;
+    }
+
+    // Copy the JSON version of the buffered sample's value into the buffer,
+    // if there's space (leaving room for an additional '}' at the end).
+    le_result_t result = ConvertBufferedValueToJson(obsPtr,
+                                                    index,
+                                                    buffPtr + len,
+                                                    buffSize - len - 1);
+    if (result != LE_OK)
+    {
+        return 0;
+    }
+
+    len += strlen(buffPtr + len);
+
+    buffPtr[len] = '}';
+    buffPtr[len + 1] = '\0';
+
+    return len + 1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the start of a JSON representation of a sample in an Observation's string or JSON buffer
+ * into a character buffer: everything that comes before the value's text.  E.g.,
+ *
+ * @code
+ * {"t":1537483647.125000,"v":"
+ * @endcode
+ *
+ * @return The number of characters printed (excl. null terminator), or 0 if it didn't fit.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PrintBufferedSampleHead
+(
+    Observation_t* obsPtr,
+    size_t index,       ///< Index of the sample in the buffer (0 = oldest).
+    char* buffPtr,      ///< [OUT] Ptr to buffer to print into.
+    size_t buffSize     ///< Size of the buffer, in bytes.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int len = snprintf(buffPtr,
+                       buffSize,
+                       "{\"t\":%lf,\"v\":%s",
+                       obs_GetBufferedTimestamp(&obsPtr->buffer, index),
+                       (obsPtr->bufferedType == IO_DATA_TYPE_STRING) ? "\"" : "");
+    if ((len < 0) || ((size_t)len >= buffSize))
+    {
+        return 0;
+    }
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the initial byte(s) of a CBOR data item: its major type and an argument (the length of a
+ * string, the number of pairs in a map, etc.).
+ *
+ * @return The number of bytes encoded (at most 5).
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PutCborHead
+(
+    uint8_t* buffPtr,   ///< [OUT] Where to put the bytes.
+    uint8_t majorType,  ///< Major type, shifted into the top three bits.
+    uint32_t argument
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (argument < 24)
+    {
+        buffPtr[0] = majorType | argument;
+        return 1;
+    }
+
+    size_t size = ((argument <= UINT8_MAX) ? 1 : (argument <= UINT16_MAX) ? 2 : 4);
+
+    // Additional information 24, 25, and 26 mean 1, 2, and 4 bytes of big-endian argument follow.
+    buffPtr[0] = majorType | ((size == 1) ? 24 : (size == 2) ? 25 : 26);
+    for (size_t i = 0; i < size; i++)
+    {
+        buffPtr[1 + i] = argument >> (8 * (size - 1 - i));
+    }
+
+    return 1 + size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a double-precision floating point number as a CBOR data item.
+ *
+ * @return The number of bytes encoded (always 9).
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PutCborDouble
+(
+    uint8_t* buffPtr,   ///< [OUT] Where to put the bytes.
+    double value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    buffPtr[0] = CBOR_DOUBLE;
+    for (size_t i = 0; i < sizeof(bits); i++)
+    {
+        buffPtr[1 + i] = bits >> (8 * (sizeof(bits) - 1 - i));
+    }
+
+    return 1 + sizeof(bits);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a text string as a CBOR data item.
+ *
+ * @return The number of bytes encoded.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PutCborText
+(
+    uint8_t* buffPtr,   ///< [OUT] Where to put the bytes.
+    const char* textPtr,
+    size_t textLen      ///< Number of bytes in the text.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t len = PutCborHead(buffPtr, CBOR_MAJOR_TYPE_TEXT, textLen);
+
+    memcpy(buffPtr + len, textPtr, textLen);
+
+    return len + textLen;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a sample in an Observation's buffer as a SenML record in CBOR: a map of the sample's
+ * time and value (no value for triggers), with the Observation's path as the base name if
+ * requested.  The text of a string or JSON value is left out (everything up to it is encoded),
+ * so that it can be written a piece at a time after it.
+ *
+ * @return The number of bytes encoded, or 0 if it didn't fit.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PrintBufferedSampleCbor
+(
+    Observation_t* obsPtr,
+    size_t index,       ///< Index of the sample in the buffer (0 = oldest).
+    const char* baseNamePtr, ///< Base name to put in the record, or NULL if none.
+    uint8_t* buffPtr,   ///< [OUT] Ptr to buffer to encode into.
+    size_t buffSize     ///< Size of the buffer, in bytes.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    io_DataType_t dataType = obsPtr->bufferedType;
+
+    size_t baseNameLen = ((baseNamePtr != NULL) ? strlen(baseNamePtr) : 0);
+
+    // Map head, base name pair, time pair, and value pair (with a string head or double value).
+    if ((1 + (1 + 5 + baseNameLen) + (1 + 9) + (1 + 9)) > buffSize)
+    {
+        return 0;
+    }
+
+    size_t pairCount = (  ((baseNamePtr != NULL) ? 1 : 0)
+                        + 1
+                        + ((dataType != IO_DATA_TYPE_TRIGGER) ? 1 : 0));
+    size_t len = PutCborHead(buffPtr, CBOR_MAJOR_TYPE_MAP, pairCount);
+
+    if (baseNamePtr != NULL)
+    {
+        buffPtr[len++] = SENML_LABEL_BASE_NAME;
+        len += PutCborText(buffPtr + len, baseNamePtr, baseNameLen);
+    }
+
+    buffPtr[len++] = SENML_LABEL_TIME;
+    len += PutCborDouble(buffPtr + len, obs_GetBufferedTimestamp(bufferPtr, index));
+
+    switch (dataType)
+    {
+        case IO_DATA_TYPE_TRIGGER:
+
+            break;
+
+        case IO_DATA_TYPE_BOOLEAN:
+
+            buffPtr[len++] = SENML_LABEL_BOOLEAN_VALUE;
+            buffPtr[len++] = (obs_GetBufferedNumber(obsPtr, index) ? CBOR_TRUE : CBOR_FALSE);
+            break;
+
+        case IO_DATA_TYPE_NUMERIC:
+
+            buffPtr[len++] = SENML_LABEL_VALUE;
+            len += PutCborDouble(buffPtr + len, obs_GetBufferedNumber(obsPtr, index));
+            break;
+
+        case IO_DATA_TYPE_STRING:
+        case IO_DATA_TYPE_JSON:
+        {
+            dataSample_Ref_t sampleRef = bufferPtr->values.samples[obs_GetSlot(bufferPtr, index)];
+            const char* textPtr = ((dataType == IO_DATA_TYPE_STRING) ?
+                                        dataSample_GetString(sampleRef) :
+                                        dataSample_GetJson(sampleRef));
+
+            buffPtr[len++] = SENML_LABEL_STRING_VALUE;
+            len += PutCborHead(buffPtr + len, CBOR_MAJOR_TYPE_TEXT, strlen(textPtr));
+            break;
+        }
+    }
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a double as an 8-byte IEEE 754 double in little-endian byte order, whatever the host's
+ * byte order is.
+ *
+ * @return The number of bytes encoded (always 8).
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PutLittleEndianDouble
+(
+    uint8_t* buffPtr,   ///< [OUT] Where to put the bytes.
+    double value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    for (size_t i = 0; i < sizeof(bits); i++)
+    {
+        buffPtr[i] = bits >> (8 * i);
+    }
+
+    return sizeof(bits);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a sample in an Observation's numeric or Boolean buffer as its timestamp followed by its
+ * value, both as little-endian 8-byte doubles.
+ *
+ * @return The number of bytes encoded, or 0 if it didn't fit.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PrintBufferedSampleRaw
+(
+    Observation_t* obsPtr,
+    size_t index,       ///< Index of the sample in the buffer (0 = oldest).
+    uint8_t* buffPtr,   ///< [OUT] Ptr to buffer to encode into.
+    size_t buffSize     ///< Size of the buffer, in bytes.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if ((2 * sizeof(double)) > buffSize)
+    {
+        return 0;
+    }
+
+    size_t len = PutLittleEndianDouble(buffPtr, obs_GetBufferedTimestamp(&obsPtr->buffer, index));
+    len += PutLittleEndianDouble(buffPtr + len, obs_GetBufferedNumber(obsPtr, index));
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start appending an element of the array to a read operation's write buffer, putting a comma in
+ * first if it's a JSON array and this isn't the first element.
+ *
+ * @return The offset into the write buffer to print the element at, or SIZE_MAX if there's no
+ *         room for it.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t StartReadOpElement
+(
+    ReadOperation_t* opPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t len = opPtr->writeLen;
+
+    if ((opPtr->elementCount > 0) && (opPtr->mode.format == QUERY_FORMAT_JSON))
+    {
+        if (len + 1 >= sizeof(opPtr->writeBuffer))
+        {
+            LE_CRIT("Buffer overflow. Skipping entry.");
+            return SIZE_MAX;
+        }
+        opPtr->writeBuffer[len++] = ',';
+    }
+
+    return len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Finish appending an element of the array to a read operation's write buffer.  If the element
+ * couldn't be printed, the comma put in before it is taken out again.
+ */
+//--------------------------------------------------------------------------------------------------
+static void EndReadOpElement
+(
+    ReadOperation_t* opPtr,
+    size_t offset,      ///< Offset that the element was printed at.
+    size_t elementLen   ///< Number of characters printed (excl. null terminator), 0 if none.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (elementLen > 0)
+    {
+        opPtr->writeLen = offset + elementLen;
+        opPtr->elementCount++;
+    }
+    else
+    {
+        opPtr->writeBuffer[opPtr->writeLen] = '\0';
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write as much of the rest of a sample that has been started in a read operation's write buffer
+ * (the text of its value, then whatever comes after that) as fits in the write buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DrainReadOpSpill
+(
+    ReadOperation_t* opPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char* buffPtr = opPtr->writeBuffer + opPtr->writeLen;
+    size_t buffSize = sizeof(opPtr->writeBuffer) - opPtr->writeLen;
+    size_t len;
+
+    if (opPtr->spillEscaped)
+    {
+        opPtr->spillTextPtr += dataSample_StringToJsonPiece(buffPtr,
+                                                            opPtr->spillTextPtr,
+                                                            buffSize,
+                                                            &len);
+    }
+    else
+    {
+        len = strnlen(opPtr->spillTextPtr, buffSize);
+        memcpy(buffPtr, opPtr->spillTextPtr, len);
+        opPtr->spillTextPtr += len;
+    }
+
+    opPtr->writeLen += len;
+
+    if (*opPtr->spillTextPtr != '\0')
+    {
+        return;  // The write buffer is full.
+    }
+
+    while ((*opPtr->spillTailPtr != '\0') && (opPtr->writeLen < sizeof(opPtr->writeBuffer)))
+    {
+        opPtr->writeBuffer[opPtr->writeLen++] = *(opPtr->spillTailPtr++);
+    }
+
+    if (*opPtr->spillTailPtr == '\0')
+    {
+        le_mem_Release(opPtr->spillSampleRef);
+        opPtr->spillSampleRef = NULL;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a representation of a sample in an Observation's buffer, in the read operation's format,
+ * to its write buffer (separated from the previous sample by a comma in JSON format).
+ *
+ * String and JSON values can be much bigger than the write buffer, so for those, only the part of
+ * the sample before the value's text is appended right away.  The rest follows as the write buffer
+ * has room for it (see DrainReadOpSpill()), so it may be spread over several chunks.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AppendReadOpSample
+(
+    ReadOperation_t* opPtr,
+    size_t index    ///< Index of the sample in the buffer (0 = oldest).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t offset = StartReadOpElement(opPtr);
+
+    if (offset == SIZE_MAX)
+    {
+        return;
+    }
+
+    Observation_t* obsPtr = opPtr->obsPtr;
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    io_DataType_t dataType = obsPtr->bufferedType;
+    bool isText = ((dataType == IO_DATA_TYPE_STRING) || (dataType == IO_DATA_TYPE_JSON));
+
+    char* buffPtr = opPtr->writeBuffer + offset;
+    size_t buffSize = sizeof(opPtr->writeBuffer) - offset;
+    size_t len = 0;
+
+    switch (opPtr->mode.format)
+    {
+        case QUERY_FORMAT_JSON:
+
+            if (isText)
+            {
+                len = PrintBufferedSampleHead(obsPtr, index, buffPtr, buffSize);
+            }
+            else
+            {
+                len = PrintBufferedSample(obsPtr, index, buffPtr, buffSize);
+            }
+            break;
+
+        case QUERY_FORMAT_SENML_CBOR:
+        {
+            // The first record carries the Observation's path as the base name.
+            char path[IO_MAX_RESOURCE_PATH_LEN + 1];
+            const char* baseNamePtr = NULL;
+
+            if (   (opPtr->elementCount == 0)
+                && (resTree_GetPath(path,
+                                    sizeof(path),
+                                    resTree_GetRoot(),
+                                    res_GetResTreeEntry(&opPtr->obsPtr->resource)) > 0)  )
+            {
+                baseNamePtr = path;
+            }
+
+            len = PrintBufferedSampleCbor(obsPtr,
+                                          index,
+                                          baseNamePtr,
+                                          (uint8_t*)buffPtr,
+                                          buffSize);
+            break;
+        }
+        case QUERY_FORMAT_RAW:
+
+            len = PrintBufferedSampleRaw(obsPtr, index, (uint8_t*)buffPtr, buffSize);
+            break;
+    }
+
+    if (len == 0)
+    {
+        LE_CRIT("Buffer overflow. Skipping entry.");
+    }
+
+    EndReadOpElement(opPtr, offset, len);
+
+    if ((len == 0) || !isText || (opPtr->mode.format == QUERY_FORMAT_RAW))
+    {
+        return;
+    }
+
+    // Hold onto the sample until its value has been written, in case it is dropped from the
+    // buffer in the meantime.
+    dataSample_Ref_t sampleRef = bufferPtr->values.samples[obs_GetSlot(bufferPtr, index)];
+    le_mem_AddRef(sampleRef);
+
+    opPtr->spillSampleRef = sampleRef;
+    opPtr->spillTextPtr = ((dataType == IO_DATA_TYPE_STRING) ?
+                                dataSample_GetString(sampleRef) :
+                                dataSample_GetJson(sampleRef));
+    opPtr->spillEscaped = (   (opPtr->mode.format == QUERY_FORMAT_JSON)
+                           && (dataType == IO_DATA_TYPE_STRING));
+    if (opPtr->mode.format == QUERY_FORMAT_JSON)
+    {
+        opPtr->spillTailPtr = ((dataType == IO_DATA_TYPE_STRING) ? "\"}" : "}");
+    }
+    else
+    {
+        opPtr->spillTailPtr = "";
+    }
+
+    DrainReadOpSpill(opPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resize an Observation's JSON chunk cache to hold every chunk of its buffer, if its maximum count
+ * has changed since the cache was allocated.  Chunks that are still in the buffer are moved to
+ * their slots in the new cache.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResizeJsonChunkCache
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t slotCount = GetJsonChunkSlotCount(obsPtr);
+
+    if ((obsPtr->jsonChunks != NULL) && (obsPtr->jsonChunkSlots == slotCount))
+    {
+        return;
+    }
+
+    JsonChunk_t** oldChunks = obsPtr->jsonChunks;
+    size_t oldSlotCount = obsPtr->jsonChunkSlots;
+
+    obsPtr->jsonChunks = obs_AllocBufferArray(slotCount * sizeof(JsonChunk_t*));
+    memset(obsPtr->jsonChunks, 0, slotCount * sizeof(JsonChunk_t*));
+    obsPtr->jsonChunkSlots = slotCount;
+
+    for (size_t i = 0; i < oldSlotCount; i++)
+    {
+        JsonChunk_t* chunkPtr = oldChunks[i];
+
+        if (chunkPtr != NULL)
+        {
+            JsonChunk_t** slotPtr = GetJsonChunkSlot(obsPtr, chunkPtr->firstSeq);
+
+            if (   (chunkPtr->firstSeq >= obsPtr->buffer.firstSeq)
+                && (*slotPtr == NULL))
+            {
+                *slotPtr = chunkPtr;
+            }
+            else
+            {
+                le_mem_Release(chunkPtr);
+            }
+        }
+    }
+
+    obs_FreeBufferArray(oldChunks);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serialize the chunk of an Observation's buffer that starts with a given sample in JSON, and put
+ * it in the Observation's chunk cache, so that the samples in it are only serialized once, no
+ * matter how many read operations read them.  Nothing is done if the chunk is cached already, or
+ * if it doesn't fit in JSON_CHUNK_MAX_BYTES.
+ *
+ * Only whole chunks that don't include the newest entry in the buffer are cached, because the
+ * newest entry can still change (swinging door compression replaces it, and run-length encoding
+ * extends it).
+ */
+//--------------------------------------------------------------------------------------------------
+static void CacheJsonChunk
+(
+    Observation_t* obsPtr,
+    uint64_t seq    ///< Sequence number of the first sample in the chunk.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    if (   ((seq % JSON_CHUNK_SAMPLES) != 0)
+        || (seq < bufferPtr->firstSeq)
+        || ((seq + JSON_CHUNK_SAMPLES) >= (bufferPtr->firstSeq + bufferPtr->count))  )
+    {
+        return;
+    }
+
+    ResizeJsonChunkCache(obsPtr);
+
+    JsonChunk_t** slotPtr = GetJsonChunkSlot(obsPtr, seq);
+
+    if ((*slotPtr != NULL) && ((*slotPtr)->firstSeq == seq))
+    {
+        return;
+    }
+
+    char json[JSON_CHUNK_MAX_BYTES];
+    size_t len = 0;
+    size_t index = seq - bufferPtr->firstSeq;
+
+    for (size_t i = 0; i < JSON_CHUNK_SAMPLES; i++)
+    {
+        size_t sampleLen = 0;
+
+        if ((i == 0) || ((len + 1) < sizeof(json)))
+        {
+            if (i > 0)
+            {
+                json[len++] = ',';
+            }
+            sampleLen = PrintBufferedSample(obsPtr, index + i, json + len, sizeof(json) - len);
+        }
+
+        if (sampleLen == 0)
+        {
+            return;
+        }
+
+        len += sampleLen;
+    }
+
+    size_t poolIndex = 0;
+    while (GetJsonChunkPoolBytes(poolIndex) < len)
+    {
+        poolIndex++;
+    }
+
+    // The slot is big enough for every chunk in the buffer, so anything in it has been dropped.
+    if (*slotPtr != NULL)
+    {
+        le_mem_Release(*slotPtr);
+    }
+
+    JsonChunk_t* chunkPtr = le_mem_ForceAlloc(JsonChunkPools[poolIndex]);
+    chunkPtr->firstSeq = seq;
+    chunkPtr->len = len;
+    memcpy(chunkPtr->json, json, len);
+
+    *slotPtr = chunkPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serialize every whole chunk of an Observation's buffer that isn't cached yet.  This is for
+ * samples that were put in the buffer without going through obs_AddToBuffer(), such as those
+ * restored from a backup file mapped into memory.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_CacheJsonChunks
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    uint64_t firstSeq = bufferPtr->firstSeq;
+
+    for (uint64_t seq = firstSeq + ((JSON_CHUNK_SAMPLES - (firstSeq % JSON_CHUNK_SAMPLES))
+                                    % JSON_CHUNK_SAMPLES);
+         (seq + JSON_CHUNK_SAMPLES) < (firstSeq + bufferPtr->count);
+         seq += JSON_CHUNK_SAMPLES)
+    {
+        CacheJsonChunk(obsPtr, seq);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the chunk of an Observation's buffer that starts with a given sample, serialized in JSON,
+ * from the Observation's chunk cache.
+ *
+ * @return Ptr to the chunk, or NULL if the sample doesn't start a chunk that is cached.
+ */
+//--------------------------------------------------------------------------------------------------
+static const JsonChunk_t* GetJsonChunk
+(
+    Observation_t* obsPtr,
+    uint64_t seq    ///< Sequence number of the first sample in the chunk.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    if (   (obsPtr->jsonChunks == NULL)
+        || ((seq % JSON_CHUNK_SAMPLES) != 0)
+        || (seq < bufferPtr->firstSeq)
+        || ((seq + JSON_CHUNK_SAMPLES) >= (bufferPtr->firstSeq + bufferPtr->count))  )
+    {
+        return NULL;
+    }
+
+    JsonChunk_t* chunkPtr = *GetJsonChunkSlot(obsPtr, seq);
+
+    if ((chunkPtr == NULL) || (chunkPtr->firstSeq != seq))
+    {
+        return NULL;
+    }
+
+    return chunkPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append the next chunk of samples to be read to a JSON read operation's write buffer from the
+ * Observation's chunk cache, if the next sample to be read starts a chunk that is cached.
+ *
+ * @return true if the chunk was appended, false if the samples must be appended one by one.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool AppendReadOpJsonChunk
+(
+    ReadOperation_t* opPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const JsonChunk_t* chunkPtr = GetJsonChunk(opPtr->obsPtr, opPtr->nextSeq);
+
+    if (   (chunkPtr == NULL)
+        || ((opPtr->writeLen + 1 + chunkPtr->len) >= sizeof(opPtr->writeBuffer))  )
+    {
+        return false;
+    }
+
+    size_t offset = StartReadOpElement(opPtr);
+
+    memcpy(opPtr->writeBuffer + offset, chunkPtr->json, chunkPtr->len);
+
+    opPtr->writeLen = offset + chunkPtr->len;
+    opPtr->writeBuffer[opPtr->writeLen] = '\0';
+    opPtr->elementCount += JSON_CHUNK_SAMPLES;
+
+    // Cached chunks never include the newest sample, so there is always another one after it.
+    opPtr->nextSeq += JSON_CHUNK_SAMPLES;
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the range of buffer indices covered by one of a downsampling read operation's buckets,
+ * leaving out any samples that have since been dropped from the buffer.
+ *
+ * @return true if the range is non-empty, false if all of its samples are gone.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool GetDownsamplingBucketRange
+(
+    ReadOperation_t* opPtr,
+    size_t bucket,          ///< Index of the bucket.
+    size_t* startIndexPtr,  ///< [OUT] Index of the first sample in the bucket.
+    size_t* endIndexPtr     ///< [OUT] Index after the last sample in the bucket.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const ReadDownsampling_t* dsPtr = &opPtr->mode.downsampling;
+    const SampleBuffer_t* bufferPtr = &opPtr->obsPtr->buffer;
+
+    uint64_t firstSeq = dsPtr->firstSeq;
+    uint64_t endSeq = dsPtr->endSeq;
+    uint64_t bucket64 = bucket;
+    uint64_t bucketCount = dsPtr->bucketCount;
+
+    // LTTB always keeps the first and last samples, each in a bucket of its own.
+    if (dsPtr->method == QUERY_DOWNSAMPLING_LTTB)
+    {
+        if (bucket == 0)
+        {
+            endSeq = firstSeq + 1;
+            bucket64 = 0;
+            bucketCount = 1;
+        }
+        else if (bucket + 1 == dsPtr->bucketCount)
+        {
+            firstSeq = endSeq - 1;
+            bucket64 = 0;
+            bucketCount = 1;
+        }
+        else
+        {
+            firstSeq++;
+            endSeq--;
+            bucket64--;
+            bucketCount -= 2;
+        }
+    }
+
+    uint64_t sampleCount = endSeq - firstSeq;
+    uint64_t startSeq = firstSeq + ((bucket64 * sampleCount) / bucketCount);
+    uint64_t stopSeq = firstSeq + (((bucket64 + 1) * sampleCount) / bucketCount);
+
+    // Samples may have been dropped from the buffer since the read started.
+    if (startSeq < bufferPtr->firstSeq)
+    {
+        startSeq = bufferPtr->firstSeq;
+    }
+    if (stopSeq > bufferPtr->firstSeq + bufferPtr->count)
+    {
+        stopSeq = bufferPtr->firstSeq + bufferPtr->count;
+    }
+    if (startSeq >= stopSeq)
+    {
+        return false;
+    }
+
+    *startIndexPtr = startSeq - bufferPtr->firstSeq;
+    *endIndexPtr = stopSeq - bufferPtr->firstSeq;
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a JSON representation of the samples chosen to represent the next bucket of a
+ * downsampling read operation to its write buffer.  See ReadDownsampling_t.
+ *
+ * Buckets are visited in order, each one once to select its samples and once before that to
+ * compute its average (for LTTB), so the read makes a single forward sweep over the buffer.
+ * NAN values are never selected.
+ *
+ * @return true if successful, false if there are no more buckets.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool LoadReadOpDownsampled
+(
+    ReadOperation_t* opPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = opPtr->obsPtr;
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    ReadDownsampling_t* dsPtr = &opPtr->mode.downsampling;
+
+    // Only numeric and Boolean type data can be downsampled.  The buffered type can change while
+    // the read is in progress, so check every time.
+    if (!obs_IsBufferNumerical(obsPtr))
+    {
+        return false;
+    }
+
+    size_t startLen = opPtr->writeLen;
+
+    do
+    {
+        if (dsPtr->nextBucket >= dsPtr->bucketCount)
+        {
+            return false;
+        }
+
+        size_t bucket = dsPtr->nextBucket++;
+        size_t startIndex;
+        size_t endIndex;
+
+        if (!GetDownsamplingBucketRange(opPtr, bucket, &startIndex, &endIndex))
+        {
+            continue;
+        }
+
+        if (dsPtr->method == QUERY_DOWNSAMPLING_MIN_MAX)
+        {
+            size_t minIndex = SIZE_MAX;
+            size_t maxIndex = SIZE_MAX;
+            double min = 0;
+            double max = 0;
+
+            for (size_t index = startIndex; index < endIndex; index++)
+            {
+                double value = obs_GetBufferedNumber(obsPtr, index);
+
+                if (isnan(value))
+                {
+                    continue;
+                }
+                if ((minIndex == SIZE_MAX) || (value < min))
+                {
+                    min = value;
+                    minIndex = index;
+                }
+                if ((maxIndex == SIZE_MAX) || (value > max))
+                {
+                    max = value;
+                    maxIndex = index;
+                }
+            }
+
+            // Write the minimum and maximum in time order (just once if they're the same sample).
+            if (minIndex != SIZE_MAX)
+            {
+                AppendReadOpSample(opPtr, (minIndex < maxIndex) ? minIndex : maxIndex);
+
+                if (minIndex != maxIndex)
+                {
+                    AppendReadOpSample(opPtr, (minIndex < maxIndex) ? maxIndex : minIndex);
+                }
+            }
+        }
+        else
+        {
+            // Compute the average of the next bucket, the third corner of the triangles.
+            double nextTimestamp = NAN;
+            double nextValue = NAN;
+            size_t nextStartIndex;
+            size_t nextEndIndex;
+
+            if (   (dsPtr->nextBucket < dsPtr->bucketCount)
+                && GetDownsamplingBucketRange(opPtr, dsPtr->nextBucket, &nextStartIndex,
+                                              &nextEndIndex)  )
+            {
+                double timestampSum = 0;
+                double valueSum = 0;
+                size_t count = 0;
+
+                for (size_t index = nextStartIndex; index < nextEndIndex; index++)
+                {
+                    double value = obs_GetBufferedNumber(obsPtr, index);
+
+                    if (!isnan(value))
+                    {
+                        timestampSum += obs_GetBufferedTimestamp(bufferPtr, index);
+                        valueSum += value;
+                        count++;
+                    }
+                }
+
+                if (count > 0)
+                {
+                    nextTimestamp = timestampSum / count;
+                    nextValue = valueSum / count;
+                }
+            }
+
+            // Pick the sample that forms the largest triangle.  Until a sample has been written,
+            // or if the next bucket has no average, just take the first (or furthest) one.
+            size_t bestIndex = SIZE_MAX;
+            double bestArea = -1;
+
+            for (size_t index = startIndex; index < endIndex; index++)
+            {
+                double value = obs_GetBufferedNumber(obsPtr, index);
+
+                if (isnan(value))
+                {
+                    continue;
+                }
+
+                if (isnan(dsPtr->prevValue))
+                {
+                    bestIndex = index;
+                    break;
+                }
+
+                double timestamp = obs_GetBufferedTimestamp(bufferPtr, index);
+                double area;
+
+                if (isnan(nextValue))
+                {
+                    area = fabs(value - dsPtr->prevValue);
+                }
+                else
+                {
+                    area = fabs(  ((dsPtr->prevTimestamp - nextTimestamp)
+                                   * (value - dsPtr->prevValue))
+                                - ((dsPtr->prevTimestamp - timestamp)
+                                   * (nextValue - dsPtr->prevValue)));
+                }
+
+                if (area > bestArea)
+                {
+                    bestArea = area;
+                    bestIndex = index;
+                }
+            }
+
+            if (bestIndex != SIZE_MAX)
+            {
+                AppendReadOpSample(opPtr, bestIndex);
+
+                dsPtr->prevTimestamp = obs_GetBufferedTimestamp(bufferPtr, bestIndex);
+                dsPtr->prevValue = obs_GetBufferedNumber(obsPtr, bestIndex);
+            }
+        }
+
+    } while (opPtr->writeLen == startLen); // Loop if nothing has been added yet.
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print a JSON representation of the aggregates of the values in a bucket of time into a
+ * character buffer.  E.g.,
+ *
+ * @code
+ * {"t":1537483620.000000,"count":60,"min":20.100000,"max":22.400000,"mean":21.250000}
+ * @endcode
+ *
+ * @return The number of characters printed (excl. null terminator), or 0 if it didn't fit.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PrintAggregates
+(
+    char* buffPtr,      ///< [OUT] Ptr to buffer to print into.
+    size_t buffSize,    ///< Size of the buffer, in bytes.
+    query_Aggregate_t aggregates,   ///< Aggregates to print.
+    double startTime,   ///< Start time of the bucket.
+    size_t count,       ///< Number of values in the bucket.
+    double min,         ///< Minimum value.
+    double max,         ///< Maximum value.
+    double mean         ///< Mean value.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int len = snprintf(buffPtr, buffSize, "{\"t\":%lf", startTime);
+
+    // Each snprintf() result is checked for an error (< 0) before it is compared with the space
+    // that is left, so a failure can't turn into a huge unsigned length.
+    if ((aggregates & QUERY_AGGREGATE_COUNT) && (len >= 0) && ((size_t)len < buffSize))
+    {
+        int n = snprintf(buffPtr + len, buffSize - len, ",\"count\":%zu", count);
+        len = ((n < 0) ? n : (len + n));
+    }
+    if ((aggregates & QUERY_AGGREGATE_MIN) && (len >= 0) && ((size_t)len < buffSize))
+    {
+        int n = snprintf(buffPtr + len, buffSize - len, ",\"min\":%lf", min);
+        len = ((n < 0) ? n : (len + n));
+    }
+    if ((aggregates & QUERY_AGGREGATE_MAX) && (len >= 0) && ((size_t)len < buffSize))
+    {
+        int n = snprintf(buffPtr + len, buffSize - len, ",\"max\":%lf", max);
+        len = ((n < 0) ? n : (len + n));
+    }
+    if ((aggregates & QUERY_AGGREGATE_MEAN) && (len >= 0) && ((size_t)len < buffSize))
+    {
+        int n = snprintf(buffPtr + len, buffSize - len, ",\"mean\":%lf", mean);
+        len = ((n < 0) ? n : (len + n));
+    }
+
+    // Leave room for the closing brace and null terminator.
+    if ((len < 0) || ((size_t)len + 1 >= buffSize))
+    {
+        LE_CRIT("Buffer overflow. Skipping bucket.");
+        return 0;
+    }
+
+    buffPtr[len] = '}';
+    buffPtr[len + 1] = '\0';
+
+    return len + 1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a JSON representation of the aggregates of the values in a bucket of time to a read
+ * operation's write buffer, separated from the previous bucket by a comma.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AppendReadOpAggregates
+(
+    ReadOperation_t* opPtr,
+    query_Aggregate_t aggregates,   ///< Aggregates to print.
+    double startTime,   ///< Start time of the bucket.
+    size_t count,       ///< Number of values in the bucket.
+    double min,         ///< Minimum value.
+    double max,         ///< Maximum value.
+    double mean         ///< Mean value.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t offset = StartReadOpElement(opPtr);
+
+    if (offset == SIZE_MAX)
+    {
+        return;
+    }
+
+    EndReadOpElement(opPtr,
+                     offset,
+                     PrintAggregates(opPtr->writeBuffer + offset,
+                                     sizeof(opPtr->writeBuffer) - offset,
+                                     aggregates,
+                                     startTime,
+                                     count,
+                                     min,
+                                     max,
+                                     mean));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a JSON representation of the aggregates of the next time bucket to be read that contains
+ * numerical values to the write buffer.  E.g.,
+ *
+ * @code
+ * {"t":1537483620.000000,"count":60,"min":20.100000,"max":22.400000,"mean":21.250000}
+ * @endcode
+ *
+ * Each call consumes the samples of one bucket, so the whole read makes a single forward pass
+ * over the buffer.
+ *
+ * @return true if successful, false if there are no more buckets.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool LoadReadOpBucket
+(
+    ReadOperation_t* opPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = opPtr->obsPtr;
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    const ReadBuckets_t* bucketsPtr = &opPtr->mode.buckets;
+
+    // Only numeric and Boolean type data can be aggregated.  The buffered type can change while
+    // the read is in progress, so check every time.
+    if (!obs_IsBufferNumerical(obsPtr))
+    {
+        opPtr->nextSeq = NO_MORE_SAMPLES;
+        return false;
+    }
+
+    size_t startLen = opPtr->writeLen;
+
+    do
+    {
+        double bucket = NAN;
+        size_t count = 0;
+        double min = NAN;
+        double max = NAN;
+        double sum = 0;
+
+        while (opPtr->nextSeq != NO_MORE_SAMPLES)
+        {
+            // If the sample has fallen off the end of the observation's buffer, then we know that
+            // all samples in the observation's buffer are now newer than this one.
+            if (opPtr->nextSeq < bufferPtr->firstSeq)
+            {
+                opPtr->nextSeq = bufferPtr->firstSeq;
+            }
+
+            if (opPtr->nextSeq >= bufferPtr->firstSeq + bufferPtr->count)
+            {
+                opPtr->nextSeq = NO_MORE_SAMPLES;
+                break;
+            }
+
+            size_t index = opPtr->nextSeq - bufferPtr->firstSeq;
+            double timestamp = obs_GetBufferedTimestamp(bufferPtr, index);
+
+            if (timestamp >= bucketsPtr->endTime)
+            {
+                opPtr->nextSeq = NO_MORE_SAMPLES;
+                break;
+            }
+
+            double sampleBucket = floor(  (timestamp - bucketsPtr->origin)
+                                        / bucketsPtr->bucketSeconds);
+
+            // Stop at the first sample of the next bucket, leaving it to be loaded next time.
+            if (!isnan(bucket) && (sampleBucket != bucket))
+            {
+                break;
+            }
+            bucket = sampleBucket;
+
+            double value = obs_GetBufferedNumber(obsPtr, index);
+
+            // A run of samples counts towards the bucket that it starts in.
+            if (!isnan(value))
+            {
+                uint32_t weight = obs_GetBufferedWeight(bufferPtr, index);
+                count += weight;
+                sum += value * weight;
+                min = fmin(min, value);
+                max = fmax(max, value);
+            }
+
+            opPtr->nextSeq++;
+        }
+
+        // If there were no samples left, we're done.
+        if (isnan(bucket))
+        {
+            return false;
+        }
+
+        // Skip buckets that contain nothing but NANs.
+        if (count == 0)
+        {
+            continue;
+        }
+
+        AppendReadOpAggregates(opPtr,
+                               bucketsPtr->aggregates,
+                               bucketsPtr->origin + (bucket * bucketsPtr->bucketSeconds),
+                               count,
+                               min,
+                               max,
+                               sum / count);
+
+    } while (opPtr->writeLen == startLen); // Loop if nothing has been added yet.
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a JSON representation of the next row of a rollup tier to be read to the write buffer,
+ * in the same format as LoadReadOpBucket() uses.  The row of the bucket currently being filled
+ * is read last.
+ *
+ * @return true if successful, false if there are no more rows.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool LoadReadOpRollup
+(
+    ReadOperation_t* opPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // The tier may have been removed while the read was in progress.
+    RollupTier_t* tierPtr = FindRollupTier(opPtr->obsPtr, opPtr->mode.rollupSeconds);
+
+    if (tierPtr == NULL)
+    {
+        opPtr->nextSeq = NO_MORE_SAMPLES;
+        return false;
+    }
+
+    size_t startLen = opPtr->writeLen;
+
+    do
+    {
+        if (opPtr->nextSeq == NO_MORE_SAMPLES)
+        {
+            return false;
+        }
+
+        // If the row has fallen off the end of the tier, then we know that all rows in the tier
+        // are now newer than this one.
+        if (opPtr->nextSeq < tierPtr->firstSeq)
+        {
+            opPtr->nextSeq = tierPtr->firstSeq;
+        }
+
+        size_t index = opPtr->nextSeq - tierPtr->firstSeq;
+
+        if (index >= obs_GetRollupRowCount(tierPtr))
+        {
+            opPtr->nextSeq = NO_MORE_SAMPLES;
+            return false;
+        }
+
+        const RollupRow_t* rowPtr = obs_GetRollupRow(tierPtr, index);
+
+        AppendReadOpAggregates(opPtr,
+                               QUERY_AGGREGATE_COUNT | QUERY_AGGREGATE_MIN
+                               | QUERY_AGGREGATE_MAX | QUERY_AGGREGATE_MEAN,
+                               rowPtr->startTime,
+                               rowPtr->count,
+                               rowPtr->min,
+                               rowPtr->max,
+                               rowPtr->mean);
+
+        // The open row is always the last one.
+        if (index < tierPtr->count)
+        {
+            opPtr->nextSeq++;
+        }
+        else
+        {
+            opPtr->nextSeq = NO_MORE_SAMPLES;
+        }
+
+    } while (opPtr->writeLen == startLen); // Loop if nothing has been added yet.
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a JSON representation of the next sample (or time bucket, downsampling bucket, or rollup
+ * row) to be read to the write buffer.
+ *
+ * @return true if successful, false if there are no more samples.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool LoadReadOpBuffer
+(
+    ReadOperation_t* opPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (opPtr->mode.buckets.aggregates != 0)
+    {
+        return LoadReadOpBucket(opPtr);
+    }
+
+    if (opPtr->mode.downsampling.bucketCount != 0)
+    {
+        return LoadReadOpDownsampled(opPtr);
+    }
+
+    if (opPtr->mode.rollupSeconds != 0)
+    {
+        return LoadReadOpRollup(opPtr);
+    }
+
+    // Only numeric and Boolean type data can be written in raw format.  The buffered type can
+    // change while the read is in progress, so check every time.
+    if ((opPtr->mode.format == QUERY_FORMAT_RAW) && !obs_IsBufferNumerical(opPtr->obsPtr))
+    {
+        opPtr->nextSeq = NO_MORE_SAMPLES;
+        return false;
+    }
+
+    SampleBuffer_t* bufferPtr = &opPtr->obsPtr->buffer;
+
+    size_t startLen = opPtr->writeLen;
+
+    do
+    {
+        if (opPtr->nextSeq == NO_MORE_SAMPLES)
+        {
+            return false;
+        }
+
+        // If the sample has fallen off the end of the observation's buffer, then we know that
+        // all samples in the observation's buffer are now newer than this one.
+        if (opPtr->nextSeq < bufferPtr->firstSeq)
+        {
+            opPtr->nextSeq = bufferPtr->firstSeq;
+        }
+
+        if (opPtr->nextSeq >= bufferPtr->firstSeq + bufferPtr->count)
+        {
+            opPtr->nextSeq = NO_MORE_SAMPLES;
+            return false;
+        }
+
+        // Whole chunks of samples that have already been serialized are copied from the cache.
+        if ((opPtr->mode.format == QUERY_FORMAT_JSON) && AppendReadOpJsonChunk(opPtr))
+        {
+            break;
+        }
+
+        size_t index = opPtr->nextSeq - bufferPtr->firstSeq;
+
+        // If the sample doesn't fit, this leaves the writeLen unchanged so we'll loop around and
+        // try the next sample.
+        AppendReadOpSample(opPtr, index);
+
+        // Advance to the next sample in the Observation's buffer, if there is one.
+        if ((index + 1) < bufferPtr->count)
+        {
+            opPtr->nextSeq++;
+        }
+        else
+        {
+            opPtr->nextSeq = NO_MORE_SAMPLES;
+        }
+
+    } while (opPtr->writeLen == startLen); // Loop if nothing has been added yet.
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write to an unbuffered file descriptor.
+ *
+ * @return The number of bytes written.  -1 on error (errno is set).
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t obs_WriteToFd
+(
+    int fd,
+    const void* buffPtr,
+    size_t byteCount
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ssize_t result;
+
+    LE_ASSERT(buffPtr != NULL);
+
+    do
+    {
+        result = write(fd, buffPtr, byteCount);
+
+    } while ((result == -1) && (errno == EINTR));
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill a read operation's write buffer with the next chunk of its array: as many samples as start
+ * within READ_OP_CHUNK_BYTES, along with the opening and closing brackets (or the CBOR
+ * indefinite-length array head and break) when their turn comes.  The chunk is then written out
+ * with as few system calls as the file descriptor allows.
+ *
+ * @return true if anything was put in the write buffer, false if the whole array has been written.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool FillReadOpChunk
+(
+    ReadOperation_t* opPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    opPtr->writeLen = 0;
+    opPtr->writeOffset = 0;
+    opPtr->writeBuffer[0] = '\0';
+
+    while (opPtr->writeLen < READ_OP_CHUNK_BYTES)
+    {
+        // The rest of a sample that didn't fit in the last chunk comes before anything else.
+        if (opPtr->spillSampleRef != NULL)
+        {
+            DrainReadOpSpill(opPtr);
+            continue;
+        }
+
+        switch (opPtr->state)
+        {
+            case START:
+
+                if (opPtr->mode.format == QUERY_FORMAT_JSON)
+                {
+                    opPtr->writeBuffer[opPtr->writeLen++] = '[';
+                }
+                else if (opPtr->mode.format == QUERY_FORMAT_SENML_CBOR)
+                {
+                    opPtr->writeBuffer[opPtr->writeLen++] = (char)CBOR_INDEFINITE_ARRAY;
+                }
+                opPtr->state = SAMPLE;
+                break;
+
+            case SAMPLE:
+
+                // Samples are loaded as late as possible, so ones added to the Observation's buffer
+                // while the read is waiting for the file descriptor are included.
+                if (!LoadReadOpBuffer(opPtr))
+                {
+                    opPtr->state = END;
+                }
+                break;
+
+            case END:
+
+                if (opPtr->mode.format == QUERY_FORMAT_JSON)
+                {
+                    opPtr->writeBuffer[opPtr->writeLen++] = ']';
+                }
+                else if (opPtr->mode.format == QUERY_FORMAT_SENML_CBOR)
+                {
+                    opPtr->writeBuffer[opPtr->writeLen++] = (char)CBOR_BREAK;
+                }
+                opPtr->state = DONE;
+                break;
+
+            case DONE:
+
+                return (opPtr->writeLen > 0);
+        }
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Continue a read operation.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ContinueReadOp
+(
+    ReadOperation_t* opPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    for (;;)
+    {
+        // If the write buffer has been written entirely, load the next chunk into it.
+        if (opPtr->writeOffset == opPtr->writeLen)
+        {
+            if (!FillReadOpChunk(opPtr))
+            {
+                EndRead(opPtr, LE_OK);
+
+                return;
+            }
+        }
+
+        // Write and check for errors.
+        ssize_t result = obs_WriteToFd(opPtr->fd,
+                                       opPtr->writeBuffer + opPtr->writeOffset,
+                                       opPtr->writeLen - opPtr->writeOffset);
+        if (result == -1)
+        {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                // Return and wait for this function to be called again by the FD Monitor.
+                return;
+            }
+
+            LE_ERROR("Error writing (%m).");
+            EndRead(opPtr, LE_COMM_ERROR);
+
+            return;
+        }
+
+        // Note: If the write buffer has not been written entirely, loop back around to write more.
+        opPtr->writeOffset += result;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Event handler call-back for events on a read operation's write file descriptor.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadOpFdEventHandler
+(
+    int fd,
+    short events
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ReadOperation_t* opPtr = le_fdMonitor_GetContextPtr();
+
+    // Check for error or hang-up.
+    if ((events & POLLERR) || (events & POLLHUP) || (events & POLLRDHUP))
+    {
+        LE_ERROR("Error or hang-up on output stream.");
+        EndRead(opPtr, LE_COMM_ERROR);
+    }
+    // Note: The only other reason for this function to be called is POLLOUT (writeable).
+    else
+    {
+        ContinueReadOp(opPtr);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start a read operation on a given Observation's buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartRead
+(
+    Observation_t* obsPtr,
+    uint64_t startSeq, ///< Sequence number of sample to start at, or NO_MORE_SAMPLES if none.
+    const ReadMode_t* modePtr, ///< What to write, or NULL to write the raw samples.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Set the fd non-blocking
+    if (0 != fcntl(outputFile, F_SETFL, O_NONBLOCK))
+    {
+        LE_ERROR("Failed to activate non-blocking mode (%m).");
+        handlerPtr(LE_COMM_ERROR, contextPtr);
+        return;
+    }
+
+    ReadOperation_t* opPtr = le_mem_ForceAlloc(ReadOperationPool);
+
+    opPtr->link = LE_DLS_LINK_INIT;
+    le_dls_Queue(&obsPtr->readOpList, &opPtr->link);
+
+    opPtr->obsPtr = obsPtr;
+
+    opPtr->fdMonitor = le_fdMonitor_Create("Read", outputFile, ReadOpFdEventHandler, POLLOUT);
+    le_fdMonitor_SetContextPtr(opPtr->fdMonitor, opPtr);
+    opPtr->fd = outputFile;
+    opPtr->nextSeq = startSeq;
+    if (modePtr != NULL)
+    {
+        opPtr->mode = *modePtr;
+    }
+    else
+    {
+        memset(&opPtr->mode, 0, sizeof(opPtr->mode));
+    }
+    opPtr->handlerPtr = handlerPtr;
+    opPtr->contextPtr = contextPtr;
+
+    opPtr->state = START;
+    opPtr->elementCount = 0;
+    opPtr->spillSampleRef = NULL;
+    opPtr->writeLen = 0;
+    opPtr->writeOffset = 0;
+
+    ContinueReadOp(opPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Move the newest block of a compressed buffer to the smallest pool that fits its contents, once it
+ * is full.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TrimCompressedBlock
+(
+    SampleBuffer_t* bufferPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CompressedBlock_t** blockPtrPtr = &bufferPtr->blocks[bufferPtr->blockCount - 1];
+    CompressedBlock_t* oldBlockPtr = *blockPtrPtr;
+
+    CompressedBlock_t* newBlockPtr = AllocCompressedBlock(oldBlockPtr->byteCount);
+    memcpy(newBlockPtr, oldBlockPtr, sizeof(CompressedBlock_t) + oldBlockPtr->byteCount);
+
+    if (bufferPtr->decodedPtr->blockPtr == oldBlockPtr)
+    {
+        bufferPtr->decodedPtr->blockPtr = newBlockPtr;
+    }
+
+    le_mem_Release(oldBlockPtr);
+    *blockPtrPtr = newBlockPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a sample to the newest block of a compressed buffer, starting a new block if that one is
+ * full.  The buffer's count is not updated.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AppendCompressedSample
+(
+    SampleBuffer_t* bufferPtr,
+    double timestamp,
+    double value
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (bufferPtr->decodedPtr == NULL)
+    {
+        bufferPtr->decodedPtr = le_mem_ForceAlloc(DecodedBlockPool);
+        memset(bufferPtr->decodedPtr, 0, sizeof(DecodedBlock_t));
+    }
+
+    if (   (bufferPtr->blockCount == 0)
+        || (((bufferPtr->blockHead + bufferPtr->count) % COMPRESSED_BLOCK_SAMPLES) == 0)  )
+    {
+        if (bufferPtr->blockCount > 0)
+        {
+            TrimCompressedBlock(bufferPtr);
+        }
+
+        if (bufferPtr->blockCount == bufferPtr->blockSlots)
+        {
+            size_t blockSlots = (bufferPtr->blockSlots == 0) ? 1 : (bufferPtr->blockSlots * 2);
+            CompressedBlock_t** blocks = obs_AllocBufferArray(  blockSlots
+                                                              * sizeof(CompressedBlock_t*));
+            if (bufferPtr->blockCount > 0)
+            {
+                memcpy(blocks, bufferPtr->blocks, bufferPtr->blockCount * sizeof(*blocks));
+            }
+            obs_FreeBufferArray(bufferPtr->blocks);
+            bufferPtr->blocks = blocks;
+            bufferPtr->blockSlots = blockSlots;
+        }
+
+        // The encoder relies on the bits after the end of the stream being zero.
+        CompressedBlock_t* blockPtr = AllocCompressedBlock(COMPRESSED_BLOCK_BYTES);
+        memset(blockPtr, 0, sizeof(CompressedBlock_t) + COMPRESSED_BLOCK_BYTES);
+        blockPtr->firstTimestamp = timestamp;
+        blockPtr->stats.min = NAN;
+        blockPtr->stats.max = NAN;
+
+        bufferPtr->blocks[bufferPtr->blockCount] = blockPtr;
+        (bufferPtr->blockCount)++;
+
+        gorilla_Init(&bufferPtr->encoder);
+    }
+
+    CompressedBlock_t* blockPtr = bufferPtr->blocks[bufferPtr->blockCount - 1];
+
+    bufferPtr->prevEncoder = bufferPtr->encoder;
+    gorilla_Encode(&bufferPtr->encoder, blockPtr->bytes, timestamp, value);
+    blockPtr->byteCount = GORILLA_BYTES(bufferPtr->encoder.bitCount);
+    (blockPtr->count)++;
+
+    bufferPtr->prevStats = blockPtr->stats;
+    AddToBlockStats(&blockPtr->stats, value);
+
+    // Keep the decoded copy of the block up to date, if there is one, to save decoding it again.
+    DecodedBlock_t* decodedPtr = bufferPtr->decodedPtr;
+    if ((decodedPtr->blockPtr == blockPtr) && (decodedPtr->count == blockPtr->count - 1))
+    {
+        decodedPtr->timestamps[decodedPtr->count] = timestamp;
+        decodedPtr->numbers[decodedPtr->count] = value;
+        (decodedPtr->count)++;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Extend the run of the newest entry in an Observation's run-length encoded buffer by a number of
+ * samples with the same value, updating its running aggregates and range index to match.  The
+ * min/max segment trees and extrema queue don't change, because the value doesn't.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ExtendNewestRun
+(
+    Observation_t* obsPtr,
+    double timestamp,   ///< Timestamp of the newest sample in the run.
+    uint32_t weight     ///< Number of samples to add to the run.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    RunningStats_t* statsPtr = &obsPtr->runningStats;
+    RangeIndex_t* indexPtr = &obsPtr->rangeIndex;
+
+    size_t slot = obs_GetSlot(bufferPtr, bufferPtr->count - 1);
+
+    bufferPtr->runEnds[slot] = timestamp;
+    bufferPtr->runCounts[slot] += weight;
+
+    double value = GetSlotNumber(obsPtr, slot);
+
+    if (isnan(value) || (weight == 0))
+    {
+        return;
+    }
+
+    // Welford's algorithm, with all the run's new samples added at once.
+    statsPtr->count += weight;
+    double delta = value - statsPtr->mean;
+    statsPtr->mean += (delta * weight) / statsPtr->count;
+    statsPtr->m2 += delta * (value - statsPtr->mean) * weight;
+    if (statsPtr->m2 > statsPtr->m2Peak)
+    {
+        statsPtr->m2Peak = statsPtr->m2;
+    }
+
+    // The newest slot's cumulative sums are the only ones that include it.
+    double diff = value - indexPtr->shift;
+    indexPtr->sums[slot] += diff * weight;
+    indexPtr->sumsOfSquares[slot] += diff * diff * weight;
+    indexPtr->counts[slot] += weight;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serialize the chunk of an Observation's buffer that was completed by the entry just added to it,
+ * if any: the chunk before the one that the new entry starts.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CacheCompletedJsonChunk
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    uint64_t newestSeq = bufferPtr->firstSeq + bufferPtr->count - 1;
+
+    if (newestSeq >= JSON_CHUNK_SAMPLES)
+    {
+        CacheJsonChunk(obsPtr, newestSeq - JSON_CHUNK_SAMPLES);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a given data sample to the buffer of a given Observation.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_AddToBuffer
+(
+    Observation_t* obsPtr,
+    dataSample_Ref_t sampleRef
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    double newEntryTimestamp = dataSample_GetTimestamp(sampleRef);
+
+    // If the new sample is timestamped older than the newest sample already in the buffer,
+    // then we have a serious problem, because buffer traversal operations could get stuck in loops.
+    if (bufferPtr->count > 0)
+    {
+        double oldEntryTimestamp = obs_GetBufferedEndTimestamp(bufferPtr, bufferPtr->count - 1);
+
+        if (oldEntryTimestamp > newEntryTimestamp)
+        {
+            LE_ERROR("New sample has older timestamp than (older) sample already in the buffer!");
+            LE_ERROR("Dropping new sample timestamped %lf (< %lf in buffer)!",
+                     newEntryTimestamp,
+                     oldEntryTimestamp);
+            return;
+        }
+
+        // In a run-length encoded buffer, a sample with the same value as the newest one (or
+        // another NAN) just extends its run.
+        if (bufferPtr->runLength)
+        {
+            double value = ((obsPtr->bufferedType == IO_DATA_TYPE_BOOLEAN) ?
+                                (dataSample_GetBoolean(sampleRef) ? 1.0 : 0.0) :
+                                dataSample_GetNumeric(sampleRef));
+            double newestValue = obs_GetBufferedNumber(obsPtr, bufferPtr->count - 1);
+
+            if ((value == newestValue) || (isnan(value) && isnan(newestValue)))
+            {
+                obs_ExtendNewestRun(obsPtr, newEntryTimestamp, 1);
+                return;
+            }
+        }
+    }
+
+    // Compressed buffers grow a block at a time, so only need room made when at the maximum count.
+    if (bufferPtr->compressed)
+    {
+        if (obsPtr->maxCount == 0)
+        {
+            return;  // Buffering is disabled.
+        }
+
+        if (bufferPtr->count >= obsPtr->maxCount)
+        {
+            obs_TruncateBuffer(obsPtr, obsPtr->maxCount - 1);
+        }
+
+        AppendCompressedSample(bufferPtr, newEntryTimestamp, dataSample_GetNumeric(sampleRef));
+        (bufferPtr->count)++;
+
+        AddToRunningAggregates(obsPtr);
+        AddToRangeIndex(obsPtr);
+        CacheCompletedJsonChunk(obsPtr);
+        return;
+    }
+
+    // If the buffer is full, either grow it (doubling its capacity, up to the maximum count)
+    // or make room by dropping the oldest sample.
+    if (bufferPtr->count == bufferPtr->capacity)
+    {
+        if (bufferPtr->capacity < obsPtr->maxCount)
+        {
+            size_t capacity = bufferPtr->capacity * 2;
+            if (capacity < MIN_BUFFER_CAPACITY)
+            {
+                capacity = MIN_BUFFER_CAPACITY;
+            }
+            if (capacity > obsPtr->maxCount)
+            {
+                capacity = obsPtr->maxCount;
+            }
+            obs_ResizeBuffer(obsPtr, capacity);
+        }
+        else if (bufferPtr->count > 0)
+        {
+            obs_TruncateBuffer(obsPtr, bufferPtr->count - 1);
+        }
+        else
+        {
+            return;  // Buffering is disabled.
+        }
+    }
+
+    size_t slot = obs_GetSlot(bufferPtr, bufferPtr->count);
+
+    bufferPtr->timestamps[slot] = newEntryTimestamp;
+
+    switch (obsPtr->bufferedType)
+    {
+        case IO_DATA_TYPE_TRIGGER:
+
+            // No value.
+            break;
+
+        case IO_DATA_TYPE_BOOLEAN:
+
+            bufferPtr->values.booleans[slot] = dataSample_GetBoolean(sampleRef);
+            break;
+
+        case IO_DATA_TYPE_NUMERIC:
+
+            bufferPtr->values.numbers[slot] = dataSample_GetNumeric(sampleRef);
+            break;
+
+        case IO_DATA_TYPE_STRING:
+        case IO_DATA_TYPE_JSON:
+
+            le_mem_AddRef(sampleRef);
+            bufferPtr->values.samples[slot] = sampleRef;
+            break;
+    }
+
+    if (bufferPtr->runLength)
+    {
+        bufferPtr->runEnds[slot] = newEntryTimestamp;
+        bufferPtr->runCounts[slot] = 1;
+    }
+
+    (bufferPtr->count)++;
+
+    if (obs_IsBufferNumerical(obsPtr))
+    {
+        AddToRunningAggregates(obsPtr);
+        AddToRangeIndex(obsPtr);
+    }
+
+    CacheCompletedJsonChunk(obsPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Drop the newest sample from a compressed buffer, by rewinding the encoder to where it was before
+ * that sample was appended.  The buffer's count must already have been reduced.
+ *
+ * @note The encoder can only be rewound by one sample, so this can't be done twice in a row
+ *       without appending a sample in between.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DropNewestCompressedSample
+(
+    SampleBuffer_t* bufferPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CompressedBlock_t* blockPtr = bufferPtr->blocks[bufferPtr->blockCount - 1];
+
+    if ((bufferPtr->count == 0) || (blockPtr->count == 1))
+    {
+        FreeCompressedBlock(bufferPtr, blockPtr);
+        (bufferPtr->blockCount)--;
+
+        if (bufferPtr->blockCount == 0)
+        {
+            bufferPtr->blockHead = 0;
+        }
+        return;
+    }
+
+    size_t bitCount = bufferPtr->encoder.bitCount;
+    bufferPtr->encoder = bufferPtr->prevEncoder;
+
+    // The encoder relies on the bits after the end of the stream being zero.
+    for (size_t bit = bufferPtr->encoder.bitCount; bit < bitCount; bit++)
+    {
+        blockPtr->bytes[bit / 8] &= ~(0x80 >> (bit % 8));
+    }
+
+    (blockPtr->count)--;
+    blockPtr->byteCount = GORILLA_BYTES(bufferPtr->encoder.bitCount);
+    blockPtr->stats = bufferPtr->prevStats;
+
+    DecodedBlock_t* decodedPtr = bufferPtr->decodedPtr;
+    if ((decodedPtr->blockPtr == blockPtr) && (decodedPtr->count > blockPtr->count))
+    {
+        decodedPtr->count = blockPtr->count;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Drop the newest sample from an Observation's numeric buffer, so that it can be replaced.
+ * The next sample added goes into the same slot, with the same sequence number.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_RemoveNewestFromBuffer
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    LE_ASSERT(!IsExtremaTracked(obsPtr));
+
+    RemoveFromRunningStats(obsPtr, bufferPtr->count - 1);
+
+    (bufferPtr->count)--;
+
+    // The range index sums for the newest slot are recomputed when the slot is written again.
+    if (bufferPtr->compressed)
+    {
+        DropNewestCompressedSample(bufferPtr);
+    }
+
+    if (bufferPtr->count == 0)
+    {
+        ResetAggregates(obsPtr);
+    }
+    else if (obsPtr->runningStats.removals >= bufferPtr->count)
+    {
+        RebuildRunningStats(obsPtr);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a given numeric data sample to the buffer of a given Observation using swinging door
+ * compression (see SwingingDoor_t), so that the buffered samples, joined by straight lines, pass
+ * within the Observation's buffer tolerance of every sample received.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddToSwingingDoorBuffer
+(
+    Observation_t* obsPtr,
+    dataSample_Ref_t sampleRef
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    SwingingDoor_t* doorPtr = &obsPtr->door;
+    double tolerance = obsPtr->bufferTolerance;
+
+    double timestamp = dataSample_GetTimestamp(sampleRef);
+    double value = dataSample_GetNumeric(sampleRef);
+
+    // Leave it to obs_AddToBuffer() to reject samples that are out of order.
+    if (   (bufferPtr->count > 0)
+        && (timestamp < obs_GetBufferedTimestamp(bufferPtr, bufferPtr->count - 1))  )
+    {
+        obs_AddToBuffer(obsPtr, sampleRef);
+        return;
+    }
+
+    if (doorPtr->hasProvisional)
+    {
+        double elapsed = timestamp - doorPtr->pivotTime;
+        double upperSlope = fmin(doorPtr->upperSlope,
+                                 (value + tolerance - doorPtr->pivotValue) / elapsed);
+        double lowerSlope = fmax(doorPtr->lowerSlope,
+                                 (value - tolerance - doorPtr->pivotValue) / elapsed);
+
+        // If the door is still open, this sample replaces the provisional one.  Its value is
+        // moved (by no more than the tolerance) onto the nearest line from the pivot that is
+        // within tolerance of all the samples replaced, if the line to it isn't.
+        if (!isnan(value) && (lowerSlope <= upperSlope))
+        {
+            double slope = (value - doorPtr->pivotValue) / elapsed;
+
+            obs_RemoveNewestFromBuffer(obsPtr);
+
+            if ((slope >= lowerSlope) && (slope <= upperSlope))
+            {
+                obs_AddToBuffer(obsPtr, sampleRef);
+            }
+            else
+            {
+                slope = fmax(lowerSlope, fmin(upperSlope, slope));
+
+                dataSample_Ref_t adjustedRef = dataSample_CreateNumeric(timestamp,
+                                                    doorPtr->pivotValue + (slope * elapsed));
+                obs_AddToBuffer(obsPtr, adjustedRef);
+                le_mem_Release(adjustedRef);
+            }
+
+            doorPtr->upperSlope = upperSlope;
+            doorPtr->lowerSlope = lowerSlope;
+            return;
+        }
+
+        // Otherwise, the provisional sample is kept for good and becomes the pivot.
+        doorPtr->hasProvisional = false;
+        doorPtr->pivotTime = obs_GetBufferedTimestamp(bufferPtr, bufferPtr->count - 1);
+        doorPtr->pivotValue = obs_GetBufferedNumber(obsPtr, bufferPtr->count - 1);
+    }
+
+    double elapsed = timestamp - doorPtr->pivotTime;
+
+    obs_AddToBuffer(obsPtr, sampleRef);
+
+    // A NAN can't be interpolated across, so is kept for good, along with the next sample.
+    // So is a sample with the same timestamp as the pivot.
+    if (isnan(value) || !doorPtr->hasPivot || !(elapsed > 0))
+    {
+        doorPtr->hasPivot = !isnan(value);
+        doorPtr->pivotTime = timestamp;
+        doorPtr->pivotValue = value;
+        return;
+    }
+
+    doorPtr->hasProvisional = true;
+    doorPtr->upperSlope = (value + tolerance - doorPtr->pivotValue) / elapsed;
+    doorPtr->lowerSlope = (value - tolerance - doorPtr->pivotValue) / elapsed;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Update the value of a data sample.  If nothing else holds a reference to the sample, it is
+ * updated in place.  Otherwise, it is replaced by a new sample with the same timestamp.
+ */
+//--------------------------------------------------------------------------------------------------
+static dataSample_Ref_t UpdateSample
+(
+    dataSample_Ref_t sampleRef,
+    io_DataType_t dataType,
+    void *valuePtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    dataSample_Ref_t sample = sampleRef;
+    double timestamp = dataSample_GetTimestamp(sampleRef);
+
+    switch (dataType)
+    {
+        case IO_DATA_TYPE_BOOLEAN:
+        {
+            bool value = *((double *)valuePtr) > 0.0 ? true : false;
+            if (dataSample_GetBoolean(sampleRef) != value)
+            {
+                if (le_mem_GetRefCount(sampleRef) == 1)
+                {
+                    dataSample_SetBoolean(sampleRef, value);
+                }
+                else
+                {
+                    sample = dataSample_CreateBoolean(timestamp, value);
+                }
+            }
+            break;
+        }
+
+        case IO_DATA_TYPE_NUMERIC:
+        {
+            double value = *((double *)valuePtr);
+            if (dataSample_GetNumeric(sampleRef) != value)
+            {
+                if (le_mem_GetRefCount(sampleRef) == 1)
+                {
+                    dataSample_SetNumeric(sampleRef, value);
+                }
+                else
+                {
+                    sample = dataSample_CreateNumeric(timestamp, value);
+                }
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    if (sample != sampleRef)
+    {
+        le_mem_Release(sampleRef);
+    }
+
+    return sample;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take a snapshot of an Observation's buffer, to be written to a backup file while the buffer
+ * goes on changing.  String and JSON samples and full compressed blocks are shared with the buffer
+ * (the snapshot holds a reference to each), while everything else is copied.
+ *
+ * @return Number of bytes allocated for the copies.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t obs_TakeBufferSnapshot
+(
+    Observation_t* obsPtr,
+    SampleBuffer_t* snapshotPtr ///< [OUT] The snapshot.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    size_t count = bufferPtr->count;
+    size_t byteCount = 0;
+
+    memset(snapshotPtr, 0, sizeof(*snapshotPtr));
+    snapshotPtr->count = count;
+    snapshotPtr->firstSeq = bufferPtr->firstSeq;
+    snapshotPtr->runLength = bufferPtr->runLength;
+    snapshotPtr->compressed = bufferPtr->compressed;
+
+    if (bufferPtr->compressed)
+    {
+        snapshotPtr->blockHead = bufferPtr->blockHead;
+        snapshotPtr->blockCount = bufferPtr->blockCount;
+        snapshotPtr->blockSlots = bufferPtr->blockCount;
+        byteCount = bufferPtr->blockCount * sizeof(CompressedBlock_t*);
+        snapshotPtr->blocks = obs_AllocBufferArray(byteCount);
+
+        // Full blocks never change, so they are shared.  Only the newest one is copied.
+        for (size_t i = 0; i < bufferPtr->blockCount; i++)
+        {
+            CompressedBlock_t* blockPtr = bufferPtr->blocks[i];
+
+            if (i < bufferPtr->blockCount - 1)
+            {
+                le_mem_AddRef(blockPtr);
+                snapshotPtr->blocks[i] = blockPtr;
+            }
+            else
+            {
+                snapshotPtr->blocks[i] = AllocCompressedBlock(blockPtr->byteCount);
+                memcpy(snapshotPtr->blocks[i],
+                       blockPtr,
+                       sizeof(CompressedBlock_t) + blockPtr->byteCount);
+                byteCount += sizeof(CompressedBlock_t) + blockPtr->byteCount;
+            }
+        }
+    }
+    else
+    {
+        size_t valueSize = GetBufferedValueSize(obsPtr->bufferedType);
+
+        snapshotPtr->capacity = count;
+        byteCount = count * (sizeof(double) + valueSize);
+        snapshotPtr->timestamps = CopyBufferArray(bufferPtr,
+                                                  bufferPtr->timestamps,
+                                                  sizeof(double),
+                                                  count);
+        snapshotPtr->values.bytes = CopyBufferArray(bufferPtr,
+                                                    bufferPtr->values.bytes,
+                                                    valueSize,
+                                                    count);
+        if (bufferPtr->runLength)
+        {
+            byteCount += count * (sizeof(double) + sizeof(uint32_t));
+            snapshotPtr->runEnds = CopyBufferArray(bufferPtr,
+                                                   bufferPtr->runEnds,
+                                                   sizeof(double),
+                                                   count);
+            snapshotPtr->runCounts = CopyBufferArray(bufferPtr,
+                                                     bufferPtr->runCounts,
+                                                     sizeof(uint32_t),
+                                                     count);
+        }
+
+        if (   (obsPtr->bufferedType == IO_DATA_TYPE_STRING)
+            || (obsPtr->bufferedType == IO_DATA_TYPE_JSON)  )
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                le_mem_AddRef(snapshotPtr->values.samples[i]);
+            }
+        }
+    }
+
+    return byteCount;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a snapshot of an Observation's buffer taken by obs_TakeBufferSnapshot().
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ReleaseBufferSnapshot
+(
+    SampleBuffer_t* snapshotPtr,
+    io_DataType_t dataType  ///< Type of the samples in the snapshot.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (   ((dataType == IO_DATA_TYPE_STRING) || (dataType == IO_DATA_TYPE_JSON))
+        && (!snapshotPtr->compressed)  )
+    {
+        for (size_t i = 0; i < snapshotPtr->count; i++)
+        {
+            le_mem_Release(snapshotPtr->values.samples[i]);
+        }
+    }
+
+    for (size_t i = 0; i < snapshotPtr->blockCount; i++)
+    {
+        le_mem_Release(snapshotPtr->blocks[i]);
+    }
+
+    obs_FreeBufferArray(snapshotPtr->blocks);
+    obs_FreeBufferArray(snapshotPtr->timestamps);
+    obs_FreeBufferArray(snapshotPtr->values.bytes);
+    obs_FreeBufferArray(snapshotPtr->runEnds);
+    obs_FreeBufferArray(snapshotPtr->runCounts);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Observation destructor.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ObservationDestructor
+(
+    void* objectPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = objectPtr;
+
+    // Delete all the buffered data samples and free the buffer's storage.
+    obs_TruncateBuffer(obsPtr, 0);
+    obs_ResizeBuffer(obsPtr, 0);
+    FlushJsonChunks(obsPtr);
+
+    obsPtr->maxCount = 0;
+
+    // Free the rollup tiers' storage.
+    for (size_t i = 0; i < obsPtr->rollupCount; i++)
+    {
+        obs_FreeBufferArray(obsPtr->rollups[i].rows);
+    }
+    obsPtr->rollupCount = 0;
+
+    // Delete its backup, and forget about any backup or restore still to be done.
+    backup_Remove(obsPtr);
+
+    // If there are read operations in progress, end them.
+    while (le_dls_IsEmpty(&obsPtr->readOpList) == false)
+    {
+        EndRead(CONTAINER_OF(le_dls_Peek(&obsPtr->readOpList), ReadOperation_t, link),
+                LE_COMM_ERROR);
+    }
+
+    res_Destruct(&obsPtr->resource);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the Observation module.
+ *
+ * @warning This must be called before any other function in this module is called.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_Init
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ObservationPool = le_mem_CreatePool("Observation", sizeof(Observation_t));
+    le_mem_SetDestructor(ObservationPool, ObservationDestructor);
+
+    ReadOperationPool = le_mem_CreatePool("Read Op", sizeof(ReadOperation_t));
+
+    for (size_t i = 0; i < JSON_CHUNK_POOL_COUNT; i++)
+    {
+        size_t jsonBytes = GetJsonChunkPoolBytes(i);
+
+        char poolName[32];
+        int len = snprintf(poolName, sizeof(poolName), "JSON Chunk %zu", jsonBytes);
+        LE_ASSERT((len >= 0) && ((size_t)len < sizeof(poolName)));
+
+        JsonChunkPools[i] = le_mem_CreatePool(poolName, sizeof(JsonChunk_t) + jsonBytes);
+    }
+
+    for (size_t i = 0; i < COMPRESSED_BLOCK_POOL_COUNT; i++)
+    {
+        size_t byteCount = GetCompressedBlockPoolBytes(i);
+
+        char poolName[32];
+        int len = snprintf(poolName, sizeof(poolName), "Compressed Block %zu", byteCount);
+        LE_ASSERT((len >= 0) && ((size_t)len < sizeof(poolName)));
+
+        CompressedBlockPools[i] = le_mem_CreatePool(poolName,
+                                                    sizeof(CompressedBlock_t) + byteCount);
     }
 
-    // Read the version byte.
-    uint8_t byte;
-    if (ReadFromFile(&byte, 1, file) != LE_OK)
-    {
-        LE_ERROR("Failed to read version byte.");
-        return;
-    }
-    if (byte != 0)
-    {
-        LE_CRIT("Backup file format version %d unrecognized.", (int)byte);
-        le_atomFile_CancelStream(file);
-        return;
-    }
+    DecodedBlockPool = le_mem_CreatePool("Decoded Block", sizeof(DecodedBlock_t));
+
+    BufferArrayMutex = le_mutex_CreateNonRecursive("BufferArrays");
+
+    backup_Init();
+
+    StartTime = obs_GetRelativeTimeMs();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create an Observation object.  This allocates the object and initializes the class members,
+ * but not the parent class members.
+ *
+ * @return Pointer to the new object.
+ */
+//--------------------------------------------------------------------------------------------------
+res_Resource_t* obs_Create
+(
+    resTree_EntryRef_t entryRef ///< The resource tree entry to attach this Resource to.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = le_mem_ForceAlloc(ObservationPool);
+
+    res_Construct(&obsPtr->resource, entryRef);
+
+    obsPtr->lowLimit = NAN;
+    obsPtr->highLimit = NAN;
+    obsPtr->changeBy = NAN;
+    obsPtr->minPeriod = NAN;
+
+    obsPtr->maxCount = 0;
+    obsPtr->compressBuffer = false;
+    obsPtr->bufferTolerance = NAN;
+    memset(&obsPtr->door, 0, sizeof(obsPtr->door));
+    obsPtr->runLengthBuffer = false;
 
-    // Read the data type code.
-    if (ReadFromFile(&byte, 1, file) != LE_OK)
-    {
-        LE_ERROR("Failed to read data type code.");
-        return;
-    }
-    io_DataType_t dataType;
-    if (!GetDataTypeFromCode(&dataType, byte))
-    {
-        le_atomFile_CancelStream(file);
-        return;
-    }
-    obsPtr->bufferedType = dataType;
+    obsPtr->transformType = OBS_TRANSFORM_TYPE_NONE;
+    memset(&obsPtr->runningStats, 0, sizeof(obsPtr->runningStats));
+    memset(&obsPtr->extrema, 0, sizeof(obsPtr->extrema));
+    memset(&obsPtr->rangeIndex, 0, sizeof(obsPtr->rangeIndex));
+    obsPtr->rangeIndex.shift = NAN;
 
-    // Read the number of samples.
-    uint32_t count;
-    if (ReadFromFile(&count, 4, file) != LE_OK)
-    {
-        LE_ERROR("Failed to read number of samples.");
-        return;
-    }
+    obsPtr->bufferedType = IO_DATA_TYPE_TRIGGER;
 
-    // The maximum count must be at least the number we read.
-    if (obsPtr->maxCount == 0)
-    {
-        obsPtr->maxCount = count;
-    }
-    // NOTE: Don't enable backups, though, because we don't know the frequency to choose
-    //       and flash wear can permanently damage a device.
+    memset(obsPtr->rollups, 0, sizeof(obsPtr->rollups));
+    obsPtr->rollupCount = 0;
+    obsPtr->rollupType = IO_DATA_TYPE_TRIGGER;
+
+    obsPtr->backupPeriod = 0;
+    obsPtr->lastBackupTime = 0;
+    obsPtr->backupLink = LE_DLS_LINK_INIT;
+    obsPtr->isBackupPending = false;
+    obsPtr->backupJobList = LE_DLS_LIST_INIT;
+    obsPtr->journalValid = false;
+    obsPtr->journalCount = 0;
+    obsPtr->backupSeq = 0;
+    obsPtr->backupNewestEnd = NAN;
+    obsPtr->backupNewestWeight = 0;
+    obsPtr->restoreLink = LE_DLS_LINK_INIT;
+    obsPtr->isRestorePending = false;
+
+    memset(&obsPtr->buffer, 0, sizeof(obsPtr->buffer));
+
+    obsPtr->readOpList = LE_DLS_LIST_INIT;
+    obsPtr->jsonChunks = NULL;
+    obsPtr->jsonChunkSlots = 0;
+
+    obsPtr->jsonExtraction[0] = '\0';
 
-    // Read all the data samples from the file.
-    ReadSamplesFromFile(obsPtr, file, count);
+    return &obsPtr->resource;
 }
 
 
@@ -1501,6 +4924,8 @@ le_result_t obs_DoJsonExtraction
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
+    backup_EnsureRestored(obsPtr);
+
     // If JSON extraction is enabled,
     if (obsPtr->jsonExtraction[0] != '\0')
     {
@@ -1626,8 +5051,7 @@ bool obs_ShouldAccept
                 else if (   (dataType == IO_DATA_TYPE_STRING)
                          || (dataType == IO_DATA_TYPE_JSON))
                 {
-                    if (0 == strcmp(dataSample_GetString(valueRef),
-                                    dataSample_GetString(previousValue)))
+                    if (dataSample_AreStringsEqual(valueRef, previousValue))
                     {
                         return false;
                     }
@@ -1639,7 +5063,7 @@ bool obs_ShouldAccept
         // minPeriod check last.
         if ((obsPtr->minPeriod != 0) && (!isnan(obsPtr->minPeriod)))
         {
-            now = GetRelativeTimeMs();  // system call
+            now = obs_GetRelativeTimeMs();  // system call
 
             if ((now - obsPtr->lastPushTime) < (obsPtr->minPeriod * 1000))
             {
@@ -1651,151 +5075,486 @@ bool obs_ShouldAccept
     // Update the time of last update.
     if (now == 0)
     {
-        now = GetRelativeTimeMs(); // system call
+        now = obs_GetRelativeTimeMs(); // system call
     }
     obsPtr->lastPushTime = now;
 
-    return true;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Perform processing of an accepted pushed data sample that is specific to an Observation
+ * resource.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ProcessAccepted
+(
+    res_Resource_t* resPtr,
+    io_DataType_t dataType,     ///< Data type of the data sample.
+    dataSample_Ref_t sampleRef  ///< Data sample.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    backup_EnsureRestored(obsPtr);
+
+    if (!IsFirstPushLogged && !backup_IsRestoring())
+    {
+        IsFirstPushLogged = true;
+        LE_INFO("First sample accepted by an Observation %" PRIu32 " ms after start-up.",
+                obs_GetRelativeTimeMs() - StartTime);
+    }
+
+    AddToRollups(obsPtr, dataType, sampleRef);
+
+    if (obsPtr->maxCount > 0)
+    {
+        // If the data type has changed, we have to dump the current set of buffered samples.
+        if (obsPtr->bufferedType != dataType)
+        {
+            obs_TruncateBuffer(obsPtr, 0);
+
+            obs_SetBufferedType(obsPtr, dataType);
+        }
+
+        if (IsSwingingDoorEnabled(obsPtr))
+        {
+            AddToSwingingDoorBuffer(obsPtr, sampleRef);
+        }
+        else
+        {
+            obs_AddToBuffer(obsPtr, sampleRef);
+        }
+
+        obs_TruncateBuffer(obsPtr, obsPtr->maxCount);
+
+        // If the buffer backup period is non-zero, then back-ups are enabled, so queue the
+        // change to be committed with the others once the backup period has passed.
+        if (obsPtr->backupPeriod > 0)
+        {
+            backup_Request(obsPtr);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the mean of all the values in an Observation's buffer from its running aggregates.
+ *
+ * @return The value, or NAN (not-a-number) if there's no numerical data in the buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static double GetRunningMean
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (obsPtr->runningStats.count == 0)
+    {
+        return NAN;
+    }
+
+    return obsPtr->runningStats.mean;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the (population) standard deviation of all the values in an Observation's buffer from its
+ * running aggregates.
+ *
+ * @return The value, or NAN (not-a-number) if there's no numerical data in the buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static double GetRunningStdDev
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (obsPtr->runningStats.count == 0)
+    {
+        return NAN;
+    }
+
+    // Rounding errors can leave a tiny negative sum of squares when all values are equal.
+    double m2 = obsPtr->runningStats.m2;
+    if (m2 < 0)
+    {
+        m2 = 0;
+    }
+
+    return sqrt(m2 / obsPtr->runningStats.count);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the minimum (for a MIN transform) or maximum (for a MAX transform) of all the values in an
+ * Observation's buffer from the front of its extrema queue.  Buffers that don't track extrema
+ * are searched instead.
+ *
+ * @return The value, or NAN (not-a-number) if there's no numerical data in the buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static double GetRunningExtremum
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ExtremaQueue_t* queuePtr = &obsPtr->extrema;
+
+    if (!IsExtremaTracked(obsPtr))
+    {
+        if (obsPtr->buffer.count == 0)
+        {
+            return NAN;
+        }
+
+        return GetRangeExtremum(obsPtr, 0, (obsPtr->transformType == OBS_TRANSFORM_TYPE_MAX));
+    }
+
+    if (queuePtr->count == 0)
+    {
+        return NAN;
+    }
+
+    return obs_GetBufferedNumber(obsPtr, queuePtr->seqs[queuePtr->head] - obsPtr->buffer.firstSeq);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Perform any post-filtering on a given Observation.
+ */
+//--------------------------------------------------------------------------------------------------
+dataSample_Ref_t obs_ApplyTransform
+(
+    res_Resource_t* resPtr,
+    io_DataType_t dataType,     ///< Data type of the data sample.
+    dataSample_Ref_t sampleRef  ///< Data sample.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+    dataSample_Ref_t sample = sampleRef;
+    double transformVal;
+
+    switch (obsPtr->transformType)
+    {
+        case OBS_TRANSFORM_TYPE_NONE:
+            goto done;
+
+        // The running aggregates are maintained as samples enter and leave the buffer,
+        // so these don't need to scan the buffer.
+        case OBS_TRANSFORM_TYPE_MEAN:
+            transformVal = GetRunningMean(obsPtr);
+            break;
+
+        case OBS_TRANSFORM_TYPE_STDDEV:
+            transformVal = GetRunningStdDev(obsPtr);
+            break;
+
+        case OBS_TRANSFORM_TYPE_MAX:
+        case OBS_TRANSFORM_TYPE_MIN:
+            transformVal = GetRunningExtremum(obsPtr);
+            break;
+
+        default:
+            LE_FATAL("Invalid transform type %d", obsPtr->transformType);
+            break;
+    }
+
+    // Update the sample to have the new, transformed value.
+    sample = UpdateSample(sampleRef, dataType, (void *)&transformVal);
+
+done:
+
+    return sample;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the minimum period between data samples accepted by a given Observation.
+ *
+ * This is used to throttle the rate of data passing into and through an Observation.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetMinPeriod
+(
+    res_Resource_t* resPtr,
+    double minPeriod
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    obsPtr->minPeriod = minPeriod;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the minimum period between data samples accepted by a given Observation.
+ *
+ * @return The value, or 0 if not set.
+ */
+//--------------------------------------------------------------------------------------------------
+double obs_GetMinPeriod
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    return obsPtr->minPeriod;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the highest value in a range that will be accepted by a given Observation.
+ *
+ * Ignored for all non-numeric types except Boolean for which non-zero = true and zero = false.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetHighLimit
+(
+    res_Resource_t* resPtr,
+    double highLimit
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    obsPtr->highLimit = highLimit;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the highest value in a range that will be accepted by a given Observation.
+ *
+ * @return The value, or NAN (not a number) if not set.
+ */
+//--------------------------------------------------------------------------------------------------
+double obs_GetHighLimit
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    return obsPtr->highLimit;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Perform processing of an accepted pushed data sample that is specific to an Observation
- * resource.
+ * Set the lowest value in a range that will be accepted by a given Observation.
+ *
+ * Ignored for all non-numeric types except Boolean for which non-zero = true and zero = false.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_ProcessAccepted
+void obs_SetLowLimit
 (
     res_Resource_t* resPtr,
-    io_DataType_t dataType,     ///< Data type of the data sample.
-    dataSample_Ref_t sampleRef  ///< Data sample.
+    double lowLimit
 )
 //--------------------------------------------------------------------------------------------------
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    if (obsPtr->maxCount > 0)
-    {
-        // If the data type has changed, we have to dump the current set of buffered samples.
-        if (obsPtr->bufferedType != dataType)
-        {
-            TruncateBuffer(obsPtr, 0);
+    obsPtr->lowLimit = lowLimit;
+}
 
-            obsPtr->bufferedType = dataType;
-        }
 
-        AddToBuffer(obsPtr, sampleRef);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the lowest value in a range that will be accepted by a given Observation.
+ *
+ * @return The value, or NAN (not a number) if not set.
+ */
+//--------------------------------------------------------------------------------------------------
+double obs_GetLowLimit
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-        TruncateBuffer(obsPtr, obsPtr->maxCount);
+    return obsPtr->lowLimit;
+}
 
-        // If the buffer backup period is non-zero, then back-ups are enabled.
-        if (obsPtr->backupPeriod > 0)
-        {
-            // If more than the backup period has passed since the time of last backup, do a backup.
-            uint32_t nextBackupTime = obsPtr->lastBackupTime + obsPtr->backupPeriod;
-            le_clk_Time_t now = le_clk_GetRelativeTime();
-            if (nextBackupTime <= now.sec)
-            {
-                Backup(obsPtr);
-            }
-            // If the backup period hasn't passed yet, and there isn't already a timer running,
-            // then start a timer to expire when it's time to do a backup.
-            else if (obsPtr->backupTimer == NULL)
-            {
-                uint32_t timerInterval = (nextBackupTime - now.sec) * 1000;
 
-                obsPtr->backupTimer = le_timer_Create("backup");
-                LE_ASSERT(le_timer_SetMsInterval(obsPtr->backupTimer, timerInterval) == LE_OK);
-                LE_ASSERT(le_timer_SetHandler(obsPtr->backupTimer, BackupTimerExpired) == LE_OK);
-                LE_ASSERT(le_timer_SetContextPtr(obsPtr->backupTimer, obsPtr) == LE_OK);
-                LE_ASSERT(le_timer_Start(obsPtr->backupTimer) == LE_OK);
-            }
-        }
-    }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the magnitude that a new value must vary from the current value to be accepted by
+ * a given Observation.
+ *
+ * Ignored for trigger types.
+ *
+ * For all other types, any non-zero value means accept any change, but drop if the same as current.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetChangeBy
+(
+    res_Resource_t* resPtr,
+    double change
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    obsPtr->changeBy = change;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Perform any post-filtering on a given Observation.
+ * Get the magnitude that a new value must vary from the current value to be accepted by
+ * a given Observation.
+ *
+ * @return The value, or 0 if not set.
  */
 //--------------------------------------------------------------------------------------------------
-dataSample_Ref_t obs_ApplyTransform
+double obs_GetChangeBy
 (
-    res_Resource_t* resPtr,
-    io_DataType_t dataType,     ///< Data type of the data sample.
-    dataSample_Ref_t sampleRef  ///< Data sample.
+    res_Resource_t* resPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
-    dataSample_Ref_t sample = sampleRef;
-    double transformVal;
 
-    switch (obsPtr->transformType)
-    {
-        case OBS_TRANSFORM_TYPE_NONE:
-            goto done;
+    return obsPtr->changeBy;
+}
 
-        case OBS_TRANSFORM_TYPE_MEAN:
-            transformVal = obs_QueryMean(resPtr, NAN);
-            break;
 
-        case OBS_TRANSFORM_TYPE_STDDEV:
-            transformVal = obs_QueryStdDev(resPtr, NAN);
-            break;
+//--------------------------------------------------------------------------------------------------
+/**
+ * Perform a transform on buffered data. Value of the observation will be the output of the
+ * transform
+ *
+ * Ignored for all non-numeric types except Boolean for which non-zero = true and zero = false.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetTransform
+(
+    res_Resource_t* resPtr,
+    obs_TransformType_t transformType,
+    const double* paramsPtr,
+    size_t paramsSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-        case OBS_TRANSFORM_TYPE_MAX:
-            transformVal = obs_QueryMax(resPtr, NAN);
-            break;
+    backup_EnsureRestored(obsPtr);
 
-        case OBS_TRANSFORM_TYPE_MIN:
-            transformVal = obs_QueryMin(resPtr, NAN);
-            break;
+    obsPtr->transformType = transformType;
 
-        default:
-            LE_FATAL("Invalid transform type %d", obsPtr->transformType);
-            break;
+    // If the transform is being set to anything other than NONE, ensure there is at least one
+    // data sample buffered in order to allow transforms to behave properly
+    if (   (OBS_TRANSFORM_TYPE_NONE != obsPtr->transformType)
+        && (0 == obsPtr->maxCount))
+    {
+        obsPtr->maxCount = 1;
     }
 
-    // Update the sample to have the new, transformed value.
-    sample = UpdateSample(sampleRef, dataType, (void *)&transformVal);
-
-done:
+    // Clear the buffer and current value of the observation.  Do this even if the same transform
+    // is being re-applied.  This allows any cumulative behavior to be cleared
+    // Also free the buffer's storage, so storage suited to the new transform will be allocated
+    // when the next sample arrives.
+    obs_TruncateBuffer(obsPtr, 0);
+    obs_SetBufferedType(obsPtr, obsPtr->bufferedType);
+    if (resPtr->pushedValue != NULL)
+    {
+        le_mem_Release(resPtr->pushedValue);
+        resPtr->pushedValue = NULL;
+    }
 
-    return sample;
+    (void)paramsPtr;
+    (void)paramsSize;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the minimum period between data samples accepted by a given Observation.
+ * Get the type of transform currently applied to an Observation.
  *
- * This is used to throttle the rate of data passing into and through an Observation.
+ * @return The TransformType
  */
 //--------------------------------------------------------------------------------------------------
-void obs_SetMinPeriod
+obs_TransformType_t obs_GetTransform
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    return obsPtr->transformType;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the maximum number of data samples to buffer in a given Observation.  Buffers are FIFO
+ * circular buffers. When full, the buffer drops the oldest value to make room for a new addition.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetBufferMaxCount
 (
     res_Resource_t* resPtr,
-    double minPeriod
+    uint32_t count
 )
 //--------------------------------------------------------------------------------------------------
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    obsPtr->minPeriod = minPeriod;
+    // If the buffer size is being changed,
+    if (obsPtr->maxCount != count)
+    {
+        // If the size is now zero and backups were enabled, disable backups.
+        // The backup is about to be deleted, so restore it first if that hasn't been done yet.
+        if ((count == 0) && (obsPtr->backupPeriod > 0))
+        {
+            backup_EnsureRestored(obsPtr);
+            backup_Disable(obsPtr);
+        }
+
+        // Update the size.
+        obsPtr->maxCount = count;
+
+        // Discard extra samples and release unneeded storage if the size has shrunk.
+        // (Compressed buffers have no capacity, but still have storage to release if emptied.)
+        obs_TruncateBuffer(obsPtr, count);
+        if ((obsPtr->buffer.capacity > count) || (count == 0))
+        {
+            obs_ResizeBuffer(obsPtr, count);
+        }
+    }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the minimum period between data samples accepted by a given Observation.
+ * Get the buffer size setting for a given Observation.
  *
- * @return The value, or 0 if not set.
+ * @return The buffer size (in number of samples) or 0 if not set.
  */
 //--------------------------------------------------------------------------------------------------
-double obs_GetMinPeriod
+uint32_t obs_GetBufferMaxCount
 (
     res_Resource_t* resPtr
 )
@@ -1803,38 +5562,119 @@ double obs_GetMinPeriod
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    return obsPtr->minPeriod;
+    backup_EnsureRestored(obsPtr);
+
+    return obsPtr->maxCount;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the highest value in a range that will be accepted by a given Observation.
+ * Take the samples out of an Observation's numeric or Boolean buffer and put them back in, so that
+ * they are stored in the form (and with the extrema tracking) that its current settings call for.
+ * The samples keep their sequence numbers, so read operations in progress carry on where they
+ * were, unless samples are merged into runs.  Runs are kept as runs if run-length encoding is
+ * still enabled, or as their first samples if not.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReloadBuffer
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+    io_DataType_t dataType = obsPtr->bufferedType;
+
+    size_t count = bufferPtr->count;
+    uint64_t firstSeq = bufferPtr->firstSeq;
+    double* timestamps = obs_AllocBufferArray(count * sizeof(double));
+    double* numbers = obs_AllocBufferArray(count * sizeof(double));
+    double* runEnds = obs_AllocBufferArray(count * sizeof(double));
+    uint32_t* runCounts = obs_AllocBufferArray(count * sizeof(uint32_t));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        timestamps[i] = obs_GetBufferedTimestamp(bufferPtr, i);
+        numbers[i] = obs_GetBufferedNumber(obsPtr, i);
+        runEnds[i] = obs_GetBufferedEndTimestamp(bufferPtr, i);
+        runCounts[i] = obs_GetBufferedWeight(bufferPtr, i);
+    }
+
+    obs_TruncateBuffer(obsPtr, 0);
+    obs_SetBufferedType(obsPtr, dataType);
+    bufferPtr->firstSeq = firstSeq;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dataSample_Ref_t sampleRef;
+        if (dataType == IO_DATA_TYPE_BOOLEAN)
+        {
+            sampleRef = dataSample_CreateBoolean(timestamps[i], (numbers[i] != 0));
+        }
+        else
+        {
+            sampleRef = dataSample_CreateNumeric(timestamps[i], numbers[i]);
+        }
+        obs_AddToBuffer(obsPtr, sampleRef);
+        le_mem_Release(sampleRef);
+
+        if (bufferPtr->runLength && (runCounts[i] > 1))
+        {
+            obs_ExtendNewestRun(obsPtr, runEnds[i], runCounts[i] - 1);
+        }
+    }
+
+    obs_FreeBufferArray(timestamps);
+    obs_FreeBufferArray(numbers);
+    obs_FreeBufferArray(runEnds);
+    obs_FreeBufferArray(runCounts);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable compression of a given Observation's buffer.  When enabled, numeric samples
+ * are buffered in blocks of delta-of-delta encoded timestamps and XOR encoded values, which
+ * typically take a few bytes per sample instead of sixteen, at the cost of decoding the blocks
+ * when the buffer is queried or read.  Other data types are never compressed.
  *
- * Ignored for all non-numeric types except Boolean for which non-zero = true and zero = false.
+ * Samples already in the buffer are kept, and converted to the new form.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_SetHighLimit
+void obs_SetBufferCompression
 (
     res_Resource_t* resPtr,
-    double highLimit
+    bool isCompressed
 )
 //--------------------------------------------------------------------------------------------------
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    obsPtr->highLimit = highLimit;
+    backup_EnsureRestored(obsPtr);
+
+    if (obsPtr->compressBuffer == isCompressed)
+    {
+        return;
+    }
+
+    obsPtr->compressBuffer = isCompressed;
+
+    if (obsPtr->bufferedType == IO_DATA_TYPE_NUMERIC)
+    {
+        ReloadBuffer(obsPtr);
+    }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the highest value in a range that will be accepted by a given Observation.
+ * Check whether compression is enabled for a given Observation's buffer.
  *
- * @return The value, or NAN (not a number) if not set.
+ * @return true if enabled.
  */
 //--------------------------------------------------------------------------------------------------
-double obs_GetHighLimit
+bool obs_IsBufferCompressed
 (
     res_Resource_t* resPtr
 )
@@ -1842,38 +5682,62 @@ double obs_GetHighLimit
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    return obsPtr->highLimit;
+    return obsPtr->compressBuffer;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the lowest value in a range that will be accepted by a given Observation.
+ * Set the tolerance of the swinging door compression of a given Observation's buffer.  When set,
+ * numeric samples are only buffered if they are needed to reconstruct the signal, by drawing
+ * straight lines between the buffered samples, to within the tolerance of every sample received.
+ * Mean and standard deviation queries then weight the reconstructed signal by time, rather than
+ * averaging the buffered samples.
  *
- * Ignored for all non-numeric types except Boolean for which non-zero = true and zero = false.
+ * Samples already in the buffer are kept.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_SetLowLimit
+void obs_SetBufferTolerance
 (
     res_Resource_t* resPtr,
-    double lowLimit
+    double tolerance    ///< Maximum reconstruction error (> 0); NAN or 0 = disabled.
 )
 //--------------------------------------------------------------------------------------------------
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    obsPtr->lowLimit = lowLimit;
+    backup_EnsureRestored(obsPtr);
+
+    if (!(tolerance > 0))
+    {
+        if (!isnan(tolerance) && (tolerance != 0))
+        {
+            LE_ERROR("Buffer tolerance must not be negative.");
+            return;
+        }
+        tolerance = NAN;
+    }
+
+    bool wasEnabled = IsSwingingDoorEnabled(obsPtr);
+
+    obsPtr->bufferTolerance = tolerance;
+
+    // Turning swinging door compression on or off changes whether the extrema are tracked.
+    if (wasEnabled != IsSwingingDoorEnabled(obsPtr))
+    {
+        ReloadBuffer(obsPtr);
+    }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the lowest value in a range that will be accepted by a given Observation.
+ * Get the tolerance of the swinging door compression of a given Observation's buffer.
  *
- * @return The value, or NAN (not a number) if not set.
+ * @return The tolerance, or NAN if not set.
  */
 //--------------------------------------------------------------------------------------------------
-double obs_GetLowLimit
+double obs_GetBufferTolerance
 (
     res_Resource_t* resPtr
 )
@@ -1881,42 +5745,55 @@ double obs_GetLowLimit
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    return obsPtr->lowLimit;
+    return obsPtr->bufferTolerance;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Set the magnitude that a new value must vary from the current value to be accepted by
- * a given Observation.
- *
- * Ignored for trigger types.
+ * Enable or disable run-length encoding of a given Observation's buffer.  When enabled, a numeric
+ * or Boolean sample with the same value as the newest buffered sample extends that sample's run,
+ * instead of taking an entry of its own, and queries weight each run by its number of samples.
+ * The maximum buffer count then limits the number of runs.  Compressed and swinging door buffers
+ * are never run-length encoded, and neither are other data types.
  *
- * For all other types, any non-zero value means accept any change, but drop if the same as current.
+ * Samples already in the buffer are kept: merged into runs when enabled, and reduced to the first
+ * sample of each run when disabled.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_SetChangeBy
+void obs_SetBufferRunLengthEncoding
 (
     res_Resource_t* resPtr,
-    double change
+    bool isEnabled
 )
 //--------------------------------------------------------------------------------------------------
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    obsPtr->changeBy = change;
+    backup_EnsureRestored(obsPtr);
+
+    if (obsPtr->runLengthBuffer == isEnabled)
+    {
+        return;
+    }
+
+    obsPtr->runLengthBuffer = isEnabled;
+
+    if (obs_IsBufferNumerical(obsPtr))
+    {
+        ReloadBuffer(obsPtr);
+    }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the magnitude that a new value must vary from the current value to be accepted by
- * a given Observation.
+ * Check whether run-length encoding is enabled for a given Observation's buffer.
  *
- * @return The value, or 0 if not set.
+ * @return true if enabled.
  */
 //--------------------------------------------------------------------------------------------------
-double obs_GetChangeBy
+bool obs_IsBufferRunLengthEncoded
 (
     res_Resource_t* resPtr
 )
@@ -1924,121 +5801,149 @@ double obs_GetChangeBy
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    return obsPtr->changeBy;
+    backup_EnsureRestored(obsPtr);
+
+    return obsPtr->runLengthBuffer;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Perform a transform on buffered data. Value of the observation will be the output of the
- * transform
+ * Find an Observation's rollup tier with a given bucket width, adding an empty one if there isn't
+ * one yet, and make it retain a given number of completed rows.
  *
- * Ignored for all non-numeric types except Boolean for which non-zero = true and zero = false.
+ * @return Pointer to the tier, or NULL if the Observation already has MAX_ROLLUP_TIERS tiers.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_SetTransform
+RollupTier_t* obs_AddRollupTier
 (
-    res_Resource_t* resPtr,
-    obs_TransformType_t transformType,
-    const double* paramsPtr,
-    size_t paramsSize
+    Observation_t* obsPtr,
+    uint32_t bucketSeconds, ///< Width of the tier's buckets, in seconds (must not be 0).
+    uint32_t count  ///< Number of completed buckets to retain (must not be 0).
 )
 //--------------------------------------------------------------------------------------------------
 {
-    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
-
-    obsPtr->transformType = transformType;
+    RollupTier_t* tierPtr = FindRollupTier(obsPtr, bucketSeconds);
 
-    // If the transform is being set to anything other than NONE, ensure there is at least one
-    // data sample buffered in order to allow transforms to behave properly
-    if (   (OBS_TRANSFORM_TYPE_NONE != obsPtr->transformType)
-        && (0 == obsPtr->maxCount))
+    if (tierPtr == NULL)
     {
-        obsPtr->maxCount = 1;
+        if (obsPtr->rollupCount >= MAX_ROLLUP_TIERS)
+        {
+            LE_ERROR("Observation already has the maximum number of rollup tiers (%d).",
+                     MAX_ROLLUP_TIERS);
+            return NULL;
+        }
+
+        // Insert the new tier in order of bucket width, finest first.
+        size_t i = obsPtr->rollupCount;
+        while ((i > 0) && (obsPtr->rollups[i - 1].bucketSeconds > bucketSeconds))
+        {
+            obsPtr->rollups[i] = obsPtr->rollups[i - 1];
+            i--;
+        }
+
+        tierPtr = &obsPtr->rollups[i];
+        memset(tierPtr, 0, sizeof(*tierPtr));
+        tierPtr->bucketSeconds = bucketSeconds;
+        obsPtr->rollupCount++;
     }
 
-    // Clear the buffer and current value of the observation.  Do this even if the same transform
-    // is being re-applied.  This allows any cumulative behavior to be cleared
-    TruncateBuffer(obsPtr, 0);
-    if (resPtr->pushedValue != NULL)
+    if (tierPtr->maxCount != count)
     {
-        le_mem_Release(resPtr->pushedValue);
-        resPtr->pushedValue = NULL;
+        ResizeRollupTier(tierPtr, count);
     }
 
-    (void)paramsPtr;
-    (void)paramsSize;
+    return tierPtr;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the type of transform currently applied to an Observation.
- *
- * @return The TransformType
+ * Add, resize, or remove one of an Observation's rollup tiers.  Each tier summarizes the numeric
+ * or Boolean values accepted by the Observation into buckets of a fixed width (aligned to
+ * multiples of that width since the Epoch), and retains a given number of completed buckets,
+ * independently of the Observation's buffer.  A new tier starts out with the values still in the
+ * buffer.
  */
 //--------------------------------------------------------------------------------------------------
-obs_TransformType_t obs_GetTransform
+void obs_SetBufferRollup
 (
-    res_Resource_t* resPtr
+    res_Resource_t* resPtr,
+    uint32_t bucketSeconds, ///< Width of the tier's buckets, in seconds.
+    uint32_t count  ///< Number of completed buckets to retain. 0 = remove the tier.
 )
 //--------------------------------------------------------------------------------------------------
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    return obsPtr->transformType;
-}
+    backup_EnsureRestored(obsPtr);
 
+    if (bucketSeconds == 0)
+    {
+        LE_ERROR("Rollup bucket width must be greater than zero.");
+        return;
+    }
 
-//--------------------------------------------------------------------------------------------------
-/**
- * Set the maximum number of data samples to buffer in a given Observation.  Buffers are FIFO
- * circular buffers. When full, the buffer drops the oldest value to make room for a new addition.
- */
-//--------------------------------------------------------------------------------------------------
-void obs_SetBufferMaxCount
-(
-    res_Resource_t* resPtr,
-    uint32_t count
-)
-//--------------------------------------------------------------------------------------------------
-{
-    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+    RollupTier_t* tierPtr = FindRollupTier(obsPtr, bucketSeconds);
 
-    // If the buffer size is being changed,
-    if (obsPtr->maxCount != count)
+    if (count == 0)
     {
-        // If the size is now zero and backups were enabled, disable backups.
-        if ((count == 0) && (obsPtr->backupPeriod > 0))
+        if (tierPtr != NULL)
         {
-            DisableBackups(obsPtr);
+            obs_FreeBufferArray(tierPtr->rows);
+
+            // Keep the remaining tiers contiguous and sorted.
+            size_t i = tierPtr - obsPtr->rollups;
+            memmove(tierPtr, tierPtr + 1, (obsPtr->rollupCount - i - 1) * sizeof(*tierPtr));
+            obsPtr->rollupCount--;
         }
+        return;
+    }
 
-        // Update the size.
-        obsPtr->maxCount = count;
+    if (tierPtr != NULL)
+    {
+        if (tierPtr->maxCount != count)
+        {
+            ResizeRollupTier(tierPtr, count);
+        }
+        return;
+    }
 
-        // Discard extra samples if the size has shrunk.
-        TruncateBuffer(obsPtr, count);
+    // A new tier starts out summarizing what is already in the buffer.
+    tierPtr = obs_AddRollupTier(obsPtr, bucketSeconds, count);
+    if (tierPtr != NULL)
+    {
+        SeedRollupTier(obsPtr, tierPtr, NAN);
     }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the buffer size setting for a given Observation.
+ * Get the number of completed buckets retained by one of an Observation's rollup tiers.
  *
- * @return The buffer size (in number of samples) or 0 if not set.
+ * @return The number of buckets, or 0 if the Observation has no tier with that bucket width.
  */
 //--------------------------------------------------------------------------------------------------
-uint32_t obs_GetBufferMaxCount
+uint32_t obs_GetBufferRollup
 (
-    res_Resource_t* resPtr
+    res_Resource_t* resPtr,
+    uint32_t bucketSeconds  ///< Width of the tier's buckets, in seconds.
 )
 //--------------------------------------------------------------------------------------------------
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    return obsPtr->maxCount;
+    backup_EnsureRestored(obsPtr);
+
+    RollupTier_t* tierPtr = FindRollupTier(obsPtr, bucketSeconds);
+
+    if (tierPtr == NULL)
+    {
+        return 0;
+    }
+
+    return tierPtr->maxCount;
 }
 
 
@@ -2066,48 +5971,32 @@ void obs_SetBufferBackupPeriod
     {
         obsPtr->backupPeriod = seconds;
 
+        // When backups are (re-)enabled, start with a full backup, in case the backup files
+        // were cleaned up while they were disabled.
+        if (oldPeriod == 0)
+        {
+            obsPtr->journalValid = false;
+        }
+
         // If the buffer size is zero, then backups aren't done, so we can skip the rest.
         if (obsPtr->maxCount > 0)
         {
-            // If the period is now zero, disable backups.
+            // If the period is now zero, disable backups.  The backup is about to be deleted, so
+            // restore it first if that hasn't been done yet.
             if (seconds == 0)
             {
-                DisableBackups(obsPtr);
+                backup_EnsureRestored(obsPtr);
+                backup_Disable(obsPtr);
             }
             // If there's nothing in the buffer, we can skip the rest and just wait for something
             // to be added to the buffer.
-            else if (!le_sls_IsEmpty(&obsPtr->sampleList))
+            else if (obsPtr->buffer.count > 0)
             {
-                // If backups were already enabled and the period has just changed,
-                if (oldPeriod != 0)
+                // If backups were already enabled and there's something waiting to be backed
+                // up, the time it's due at has just changed.
+                if ((oldPeriod != 0) && obsPtr->isBackupPending)
                 {
-                    // If the timer is running, then we know there's something waiting to be
-                    // backed up.  Otherwise, we wait for something to be added to the buffer.
-                    if (obsPtr->backupTimer != NULL)
-                    {
-                        // Stop the old timer, because we know it has the wrong interval.
-                        le_timer_Stop(obsPtr->backupTimer);
-
-                        // If the backup period has passed since the last backup,
-                        // release the timer and do a backup now.
-                        uint32_t nextBackupTime = obsPtr->lastBackupTime + seconds;
-                        le_clk_Time_t now = le_clk_GetRelativeTime();
-                        if (nextBackupTime < now.sec)
-                        {
-                            le_timer_Delete(obsPtr->backupTimer);
-                            obsPtr->backupTimer = NULL;
-
-                            Backup(obsPtr);
-                        }
-                        else // If the backup period has not yet passed, correct the timer's
-                             // interval and restart it.
-                        {
-                            uint32_t timerInterval = (nextBackupTime - now.sec) * 1000;
-                            LE_ASSERT(le_timer_SetMsInterval(obsPtr->backupTimer, timerInterval)
-                                      == LE_OK);
-                            LE_ASSERT(le_timer_Start(obsPtr->backupTimer) == LE_OK);
-                        }
-                    }
+                    backup_ScheduleCommit();
                 }
             }
         }
@@ -2132,209 +6021,514 @@ uint32_t obs_GetBufferBackupPeriod
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    return obsPtr->backupPeriod;
+    return obsPtr->backupPeriod;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Convert a time that may be relative to the current time into an absolute time.
+ *
+ * @return Seconds since the Epoch (or NAN if the time given is NAN).
+ */
+//--------------------------------------------------------------------------------------------------
+static double ToAbsoluteTime
+(
+    double time     ///< If <= 30 years, count back from now; else absolute time.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // If the time is less than or equal to 30 years, then convert to an
+    // absolute timestamp by subtracting it from the current time.
+    if (time <= THIRTY_YEARS)
+    {
+        le_clk_Time_t now = le_clk_GetAbsoluteTime();
+        time = ((((double)(now.usec)) / 1000000) + now.sec) - time;
+    }
+
+    return time;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the data sample at or after a given timestamp in a given Observation's buffer.
+ *
+ * @return the index of the sample in the buffer (0 = oldest), or the number of samples in the
+ *         buffer if not found.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t FindBufferIndex
+(
+    Observation_t* obsPtr,
+    double startTime   ///< NAN for oldest; if < 30 years, count back from now; else absolute time.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    // If the buffer is empty or the startTime wasn't specified, start at the oldest.
+    if ((bufferPtr->count == 0) || isnan(startTime))
+    {
+        return 0;
+    }
+
+    startTime = ToAbsoluteTime(startTime);
+
+    // obs_AddToBuffer() keeps the timestamps in non-decreasing order, so binary search for the
+    // oldest entry that is the same age or newer than the specified start time.
+    size_t low = 0;
+    size_t high = bufferPtr->count;
+
+    // In a compressed buffer, first narrow the search down to a single block (and the first
+    // sample of the next one) using the blocks' first timestamps, so only that block is decoded.
+    if (bufferPtr->compressed)
+    {
+        size_t blockLow = 0;
+        size_t blockHigh = bufferPtr->blockCount;
+
+        while (blockLow < blockHigh)
+        {
+            size_t middle = blockLow + ((blockHigh - blockLow) / 2);
+
+            if (bufferPtr->blocks[middle]->firstTimestamp < startTime)
+            {
+                blockLow = middle + 1;
+            }
+            else
+            {
+                blockHigh = middle;
+            }
+        }
+
+        // The first block may have had samples dropped, but its first timestamp is still no
+        // newer than its remaining samples'.
+        if (blockLow == 0)
+        {
+            return 0;
+        }
+
+        size_t blockEnd = (blockLow * COMPRESSED_BLOCK_SAMPLES) - bufferPtr->blockHead;
+        if (blockEnd < high)
+        {
+            high = blockEnd;
+        }
+        if (blockLow > 1)
+        {
+            low = blockEnd - COMPRESSED_BLOCK_SAMPLES;
+        }
+    }
+
+    while (low < high)
+    {
+        size_t middle = low + ((high - low) / 2);
+
+        if (obs_GetBufferedTimestamp(bufferPtr, middle) < startTime)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the oldest sample in a given Observation's buffer that is newer than a given timestamp.
+ * If the sample found at or after the startAfter time is an exact match for that time, then the
+ * sample after it is used.
+ *
+ * @return the index of the sample in the buffer (0 = oldest), or the number of samples in the
+ *         buffer if not found.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t FindBufferIndexAfter
+(
+    Observation_t* obsPtr,
+    double startAfter   ///< NAN for oldest; if < 30 years, count back from now; else absolute time.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    size_t index = FindBufferIndex(obsPtr, startAfter);
+
+    if ((index < bufferPtr->count) && (obs_GetBufferedTimestamp(bufferPtr, index) == startAfter))
+    {
+        index++;
+    }
+
+    return index;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find the first entry in a given Observation's buffer that a query over the samples at or after
+ * a given timestamp covers.  For a run-length encoded buffer, this is the first run that ends at
+ * or after that time, so a run that started earlier is counted as a whole.
+ *
+ * @return the index of the entry in the buffer (0 = oldest), or the number of entries in the
+ *         buffer if not found.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t FindQueryIndex
+(
+    Observation_t* obsPtr,
+    double startTime   ///< NAN for oldest; if < 30 years, count back from now; else absolute time.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    if (!bufferPtr->runLength || isnan(startTime))
+    {
+        return FindBufferIndex(obsPtr, startTime);
+    }
+
+    startTime = ToAbsoluteTime(startTime);
+
+    // Runs don't overlap, so their end timestamps are in non-decreasing order too.
+    size_t low = 0;
+    size_t high = bufferPtr->count;
+
+    while (low < high)
+    {
+        size_t middle = low + ((high - low) / 2);
+
+        if (obs_GetBufferedEndTimestamp(bufferPtr, middle) < startTime)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read data out of a buffer.  Data is written to a given file descriptor in a given format.  In
+ * JSON format, that is an array of objects containing a timestamp and a value (or just a timestamp
+ * for triggers).  E.g.,
+ *
+ * @code
+ * [{"t":1537483647.125,"v":true},{"t":1537483657.128,"v":true}]
+ * @endcode
+ *
+ * See query_ReadBuffer() for the binary formats.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ReadBuffer
+(
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startAfter,  ///< Start after this many seconds ago, or after an absolute number of
+                        ///< seconds since the Epoch (if startafter > 30 years).
+                        ///< Use NAN (not a number) to read the whole buffer.
+    query_Format_t format,  ///< Format to write the data in.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    backup_EnsureRestored(obsPtr);
+
+    size_t index = FindBufferIndexAfter(obsPtr, startAfter);
+
+    uint64_t startSeq = NO_MORE_SAMPLES;
+    if (index < obsPtr->buffer.count)
+    {
+        startSeq = obsPtr->buffer.firstSeq + index;
+    }
+
+    ReadMode_t mode;
+    memset(&mode, 0, sizeof(mode));
+
+    mode.format = format;
+
+    StartRead(obsPtr, startSeq, &mode, outputFile, handlerPtr, contextPtr);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Function that gets called for each file system object (file, directory, symlink, etc.) found
- * under the backup directory.
+ * Export the numerical samples in a time window of an Observation's buffer as a snapshot in a
+ * sealed, read-only memory file that the client can map into memory.  The snapshot is an
+ * ExportHeader_t followed by an array of timestamps and an array of values.  (For run-length
+ * encoded buffers, there is one sample per run, stamped with the time of its first sample, as
+ * for obs_ReadBuffer().)
  *
- * @return 0 to continue the file system tree walk, non-zero to stop.
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_UNAVAILABLE if the buffer doesn't contain numerical data.
+ *  - LE_FAULT if the memory file couldn't be created.
  */
 //--------------------------------------------------------------------------------------------------
-static int BackupDirTreeWalkCallback
+le_result_t obs_ExportBuffer
 (
-    const char *fpath,      ///< File system path of the object.
-    const struct stat *sb,  ///< Ptr to the stat() info for the object.
-    int typeflag,           ///< What type of file system object we're looking at.
-    struct FTW *ftwbuf      ///< Ptr to buffer containing the basename and the nesting level.
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startTime,   ///< Samples before this time are excluded. If < 30 years then seconds
+                        ///< before now; else seconds since the Epoch. NAN = no limit.
+    double endTime,     ///< Samples at or after this time are excluded. If < 30 years then
+                        ///< seconds before now; else seconds since the Epoch. NAN = no limit.
+    int* snapshotFilePtr    ///< [OUT] File descriptor of the snapshot, if LE_OK returned.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    switch (typeflag)
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
+
+    backup_EnsureRestored(obsPtr);
+
+    // This only works for numeric or Boolean type data.
+    if (!obs_IsBufferNumerical(obsPtr))
     {
-        case FTW_F:  // regular file
-        {
-            // Compute the resource tree entry path of the associated Observation.
-            const char* relPath = fpath + BACKUP_DIR_PATH_LEN;
-            const char* suffixPtr = strstr(relPath, BACKUP_SUFFIX);
-            if (suffixPtr == NULL)
-            {
-                LE_WARN("Unexpected file in backup directory. Skipping '%s'.", fpath);
-                return 0;
-            }
-            // Copy all but the suffix into the observation path.
-            size_t obsPathBytes = (suffixPtr - relPath) + sizeof("/obs/");
-            char obsPath[HUB_MAX_RESOURCE_PATH_BYTES];
-            if (obsPathBytes >= sizeof(obsPath))
-            {
-                LE_ERROR("Length of path too long. Skipping '%s'.", fpath);
-                return 0;
-            }
-            (void)snprintf(obsPath, obsPathBytes, "/obs/%s", relPath);
+        return LE_UNAVAILABLE;
+    }
 
-            // If that Observation doesn't exist, or its backup period is 0, delete the file.
-            resTree_EntryRef_t entryRef = resTree_FindEntry(resTree_GetRoot(), obsPath);
-            if (   (entryRef == NULL)
-                || (resTree_GetEntryType(entryRef) != ADMIN_ENTRY_TYPE_OBSERVATION)
-                || (resTree_GetBufferBackupPeriod(entryRef) == 0)  )
-            {
-                if (unlink(fpath) != 0)
-                {
-                    LE_CRIT("Failed to delete '%s' (%m).", fpath);
-                }
-            }
+    size_t startIndex = FindBufferIndex(obsPtr, startTime);
+    size_t endIndex = (isnan(endTime) ? bufferPtr->count : FindBufferIndex(obsPtr, endTime));
+    size_t count = ((endIndex > startIndex) ? (endIndex - startIndex) : 0);
 
-            return 0;
-        }
-        case FTW_D:  // directory and FTW_DEPTH was NOT specified
+    ExportHeader_t header;
+    memset(&header, 0, sizeof(header));
 
-            // This should never happen, because we specified FTW_DEPTH.
-            LE_CRIT("Received FTW_D flag for '%s'!", fpath);
-            return 0;
+    memcpy(header.magic, "DHXS", sizeof(header.magic));
+    header.version = EXPORT_VERSION;
+    header.dataType = obsPtr->bufferedType;
+    header.count = count;
+    header.timestampsOffset = sizeof(header);
+    header.valuesOffset = header.timestampsOffset + (count * sizeof(double));
 
-        case FTW_DNR:   // directory that can't be read
+    size_t size = header.valuesOffset + (count * sizeof(double));
 
-            LE_ERROR("Can't read directory '%s'", fpath);
-            return 0;
+    int fd = memfd_create("dataHubExport", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+    {
+        LE_ERROR("Failed to create memory file for export (%m).");
+        return LE_FAULT;
+    }
 
-        case FTW_DP:    // directory and FTW_DEPTH was specified
-        {
-            // If the directory is empty, delete it.
-            int result = rmdir(fpath);
-            if ((result == -1) && (errno != ENOTEMPTY) && (errno != EEXIST))
-            {
-                LE_CRIT("Failed to remove directory '%s' (%m).", fpath);
-            }
-            return 0;
-        }
-        case FTW_NS:     // stat() call failed on fpath
+    if (ftruncate(fd, size) != 0)
+    {
+        LE_ERROR("Failed to size memory file for export to %zu bytes (%m).", size);
+        close(fd);
+        return LE_FAULT;
+    }
 
-            LE_CRIT("Failed to stat '%s'", fpath);
-            return 0;
+    uint8_t* mapPtr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapPtr == MAP_FAILED)
+    {
+        LE_ERROR("Failed to map memory file for export (%m).");
+        close(fd);
+        return LE_FAULT;
+    }
 
-        case FTW_SL:     // symbolic link and FTW_PHYS specified
+    memcpy(mapPtr, &header, sizeof(header));
 
-            // This should never happen, because we didn't specify FTW_PHYS.
-            LE_CRIT("Received FTW_SL flag for '%s'!", fpath);
-            return 0;
+    double* timestamps = (double*)(mapPtr + header.timestampsOffset);
+    double* values = (double*)(mapPtr + header.valuesOffset);
 
-        case FTW_SLN:    // symbolic link pointing to a nonexistent file
+    for (size_t i = 0; i < count; i++)
+    {
+        timestamps[i] = obs_GetBufferedTimestamp(bufferPtr, startIndex + i);
+        values[i] = obs_GetBufferedNumber(obsPtr, startIndex + i);
+    }
 
-            LE_CRIT("Broken symlink found at '%s'", fpath);
-            return 0;
+    munmap(mapPtr, size);
+
+    // Now that there are no writable mappings left, seal the file so that nothing can change it
+    // while the client has it mapped.
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+    {
+        LE_ERROR("Failed to seal memory file for export (%m).");
+        close(fd);
+        return LE_FAULT;
     }
 
-    LE_CRIT("Unexpected type flag %d.", typeflag);
+    *snapshotFilePtr = fd;
 
-    return -1;
+    return LE_OK;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Delete buffer backup files that aren't being used.
+ * Read aggregates of the numerical data in a buffer, bucketed by time.  Data is written to a given
+ * file descriptor in JSON-encoded format as an array of objects, one per time bucket, containing
+ * the start time of the bucket and the requested aggregates of the values in it.  E.g.,
+ *
+ * @code
+ * [{"t":1537483620.000000,"mean":21.250000},{"t":1537483680.000000,"mean":21.500000}]
+ * @endcode
+ *
+ * Buckets that contain no numerical values are omitted.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_DeleteUnusedBackupFiles
+void obs_ReadBufferAggregates
 (
-    void
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startTime,   ///< Start time of the first bucket. If < 30 years then seconds before now;
+                        ///< else seconds since the Epoch. NAN = start at the oldest sample.
+    double endTime,     ///< Samples at or after this time are excluded. If < 30 years then
+                        ///< seconds before now; else seconds since the Epoch. NAN = no limit.
+    double bucketSeconds,   ///< Width of each time bucket, in seconds (> 0).
+    query_Aggregate_t aggregates,   ///< Aggregates to write for each bucket (non-zero).
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    LE_DEBUG("Cleaning up unused buffer backup files.");
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    backup_EnsureRestored(obsPtr);
+
+    ReadMode_t mode;
+    memset(&mode, 0, sizeof(mode));
+
+    ReadBuckets_t buckets;
 
-    // Walk the directory tree under the backup directory.
-    // For each file, compute the resource tree entry path of the associated Observation.
-    // If that Observation doesn't exist, delete the file.
-    // If the directory is empty (after examining all files in it), delete the directory.
-    // Note: The number of file descriptors allowed to be used is selected to prevent
-    // running into the app's open file descriptor limit, while avoiding a lot of opening
-    // and closing of directories.  Normally we don't expect a lot of depth in the Observation
-    // resource naming heirarchy, so there shouldn't be a lot of depth in the backup directory.
-    int result = nftw(BACKUP_DIR,
-                      BackupDirTreeWalkCallback,
-                      4 /* max fds */,
-                      FTW_DEPTH /* depth-first traversal */);
-    if (result != 0)
+    buckets.aggregates = aggregates;
+    buckets.origin = ToAbsoluteTime(startTime);
+    buckets.bucketSeconds = bucketSeconds;
+    buckets.endTime = ToAbsoluteTime(endTime);
+
+    if (isnan(buckets.endTime))
     {
-        if (errno == ENOENT)
-        {
-            LE_DEBUG("No backup directory. Skipping backup file clean-up.");
-        }
-        else
+        buckets.endTime = INFINITY;
+    }
+
+    size_t index = FindBufferIndex(obsPtr, buckets.origin);
+
+    uint64_t startSeq = NO_MORE_SAMPLES;
+    if (index < obsPtr->buffer.count)
+    {
+        startSeq = obsPtr->buffer.firstSeq + index;
+
+        // If no start time was given, the buckets start at the oldest sample.
+        if (isnan(buckets.origin))
         {
-            LE_CRIT("Failed to traverse backup directory '%s' (%m)", BACKUP_DIR);
+            buckets.origin = obs_GetBufferedTimestamp(&obsPtr->buffer, index);
         }
     }
+
+    mode.buckets = buckets;
+
+    StartRead(obsPtr, startSeq, &mode, outputFile, handlerPtr, contextPtr);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Find the data sample at or after a given timestamp in a given Observation's buffer.
+ * Read a downsampled representation of the numerical data in a buffer, for plotting.  At most
+ * maxPoints samples are written to a given file descriptor, in the same JSON-encoded format as
+ * obs_ReadBuffer().  If the buffer holds no more than maxPoints samples after startAfter,
+ * they are all written.
  *
- * @return a pointer to the buffer entry, or NULL if not found.
+ * If the buffer doesn't contain numerical data, an empty array is written.
  */
 //--------------------------------------------------------------------------------------------------
-static BufferEntry_t* FindBufferEntry
+void obs_ReadBufferDownsampled
 (
-    Observation_t* obsPtr,
-    double startTime   ///< NAN for oldest; if < 30 years, count back from now; else absolute time.
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startAfter,  ///< Start after this many seconds ago, or after an absolute number of
+                        ///< seconds since the Epoch (if startafter > 30 years).
+                        ///< Use NAN (not a number) to read the whole buffer.
+    uint32_t maxPoints, ///< Maximum number of samples to write (>= 3 for LTTB, >= 2 for min/max).
+    query_Downsampling_t method,    ///< Downsampling algorithm.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    // Start at the oldest end and search forward.
-    BufferEntry_t* buffEntryPtr = GetOldestBufferEntry(obsPtr);
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    backup_EnsureRestored(obsPtr);
+
+    size_t index = FindBufferIndexAfter(obsPtr, startAfter);
+    size_t sampleCount = obsPtr->buffer.count - index;
 
-    // If the buffer isn't empty and the startTime was specified,
-    if ((buffEntryPtr != NULL) && (!isnan(startTime)))
+    uint64_t startSeq = NO_MORE_SAMPLES;
+    if (index < obsPtr->buffer.count)
     {
-        // If the start time is less than or equal to 30 years, then convert to an
-        // absolute timestamp by subtracting it from the current time.
-        if (startTime <= THIRTY_YEARS)
-        {
-            le_clk_Time_t now = le_clk_GetAbsoluteTime();
-            startTime = ((((double)(now.usec)) / 1000000) + now.sec) - startTime;
-        }
+        startSeq = obsPtr->buffer.firstSeq + index;
+    }
 
-        // Walk up the buffer looking for an entry that is the same age or newer than the
-        // specified start time.
-        do
-        {
-            if (dataSample_GetTimestamp(buffEntryPtr->sampleRef) >= startTime)
-            {
-                break;
-            }
+    // Only numeric and Boolean type data can be downsampled.
+    if (!obs_IsBufferNumerical(obsPtr))
+    {
+        startSeq = NO_MORE_SAMPLES;
+    }
+
+    // If there aren't too many samples already, just write them all.
+    if ((startSeq == NO_MORE_SAMPLES) || (sampleCount <= maxPoints))
+    {
+        StartRead(obsPtr, startSeq, NULL, outputFile, handlerPtr, contextPtr);
+        return;
+    }
+
+    ReadMode_t mode;
+    memset(&mode, 0, sizeof(mode));
 
-            buffEntryPtr = GetNextBufferEntry(obsPtr, buffEntryPtr);
+    ReadDownsampling_t* downsamplingPtr = &mode.downsampling;
 
-        } while (buffEntryPtr != NULL);
+    downsamplingPtr->method = method;
+    downsamplingPtr->firstSeq = startSeq;
+    downsamplingPtr->endSeq = startSeq + sampleCount;
+    downsamplingPtr->nextBucket = 0;
+    downsamplingPtr->prevTimestamp = NAN;
+    downsamplingPtr->prevValue = NAN;
+
+    if (method == QUERY_DOWNSAMPLING_MIN_MAX)
+    {
+        // Each bucket may be represented by two samples.
+        downsamplingPtr->bucketCount = maxPoints / 2;
+    }
+    else
+    {
+        downsamplingPtr->bucketCount = maxPoints;
     }
 
-    return buffEntryPtr;
+    StartRead(obsPtr, startSeq, &mode, outputFile, handlerPtr, contextPtr);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Read data out of a buffer.  Data is written to a given file descriptor in JSON-encoded format
- * as an array of objects containing a timestamp and a value (or just a timestamp for triggers).
- * E.g.,
+ * Read the rows of one of an Observation's rollup tiers, starting with the first bucket that
+ * starts at or after a given time, and write them to a given file descriptor in JSON format.
+ * The tier used is the coarsest one whose buckets are no wider than a given resolution.  The
+ * bucket currently being filled is written last.  E.g.,
  *
  * @code
- * [{"t":1537483647.125,"v":true},{"t":1537483657.128,"v":true}]
+ * [{"t":1537483560.000000,"count":60,"min":20.100000,"max":22.400000,"mean":21.250000}]
  * @endcode
+ *
+ * @return
+ *  - LE_OK if the read operation started.
+ *  - LE_NOT_FOUND if the Observation has no rollup tier that fine.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_ReadBufferJson
+le_result_t obs_ReadRollupJson
 (
     res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
-    double startAfter,  ///< Start after this many seconds ago, or after an absolute number of
-                        ///< seconds since the Epoch (if startafter > 30 years).
-                        ///< Use NAN (not a number) to read the whole buffer.
+    uint32_t resolution,    ///< Maximum bucket width, in seconds.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+                        ///< NAN = start at the oldest bucket.
     int outputFile, ///< File descriptor to write the data to.
     query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
     void* contextPtr    ///< Value to be passed to completion callback.
@@ -2343,16 +6537,31 @@ void obs_ReadBufferJson
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    BufferEntry_t* startPtr = FindBufferEntry(obsPtr, startAfter);
+    backup_EnsureRestored(obsPtr);
+
+    RollupTier_t* tierPtr = SelectRollupTier(obsPtr, resolution);
+
+    if (tierPtr == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    ReadMode_t mode;
+    memset(&mode, 0, sizeof(mode));
+
+    mode.rollupSeconds = tierPtr->bucketSeconds;
+
+    size_t index = FindRollupIndex(tierPtr, ToAbsoluteTime(startTime));
 
-    // If the data sample found is an exact match for the startAfter time, then skip to the
-    // sample after that.
-    if ((startPtr != NULL) && (dataSample_GetTimestamp(startPtr->sampleRef) == startAfter))
+    uint64_t startSeq = NO_MORE_SAMPLES;
+    if (index < obs_GetRollupRowCount(tierPtr))
     {
-        startPtr = GetNextBufferEntry(obsPtr, startPtr);
+        startSeq = tierPtr->firstSeq + index;
     }
 
-    StartRead(obsPtr, startPtr, outputFile, handlerPtr, contextPtr);
+    StartRead(obsPtr, startSeq, &mode, outputFile, handlerPtr, contextPtr);
+
+    return LE_OK;
 }
 
 
@@ -2360,7 +6569,8 @@ void obs_ReadBufferJson
 /**
  * Find the oldest data sample in a given Observation's buffer that is newer than a given timestamp.
  *
- * @return Reference to the sample, or NULL if not found in buffer.
+ * @return Reference to the sample, or NULL if not found in buffer.  The caller must release this
+ *         reference when finished with it.
  */
 //--------------------------------------------------------------------------------------------------
 dataSample_Ref_t obs_FindBufferedSampleAfter
@@ -2374,21 +6584,41 @@ dataSample_Ref_t obs_FindBufferedSampleAfter
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
-    BufferEntry_t* startPtr = FindBufferEntry(obsPtr, startAfter);
+    backup_EnsureRestored(obsPtr);
+    SampleBuffer_t* bufferPtr = &obsPtr->buffer;
 
-    // If the data sample found is an exact match for the startAfter time, then skip to the
-    // sample after that.
-    if ((startPtr != NULL) && (dataSample_GetTimestamp(startPtr->sampleRef) == startAfter))
+    size_t index = FindBufferIndexAfter(obsPtr, startAfter);
+
+    if (index >= bufferPtr->count)
     {
-        startPtr = GetNextBufferEntry(obsPtr, startPtr);
+        return NULL;
     }
 
-    if (startPtr != NULL)
+    size_t slot = obs_GetSlot(bufferPtr, index);
+    double timestamp = obs_GetBufferedTimestamp(bufferPtr, index);
+
+    switch (obsPtr->bufferedType)
     {
-        return startPtr->sampleRef;
+        case IO_DATA_TYPE_TRIGGER:
+
+            return dataSample_CreateTrigger(timestamp);
+
+        case IO_DATA_TYPE_BOOLEAN:
+
+            return dataSample_CreateBoolean(timestamp, bufferPtr->values.booleans[slot]);
+
+        case IO_DATA_TYPE_NUMERIC:
+
+            return dataSample_CreateNumeric(timestamp, obs_GetBufferedNumber(obsPtr, index));
+
+        case IO_DATA_TYPE_STRING:
+        case IO_DATA_TYPE_JSON:
+
+            le_mem_AddRef(bufferPtr->values.samples[slot]);
+            return bufferPtr->values.samples[slot];
     }
 
-    return NULL;
+    LE_FATAL("Invalid data type %d.", obsPtr->bufferedType);
 }
 
 
@@ -2439,51 +6669,51 @@ const char* obs_GetJsonExtraction
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get buffer entry numerical value.  This works for numeric or Boolean types only.
+ * Get the minimum value found in an Observation's data set within a given time span.
  *
- * @return The value.
+ * @return The value, or NAN (not-a-number) if there's no numerical data in the Observation's
+ *         buffer (if the buffer size is zero, the buffer is empty, or the buffer contains data
+ *         of a non-numerical type).
  */
 //--------------------------------------------------------------------------------------------------
-static double GetBufferedNumber
+double obs_QueryMin
 (
-    BufferEntry_t* buffEntryPtr,
-    io_DataType_t dataType
+    res_Resource_t* resPtr,    ///< Ptr to Observation resource.
+    double startTime    ///< If < 30 years then seconds before now; else seconds since the Epoch.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    if (dataType == IO_DATA_TYPE_NUMERIC)
-    {
-        return dataSample_GetNumeric(buffEntryPtr->sampleRef);
-    }
-    else if (dataType == IO_DATA_TYPE_BOOLEAN)
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    backup_EnsureRestored(obsPtr);
+
+    // This only works for numeric or Boolean type data.
+    if (!obs_IsBufferNumerical(obsPtr))
     {
-        if (dataSample_GetBoolean(buffEntryPtr->sampleRef))
-        {
-            return 1.0;
-        }
-        else
-        {
-            return 0.0;
-        }
+        return NAN;
     }
-    else
+
+    size_t startIndex = FindQueryIndex(obsPtr, startTime);
+
+    if (startIndex >= obsPtr->buffer.count)
     {
-        LE_CRIT("Non-numerical data type %d.", dataType);
         return NAN;
     }
+
+    return GetRangeExtremum(obsPtr, startIndex, false /* min */);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the minimum value found in an Observation's data set within a given time span.
+ * Get the maximum value found within a given time span in an Observation's buffer.
  *
  * @return The value, or NAN (not-a-number) if there's no numerical data in the Observation's
  *         buffer (if the buffer size is zero, the buffer is empty, or the buffer contains data
  *         of a non-numerical type).
  */
 //--------------------------------------------------------------------------------------------------
-double obs_QueryMin
+double obs_QueryMax
 (
     res_Resource_t* resPtr,    ///< Ptr to Observation resource.
     double startTime    ///< If < 30 years then seconds before now; else seconds since the Epoch.
@@ -2492,46 +6722,37 @@ double obs_QueryMin
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
+    backup_EnsureRestored(obsPtr);
+
     // This only works for numeric or Boolean type data.
-    if (   (obsPtr->bufferedType != IO_DATA_TYPE_NUMERIC)
-        && (obsPtr->bufferedType != IO_DATA_TYPE_BOOLEAN)  )
+    if (!obs_IsBufferNumerical(obsPtr))
     {
         return NAN;
     }
 
-    BufferEntry_t* buffEntryPtr = FindBufferEntry(obsPtr, startTime);
-
-    double result = NAN;
+    size_t startIndex = FindQueryIndex(obsPtr, startTime);
 
-    while (buffEntryPtr != NULL)
+    if (startIndex >= obsPtr->buffer.count)
     {
-        double value = GetBufferedNumber(buffEntryPtr, obsPtr->bufferedType);
-
-        if (!isnan(value))
-        {
-            if (isnan(result) || (result > value))
-            {
-                result = value;
-            }
-        }
-
-        buffEntryPtr = GetNextBufferEntry(obsPtr, buffEntryPtr);
+        return NAN;
     }
 
-    return result;
+    return GetRangeExtremum(obsPtr, startIndex, true /* max */);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the maximum value found within a given time span in an Observation's buffer.
+ * Get the mean (average) of all values found within a given time span in an Observation's buffer.
+ * For a swinging door buffer, this is the time-weighted mean of the signal reconstructed from the
+ * buffered samples.
  *
  * @return The value, or NAN (not-a-number) if there's no numerical data in the Observation's
  *         buffer (if the buffer size is zero, the buffer is empty, or the buffer contains data
  *         of a non-numerical type).
  */
 //--------------------------------------------------------------------------------------------------
-double obs_QueryMax
+double obs_QueryMean
 (
     res_Resource_t* resPtr,    ///< Ptr to Observation resource.
     double startTime    ///< If < 30 years then seconds before now; else seconds since the Epoch.
@@ -2540,46 +6761,53 @@ double obs_QueryMax
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
+    backup_EnsureRestored(obsPtr);
+
     // This only works for numeric or Boolean type data.
-    if (   (obsPtr->bufferedType != IO_DATA_TYPE_NUMERIC)
-        && (obsPtr->bufferedType != IO_DATA_TYPE_BOOLEAN)  )
+    if (!obs_IsBufferNumerical(obsPtr))
     {
         return NAN;
     }
 
-    BufferEntry_t* buffEntryPtr = FindBufferEntry(obsPtr, startTime);
-
-    double result = NAN;
+    size_t startIndex = FindQueryIndex(obsPtr, startTime);
 
-    while (buffEntryPtr != NULL)
+    if (startIndex >= obsPtr->buffer.count)
     {
-        double value = GetBufferedNumber(buffEntryPtr, obsPtr->bufferedType);
+        return NAN;
+    }
 
-        if (!isnan(value))
-        {
-            if (isnan(result) || (result < value))
-            {
-                result = value;
-            }
-        }
+    double sum;
+    double sumOfSquares;
+    size_t count = GetRangeSums(obsPtr, startIndex, &sum, &sumOfSquares);
+
+    if (count == 0)
+    {
+        return NAN;
+    }
 
-        buffEntryPtr = GetNextBufferEntry(obsPtr, buffEntryPtr);
+    double mean;
+    double stdDev;
+    if (IsSwingingDoorEnabled(obsPtr) && GetInterpolatedMoments(obsPtr, startIndex, &mean, &stdDev))
+    {
+        return mean;
     }
 
-    return result;
+    return obsPtr->rangeIndex.shift + (sum / count);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the mean (average) of all values found within a given time span in an Observation's buffer.
+ * Get the standard deviation of all values found within a given time span in an
+ * Observation's buffer.  For a swinging door buffer, this is the time-weighted standard deviation
+ * of the signal reconstructed from the buffered samples.
  *
  * @return The value, or NAN (not-a-number) if there's no numerical data in the Observation's
  *         buffer (if the buffer size is zero, the buffer is empty, or the buffer contains data
  *         of a non-numerical type).
  */
 //--------------------------------------------------------------------------------------------------
-double obs_QueryMean
+double obs_QueryStdDev
 (
     res_Resource_t* resPtr,    ///< Ptr to Observation resource.
     double startTime    ///< If < 30 years then seconds before now; else seconds since the Epoch.
@@ -2588,112 +6816,186 @@ double obs_QueryMean
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
+    backup_EnsureRestored(obsPtr);
+
     // This only works for numeric or Boolean type data.
-    if (   (obsPtr->bufferedType != IO_DATA_TYPE_NUMERIC)
-        && (obsPtr->bufferedType != IO_DATA_TYPE_BOOLEAN)  )
+    if (!obs_IsBufferNumerical(obsPtr))
     {
         return NAN;
     }
 
-    BufferEntry_t* buffEntryPtr = FindBufferEntry(obsPtr, startTime);
-
-    double sum = 0;
-    size_t count = 0;
+    size_t startIndex = FindQueryIndex(obsPtr, startTime);
 
-    while (buffEntryPtr != NULL)
+    if (startIndex >= obsPtr->buffer.count)
     {
-        double value = GetBufferedNumber(buffEntryPtr, obsPtr->bufferedType);
-
-        if (!isnan(value))
-        {
-            sum += value;
-            count++;
-        }
-
-        buffEntryPtr = GetNextBufferEntry(obsPtr, buffEntryPtr);
+        return NAN;
     }
 
+    double sum;
+    double sumOfSquares;
+    size_t count = GetRangeSums(obsPtr, startIndex, &sum, &sumOfSquares);
+
     if (count == 0)
     {
         return NAN;
     }
 
-    return (sum / count);
+    double mean;
+    double stdDev;
+    if (IsSwingingDoorEnabled(obsPtr) && GetInterpolatedMoments(obsPtr, startIndex, &mean, &stdDev))
+    {
+        return stdDev;
+    }
+
+    return GetRangeStdDev(obsPtr, startIndex, count, sum, sumOfSquares);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the standard deviation of all values found within a given time span in an
- * Observation's buffer.
+ * Get a summary of all the statistics that can be queried on the values found within a given
+ * time span in an Observation's buffer.
  *
- * @return The value, or NAN (not-a-number) if there's no numerical data in the Observation's
- *         buffer (if the buffer size is zero, the buffer is empty, or the buffer contains data
- *         of a non-numerical type).
+ * All of these come from the buffer's range index, so this costs no more than a single one
+ * of the individual queries.  (For swinging door buffers, the mean and standard deviation are
+ * time-weighted, as for the individual queries.  For run-length encoded buffers, a run that ends
+ * in the time span is included as a whole, and counts as many values as it has samples.)
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_UNAVAILABLE if there's no numerical data in the Observation's buffer within the time span
+ *    (if the buffer size is zero, the buffer is empty, or the buffer contains data of a
+ *    non-numerical type).
  */
 //--------------------------------------------------------------------------------------------------
-double obs_QueryStdDev
+le_result_t obs_QueryStats
 (
     res_Resource_t* resPtr,    ///< Ptr to Observation resource.
-    double startTime    ///< If < 30 years then seconds before now; else seconds since the Epoch.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,         ///< [OUT] Number of non-NAN values in the time span.
+    double* minPtr,             ///< [OUT] Minimum value.
+    double* maxPtr,             ///< [OUT] Maximum value.
+    double* meanPtr,            ///< [OUT] Mean (average) value.
+    double* stdDevPtr,          ///< [OUT] Standard deviation.
+    double* sumPtr,             ///< [OUT] Sum of the values.
+    double* firstTimestampPtr,  ///< [OUT] Timestamp of the oldest sample in the time span.
+    double* lastTimestampPtr    ///< [OUT] Timestamp of the newest sample in the time span.
 )
 //--------------------------------------------------------------------------------------------------
 {
     Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
 
+    backup_EnsureRestored(obsPtr);
+
     // This only works for numeric or Boolean type data.
-    if (   (obsPtr->bufferedType != IO_DATA_TYPE_NUMERIC)
-        && (obsPtr->bufferedType != IO_DATA_TYPE_BOOLEAN)  )
+    if (!obs_IsBufferNumerical(obsPtr))
     {
-        return NAN;
+        return LE_UNAVAILABLE;
     }
 
-    BufferEntry_t* startEntryPtr = FindBufferEntry(obsPtr, startTime);
+    size_t startIndex = FindQueryIndex(obsPtr, startTime);
 
-    if (startEntryPtr == NULL)
+    if (startIndex >= obsPtr->buffer.count)
     {
-        return NAN;
+        return LE_UNAVAILABLE;
     }
 
-    double sum = 0;
-    size_t count = 0;
+    double sum;
+    double sumOfSquares;
+    size_t count = GetRangeSums(obsPtr, startIndex, &sum, &sumOfSquares);
 
-    BufferEntry_t* buffEntryPtr = startEntryPtr;
-    while (buffEntryPtr != NULL)
+    if (count == 0)
     {
-        double value = GetBufferedNumber(buffEntryPtr, obsPtr->bufferedType);
+        return LE_UNAVAILABLE;
+    }
 
-        if (!isnan(value))
-        {
-            sum += value;
-            count++;
-        }
+    double shift = obsPtr->rangeIndex.shift;
 
-        buffEntryPtr = GetNextBufferEntry(obsPtr, buffEntryPtr);
+    *countPtr = count;
+    *minPtr = GetRangeExtremum(obsPtr, startIndex, false /* min */);
+    *maxPtr = GetRangeExtremum(obsPtr, startIndex, true /* max */);
+    *meanPtr = shift + (sum / count);
+    *stdDevPtr = GetRangeStdDev(obsPtr, startIndex, count, sum, sumOfSquares);
+    *sumPtr = (shift * count) + sum;
+    if (IsSwingingDoorEnabled(obsPtr))
+    {
+        (void)GetInterpolatedMoments(obsPtr, startIndex, meanPtr, stdDevPtr);
     }
+    *firstTimestampPtr = obs_GetBufferedTimestamp(&obsPtr->buffer, startIndex);
+    *lastTimestampPtr = obs_GetBufferedEndTimestamp(&obsPtr->buffer, obsPtr->buffer.count - 1);
 
-    if (count == 0)
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics about the values summarized by one of an Observation's rollup tiers in buckets
+ * that start at or after a given time.  The tier used is the coarsest one whose buckets are no
+ * wider than a given resolution, so this can cover a much longer time span than the buffer.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_NOT_FOUND if the Observation has no rollup tier that fine.
+ *  - LE_UNAVAILABLE if there are no values in the time span.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t obs_QueryRollupStats
+(
+    res_Resource_t* resPtr,    ///< Ptr to Observation resource.
+    uint32_t resolution,    ///< Maximum bucket width, in seconds.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,         ///< [OUT] Number of non-NAN values in the time span.
+    double* minPtr,             ///< [OUT] Minimum value.
+    double* maxPtr,             ///< [OUT] Maximum value.
+    double* meanPtr,            ///< [OUT] Mean (average) value.
+    double* stdDevPtr,          ///< [OUT] Standard deviation.
+    double* sumPtr,             ///< [OUT] Sum of the values.
+    double* firstTimestampPtr,  ///< [OUT] Start time of the oldest bucket in the time span.
+    double* lastTimestampPtr    ///< [OUT] Start time of the newest bucket in the time span.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Observation_t* obsPtr = CONTAINER_OF(resPtr, Observation_t, resource);
+
+    backup_EnsureRestored(obsPtr);
+
+    RollupTier_t* tierPtr = SelectRollupTier(obsPtr, resolution);
+
+    if (tierPtr == NULL)
     {
-        return NAN;
+        return LE_NOT_FOUND;
     }
 
-    const double mean = (sum / count);
+    size_t rowCount = obs_GetRollupRowCount(tierPtr);
+    size_t startIndex = FindRollupIndex(tierPtr, ToAbsoluteTime(startTime));
 
-    double sumOfSquaredDifferences = 0;
-
-    buffEntryPtr = startEntryPtr;
-    while (buffEntryPtr != NULL)
+    if (startIndex >= rowCount)
     {
-        double value = GetBufferedNumber(buffEntryPtr, obsPtr->bufferedType);
+        return LE_UNAVAILABLE;
+    }
 
-        if (!isnan(value))
-        {
-            double diff = value - mean;
-            sumOfSquaredDifferences += (diff * diff);
-        }
+    RollupRow_t total;
+    memset(&total, 0, sizeof(total));
 
-        buffEntryPtr = GetNextBufferEntry(obsPtr, buffEntryPtr);
+    for (size_t index = startIndex; index < rowCount; index++)
+    {
+        MergeRollupRow(&total, obs_GetRollupRow(tierPtr, index));
     }
 
-    return sqrt(sumOfSquaredDifferences / count);
+    if (total.count == 0)
+    {
+        return LE_UNAVAILABLE;
+    }
+
+    *countPtr = total.count;
+    *minPtr = total.min;
+    *maxPtr = total.max;
+    *meanPtr = total.mean;
+    *stdDevPtr = sqrt(fmax(total.m2, 0) / total.count);
+    *sumPtr = total.mean * total.count;
+    *firstTimestampPtr = obs_GetRollupRow(tierPtr, startIndex)->startTime;
+    *lastTimestampPtr = obs_GetRollupRow(tierPtr, rowCount - 1)->startTime;
+
+    return LE_OK;
 }
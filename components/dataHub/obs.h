@@ -66,6 +66,18 @@ void obs_RestoreBackup
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Make sure an Observation's data buffer has been restored from non-volatile backup, if it had
+ * one, before the Observation is used.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_CompleteRestore
+(
+    res_Resource_t* resPtr
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Perform JSON extraction.  If the data type is not JSON, does nothing.
@@ -295,6 +307,115 @@ uint32_t obs_GetBufferMaxCount
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable compression of a given Observation's buffer.  Only numeric samples are
+ * compressed.  Samples already in the buffer are kept.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetBufferCompression
+(
+    res_Resource_t* resPtr,
+    bool isCompressed
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether compression is enabled for a given Observation's buffer.
+ *
+ * @return true if enabled.
+ */
+//--------------------------------------------------------------------------------------------------
+bool obs_IsBufferCompressed
+(
+    res_Resource_t* resPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the tolerance of the swinging door compression of a given Observation's buffer.  When set,
+ * numeric samples are only buffered if they are needed to reconstruct the signal to within the
+ * tolerance, by linear interpolation.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetBufferTolerance
+(
+    res_Resource_t* resPtr,
+    double tolerance    ///< Maximum reconstruction error (> 0); NAN or 0 = disabled.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the tolerance of the swinging door compression of a given Observation's buffer.
+ *
+ * @return The tolerance, or NAN if not set.
+ */
+//--------------------------------------------------------------------------------------------------
+double obs_GetBufferTolerance
+(
+    res_Resource_t* resPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable run-length encoding of a given Observation's buffer.  When enabled, repeated
+ * numerical values are buffered as runs of samples, which queries weight by their sample counts.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetBufferRunLengthEncoding
+(
+    res_Resource_t* resPtr,
+    bool isEnabled
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether run-length encoding is enabled for a given Observation's buffer.
+ *
+ * @return true if enabled.
+ */
+//--------------------------------------------------------------------------------------------------
+bool obs_IsBufferRunLengthEncoded
+(
+    res_Resource_t* resPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add, resize, or remove one of an Observation's rollup tiers.  Each tier summarizes the numeric
+ * or Boolean values accepted by the Observation into buckets of a fixed width (aligned to
+ * multiples of that width since the Epoch), and retains a given number of completed buckets,
+ * independently of the Observation's buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetBufferRollup
+(
+    res_Resource_t* resPtr,
+    uint32_t bucketSeconds, ///< Width of the tier's buckets, in seconds.
+    uint32_t count  ///< Number of completed buckets to retain. 0 = remove the tier.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of completed buckets retained by one of an Observation's rollup tiers.
+ *
+ * @return The number of buckets, or 0 if the Observation has no tier with that bucket width.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t obs_GetBufferRollup
+(
+    res_Resource_t* resPtr,
+    uint32_t bucketSeconds  ///< Width of the tier's buckets, in seconds.
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the minimum time between backups of an Observation's buffer to non-volatile storage.
@@ -325,6 +446,71 @@ uint32_t obs_GetBufferBackupPeriod
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the maximum number of bytes per hour to write to buffer backup files.
+ * See admin_SetBackupWriteBudget() for more information.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetBackupWriteBudget
+(
+    uint32_t bytesPerHour   ///< The budget, or 0 for unlimited.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the maximum number of bytes per hour to write to buffer backup files.
+ *
+ * @return The budget, or 0 if unlimited.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t obs_GetBackupWriteBudget
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the writing of buffer backup files.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_GetBackupWriteStats
+(
+    uint64_t* totalBytesPtr,    ///< [OUT] Bytes written since start-up.
+    uint64_t* lastHourBytesPtr, ///< [OUT] Bytes written during the last hour.
+    uint32_t* commitCountPtr    ///< [OUT] Number of backup commits since start-up.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the memory allocated for Observation buffer arrays, which hold the buffered
+ * samples, their indexes and rollup tiers, and the snapshots and journal batches being written to
+ * backup files.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_GetBufferMemoryStats
+(
+    uint64_t* bytesPtr,     ///< [OUT] Bytes allocated now.
+    uint64_t* peakBytesPtr  ///< [OUT] Most bytes allocated at once since start-up.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics on the memory held by backups waiting to be written by the backup writer thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_GetBackupMemoryStats
+(
+    uint64_t* snapshotBytesPtr, ///< [OUT] Bytes held by buffer snapshots and rollup file contents.
+    uint64_t* batchBytesPtr,    ///< [OUT] Bytes held by journal batches.
+    uint64_t* peakBytesPtr      ///< [OUT] Most bytes held by both at once since start-up.
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Delete buffer backup files that aren't being used.
@@ -338,21 +524,124 @@ void obs_DeleteUnusedBackupFiles
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Read data out of a buffer.  Data is written to a given file descriptor in JSON-encoded format
- * as an array of objects containing a timestamp and a value (or just a timestamp for triggers).
- * E.g.,
+ * Read data out of a buffer.  Data is written to a given file descriptor in a given format.  In
+ * JSON format, that is an array of objects containing a timestamp and a value (or just a timestamp
+ * for triggers).  E.g.,
  *
  * @code
  * [{"t":1537483647.125,"v":true},{"t":1537483657.128,"v":true}]
  * @endcode
+ *
+ * See query_ReadBuffer() for the binary formats.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ReadBuffer
+(
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startAfter,  ///< Start after this many seconds ago, or after an absolute number of
+                        ///< seconds since the Epoch (if startafter > 30 years).
+                        ///< Use NAN (not a number) to read the whole buffer.
+    query_Format_t format,  ///< Format to write the data in.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Export the numerical samples in a time window of an Observation's buffer as a snapshot in a
+ * sealed, read-only memory file.  See query_ExportBuffer() for the snapshot's layout.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_UNAVAILABLE if the buffer doesn't contain numerical data.
+ *  - LE_FAULT if the memory file couldn't be created.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t obs_ExportBuffer
+(
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startTime,   ///< Samples before this time are excluded. If < 30 years then seconds
+                        ///< before now; else seconds since the Epoch. NAN = no limit.
+    double endTime,     ///< Samples at or after this time are excluded. If < 30 years then
+                        ///< seconds before now; else seconds since the Epoch. NAN = no limit.
+    int* snapshotFilePtr    ///< [OUT] File descriptor of the snapshot, if LE_OK returned.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read aggregates of the numerical data in a buffer, bucketed by time.  Data is written to a given
+ * file descriptor in JSON-encoded format as an array of objects, one per time bucket, containing
+ * the start time of the bucket and the requested aggregates of the values in it.  E.g.,
+ *
+ * @code
+ * [{"t":1537483620.000000,"mean":21.250000},{"t":1537483680.000000,"mean":21.500000}]
+ * @endcode
+ *
+ * Buckets that contain no numerical values are omitted.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ReadBufferAggregates
+(
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startTime,   ///< Start time of the first bucket. If < 30 years then seconds before now;
+                        ///< else seconds since the Epoch. NAN = start at the oldest sample.
+    double endTime,     ///< Samples at or after this time are excluded. If < 30 years then
+                        ///< seconds before now; else seconds since the Epoch. NAN = no limit.
+    double bucketSeconds,   ///< Width of each time bucket, in seconds (> 0).
+    query_Aggregate_t aggregates,   ///< Aggregates to write for each bucket (non-zero).
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a downsampled representation of the numerical data in a buffer, for plotting.  At most
+ * maxPoints samples are written to a given file descriptor, in the same JSON-encoded format as
+ * obs_ReadBuffer().  If the buffer holds no more than maxPoints samples after startAfter,
+ * they are all written.
  */
 //--------------------------------------------------------------------------------------------------
-void obs_ReadBufferJson
+void obs_ReadBufferDownsampled
 (
     res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
     double startAfter,  ///< Start after this many seconds ago, or after an absolute number of
                         ///< seconds since the Epoch (if startafter > 30 years).
                         ///< Use NAN (not a number) to read the whole buffer.
+    uint32_t maxPoints, ///< Maximum number of samples to write (>= 3 for LTTB, >= 2 for min/max).
+    query_Downsampling_t method,    ///< Downsampling algorithm.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the rows of one of an Observation's rollup tiers, starting with the first bucket that
+ * starts at or after a given time, and write them to a given file descriptor in JSON format.
+ * The tier used is the coarsest one whose buckets are no wider than a given resolution.  The
+ * bucket currently being filled is written last.  E.g.,
+ *
+ * @code
+ * [{"t":1537483560.000000,"count":60,"min":20.100000,"max":22.400000,"mean":21.250000}]
+ * @endcode
+ *
+ * @return
+ *  - LE_OK if the read operation started.
+ *  - LE_NOT_FOUND if the Observation has no rollup tier that fine.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t obs_ReadRollupJson
+(
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    uint32_t resolution,    ///< Maximum bucket width, in seconds.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+                        ///< NAN = start at the oldest bucket.
     int outputFile, ///< File descriptor to write the data to.
     query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
     void* contextPtr    ///< Value to be passed to completion callback.
@@ -363,7 +652,8 @@ void obs_ReadBufferJson
 /**
  * Find the oldest data sample in a given Observation's buffer that is newer than a given timestamp.
  *
- * @return Reference to the sample, or NULL if not found in buffer.
+ * @return Reference to the sample, or NULL if not found in buffer. The caller must release this
+ *         reference when finished with it.
  */
 //--------------------------------------------------------------------------------------------------
 dataSample_Ref_t obs_FindBufferedSampleAfter
@@ -470,4 +760,59 @@ double obs_QueryStdDev
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a summary of all the statistics that can be queried on the values found within a given
+ * time span in an Observation's buffer.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_UNAVAILABLE if there's no numerical data in the Observation's buffer within the time span
+ *    (if the buffer size is zero, the buffer is empty, or the buffer contains data of a
+ *    non-numerical type).
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t obs_QueryStats
+(
+    res_Resource_t* resPtr,    ///< Ptr to Observation resource.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,         ///< [OUT] Number of non-NAN values in the time span.
+    double* minPtr,             ///< [OUT] Minimum value.
+    double* maxPtr,             ///< [OUT] Maximum value.
+    double* meanPtr,            ///< [OUT] Mean (average) value.
+    double* stdDevPtr,          ///< [OUT] Standard deviation.
+    double* sumPtr,             ///< [OUT] Sum of the values.
+    double* firstTimestampPtr,  ///< [OUT] Timestamp of the oldest sample in the time span.
+    double* lastTimestampPtr    ///< [OUT] Timestamp of the newest sample in the time span.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics about the values summarized by one of an Observation's rollup tiers in buckets
+ * that start at or after a given time.  The tier used is the coarsest one whose buckets are no
+ * wider than a given resolution, so this can cover a much longer time span than the buffer.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_NOT_FOUND if the Observation has no rollup tier that fine.
+ *  - LE_UNAVAILABLE if there are no values in the time span.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t obs_QueryRollupStats
+(
+    res_Resource_t* resPtr,    ///< Ptr to Observation resource.
+    uint32_t resolution,    ///< Maximum bucket width, in seconds.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,         ///< [OUT] Number of non-NAN values in the time span.
+    double* minPtr,             ///< [OUT] Minimum value.
+    double* maxPtr,             ///< [OUT] Maximum value.
+    double* meanPtr,            ///< [OUT] Mean (average) value.
+    double* stdDevPtr,          ///< [OUT] Standard deviation.
+    double* sumPtr,             ///< [OUT] Sum of the values.
+    double* firstTimestampPtr,  ///< [OUT] Start time of the oldest bucket in the time span.
+    double* lastTimestampPtr    ///< [OUT] Start time of the newest bucket in the time span.
+);
+
+
 #endif // OBS_H_INCLUDE_GUARD
@@ -0,0 +1,706 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file obsInternal.h
+ *
+ * Definitions shared by the source files of the Observation module: the Observation object and
+ * its data sample buffer, and the buffer operations that the buffer backups (backup.c) need
+ * from obs.c.  Not for use outside the Observation module.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef OBS_INTERNAL_H_INCLUDE_GUARD
+#define OBS_INTERNAL_H_INCLUDE_GUARD
+
+
+/// Number of samples in each block of a compressed buffer.
+#define COMPRESSED_BLOCK_SAMPLES 128
+
+/// Number of bytes of encoded samples that a compressed buffer block can hold in the worst case.
+#define COMPRESSED_BLOCK_BYTES GORILLA_BYTES(COMPRESSED_BLOCK_SAMPLES * GORILLA_MAX_SAMPLE_BITS)
+
+/// Aggregates of the non-NAN values in a block of a compressed buffer, so that range queries only
+/// have to decode a block that the range starts part way through.
+typedef struct
+{
+    size_t count;   ///< Number of non-NAN values.
+    double mean;    ///< Mean of the values.
+    double m2;      ///< Sum of squared differences from the mean.
+    double min;     ///< Minimum value (NAN if none).
+    double max;     ///< Maximum value (NAN if none).
+}
+BlockStats_t;
+
+/// Block of samples in a compressed buffer, allocated from one of the compressed block pools.  The
+/// newest block of a buffer has room for COMPRESSED_BLOCK_BYTES, and is moved to a smaller pool
+/// once it is full.  Full blocks never change, so buffer snapshots share them.
+typedef struct
+{
+    double firstTimestamp;  ///< Timestamp of the first sample in the block.
+    BlockStats_t stats;     ///< Aggregates of all the block's values (skipped ones included).
+    size_t count;           ///< Number of samples in the block.
+    size_t byteCount;       ///< Number of bytes of encoded samples.
+    uint8_t bytes[];        ///< Encoded samples.
+}
+CompressedBlock_t;
+
+/// Decoded copy of one block of a compressed buffer, so that scans over the buffer and repeated
+/// reads of nearby samples decode each block only once.
+typedef struct
+{
+    const CompressedBlock_t* blockPtr;  ///< Block decoded (NULL if none).
+    size_t count;   ///< Number of the block's samples decoded.
+    double timestamps[COMPRESSED_BLOCK_SAMPLES];    ///< Decoded timestamps.
+    double numbers[COMPRESSED_BLOCK_SAMPLES];       ///< Decoded values.
+}
+DecodedBlock_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Data sample buffer.  A ring buffer whose storage is specialized for the type of data buffered:
+ * timestamps are kept in one array and values in a parallel array indexed by the same slot number,
+ * so that scans over the buffer walk through contiguous memory instead of chasing pointers.
+ *
+ * Boolean and numeric values are stored directly in the value array.  String and JSON values are
+ * stored as references to their (immutable) Data Samples, which share their string payloads with
+ * the Observation's current value.  Triggers have no value array at all.
+ *
+ * The capacity grows on demand, up to the Observation's maxCount, and shrinks when the maxCount
+ * does.  Every sample is assigned a sequence number as it is added, which allows readers to
+ * detect that the sample they were going to read next has been dropped from the buffer.
+ *
+ * If compression is enabled, numeric samples are instead stored in a list of compressed blocks of
+ * COMPRESSED_BLOCK_SAMPLES samples each (see gorilla.h).  Samples are appended to the newest
+ * block, and dropped from the oldest block by skipping over them until the whole block can be
+ * freed.  The arrays (and the range index) are then not used at all; instead, each block keeps
+ * aggregates of its values for range queries.
+ *
+ * If run-length encoding is enabled, an uncompressed numeric or Boolean sample whose value is the
+ * same as the newest buffered sample's extends that sample's entry into a run, rather than taking
+ * a slot of its own.  Each slot then also records the number of samples in its run and the
+ * timestamp of the newest of them.  State-like signals that rarely change then take a slot per
+ * change instead of a slot per sample.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t capacity;    ///< Number of slots allocated in the arrays.
+    size_t head;        ///< Slot holding the oldest sample.
+    size_t count;       ///< Current number of samples in the buffer.
+    uint64_t firstSeq;  ///< Sequence number of the oldest sample in the buffer.
+    double* timestamps; ///< Array of sample timestamps.
+    union
+    {
+        bool* booleans;             ///< Boolean values.
+        double* numbers;            ///< Numeric values.
+        dataSample_Ref_t* samples;  ///< String or JSON samples (each holding a reference).
+        uint8_t* bytes;             ///< Raw storage, for type-independent copying.
+    }
+    values;             ///< Array of sample values (NULL for triggers).
+    bool runLength;     ///< true if samples with repeated values are stored as runs.
+    double* runEnds;    ///< Array of timestamps of the newest samples in runs (run-length only).
+    uint32_t* runCounts;    ///< Array of numbers of samples in runs (run-length only).
+    bool compressed;    ///< true if the samples are stored in compressed blocks, not the arrays.
+    CompressedBlock_t** blocks; ///< Array of compressed blocks, oldest first.
+    size_t blockCount;  ///< Number of compressed blocks.
+    size_t blockSlots;  ///< Number of entries allocated in the array of compressed blocks.
+    size_t blockHead;   ///< Number of samples skipped at the start of the oldest block.
+    gorilla_State_t encoder;    ///< State of the encoder appending to the newest block.
+    gorilla_State_t prevEncoder;    ///< State of the encoder before the newest sample.
+    BlockStats_t prevStats;         ///< Newest block's aggregates before the newest sample.
+    DecodedBlock_t* decodedPtr; ///< Most recently decoded block (NULL if not allocated yet).
+}
+SampleBuffer_t;
+
+/// Running aggregates over the numeric (or Boolean) values in an Observation's buffer, updated as
+/// samples are added and dropped so that transforms don't have to rescan the buffer.
+typedef struct
+{
+    size_t count;   ///< Number of values included (NANs are excluded).
+    double mean;    ///< Mean of the values.
+    double m2;      ///< Sum of squared differences from the mean (Welford's algorithm).
+    double m2Peak;  ///< Largest m2 since the aggregates were last recomputed.
+    size_t removals; ///< Number of values removed since the aggregates were last recomputed.
+}
+RunningStats_t;
+
+/// Monotonic queue of the sequence numbers of buffered samples that could still become the
+/// buffer's minimum (or maximum) as older samples are dropped.  The front is always the current
+/// minimum (or maximum).  Only maintained while a MIN or MAX transform is applied.
+typedef struct
+{
+    uint64_t* seqs;     ///< Ring of sample sequence numbers (same capacity as the sample buffer).
+    size_t head;        ///< Index of the front (oldest) entry in the ring.
+    size_t count;       ///< Number of entries in the queue.
+}
+ExtremaQueue_t;
+
+/// Range-aggregate index over the numeric (or Boolean) values in an Observation's buffer, used to
+/// answer min/max/mean/stddev queries over any time span of the buffer in O(log n) time.
+///
+/// Sums are cumulative from the oldest sample (per slot, up to and including that slot's sample),
+/// so the sum over a range is the difference of two entries.  Values are offset by a shift (close
+/// to their mean) before summing to limit cancellation when computing the variance.
+///
+/// Min/max use a bottom-up segment tree over the buffer slots whose leaves are the buffer's own
+/// value array.  Leaves of dropped samples are stale, but queries only combine tree nodes that lie
+/// entirely within the range of slots queried, so they never see them.
+typedef struct
+{
+    double* sums;           ///< Per slot, cumulative sum of (value - shift).
+    double* sumsOfSquares;  ///< Per slot, cumulative sum of (value - shift)^2.
+    uint32_t* counts;       ///< Per slot, cumulative number of non-NAN values (incl. runs).
+    double baseSum;         ///< Cumulative sum of (value - shift) before the oldest sample.
+    double baseSumOfSquares; ///< Cumulative sum of (value - shift)^2 before the oldest sample.
+    uint32_t baseCount;     ///< Cumulative number of non-NAN values before the oldest sample.
+    double shift;           ///< Offset subtracted from values before summing (NAN = not set yet).
+    size_t drops;           ///< Number of samples dropped since the sums were last rebuilt.
+    double* minNodes;       ///< Internal nodes of the min segment tree (index 1 = root).
+    double* maxNodes;       ///< Internal nodes of the max segment tree (index 1 = root).
+}
+RangeIndex_t;
+
+/// Maximum number of rollup tiers an Observation can have.
+#define MAX_ROLLUP_TIERS 4
+
+/// Summary of the numeric (or Boolean) values accepted by an Observation within one bucket of time.
+typedef struct
+{
+    double startTime;   ///< Start of the bucket (seconds since the Epoch).
+    uint32_t count;     ///< Number of values (NANs are excluded).
+    double min;         ///< Minimum value.
+    double max;         ///< Maximum value.
+    double mean;        ///< Mean of the values.
+    double m2;          ///< Sum of squared differences from the mean.
+}
+RollupRow_t;
+
+/// Rollup tier: a ring of per-bucket summaries of the values accepted by an Observation at a fixed
+/// time resolution, retained independently of (and usually for much longer than) the samples in
+/// the buffer.  Buckets are aligned to multiples of their width since the Epoch, so a coarser
+/// tier's buckets are unions of a finer tier's when its width is a multiple of the finer one's.
+typedef struct
+{
+    uint32_t bucketSeconds; ///< Width of each bucket, in seconds.
+    size_t maxCount;    ///< Number of completed rows to retain (capacity of the ring).
+    size_t head;        ///< Index in the ring of the oldest row.
+    size_t count;       ///< Number of completed rows in the ring.
+    uint64_t firstSeq;  ///< Sequence number of the oldest row in the ring.
+    RollupRow_t* rows;  ///< Ring of completed rows.
+    RollupRow_t open;   ///< Row of the bucket currently being filled (count = 0 if none).
+}
+RollupTier_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the swinging door compression of an Observation's numeric buffer.
+ *
+ * The door pivots on the last sample kept for good (the pivot).  Each sample received since then
+ * narrows the range of slopes of lines from the pivot that pass within the tolerance of all of
+ * them.  While that range is not empty, the newest sample is kept only provisionally, replacing
+ * the previous provisional one, on a line in that range, so the line from the pivot to it
+ * reconstructs all the samples in between well enough.  When a sample closes the door, the
+ * provisional sample is kept for good and becomes the new pivot.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool hasPivot;          ///< true if there is a pivot (false after a NAN or an empty buffer).
+    bool hasProvisional;    ///< true if the newest buffered sample is provisional.
+    double pivotTime;       ///< Timestamp of the pivot.
+    double pivotValue;      ///< Value of the pivot.
+    double upperSlope;      ///< Steepest slope from the pivot still within tolerance of all.
+    double lowerSlope;      ///< Shallowest slope from the pivot still within tolerance of all.
+}
+SwingingDoor_t;
+
+/// Chunk of a buffer, serialized for read operations.  Allocated from one of the JSON chunk pools,
+/// big enough to hold it.  Immutable once cached.
+typedef struct
+{
+    uint64_t firstSeq;  ///< Sequence number of the first sample in the chunk.
+    size_t len;         ///< Number of bytes of JSON.
+    char json[];        ///< The samples' JSON objects, separated by commas (no null terminator).
+}
+JsonChunk_t;
+
+/// Number of slots allocated the first time a sample is added to an empty buffer.
+#define MIN_BUFFER_CAPACITY 16
+
+/// Observation Resource.  Allocated from the Observation Pool.
+typedef struct
+{
+    res_Resource_t resource;    ///< The base class (MUST BE FIRST).
+
+    double highLimit; ///< Filter deadband/liveband high limit; NAN = disabled.
+    double lowLimit;  ///< Filter deadband/liveband low limit; NAN = disabled.
+    double changeBy;  ///< Drop values that differ by less than this from current; NAN/0 = disabled.
+
+    double minPeriod; ///< Min number of seconds before accepting another value; NAN/0 = disabled.
+    uint32_t lastPushTime; ///< Time at which last push was accepted (ms, relative clock).
+
+    obs_TransformType_t transformType; ///< Buffer transform type
+    RunningStats_t runningStats; ///< Mean and variance of the buffered values.
+    ExtremaQueue_t extrema; ///< Buffered min or max candidates (MIN/MAX transforms only).
+    RangeIndex_t rangeIndex; ///< Index used for queries over a time span of the buffer.
+
+    size_t maxCount;  ///< Maximum number of entries to buffer.
+    bool compressBuffer; ///< true if numeric samples should be buffered in compressed form.
+    double bufferTolerance; ///< Swinging door compression tolerance; NAN = disabled.
+    SwingingDoor_t door; ///< Swinging door compression state.
+    bool runLengthBuffer; ///< true if repeated values should be buffered as runs.
+
+    RollupTier_t rollups[MAX_ROLLUP_TIERS]; ///< Rollup tiers, finest resolution first.
+    size_t rollupCount; ///< Number of rollup tiers in use.
+    io_DataType_t rollupType; ///< Data type of the values summarized in the rollup tiers.
+
+    io_DataType_t bufferedType; ///< Data type of samples currently in the buffer.
+
+    uint32_t backupPeriod; ///< Min time (in seconds) between non-volatile backups of the buffer.
+    uint32_t lastBackupTime; ///< Time at which last push was accepted (seconds, relative clock).
+    le_dls_Link_t backupLink; ///< Used to link into the PendingBackupList.
+    bool isBackupPending; ///< true if in the PendingBackupList.
+    le_dls_List_t backupJobList; ///< Backup writer thread jobs that will report back to it.
+    bool journalValid; ///< true if the backup file and its journal hold the buffer up to backupSeq.
+    size_t journalCount; ///< Number of records in the journal.
+    uint64_t backupSeq; ///< Sequence number after the newest sample backed up.
+    double backupNewestEnd; ///< End timestamp of the newest sample (or run) backed up.
+    uint32_t backupNewestWeight; ///< Number of samples in the newest run backed up.
+    le_dls_Link_t restoreLink; ///< Used to link into the PendingRestoreList.
+    bool isRestorePending; ///< true if the buffer hasn't been restored from backup yet.
+
+    SampleBuffer_t buffer; ///< Buffered data samples (oldest first, newest last).
+
+    le_dls_List_t readOpList; ///< List of ongoing Read Operations on the buffered samples.
+    JsonChunk_t** jsonChunks; ///< Serialized chunks of the buffer (NULL until one is cached).
+    size_t jsonChunkSlots; ///< Number of slots in jsonChunks.
+
+    char jsonExtraction[ADMIN_MAX_JSON_EXTRACTOR_LEN + 1]; ///< JSON extraction specifier (or "").
+}
+Observation_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get buffer entry numerical value.  This works for numeric or Boolean types only.
+ *
+ * @return The value.
+ */
+//--------------------------------------------------------------------------------------------------
+double obs_GetBufferedNumber
+(
+    Observation_t* obsPtr,
+    size_t index    ///< Index of the sample in the buffer (0 = oldest).
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Make sure the block of a compressed buffer that holds a given sample is decoded.
+ *
+ * @return The position of the sample in the decoded block's arrays.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t obs_LoadDecodedBlock
+(
+    SampleBuffer_t* bufferPtr,
+    size_t index    ///< Index of the sample in the buffer (0 = oldest).
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allocate one of the arrays used to store an Observation's buffered samples.
+ *
+ * Buffer capacities are configurable at run-time, so these arrays can't come from fixed-size
+ * memory pools.  Like le_mem_ForceAlloc(), this never returns NULL unless zero bytes are requested.
+ * The bytes are counted in the buffer memory statistics until the array is freed by
+ * obs_FreeBufferArray().
+ *
+ * @return Pointer to the array, or NULL if byteCount is zero.
+ */
+//--------------------------------------------------------------------------------------------------
+void* obs_AllocBufferArray
+(
+    size_t byteCount
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Free an array allocated by obs_AllocBufferArray().
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_FreeBufferArray
+(
+    void* arrayPtr  ///< The array (may be NULL).
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change the number of slots allocated for an Observation's buffer.  The buffered samples are
+ * moved into the new arrays, oldest first, starting at slot 0.
+ *
+ * @warning The buffer must not contain more samples than the new capacity.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ResizeBuffer
+(
+    Observation_t* obsPtr,
+    size_t capacity
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Change the data type of the samples stored in an Observation's buffer.  The buffer must be
+ * empty.  Its storage is freed, to be reallocated for the new type when the next sample arrives.
+ * Numeric samples are stored compressed if compression is enabled for the Observation.  Otherwise,
+ * numeric (without swinging door compression) and Boolean samples are stored as runs if
+ * run-length encoding is enabled.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SetBufferedType
+(
+    Observation_t* obsPtr,
+    io_DataType_t dataType
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a given data sample to the buffer of a given Observation.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_AddToBuffer
+(
+    Observation_t* obsPtr,
+    dataSample_Ref_t sampleRef
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Extend the run of the newest entry in an Observation's run-length encoded buffer by a number of
+ * samples with the same value, updating its running aggregates and range index to match.  The
+ * min/max segment trees and extrema queue don't change, because the value doesn't.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ExtendNewestRun
+(
+    Observation_t* obsPtr,
+    double timestamp,   ///< Timestamp of the newest sample in the run.
+    uint32_t weight     ///< Number of samples to add to the run.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Drop the newest sample from an Observation's numeric buffer, so that it can be replaced.
+ * The next sample added goes into the same slot, with the same sequence number.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_RemoveNewestFromBuffer
+(
+    Observation_t* obsPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * If the number of entries in a given Observation's buffer is larger than the number given,
+ * discard enough of the oldest entries to correct that condition.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_TruncateBuffer
+(
+    Observation_t* obsPtr,
+    size_t count
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Rebuild the running aggregates and indexes of an Observation's buffer from scratch, after its
+ * arrays have been filled in directly rather than a sample at a time.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_RebuildAggregates
+(
+    Observation_t* obsPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Serialize every whole chunk of an Observation's buffer that isn't cached yet, after its arrays
+ * have been filled in directly rather than a sample at a time.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_CacheJsonChunks
+(
+    Observation_t* obsPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Move the row of the bucket currently being filled into a rollup tier's ring of completed rows,
+ * dropping the oldest row if the ring is full.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_CompleteRollupRow
+(
+    RollupTier_t* tierPtr
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find an Observation's rollup tier with a given bucket width, adding an empty one if there isn't
+ * one yet, and make it retain a given number of completed rows.
+ *
+ * @return Pointer to the tier, or NULL if the Observation already has MAX_ROLLUP_TIERS tiers.
+ */
+//--------------------------------------------------------------------------------------------------
+RollupTier_t* obs_AddRollupTier
+(
+    Observation_t* obsPtr,
+    uint32_t bucketSeconds, ///< Width of the tier's buckets, in seconds (must not be 0).
+    uint32_t count  ///< Number of completed buckets to retain (must not be 0).
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the numerical values in an Observation's buffer that are newer than a given time to all of
+ * its rollup tiers, as if they were being accepted again.
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_SeedRollups
+(
+    Observation_t* obsPtr,
+    double afterTime    ///< Seconds since the Epoch, or NAN for the whole buffer.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Take a snapshot of an Observation's buffer, to be written to a backup file while the buffer
+ * goes on changing.  String and JSON samples and full compressed blocks are shared with the buffer
+ * (the snapshot holds a reference to each), while everything else is copied.
+ *
+ * @return Number of bytes allocated for the copies.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t obs_TakeBufferSnapshot
+(
+    Observation_t* obsPtr,
+    SampleBuffer_t* snapshotPtr ///< [OUT] The snapshot.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release a snapshot of an Observation's buffer taken by obs_TakeBufferSnapshot().
+ */
+//--------------------------------------------------------------------------------------------------
+void obs_ReleaseBufferSnapshot
+(
+    SampleBuffer_t* snapshotPtr,
+    io_DataType_t dataType  ///< Type of the samples in the snapshot.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write to an unbuffered file descriptor.
+ *
+ * @return The number of bytes written.  -1 on error (errno is set).
+ */
+//--------------------------------------------------------------------------------------------------
+ssize_t obs_WriteToFd
+(
+    int fd,
+    const void* buffPtr,
+    size_t byteCount
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the relative time in milliseconds.
+ *
+ * @return the relative time (ms).
+ */
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t obs_GetRelativeTimeMs
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_clk_Time_t structuredTime = le_clk_GetRelativeTime();
+
+    return (structuredTime.sec * 1000 + structuredTime.usec / 1000);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the slot in an Observation's buffer arrays that holds a given sample.
+ *
+ * @return The slot number.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline size_t obs_GetSlot
+(
+    const SampleBuffer_t* bufferPtr,
+    size_t index    ///< Index of the sample in the buffer (0 = oldest).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t slot = bufferPtr->head + index;
+
+    if (slot >= bufferPtr->capacity)
+    {
+        slot -= bufferPtr->capacity;
+    }
+
+    return slot;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the timestamp of a given sample in an Observation's buffer.
+ *
+ * @return The timestamp.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline double obs_GetBufferedTimestamp
+(
+    SampleBuffer_t* bufferPtr,
+    size_t index    ///< Index of the sample in the buffer (0 = oldest).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (bufferPtr->compressed)
+    {
+        return bufferPtr->decodedPtr->timestamps[obs_LoadDecodedBlock(bufferPtr, index)];
+    }
+
+    return bufferPtr->timestamps[obs_GetSlot(bufferPtr, index)];
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the timestamp of the newest sample in a given entry of an Observation's buffer.  For a
+ * run-length encoded buffer, that is the end of the entry's run.
+ *
+ * @return The timestamp.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline double obs_GetBufferedEndTimestamp
+(
+    SampleBuffer_t* bufferPtr,
+    size_t index    ///< Index of the entry in the buffer (0 = oldest).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (bufferPtr->runLength)
+    {
+        return bufferPtr->runEnds[obs_GetSlot(bufferPtr, index)];
+    }
+
+    return obs_GetBufferedTimestamp(bufferPtr, index);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of samples represented by a given entry of an Observation's buffer.
+ *
+ * @return The number of samples in the entry's run (always 1 if not run-length encoded).
+ */
+//--------------------------------------------------------------------------------------------------
+static inline uint32_t obs_GetBufferedWeight
+(
+    const SampleBuffer_t* bufferPtr,
+    size_t index    ///< Index of the entry in the buffer (0 = oldest).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (bufferPtr->runLength)
+    {
+        return bufferPtr->runCounts[obs_GetSlot(bufferPtr, index)];
+    }
+
+    return 1;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether an Observation's buffer holds numerical (numeric or Boolean) values, which have
+ * running aggregates and a range index.
+ *
+ * @return true if numeric or Boolean.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline bool obs_IsBufferNumerical
+(
+    Observation_t* obsPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return (   (obsPtr->bufferedType == IO_DATA_TYPE_NUMERIC)
+            || (obsPtr->bufferedType == IO_DATA_TYPE_BOOLEAN)  );
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of rows in a rollup tier, including the row of the bucket currently being filled
+ * (if it has any values in it yet).
+ *
+ * @return The number of rows.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline size_t obs_GetRollupRowCount
+(
+    const RollupTier_t* tierPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return tierPtr->count + ((tierPtr->open.count > 0) ? 1 : 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a row of a rollup tier.  Index count is the row of the bucket currently being filled.
+ *
+ * @return Pointer to the row.
+ */
+//--------------------------------------------------------------------------------------------------
+static inline RollupRow_t* obs_GetRollupRow
+(
+    RollupTier_t* tierPtr,
+    size_t index    ///< Index of the row (0 = oldest).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (index == tierPtr->count)
+    {
+        return &tierPtr->open;
+    }
+
+    return &tierPtr->rows[(tierPtr->head + index) % tierPtr->maxCount];
+}
+
+
+#endif // OBS_INTERNAL_H_INCLUDE_GUARD
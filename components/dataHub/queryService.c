@@ -106,12 +106,341 @@ le_result_t query_ReadBufferJson
         return LE_OK;   // Doesn't matter what we return.
     }
 
-    resTree_ReadBufferJson(entryRef, startAfter, outputFile, completionFuncPtr, contextPtr);
+    resTree_ReadBuffer(entryRef,
+                       startAfter,
+                       QUERY_FORMAT_JSON,
+                       outputFile,
+                       completionFuncPtr,
+                       contextPtr);
 
     return LE_OK;
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read data out of a buffer in a given format.  Data is written to a given file descriptor, as a
+ * JSON array (the same as query_ReadBufferJson() writes), a SenML pack encoded in CBOR, or packed
+ * binary (timestamp, value) pairs.
+ *
+ * @return
+ *  - LE_OK if the read operation started successfully.
+ *  - LE_NOT_FOUND if the Observation doesn't exist.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t query_ReadBuffer
+(
+    const char* obsPath,
+        ///< [IN] Observation path. Can be absolute
+        ///< (beginning with a '/') or relative to /obs/.
+    double startAfter,
+        ///< [IN] Start after this many seconds ago,
+        ///< or after an absolute number of seconds since the Epoch
+        ///< (if startafter > 30 years).
+        ///< Use NAN (not a number) to read the whole buffer.
+    query_Format_t format,
+        ///< [IN] Format to write the data in.
+    int outputFile,
+        ///< [IN] File descriptor to write the data to.
+    query_ReadCompletionFunc_t completionFuncPtr,
+        ///< [IN] Completion callback to be called when operation finishes.
+    void* contextPtr
+        ///< [IN]
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t entryRef = FindObservation(obsPath);
+
+    if (entryRef == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if (startAfter < 0)
+    {
+        LE_KILL_CLIENT("Negative startAfter time provided (%lf).", startAfter);
+        return LE_OK;   // Doesn't matter what we return.
+    }
+
+    switch (format)
+    {
+        case QUERY_FORMAT_JSON:
+        case QUERY_FORMAT_SENML_CBOR:
+        case QUERY_FORMAT_RAW:
+
+            break;
+
+        default:
+
+            LE_KILL_CLIENT("Invalid read format (%d).", format);
+            return LE_OK;   // Doesn't matter what we return.
+    }
+
+    resTree_ReadBuffer(entryRef, startAfter, format, outputFile, completionFuncPtr, contextPtr);
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Export the numerical samples in a time window of a buffer as a snapshot in a read-only memory
+ * file that can be mapped into memory.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_NOT_FOUND if the Observation doesn't exist.
+ *  - LE_UNAVAILABLE if the buffer doesn't contain numerical data.
+ *  - LE_FAULT if the snapshot couldn't be created.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t query_ExportBuffer
+(
+    const char* obsPath,
+        ///< [IN] Observation path. Can be absolute
+        ///< (beginning with a '/') or relative to /obs/.
+    double startTime,
+        ///< [IN] Samples before this time are excluded.
+        ///< If < 30 years then seconds before now; else seconds since the Epoch.
+        ///< Use NAN (not a number) to start at the oldest sample in the buffer.
+    double endTime,
+        ///< [IN] Samples at or after this time are excluded.
+        ///< If < 30 years then seconds before now; else seconds since the Epoch.
+        ///< Use NAN (not a number) to read to the end of the buffer.
+    int* snapshotFilePtr
+        ///< [OUT] Snapshot, if LE_OK returned.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    *snapshotFilePtr = -1;
+
+    resTree_EntryRef_t entryRef = FindObservation(obsPath);
+
+    if (entryRef == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if ((startTime < 0) || (endTime < 0))
+    {
+        LE_KILL_CLIENT("Negative time provided (start = %lf, end = %lf).", startTime, endTime);
+        return LE_OK;   // Doesn't matter what we return.
+    }
+
+    // The snapshot file descriptor is closed on this side after it is sent to the client.
+    return resTree_ExportBuffer(entryRef, startTime, endTime, snapshotFilePtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read aggregates of the numerical data in a buffer, bucketed by time.  Data is written to a given
+ * file descriptor in JSON-encoded format as an array of objects, one per time bucket, containing
+ * the start time of the bucket and the requested aggregates of the values in it.  E.g.,
+ *
+ * @code
+ * [{"t":1537483620.000000,"mean":21.250000},{"t":1537483680.000000,"mean":21.500000}]
+ * @endcode
+ *
+ * @return
+ *  - LE_OK if the read operation started successfully.
+ *  - LE_NOT_FOUND if the Observation doesn't exist.
+ *  - LE_BAD_PARAMETER if the bucket width is not positive or no aggregates were requested.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t query_ReadBufferAggregates
+(
+    const char* obsPath,
+        ///< [IN] Observation path. Can be absolute
+        ///< (beginning with a '/') or relative to /obs/.
+    double startTime,
+        ///< [IN] Start time of the first bucket.
+        ///< If < 30 years then seconds before now; else seconds since the Epoch.
+        ///< Use NAN (not a number) to start at the oldest sample in the buffer.
+    double endTime,
+        ///< [IN] Samples at or after this time are excluded.
+        ///< If < 30 years then seconds before now; else seconds since the Epoch.
+        ///< Use NAN (not a number) to read to the end of the buffer.
+    double bucketSeconds,
+        ///< [IN] Width of each time bucket, in seconds.
+    query_Aggregate_t aggregates,
+        ///< [IN] Aggregates to compute for each bucket.
+    int outputFile,
+        ///< [IN] File descriptor to write the data to.
+    query_ReadCompletionFunc_t completionFuncPtr,
+        ///< [IN] Completion callback to be called when operation finishes.
+    void* contextPtr
+        ///< [IN]
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t entryRef = FindObservation(obsPath);
+
+    if (entryRef == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if ((startTime < 0) || (endTime < 0))
+    {
+        LE_KILL_CLIENT("Negative time provided (start = %lf, end = %lf).", startTime, endTime);
+        return LE_OK;   // Doesn't matter what we return.
+    }
+
+    if (!(bucketSeconds > 0) || isinf(bucketSeconds) || (aggregates == 0))
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    resTree_ReadBufferAggregates(entryRef,
+                                 startTime,
+                                 endTime,
+                                 bucketSeconds,
+                                 aggregates,
+                                 outputFile,
+                                 completionFuncPtr,
+                                 contextPtr);
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a downsampled representation of the numerical data in a buffer, for plotting.  At most
+ * maxPoints samples are written to a given file descriptor, in the same JSON-encoded format as
+ * query_ReadBufferJson().
+ *
+ * @return
+ *  - LE_OK if the read operation started successfully.
+ *  - LE_NOT_FOUND if the Observation doesn't exist.
+ *  - LE_BAD_PARAMETER if maxPoints is too small for the downsampling algorithm.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t query_ReadBufferDownsampled
+(
+    const char* obsPath,
+        ///< [IN] Observation path. Can be absolute
+        ///< (beginning with a '/') or relative to /obs/.
+    double startAfter,
+        ///< [IN] Start after this many seconds ago,
+        ///< or after an absolute number of seconds since the Epoch
+        ///< (if startafter > 30 years).
+        ///< Use NAN (not a number) to read the whole buffer.
+    uint32_t maxPoints,
+        ///< [IN] Maximum number of samples to write.
+    query_Downsampling_t method,
+        ///< [IN] Downsampling algorithm.
+    int outputFile,
+        ///< [IN] File descriptor to write the data to.
+    query_ReadCompletionFunc_t completionFuncPtr,
+        ///< [IN] Completion callback to be called when operation finishes.
+    void* contextPtr
+        ///< [IN]
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t entryRef = FindObservation(obsPath);
+
+    if (entryRef == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if (startAfter < 0)
+    {
+        LE_KILL_CLIENT("Negative startAfter time provided (%lf).", startAfter);
+        return LE_OK;   // Doesn't matter what we return.
+    }
+
+    switch (method)
+    {
+        case QUERY_DOWNSAMPLING_LTTB:
+
+            if (maxPoints < 3)
+            {
+                return LE_BAD_PARAMETER;
+            }
+            break;
+
+        case QUERY_DOWNSAMPLING_MIN_MAX:
+
+            if (maxPoints < 2)
+            {
+                return LE_BAD_PARAMETER;
+            }
+            break;
+
+        default:
+
+            LE_KILL_CLIENT("Invalid downsampling method (%d).", method);
+            return LE_OK;   // Doesn't matter what we return.
+    }
+
+    resTree_ReadBufferDownsampled(entryRef,
+                                  startAfter,
+                                  maxPoints,
+                                  method,
+                                  outputFile,
+                                  completionFuncPtr,
+                                  contextPtr);
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the buckets of one of an Observation's rollup tiers, starting with the first bucket that
+ * starts at or after a given time, and write them to a given file descriptor in JSON format.
+ * The tier used is the coarsest one whose buckets are no wider than a given resolution.
+ *
+ * @return
+ *  - LE_OK if the read operation started successfully.
+ *  - LE_NOT_FOUND if the Observation doesn't exist or has no rollup tier that fine.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t query_ReadRollupJson
+(
+    const char* obsPath,
+        ///< [IN] Observation path. Can be absolute
+        ///< (beginning with a '/') or relative to /obs/.
+    uint32_t resolution,
+        ///< [IN] Maximum bucket width, in seconds.
+    double startTime,
+        ///< [IN] If < 30 years then seconds before now; else seconds since the Epoch.
+        ///< Use NAN (not a number) to start at the oldest bucket.
+    int outputFile,
+        ///< [IN] File descriptor to write the data to.
+    query_ReadCompletionFunc_t completionFuncPtr,
+        ///< [IN] Completion callback to be called when operation finishes.
+    void* contextPtr
+        ///< [IN]
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t entryRef = FindObservation(obsPath);
+
+    if (entryRef == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    if (startTime < 0)
+    {
+        LE_KILL_CLIENT("Negative startTime provided (%lf).", startTime);
+        return LE_OK;   // Doesn't matter what we return.
+    }
+
+    return resTree_ReadRollupJson(entryRef,
+                                  resolution,
+                                  startTime,
+                                  outputFile,
+                                  completionFuncPtr,
+                                  contextPtr);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Read the timestamp of a single sample from a buffer.
@@ -161,6 +490,8 @@ le_result_t query_ReadBufferSampleTimestamp
 
     *timestampPtr = dataSample_GetTimestamp(sample);
 
+    le_mem_Release(sample);
+
     return LE_OK;
 }
 
@@ -222,6 +553,8 @@ le_result_t query_ReadBufferSampleBoolean
     *timestampPtr = dataSample_GetTimestamp(sample);
     *valuePtr = dataSample_GetBoolean(sample);
 
+    le_mem_Release(sample);
+
     return LE_OK;
 }
 
@@ -283,6 +616,8 @@ le_result_t query_ReadBufferSampleNumeric
     *timestampPtr = dataSample_GetTimestamp(sample);
     *valuePtr = dataSample_GetNumeric(sample);
 
+    le_mem_Release(sample);
+
     return LE_OK;
 }
 
@@ -341,7 +676,13 @@ le_result_t query_ReadBufferSampleString
 
     *timestampPtr = dataSample_GetTimestamp(sample);
 
-    return dataSample_ConvertToString(sample, resTree_GetDataType(entryRef), value, valueSize);
+    le_result_t result = dataSample_ConvertToString(sample,
+                                                    resTree_GetDataType(entryRef),
+                                                    value,
+                                                    valueSize);
+    le_mem_Release(sample);
+
+    return result;
 }
 
 
@@ -400,7 +741,13 @@ le_result_t query_ReadBufferSampleJson
 
     *timestampPtr = dataSample_GetTimestamp(sample);
 
-    return dataSample_ConvertToJson(sample, resTree_GetDataType(entryRef), value, valueSize);
+    le_result_t result = dataSample_ConvertToJson(sample,
+                                                  resTree_GetDataType(entryRef),
+                                                  value,
+                                                  valueSize);
+    le_mem_Release(sample);
+
+    return result;
 }
 
 
@@ -525,6 +872,126 @@ double query_GetStdDev
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a summary of the statistics of all values found within a given time span in an
+ * Observation's buffer.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_NOT_FOUND if the Observation doesn't exist.
+ *  - LE_UNAVAILABLE if there's no numerical data in the Observation's buffer within the time span
+ *                   (if the buffer size is zero, the buffer is empty, or the buffer contains
+ *                   data of a non-numerical type).
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t query_GetStats
+(
+    const char* obsPath,
+        ///< [IN] Observation path. Can be absolute
+        ///< (beginning with a '/') or relative to /obs/.
+    double startTime,
+        ///< [IN] If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,
+        ///< [OUT] Number of numerical values in the time span, if LE_OK returned.
+    double* minPtr,
+        ///< [OUT] Minimum value, if LE_OK returned.
+    double* maxPtr,
+        ///< [OUT] Maximum value, if LE_OK returned.
+    double* meanPtr,
+        ///< [OUT] Mean (average) value, if LE_OK returned.
+    double* stdDevPtr,
+        ///< [OUT] Standard deviation, if LE_OK returned.
+    double* sumPtr,
+        ///< [OUT] Sum of the values, if LE_OK returned.
+    double* firstTimestampPtr,
+        ///< [OUT] Timestamp of the oldest sample in the time span.
+    double* lastTimestampPtr
+        ///< [OUT] Timestamp of the newest sample in the time span.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t entryRef = FindObservation(obsPath);
+
+    if (entryRef == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    return resTree_QueryStats(entryRef,
+                              startTime,
+                              countPtr,
+                              minPtr,
+                              maxPtr,
+                              meanPtr,
+                              stdDevPtr,
+                              sumPtr,
+                              firstTimestampPtr,
+                              lastTimestampPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a summary of the statistics of all values summarized by one of an Observation's rollup
+ * tiers in buckets that start within a given time span.  The tier used is the coarsest one whose
+ * buckets are no wider than a given resolution.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_NOT_FOUND if the Observation doesn't exist or has no rollup tier that fine.
+ *  - LE_UNAVAILABLE if the tier has no numerical data within the time span.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t query_GetRollupStats
+(
+    const char* obsPath,
+        ///< [IN] Observation path. Can be absolute
+        ///< (beginning with a '/') or relative to /obs/.
+    uint32_t resolution,
+        ///< [IN] Maximum bucket width, in seconds.
+    double startTime,
+        ///< [IN] If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,
+        ///< [OUT] Number of numerical values in the time span, if LE_OK returned.
+    double* minPtr,
+        ///< [OUT] Minimum value, if LE_OK returned.
+    double* maxPtr,
+        ///< [OUT] Maximum value, if LE_OK returned.
+    double* meanPtr,
+        ///< [OUT] Mean (average) value, if LE_OK returned.
+    double* stdDevPtr,
+        ///< [OUT] Standard deviation, if LE_OK returned.
+    double* sumPtr,
+        ///< [OUT] Sum of the values, if LE_OK returned.
+    double* firstTimestampPtr,
+        ///< [OUT] Start time of the oldest bucket in the time span.
+    double* lastTimestampPtr
+        ///< [OUT] Start time of the newest bucket in the time span.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    resTree_EntryRef_t entryRef = FindObservation(obsPath);
+
+    if (entryRef == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    return resTree_QueryRollupStats(entryRef,
+                                    resolution,
+                                    startTime,
+                                    countPtr,
+                                    minPtr,
+                                    maxPtr,
+                                    meanPtr,
+                                    stdDevPtr,
+                                    sumPtr,
+                                    firstTimestampPtr,
+                                    lastTimestampPtr);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Find a resource at a given path.  The path can be absolute (beginning with a '/'), or relative
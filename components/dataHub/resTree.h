@@ -336,6 +336,44 @@ void resTree_Push
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a Trigger value to a resource, reusing a recently pushed Data Sample if possible.
+ */
+//--------------------------------------------------------------------------------------------------
+void resTree_PushTrigger
+(
+    resTree_EntryRef_t entryRef,    ///< The entry to push to.
+    double timestamp                ///< The timestamp (IO_NOW = now).
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a Boolean value to a resource, reusing a recently pushed Data Sample if possible.
+ */
+//--------------------------------------------------------------------------------------------------
+void resTree_PushBoolean
+(
+    resTree_EntryRef_t entryRef,    ///< The entry to push to.
+    double timestamp,               ///< The timestamp (IO_NOW = now).
+    bool value                      ///< The value.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a Numeric value to a resource, reusing a recently pushed Data Sample if possible.
+ */
+//--------------------------------------------------------------------------------------------------
+void resTree_PushNumeric
+(
+    resTree_EntryRef_t entryRef,    ///< The entry to push to.
+    double timestamp,               ///< The timestamp (IO_NOW = now).
+    double value                    ///< The value.
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Add a Push Handler to an Output resource.
@@ -619,6 +657,115 @@ uint32_t resTree_GetBufferMaxCount
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable compression of a given Observation's buffer.  Only numeric samples are
+ * compressed.  Samples already in the buffer are kept.
+ */
+//--------------------------------------------------------------------------------------------------
+void resTree_SetBufferCompression
+(
+    resTree_EntryRef_t obsEntry,
+    bool isCompressed
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether compression is enabled for a given Observation's buffer.
+ *
+ * @return true if enabled.
+ */
+//--------------------------------------------------------------------------------------------------
+bool resTree_IsBufferCompressed
+(
+    resTree_EntryRef_t obsEntry
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the tolerance of the swinging door compression of a given Observation's buffer.  When set,
+ * numeric samples are only buffered if they are needed to reconstruct the signal to within the
+ * tolerance, by linear interpolation.
+ */
+//--------------------------------------------------------------------------------------------------
+void resTree_SetBufferTolerance
+(
+    resTree_EntryRef_t obsEntry,
+    double tolerance    ///< Maximum reconstruction error (> 0); NAN or 0 = disabled.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the tolerance of the swinging door compression of a given Observation's buffer.
+ *
+ * @return The tolerance, or NAN if not set.
+ */
+//--------------------------------------------------------------------------------------------------
+double resTree_GetBufferTolerance
+(
+    resTree_EntryRef_t obsEntry
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable run-length encoding of a given Observation's buffer.  When enabled, repeated
+ * numerical values are buffered as runs of samples, which queries weight by their sample counts.
+ */
+//--------------------------------------------------------------------------------------------------
+void resTree_SetBufferRunLengthEncoding
+(
+    resTree_EntryRef_t obsEntry,
+    bool isEnabled
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether run-length encoding is enabled for a given Observation's buffer.
+ *
+ * @return true if enabled.
+ */
+//--------------------------------------------------------------------------------------------------
+bool resTree_IsBufferRunLengthEncoded
+(
+    resTree_EntryRef_t obsEntry
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add, resize, or remove one of an Observation's rollup tiers.  Each tier summarizes the numeric
+ * or Boolean values accepted by the Observation into buckets of a fixed width (aligned to
+ * multiples of that width since the Epoch), and retains a given number of completed buckets,
+ * independently of the Observation's buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+void resTree_SetBufferRollup
+(
+    resTree_EntryRef_t obsEntry,
+    uint32_t bucketSeconds, ///< Width of the tier's buckets, in seconds.
+    uint32_t count  ///< Number of completed buckets to retain. 0 = remove the tier.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of completed buckets retained by one of an Observation's rollup tiers.
+ *
+ * @return The number of buckets, or 0 if the Observation has no tier with that bucket width.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t resTree_GetBufferRollup
+(
+    resTree_EntryRef_t obsEntry,
+    uint32_t bucketSeconds  ///< Width of the tier's buckets, in seconds.
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the minimum time between backups of an Observation's buffer to non-volatile storage.
@@ -847,21 +994,125 @@ void resTree_ForEachResource
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Read data out of a buffer.  Data is written to a given file descriptor in JSON-encoded format
- * as an array of objects containing a timestamp and a value (or just a timestamp for triggers).
- * E.g.,
+ * Read data out of a buffer.  Data is written to a given file descriptor in a given format.  In
+ * JSON format, that is an array of objects containing a timestamp and a value (or just a timestamp
+ * for triggers).  E.g.,
  *
  * @code
  * [{"t":1537483647.125,"v":true},{"t":1537483657.128,"v":true}]
  * @endcode
+ *
+ * See query_ReadBuffer() for the binary formats.
+ */
+//--------------------------------------------------------------------------------------------------
+void resTree_ReadBuffer
+(
+    resTree_EntryRef_t obsEntry, ///< Observation entry.
+    double startAfter,  ///< Start after this many seconds ago, or after an absolute number of
+                        ///< seconds since the Epoch (if startafter > 30 years).
+                        ///< Use NAN (not a number) to read the whole buffer.
+    query_Format_t format,  ///< Format to write the data in.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Export the numerical samples in a time window of an Observation's buffer as a snapshot in a
+ * sealed, read-only memory file.  See query_ExportBuffer() for the snapshot's layout.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_NOT_FOUND if the entry is not an Observation.
+ *  - LE_UNAVAILABLE if the buffer doesn't contain numerical data.
+ *  - LE_FAULT if the memory file couldn't be created.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resTree_ExportBuffer
+(
+    resTree_EntryRef_t obsEntry,    ///< Observation entry.
+    double startTime,   ///< Samples before this time are excluded. If < 30 years then seconds
+                        ///< before now; else seconds since the Epoch. NAN = no limit.
+    double endTime,     ///< Samples at or after this time are excluded. If < 30 years then
+                        ///< seconds before now; else seconds since the Epoch. NAN = no limit.
+    int* snapshotFilePtr    ///< [OUT] File descriptor of the snapshot, if LE_OK returned.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read aggregates of the numerical data in a buffer, bucketed by time.  Data is written to a given
+ * file descriptor in JSON-encoded format as an array of objects, one per time bucket, containing
+ * the start time of the bucket and the requested aggregates of the values in it.  E.g.,
+ *
+ * @code
+ * [{"t":1537483620.000000,"mean":21.250000},{"t":1537483680.000000,"mean":21.500000}]
+ * @endcode
+ *
+ * Buckets that contain no numerical values are omitted.
+ */
+//--------------------------------------------------------------------------------------------------
+void resTree_ReadBufferAggregates
+(
+    resTree_EntryRef_t obsEntry, ///< Observation entry.
+    double startTime,   ///< Start time of the first bucket. If < 30 years then seconds before now;
+                        ///< else seconds since the Epoch. NAN = start at the oldest sample.
+    double endTime,     ///< Samples at or after this time are excluded. If < 30 years then
+                        ///< seconds before now; else seconds since the Epoch. NAN = no limit.
+    double bucketSeconds,   ///< Width of each time bucket, in seconds (> 0).
+    query_Aggregate_t aggregates,   ///< Aggregates to write for each bucket (non-zero).
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a downsampled representation of the numerical data in a buffer, for plotting.  At most
+ * maxPoints samples are written to a given file descriptor, in the same JSON-encoded format as
+ * resTree_ReadBuffer().  If the buffer holds no more than maxPoints samples after startAfter,
+ * they are all written.
  */
 //--------------------------------------------------------------------------------------------------
-void resTree_ReadBufferJson
+void resTree_ReadBufferDownsampled
 (
     resTree_EntryRef_t obsEntry, ///< Observation entry.
     double startAfter,  ///< Start after this many seconds ago, or after an absolute number of
                         ///< seconds since the Epoch (if startafter > 30 years).
                         ///< Use NAN (not a number) to read the whole buffer.
+    uint32_t maxPoints, ///< Maximum number of samples to write (>= 3 for LTTB, >= 2 for min/max).
+    query_Downsampling_t method,    ///< Downsampling algorithm.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the rows of one of an Observation's rollup tiers, starting with the first bucket that
+ * starts at or after a given time, and write them to a given file descriptor in JSON format.
+ * The tier used is the coarsest one whose buckets are no wider than a given resolution.  The
+ * bucket currently being filled is written last.  E.g.,
+ *
+ * @code
+ * [{"t":1537483560.000000,"count":60,"min":20.100000,"max":22.400000,"mean":21.250000}]
+ * @endcode
+ *
+ * @return
+ *  - LE_OK if the read operation started.
+ *  - LE_NOT_FOUND if the Observation has no rollup tier that fine.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resTree_ReadRollupJson
+(
+    resTree_EntryRef_t obsEntry,    ///< Observation entry.
+    uint32_t resolution,    ///< Maximum bucket width, in seconds.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+                        ///< NAN = start at the oldest bucket.
     int outputFile, ///< File descriptor to write the data to.
     query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
     void* contextPtr    ///< Value to be passed to completion callback.
@@ -873,7 +1124,8 @@ void resTree_ReadBufferJson
  * Find the oldest data sample held in a given Observation's buffer that is newer than a
  * given timestamp.
  *
- * @return Reference to the sample, or NULL if not found.
+ * @return Reference to the sample, or NULL if not found. The caller must release this
+ *         reference when finished with it.
  */
 //--------------------------------------------------------------------------------------------------
 dataSample_Ref_t resTree_FindBufferedSampleAfter
@@ -1005,4 +1257,60 @@ double resTree_QueryStdDev
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a summary of all the statistics that can be queried on the values found within a given
+ * time span in an Observation's buffer.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_NOT_FOUND if the entry is not an Observation.
+ *  - LE_UNAVAILABLE if there's no numerical data in the Observation's buffer within the time span
+ *    (if the buffer size is zero, the buffer is empty, or the buffer contains data of a
+ *    non-numerical type).
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resTree_QueryStats
+(
+    resTree_EntryRef_t obsEntry,    ///< Observation entry.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,         ///< [OUT] Number of non-NAN values in the time span.
+    double* minPtr,             ///< [OUT] Minimum value.
+    double* maxPtr,             ///< [OUT] Maximum value.
+    double* meanPtr,            ///< [OUT] Mean (average) value.
+    double* stdDevPtr,          ///< [OUT] Standard deviation.
+    double* sumPtr,             ///< [OUT] Sum of the values.
+    double* firstTimestampPtr,  ///< [OUT] Timestamp of the oldest sample in the time span.
+    double* lastTimestampPtr    ///< [OUT] Timestamp of the newest sample in the time span.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics about the values summarized by one of an Observation's rollup tiers in buckets
+ * that start at or after a given time.  The tier used is the coarsest one whose buckets are no
+ * wider than a given resolution, so this can cover a much longer time span than the buffer.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_NOT_FOUND if the Observation has no rollup tier that fine.
+ *  - LE_UNAVAILABLE if there are no values in the time span.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t resTree_QueryRollupStats
+(
+    resTree_EntryRef_t obsEntry,    ///< Observation entry.
+    uint32_t resolution,    ///< Maximum bucket width, in seconds.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,         ///< [OUT] Number of non-NAN values in the time span.
+    double* minPtr,             ///< [OUT] Minimum value.
+    double* maxPtr,             ///< [OUT] Maximum value.
+    double* meanPtr,            ///< [OUT] Mean (average) value.
+    double* stdDevPtr,          ///< [OUT] Standard deviation.
+    double* sumPtr,             ///< [OUT] Sum of the values.
+    double* firstTimestampPtr,  ///< [OUT] Start time of the oldest bucket in the time span.
+    double* lastTimestampPtr    ///< [OUT] Start time of the newest bucket in the time span.
+);
+
+
 #endif // NAMESPACE_H_INCLUDE_GUARD
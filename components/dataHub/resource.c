@@ -104,6 +104,26 @@ static bool IsAcceptable
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * If a given resource is an Observation, make sure its buffer has been restored from backup, so
+ * its current value and data type are up to date.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CompleteRestore
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (   (resPtr->entryRef != NULL)
+        && (resTree_GetEntryType(resPtr->entryRef) == ADMIN_ENTRY_TYPE_OBSERVATION)  )
+    {
+        obs_CompleteRestore(resPtr);
+    }
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Constructor for the Resource base class.
@@ -133,6 +153,7 @@ void res_Construct
     resPtr->defaultType = IO_DATA_TYPE_TRIGGER;
     resPtr->isConfigChanging = false;
     resPtr->pushHandlerList = LE_DLS_LIST_INIT;
+    memset(resPtr->recycledSamples, 0, sizeof(resPtr->recycledSamples));
     resPtr->jsonExample = NULL;
 }
 
@@ -285,6 +306,15 @@ void res_Destruct
         resPtr->pushedValue = NULL;
     }
 
+    for (size_t i = 0; i < RES_NUM_RECYCLED_SAMPLES; i++)
+    {
+        if (resPtr->recycledSamples[i] != NULL)
+        {
+            le_mem_Release(resPtr->recycledSamples[i]);
+            resPtr->recycledSamples[i] = NULL;
+        }
+    }
+
     LE_ASSERT(resPtr->srcPtr == NULL);
     LE_ASSERT(le_dls_IsEmpty(&resPtr->destList));
 
@@ -349,6 +379,8 @@ io_DataType_t res_GetDataType
 )
 //--------------------------------------------------------------------------------------------------
 {
+    CompleteRestore(resPtr);
+
     return resPtr->currentType;
 }
 
@@ -366,6 +398,8 @@ dataSample_Ref_t res_GetCurrentValue
 )
 //--------------------------------------------------------------------------------------------------
 {
+    CompleteRestore(resPtr);
+
     return resPtr->currentValue;
 }
 
@@ -548,6 +582,63 @@ static void UpdateCurrentValue
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a non-string Data Sample to push to a given resource, reusing one of the samples recently
+ * obtained for that resource if nothing else holds a reference to it anymore.  This allows
+ * Trigger, Boolean and Numeric values to be pushed along a route without allocating anything
+ * in the steady state.
+ *
+ * @return Reference to a Data Sample with the given timestamp, which the caller must set the value
+ *         of (unless it is a Trigger) and then push or release.
+ */
+//--------------------------------------------------------------------------------------------------
+dataSample_Ref_t res_GetRecycledSample
+(
+    res_Resource_t* resPtr,
+    double timestamp
+)
+//--------------------------------------------------------------------------------------------------
+{
+    dataSample_Ref_t* samplesPtr = resPtr->recycledSamples;
+    dataSample_Ref_t sampleRef = NULL;
+    size_t i;
+
+    // Look for a sample that only this resource is still holding, oldest first.
+    for (i = 0; i < RES_NUM_RECYCLED_SAMPLES; i++)
+    {
+        if ((samplesPtr[i] != NULL) && (le_mem_GetRefCount(samplesPtr[i]) == 1))
+        {
+            sampleRef = samplesPtr[i];
+            dataSample_SetTimestamp(sampleRef, timestamp);
+            break;
+        }
+    }
+
+    // If none could be reused, drop the oldest one and create a new one.
+    if (sampleRef == NULL)
+    {
+        i = 0;
+        if (samplesPtr[0] != NULL)
+        {
+            le_mem_Release(samplesPtr[0]);
+        }
+        sampleRef = dataSample_CreateTrigger(timestamp);
+    }
+
+    // Move the sample to the newest position, keeping a reference for later reuse.
+    for (; i < (RES_NUM_RECYCLED_SAMPLES - 1); i++)
+    {
+        samplesPtr[i] = samplesPtr[i + 1];
+    }
+    samplesPtr[RES_NUM_RECYCLED_SAMPLES - 1] = sampleRef;
+
+    le_mem_AddRef(sampleRef);
+
+    return sampleRef;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Push a data sample to a resource.
@@ -617,9 +708,10 @@ void res_Push
     // original sample).
     if (res_IsOverridden(resPtr))
     {
-        dataSample_Ref_t overrideSample = dataSample_Copy(resPtr->overrideType,
-                                                          resPtr->overrideValue);
-        dataSample_SetTimestamp(overrideSample, dataSample_GetTimestamp(dataSample));
+        double timestamp = dataSample_GetTimestamp(dataSample);
+        dataSample_Ref_t overrideSample = dataSample_CopyWithTimestamp(resPtr->overrideType,
+                                                                       resPtr->overrideValue,
+                                                                       timestamp);
         dataType = resPtr->overrideType;
         le_mem_Release(dataSample);
         dataSample = overrideSample;
@@ -1176,6 +1268,147 @@ uint32_t res_GetBufferMaxCount
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable compression of a given Observation's buffer.  Only numeric samples are
+ * compressed.  Samples already in the buffer are kept.
+ */
+//--------------------------------------------------------------------------------------------------
+void res_SetBufferCompression
+(
+    res_Resource_t* resPtr,
+    bool isCompressed
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_SetBufferCompression(resPtr, isCompressed);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether compression is enabled for a given Observation's buffer.
+ *
+ * @return true if enabled.
+ */
+//--------------------------------------------------------------------------------------------------
+bool res_IsBufferCompressed
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return obs_IsBufferCompressed(resPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the tolerance of the swinging door compression of a given Observation's buffer.  When set,
+ * numeric samples are only buffered if they are needed to reconstruct the signal to within the
+ * tolerance, by linear interpolation.
+ */
+//--------------------------------------------------------------------------------------------------
+void res_SetBufferTolerance
+(
+    res_Resource_t* resPtr,
+    double tolerance    ///< Maximum reconstruction error (> 0); NAN or 0 = disabled.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_SetBufferTolerance(resPtr, tolerance);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the tolerance of the swinging door compression of a given Observation's buffer.
+ *
+ * @return The tolerance, or NAN if not set.
+ */
+//--------------------------------------------------------------------------------------------------
+double res_GetBufferTolerance
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return obs_GetBufferTolerance(resPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Enable or disable run-length encoding of a given Observation's buffer.  When enabled, repeated
+ * numerical values are buffered as runs of samples, which queries weight by their sample counts.
+ */
+//--------------------------------------------------------------------------------------------------
+void res_SetBufferRunLengthEncoding
+(
+    res_Resource_t* resPtr,
+    bool isEnabled
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_SetBufferRunLengthEncoding(resPtr, isEnabled);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether run-length encoding is enabled for a given Observation's buffer.
+ *
+ * @return true if enabled.
+ */
+//--------------------------------------------------------------------------------------------------
+bool res_IsBufferRunLengthEncoded
+(
+    res_Resource_t* resPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return obs_IsBufferRunLengthEncoded(resPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add, resize, or remove one of an Observation's rollup tiers.  Each tier summarizes the numeric
+ * or Boolean values accepted by the Observation into buckets of a fixed width (aligned to
+ * multiples of that width since the Epoch), and retains a given number of completed buckets,
+ * independently of the Observation's buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+void res_SetBufferRollup
+(
+    res_Resource_t* resPtr,
+    uint32_t bucketSeconds, ///< Width of the tier's buckets, in seconds.
+    uint32_t count  ///< Number of completed buckets to retain. 0 = remove the tier.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_SetBufferRollup(resPtr, bucketSeconds, count);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of completed buckets retained by one of an Observation's rollup tiers.
+ *
+ * @return The number of buckets, or 0 if the Observation has no tier with that bucket width.
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t res_GetBufferRollup
+(
+    res_Resource_t* resPtr,
+    uint32_t bucketSeconds  ///< Width of the tier's buckets, in seconds.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return obs_GetBufferRollup(resPtr, bucketSeconds);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the minimum time between backups of an Observation's buffer to non-volatile storage.
@@ -1577,28 +1810,165 @@ void res_EndUpdate
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Read data out of a buffer.  Data is written to a given file descriptor in JSON-encoded format
- * as an array of objects containing a timestamp and a value (or just a timestamp for triggers).
- * E.g.,
+ * Read data out of a buffer.  Data is written to a given file descriptor in a given format.  In
+ * JSON format, that is an array of objects containing a timestamp and a value (or just a timestamp
+ * for triggers).  E.g.,
  *
  * @code
  * [{"t":1537483647.125,"v":true},{"t":1537483657.128,"v":true}]
  * @endcode
+ *
+ * See query_ReadBuffer() for the binary formats.
  */
 //--------------------------------------------------------------------------------------------------
-void res_ReadBufferJson
+void res_ReadBuffer
 (
     res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
     double startAfter,  ///< Start after this many seconds ago, or after an absolute number of
                         ///< seconds since the Epoch (if startafter > 30 years).
                         ///< Use NAN (not a number) to read the whole buffer.
+    query_Format_t format,  ///< Format to write the data in.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_ReadBuffer(resPtr, startAfter, format, outputFile, handlerPtr, contextPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Export the numerical samples in a time window of an Observation's buffer as a snapshot in a
+ * sealed, read-only memory file.  See query_ExportBuffer() for the snapshot's layout.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_UNAVAILABLE if the buffer doesn't contain numerical data.
+ *  - LE_FAULT if the memory file couldn't be created.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t res_ExportBuffer
+(
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startTime,   ///< Samples before this time are excluded. If < 30 years then seconds
+                        ///< before now; else seconds since the Epoch. NAN = no limit.
+    double endTime,     ///< Samples at or after this time are excluded. If < 30 years then
+                        ///< seconds before now; else seconds since the Epoch. NAN = no limit.
+    int* snapshotFilePtr    ///< [OUT] File descriptor of the snapshot, if LE_OK returned.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return obs_ExportBuffer(resPtr, startTime, endTime, snapshotFilePtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read aggregates of the numerical data in a buffer, bucketed by time.  Data is written to a given
+ * file descriptor in JSON-encoded format as an array of objects, one per time bucket, containing
+ * the start time of the bucket and the requested aggregates of the values in it.  E.g.,
+ *
+ * @code
+ * [{"t":1537483620.000000,"mean":21.250000},{"t":1537483680.000000,"mean":21.500000}]
+ * @endcode
+ *
+ * Buckets that contain no numerical values are omitted.
+ */
+//--------------------------------------------------------------------------------------------------
+void res_ReadBufferAggregates
+(
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startTime,   ///< Start time of the first bucket. If < 30 years then seconds before now;
+                        ///< else seconds since the Epoch. NAN = start at the oldest sample.
+    double endTime,     ///< Samples at or after this time are excluded. If < 30 years then
+                        ///< seconds before now; else seconds since the Epoch. NAN = no limit.
+    double bucketSeconds,   ///< Width of each time bucket, in seconds (> 0).
+    query_Aggregate_t aggregates,   ///< Aggregates to write for each bucket (non-zero).
     int outputFile, ///< File descriptor to write the data to.
     query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
     void* contextPtr    ///< Value to be passed to completion callback.
 )
 //--------------------------------------------------------------------------------------------------
 {
-    obs_ReadBufferJson(resPtr, startAfter, outputFile, handlerPtr, contextPtr);
+    obs_ReadBufferAggregates(resPtr,
+                             startTime,
+                             endTime,
+                             bucketSeconds,
+                             aggregates,
+                             outputFile,
+                             handlerPtr,
+                             contextPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a downsampled representation of the numerical data in a buffer, for plotting.  At most
+ * maxPoints samples are written to a given file descriptor, in the same JSON-encoded format as
+ * res_ReadBuffer().  If the buffer holds no more than maxPoints samples after startAfter,
+ * they are all written.
+ */
+//--------------------------------------------------------------------------------------------------
+void res_ReadBufferDownsampled
+(
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    double startAfter,  ///< Start after this many seconds ago, or after an absolute number of
+                        ///< seconds since the Epoch (if startafter > 30 years).
+                        ///< Use NAN (not a number) to read the whole buffer.
+    uint32_t maxPoints, ///< Maximum number of samples to write (>= 3 for LTTB, >= 2 for min/max).
+    query_Downsampling_t method,    ///< Downsampling algorithm.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    obs_ReadBufferDownsampled(resPtr,
+                              startAfter,
+                              maxPoints,
+                              method,
+                              outputFile,
+                              handlerPtr,
+                              contextPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the rows of one of an Observation's rollup tiers, starting with the first bucket that
+ * starts at or after a given time, and write them to a given file descriptor in JSON format.
+ * The tier used is the coarsest one whose buckets are no wider than a given resolution.  The
+ * bucket currently being filled is written last.  E.g.,
+ *
+ * @code
+ * [{"t":1537483560.000000,"count":60,"min":20.100000,"max":22.400000,"mean":21.250000}]
+ * @endcode
+ *
+ * @return
+ *  - LE_OK if the read operation started.
+ *  - LE_NOT_FOUND if the Observation has no rollup tier that fine.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t res_ReadRollupJson
+(
+    res_Resource_t* resPtr, ///< Ptr to the resource object for the Observation.
+    uint32_t resolution,    ///< Maximum bucket width, in seconds.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+                        ///< NAN = start at the oldest bucket.
+    int outputFile, ///< File descriptor to write the data to.
+    query_ReadCompletionFunc_t handlerPtr, ///< Completion callback.
+    void* contextPtr    ///< Value to be passed to completion callback.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return obs_ReadRollupJson(resPtr,
+                              resolution,
+                              startTime,
+                              outputFile,
+                              handlerPtr,
+                              contextPtr);
 }
 
 
@@ -1793,3 +2163,85 @@ double res_QueryStdDev
 {
     return obs_QueryStdDev(resPtr, startTime);
 }
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a summary of all the statistics that can be queried on the values found within a given
+ * time span in an Observation's buffer.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_UNAVAILABLE if there's no numerical data in the Observation's buffer within the time span
+ *    (if the buffer size is zero, the buffer is empty, or the buffer contains data of a
+ *    non-numerical type).
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t res_QueryStats
+(
+    res_Resource_t* resPtr,    ///< Ptr to Observation resource.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,         ///< [OUT] Number of non-NAN values in the time span.
+    double* minPtr,             ///< [OUT] Minimum value.
+    double* maxPtr,             ///< [OUT] Maximum value.
+    double* meanPtr,            ///< [OUT] Mean (average) value.
+    double* stdDevPtr,          ///< [OUT] Standard deviation.
+    double* sumPtr,             ///< [OUT] Sum of the values.
+    double* firstTimestampPtr,  ///< [OUT] Timestamp of the oldest sample in the time span.
+    double* lastTimestampPtr    ///< [OUT] Timestamp of the newest sample in the time span.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return obs_QueryStats(resPtr,
+                          startTime,
+                          countPtr,
+                          minPtr,
+                          maxPtr,
+                          meanPtr,
+                          stdDevPtr,
+                          sumPtr,
+                          firstTimestampPtr,
+                          lastTimestampPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get statistics about the values summarized by one of an Observation's rollup tiers in buckets
+ * that start at or after a given time.  The tier used is the coarsest one whose buckets are no
+ * wider than a given resolution, so this can cover a much longer time span than the buffer.
+ *
+ * @return
+ *  - LE_OK if successful.
+ *  - LE_NOT_FOUND if the Observation has no rollup tier that fine.
+ *  - LE_UNAVAILABLE if there are no values in the time span.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t res_QueryRollupStats
+(
+    res_Resource_t* resPtr,    ///< Ptr to Observation resource.
+    uint32_t resolution,    ///< Maximum bucket width, in seconds.
+    double startTime,   ///< If < 30 years then seconds before now; else seconds since the Epoch.
+    uint32_t* countPtr,         ///< [OUT] Number of non-NAN values in the time span.
+    double* minPtr,             ///< [OUT] Minimum value.
+    double* maxPtr,             ///< [OUT] Maximum value.
+    double* meanPtr,            ///< [OUT] Mean (average) value.
+    double* stdDevPtr,          ///< [OUT] Standard deviation.
+    double* sumPtr,             ///< [OUT] Sum of the values.
+    double* firstTimestampPtr,  ///< [OUT] Start time of the oldest bucket in the time span.
+    double* lastTimestampPtr    ///< [OUT] Start time of the newest bucket in the time span.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return obs_QueryRollupStats(resPtr,
+                                resolution,
+                                startTime,
+                                countPtr,
+                                minPtr,
+                                maxPtr,
+                                meanPtr,
+                                stdDevPtr,
+                                sumPtr,
+                                firstTimestampPtr,
+                                lastTimestampPtr);
+}
@@ -0,0 +1,831 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * Backup and restore test for the Data Hub.
+ *
+ * Fills Observations' buffers and waits for the Data Hub to back them up.  Then, for each case,
+ * deletes the Observation, puts its backup files back (as they were, or damaged), and re-creates
+ * the Observation to check what the Data Hub restores from them:
+ *
+ *  - an intact backup file and journal restore the buffer as it was;
+ *  - a backup file that fails its CRC check, or that has been truncated, restores nothing;
+ *  - a journal whose last batch was torn restores the buffer as it was before that batch;
+ *  - the backup of a compressed buffer restores the buffer as it was.
+ *
+ * Usage: backupTest [BACKUP_DIR]
+ *
+ * BACKUP_DIR is the directory the Data Hub keeps its backup files in.  It defaults to the same
+ * directory as in the Data Hub's backup.c, which is relative to the current directory unless
+ * built for an embedded target, so run it from the directory the Data Hub was started in.
+ *
+ * The app deletes the Observations it created before it exits, and exits with EXIT_FAILURE if any
+ * check failed.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include <math.h>
+
+/// Must match BACKUP_DIR in components/dataHub/backup.c.
+#ifdef LEGATO_EMBEDDED
+ #define BACKUP_DIR "/home/root/dataHubBackup/"
+#else
+ #define BACKUP_DIR "backup/"
+#endif
+
+#define BACKUP_SUFFIX ".bak"
+#define JOURNAL_SUFFIX ".jnl"
+
+/// Size of the header of a backup file (format version 3), which is followed by the records.
+#define BACKUP_HEADER_BYTES 32
+
+#define OBS_DIR "backupTest"
+#define PLAIN_OBS OBS_DIR "/plain"
+#define JOURNAL_OBS OBS_DIR "/journal"
+#define COMPRESSED_OBS OBS_DIR "/compressed"
+
+/// Buffer size of the Observations.
+#define MAX_COUNT 2000
+
+/// Backup period of the Observations, in seconds.
+#define BACKUP_PERIOD 1
+
+/// Number of milliseconds the backup files must go unchanged for before they are taken to hold
+/// everything pushed so far.
+#define SETTLE_MS (3 * BACKUP_PERIOD * 1000)
+
+/// Maximum number of milliseconds to wait for the Data Hub to write or delete backup files.
+#define TIMEOUT_MS 30000
+
+/// Number of milliseconds between checks of the backup files while waiting.
+#define POLL_MS 100
+
+/// Timestamp of the first sample pushed (seconds since the Epoch).
+#define START_TIME 1600000000.0
+
+/// Directory the Data Hub keeps its backup files in.
+static const char* BackupDir = BACKUP_DIR;
+
+/// Timestamp of the next sample to be pushed.
+static double NextTimestamp = START_TIME;
+
+/// Number of samples pushed so far.
+static uint32_t PushCount = 0;
+
+/// Number of checks that failed.
+static int FailureCount = 0;
+
+/// Contents of an Observation's backup file and journal.
+typedef struct
+{
+    uint8_t* backupPtr;     ///< Contents of the backup file.
+    size_t backupSize;      ///< Number of bytes in the backup file.
+    uint8_t* journalPtr;    ///< Contents of the journal (NULL if there is none).
+    size_t journalSize;     ///< Number of bytes in the journal.
+}
+Backup_t;
+
+/// Statistics of an Observation's buffer, as reported by query_GetStats().
+typedef struct
+{
+    le_result_t result;
+    uint32_t count;
+    double min;
+    double max;
+    double mean;
+    double stdDev;
+    double sum;
+    double firstTimestamp;
+    double lastTimestamp;
+}
+Stats_t;
+
+/// What is known about a backup file, for noticing when it changes.
+typedef struct
+{
+    bool exists;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+}
+FileState_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the file system path of one of an Observation's backup files.
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetFilePath
+(
+    char* pathPtr,          ///< [OUT] Buffer to put the path in.
+    size_t pathSize,        ///< Size of the buffer, in bytes.
+    const char* obsPath,    ///< Path of the Observation within the /obs/ namespace.
+    const char* suffix      ///< BACKUP_SUFFIX or JOURNAL_SUFFIX.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int len = snprintf(pathPtr, pathSize, "%s%s%s", BackupDir, obsPath, suffix);
+    LE_ASSERT((len > 0) && ((size_t)len < pathSize));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the state of a file.
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetFileState
+(
+    const char* path,
+    FileState_t* statePtr   ///< [OUT]
+)
+//--------------------------------------------------------------------------------------------------
+{
+    struct stat st;
+
+    memset(statePtr, 0, sizeof(*statePtr));
+
+    if (stat(path, &st) != 0)
+    {
+        LE_ASSERT(errno == ENOENT);
+        return;
+    }
+
+    statePtr->exists = true;
+    statePtr->dev = st.st_dev;
+    statePtr->ino = st.st_ino;
+    statePtr->size = st.st_size;
+    statePtr->mtime = st.st_mtim;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether two states of a file are the same.
+ *
+ * @return true if the file hasn't changed.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSameFileState
+(
+    const FileState_t* aPtr,
+    const FileState_t* bPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return (   (aPtr->exists == bPtr->exists)
+            && (aPtr->dev == bPtr->dev)
+            && (aPtr->ino == bPtr->ino)
+            && (aPtr->size == bPtr->size)
+            && (aPtr->mtime.tv_sec == bPtr->mtime.tv_sec)
+            && (aPtr->mtime.tv_nsec == bPtr->mtime.tv_nsec)  );
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until the Data Hub has backed up everything pushed to an Observation so far: its backup
+ * file exists, and neither it nor the journal has changed for SETTLE_MS.
+ */
+//--------------------------------------------------------------------------------------------------
+static void WaitForBackup
+(
+    const char* obsPath ///< Path of the Observation within the /obs/ namespace.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char backupPath[PATH_MAX];
+    char journalPath[PATH_MAX];
+    GetFilePath(backupPath, sizeof(backupPath), obsPath, BACKUP_SUFFIX);
+    GetFilePath(journalPath, sizeof(journalPath), obsPath, JOURNAL_SUFFIX);
+
+    FileState_t backupState;
+    FileState_t journalState;
+    GetFileState(backupPath, &backupState);
+    GetFileState(journalPath, &journalState);
+
+    int unchangedMs = 0;
+
+    for (int waitedMs = 0; waitedMs < TIMEOUT_MS; waitedMs += POLL_MS)
+    {
+        usleep(POLL_MS * 1000);
+
+        FileState_t newBackupState;
+        FileState_t newJournalState;
+        GetFileState(backupPath, &newBackupState);
+        GetFileState(journalPath, &newJournalState);
+
+        if (   IsSameFileState(&backupState, &newBackupState)
+            && IsSameFileState(&journalState, &newJournalState)  )
+        {
+            unchangedMs += POLL_MS;
+
+            if (backupState.exists && (unchangedMs >= SETTLE_MS))
+            {
+                return;
+            }
+        }
+        else
+        {
+            backupState = newBackupState;
+            journalState = newJournalState;
+            unchangedMs = 0;
+        }
+    }
+
+    LE_FATAL("Timed out waiting for '%s' to be backed up.", obsPath);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the whole of a file into memory.
+ *
+ * @return Pointer to the contents (to be released using free()), or NULL if the file doesn't exist.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t* ReadFile
+(
+    const char* path,
+    size_t* sizePtr     ///< [OUT] Number of bytes read.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    *sizePtr = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        LE_ASSERT(errno == ENOENT);
+        return NULL;
+    }
+
+    struct stat st;
+    LE_ASSERT(fstat(fd, &st) == 0);
+
+    // Allocate at least one byte, so an empty file isn't taken to be missing.
+    uint8_t* bytesPtr = malloc(st.st_size + 1);
+    LE_ASSERT(bytesPtr != NULL);
+
+    size_t size = 0;
+    while (size < (size_t)st.st_size)
+    {
+        ssize_t result = read(fd, bytesPtr + size, st.st_size - size);
+        if ((result < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        LE_FATAL_IF(result <= 0, "Failed to read '%s' (%m).", path);
+        size += result;
+    }
+
+    close(fd);
+
+    *sizePtr = size;
+    return bytesPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a file, creating its directory if necessary.
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteFile
+(
+    const char* path,
+    const uint8_t* bytesPtr,
+    size_t size
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char dirPath[PATH_MAX];
+    LE_ASSERT(le_path_GetDir(path, "/", dirPath, sizeof(dirPath)) == LE_OK);
+    LE_ASSERT(le_dir_MakePath(dirPath, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) == LE_OK);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    LE_FATAL_IF(fd < 0, "Failed to create '%s' (%m).", path);
+
+    size_t written = 0;
+    while (written < size)
+    {
+        ssize_t result = write(fd, bytesPtr + written, size - written);
+        if ((result < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        LE_FATAL_IF(result <= 0, "Failed to write '%s' (%m).", path);
+        written += result;
+    }
+
+    LE_FATAL_IF(close(fd) != 0, "Failed to close '%s' (%m).", path);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read an Observation's backup file and journal into memory.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SaveBackup
+(
+    const char* obsPath,    ///< Path of the Observation within the /obs/ namespace.
+    Backup_t* backupPtr     ///< [OUT] The contents (to be released using ReleaseBackup()).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char path[PATH_MAX];
+
+    GetFilePath(path, sizeof(path), obsPath, BACKUP_SUFFIX);
+    backupPtr->backupPtr = ReadFile(path, &backupPtr->backupSize);
+    LE_FATAL_IF(backupPtr->backupPtr == NULL, "No backup file '%s'.", path);
+
+    GetFilePath(path, sizeof(path), obsPath, JOURNAL_SUFFIX);
+    backupPtr->journalPtr = ReadFile(path, &backupPtr->journalSize);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Make a copy of the contents of an Observation's backup file and journal, for damaging.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CopyBackup
+(
+    Backup_t* copyPtr,          ///< [OUT] The copy (to be released using ReleaseBackup()).
+    const Backup_t* backupPtr   ///< The contents to copy.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    *copyPtr = *backupPtr;
+
+    copyPtr->backupPtr = malloc(backupPtr->backupSize + 1);
+    LE_ASSERT(copyPtr->backupPtr != NULL);
+    memcpy(copyPtr->backupPtr, backupPtr->backupPtr, backupPtr->backupSize);
+
+    if (backupPtr->journalPtr != NULL)
+    {
+        copyPtr->journalPtr = malloc(backupPtr->journalSize + 1);
+        LE_ASSERT(copyPtr->journalPtr != NULL);
+        memcpy(copyPtr->journalPtr, backupPtr->journalPtr, backupPtr->journalSize);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the contents of an Observation's backup file and journal.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReleaseBackup
+(
+    Backup_t* backupPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    free(backupPtr->backupPtr);
+    free(backupPtr->journalPtr);
+    memset(backupPtr, 0, sizeof(*backupPtr));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete an Observation along with its backup files, and wait until the Data Hub has deleted
+ * the files.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RemoveObs
+(
+    const char* obsPath ///< Path of the Observation within the /obs/ namespace.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char backupPath[PATH_MAX];
+    char journalPath[PATH_MAX];
+    GetFilePath(backupPath, sizeof(backupPath), obsPath, BACKUP_SUFFIX);
+    GetFilePath(journalPath, sizeof(journalPath), obsPath, JOURNAL_SUFFIX);
+
+    // The Data Hub only deletes the backup files of Observations that have backups enabled.
+    admin_SetBufferBackupPeriod(obsPath, BACKUP_PERIOD);
+    admin_DeleteObs(obsPath);
+
+    for (int waitedMs = 0; waitedMs < TIMEOUT_MS; waitedMs += POLL_MS)
+    {
+        FileState_t backupState;
+        FileState_t journalState;
+        GetFileState(backupPath, &backupState);
+        GetFileState(journalPath, &journalState);
+
+        if (!backupState.exists && !journalState.exists)
+        {
+            return;
+        }
+
+        usleep(POLL_MS * 1000);
+    }
+
+    LE_FATAL("Timed out waiting for the backup files of '%s' to be deleted.", obsPath);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create an Observation that is backed up every BACKUP_PERIOD seconds, replacing any left over
+ * from an earlier run.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CreateObs
+(
+    const char* obsPath,    ///< Path of the Observation within the /obs/ namespace.
+    bool isCompressed       ///< true if the buffer is to be compressed.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Creating it first restores (and so gets rid of) any backup left over from an earlier run.
+    (void)admin_CreateObs(obsPath);
+    RemoveObs(obsPath);
+
+    LE_ASSERT(admin_CreateObs(obsPath) == LE_OK);
+    admin_SetBufferMaxCount(obsPath, MAX_COUNT);
+    admin_SetBufferCompression(obsPath, isCompressed);
+    admin_SetBufferBackupPeriod(obsPath, BACKUP_PERIOD);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete an Observation and re-create it with the given contents in its backup files, so the Data
+ * Hub restores its buffer from them.  Backups of the re-created Observation are not enabled, so
+ * the Data Hub leaves the files alone.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RestoreObs
+(
+    const char* obsPath,        ///< Path of the Observation within the /obs/ namespace.
+    const Backup_t* backupPtr   ///< Contents of the backup files.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char path[PATH_MAX];
+
+    RemoveObs(obsPath);
+
+    GetFilePath(path, sizeof(path), obsPath, BACKUP_SUFFIX);
+    WriteFile(path, backupPtr->backupPtr, backupPtr->backupSize);
+
+    if (backupPtr->journalPtr != NULL)
+    {
+        GetFilePath(path, sizeof(path), obsPath, JOURNAL_SUFFIX);
+        WriteFile(path, backupPtr->journalPtr, backupPtr->journalSize);
+    }
+
+    LE_ASSERT(admin_CreateObs(obsPath) == LE_OK);
+    admin_SetBufferMaxCount(obsPath, MAX_COUNT);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the value of a numeric sample pushed by PushSamples().  The values vary, so compressed
+ * buffers get a mix of small and large differences to encode.
+ *
+ * @return The value.
+ */
+//--------------------------------------------------------------------------------------------------
+static double GetSampleValue
+(
+    uint32_t pushNum    ///< Number of samples pushed before it.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return ((pushNum * 7919) % 1000) / 8.0 - ((pushNum % 3) * 100.0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push numeric samples to an Observation, with timestamps half a second apart.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PushSamples
+(
+    const char* obsPath,    ///< Path of the Observation within the /obs/ namespace.
+    uint32_t count          ///< Number of samples to push.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char path[PATH_MAX];
+    int len = snprintf(path, sizeof(path), "/obs/%s", obsPath);
+    LE_ASSERT((len > 0) && ((size_t)len < sizeof(path)));
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        admin_PushNumeric(path, NextTimestamp, GetSampleValue(PushCount));
+
+        NextTimestamp += 0.5;
+        PushCount++;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the statistics of everything in an Observation's buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetStats
+(
+    const char* obsPath,    ///< Path of the Observation within the /obs/ namespace.
+    Stats_t* statsPtr       ///< [OUT]
+)
+//--------------------------------------------------------------------------------------------------
+{
+    statsPtr->result = query_GetStats(obsPath,
+                                      NAN,
+                                      &statsPtr->count,
+                                      &statsPtr->min,
+                                      &statsPtr->max,
+                                      &statsPtr->mean,
+                                      &statsPtr->stdDev,
+                                      &statsPtr->sum,
+                                      &statsPtr->firstTimestamp,
+                                      &statsPtr->lastTimestamp);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record the outcome of a check.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Check
+(
+    bool isOk,
+    const char* caseName,   ///< Name of the test case.
+    const char* what        ///< What was checked.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (!isOk)
+    {
+        LE_ERROR("%s: %s check failed.", caseName, what);
+        printf("FAILED: %s: %s\n", caseName, what);
+        FailureCount++;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether two statistics are the same, give or take rounding of sums accumulated in a
+ * different order.
+ *
+ * @return true if they are.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsClose
+(
+    double a,
+    double b
+)
+//--------------------------------------------------------------------------------------------------
+{
+    double diff = a - b;
+    double limit = 1e-9 * ((a < 0) ? -a : a) + 1e-9;
+
+    return ((diff <= limit) && (diff >= -limit));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check that an Observation's buffer has been restored as it was.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckRestored
+(
+    const char* obsPath,            ///< Path of the Observation within the /obs/ namespace.
+    const Stats_t* expectedPtr,     ///< Statistics of the buffer when it was backed up.
+    const char* caseName            ///< Name of the test case.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Stats_t stats;
+    GetStats(obsPath, &stats);
+
+    Check(stats.result == LE_OK, caseName, "result");
+    if (stats.result == LE_OK)
+    {
+        Check(stats.count == expectedPtr->count, caseName, "count");
+        Check(stats.min == expectedPtr->min, caseName, "min");
+        Check(stats.max == expectedPtr->max, caseName, "max");
+        Check(IsClose(stats.mean, expectedPtr->mean), caseName, "mean");
+        Check(IsClose(stats.stdDev, expectedPtr->stdDev), caseName, "stdDev");
+        Check(IsClose(stats.sum, expectedPtr->sum), caseName, "sum");
+        Check(stats.firstTimestamp == expectedPtr->firstTimestamp, caseName, "first timestamp");
+        Check(stats.lastTimestamp == expectedPtr->lastTimestamp, caseName, "last timestamp");
+    }
+
+    printf("%s: restored %" PRIu32 " of %" PRIu32 " samples\n",
+           caseName,
+           (stats.result == LE_OK) ? stats.count : 0,
+           expectedPtr->count);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check that nothing was restored to an Observation's buffer.
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckEmpty
+(
+    const char* obsPath,    ///< Path of the Observation within the /obs/ namespace.
+    const char* caseName    ///< Name of the test case.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Stats_t stats;
+    GetStats(obsPath, &stats);
+
+    Check(stats.result == LE_UNAVAILABLE, caseName, "empty buffer");
+
+    printf("%s: restored %" PRIu32 " samples\n",
+           caseName,
+           (stats.result == LE_OK) ? stats.count : 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore an uncompressed buffer from its backup file, from a copy of it that fails its CRC check,
+ * and from a copy cut short by a byte.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestBackupFile
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CreateObs(PLAIN_OBS, false);
+    PushSamples(PLAIN_OBS, 100);
+    WaitForBackup(PLAIN_OBS);
+
+    Stats_t expected;
+    GetStats(PLAIN_OBS, &expected);
+    LE_ASSERT((expected.result == LE_OK) && (expected.count == 100));
+
+    Backup_t backup;
+    SaveBackup(PLAIN_OBS, &backup);
+    LE_ASSERT(backup.backupSize > BACKUP_HEADER_BYTES);
+
+    RestoreObs(PLAIN_OBS, &backup);
+    CheckRestored(PLAIN_OBS, &expected, "intact backup");
+
+    // The last byte holds part of the newest value, which is covered by the CRC in the header.
+    Backup_t damaged;
+    CopyBackup(&damaged, &backup);
+    damaged.backupPtr[damaged.backupSize - 1] ^= 0x01;
+    RestoreObs(PLAIN_OBS, &damaged);
+    CheckEmpty(PLAIN_OBS, "corrupted backup");
+    ReleaseBackup(&damaged);
+
+    CopyBackup(&damaged, &backup);
+    damaged.backupSize--;
+    RestoreObs(PLAIN_OBS, &damaged);
+    CheckEmpty(PLAIN_OBS, "truncated backup");
+    ReleaseBackup(&damaged);
+
+    ReleaseBackup(&backup);
+    RemoveObs(PLAIN_OBS);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore a buffer from its backup file and a journal of the samples pushed since, and from the
+ * same files with the journal torn part way through the batches written after a given point.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestJournal
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CreateObs(JOURNAL_OBS, false);
+    PushSamples(JOURNAL_OBS, 50);
+    WaitForBackup(JOURNAL_OBS);
+    PushSamples(JOURNAL_OBS, 10);
+    WaitForBackup(JOURNAL_OBS);
+
+    // Remember how far the journal had got before the last samples were pushed.
+    Stats_t beforeTear;
+    GetStats(JOURNAL_OBS, &beforeTear);
+    LE_ASSERT((beforeTear.result == LE_OK) && (beforeTear.count == 60));
+
+    Backup_t backup;
+    SaveBackup(JOURNAL_OBS, &backup);
+    LE_ASSERT(backup.journalPtr != NULL);
+    size_t tornSize = backup.journalSize;
+    ReleaseBackup(&backup);
+
+    PushSamples(JOURNAL_OBS, 10);
+    WaitForBackup(JOURNAL_OBS);
+
+    Stats_t expected;
+    GetStats(JOURNAL_OBS, &expected);
+    LE_ASSERT((expected.result == LE_OK) && (expected.count == 70));
+
+    SaveBackup(JOURNAL_OBS, &backup);
+    LE_ASSERT(backup.journalPtr != NULL);
+    LE_FATAL_IF(backup.journalSize <= tornSize,
+                "Last samples pushed weren't journaled (journal was %zu bytes, now %zu).",
+                tornSize,
+                backup.journalSize);
+
+    RestoreObs(JOURNAL_OBS, &backup);
+    CheckRestored(JOURNAL_OBS, &expected, "intact journal");
+
+    // Cut the journal off half way through what was appended for the last samples pushed.
+    Backup_t damaged;
+    CopyBackup(&damaged, &backup);
+    damaged.journalSize = tornSize + (backup.journalSize - tornSize) / 2;
+    RestoreObs(JOURNAL_OBS, &damaged);
+    CheckRestored(JOURNAL_OBS, &beforeTear, "torn journal");
+    ReleaseBackup(&damaged);
+
+    ReleaseBackup(&backup);
+    RemoveObs(JOURNAL_OBS);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore a compressed buffer from its backup.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestCompressed
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CreateObs(COMPRESSED_OBS, true);
+    uint32_t firstPushNum = PushCount;
+    PushSamples(COMPRESSED_OBS, 1000);
+    WaitForBackup(COMPRESSED_OBS);
+
+    Stats_t expected;
+    GetStats(COMPRESSED_OBS, &expected);
+    LE_ASSERT((expected.result == LE_OK) && (expected.count == 1000));
+
+    Backup_t backup;
+    SaveBackup(COMPRESSED_OBS, &backup);
+
+    RestoreObs(COMPRESSED_OBS, &backup);
+    CheckRestored(COMPRESSED_OBS, &expected, "compressed backup");
+
+    // The oldest sample is decoded from the first compressed block, so check its value too.
+    double timestamp;
+    double value;
+    le_result_t result = query_ReadBufferSampleNumeric(COMPRESSED_OBS, NAN, &timestamp, &value);
+    Check(   (result == LE_OK)
+          && (timestamp == expected.firstTimestamp)
+          && (value == GetSampleValue(firstPushNum)),
+          "compressed backup",
+          "oldest sample");
+
+    ReleaseBackup(&backup);
+    RemoveObs(COMPRESSED_OBS);
+}
+
+
+COMPONENT_INIT
+{
+    if (le_arg_NumArgs() > 0)
+    {
+        BackupDir = le_arg_GetArg(0);
+        LE_ASSERT((BackupDir != NULL) && (BackupDir[0] != '\0'));
+        LE_ASSERT(BackupDir[strlen(BackupDir) - 1] == '/');
+    }
+
+    TestBackupFile();
+    TestJournal();
+    TestCompressed();
+
+    if (FailureCount > 0)
+    {
+        printf("%d backup test checks failed.\n", FailureCount);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("All backup tests passed.\n");
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,65 @@
+#!/bin/bash
+#
+# Measures the number of Data Hub memory pool allocations per numeric push through a 5-hop route,
+# using the pushBench app.  Run "make start" first (it builds and starts the pushBench app too).
+#
+# The benchmark is run twice, with different numbers of pushes.  Setting up and tearing down the
+# route costs the same in both runs, so the difference between the two runs' allocation counts,
+# divided by the difference in the number of pushes, is the number of allocations per push.
+#
+# Copyright (C) Sierra Wireless Inc.
+
+BENCH=_build_pushBench/${TARGET:-localhost}/app/pushBench/staging/read-only/bin/pushBench
+SHORT_RUN=1000
+LONG_RUN=11000
+
+HUB_PID=$(pidof hubd)
+if [ -z "$HUB_PID" ]
+then
+    echo "The Data Hub (hubd) is not running." >&2
+    exit 1
+fi
+
+# Total number of allocations done so far from all of hubd's memory pools, except the Legato
+# framework's own pools (named "framework.*"), which hold IPC messages and so are allocated from
+# on every push by design.  Pools added to the Data Hub later are counted without changing this.
+# The "inspect pools" columns are: TOTAL BLKS, USED BLKS, MAX USED, OVERFLOWS, ALLOCS, BLK BYTES,
+# USED BYTES, POOL.
+HubAllocs()
+{
+    inspect pools $HUB_PID | awk '
+        $1 ~ /^[0-9]+$/ && $8 !~ /^framework\./ {
+            total += $5
+        }
+        END { print total + 0 }'
+}
+
+# Runs the benchmark app for a given number of pushes and prints the number of allocations done
+# meanwhile.  Returns non-zero if the app failed, because "exit" inside the command substitution
+# that captures its output would only leave that subshell, not the script.
+RunBench()
+{
+    local before=$(HubAllocs)
+    $BENCH $1 >&2 || return 1
+    local after=$(HubAllocs)
+    echo $((after - before))
+}
+
+# Warm up, so any one-time allocations don't get counted.
+if ! RunBench $SHORT_RUN > /dev/null 2>&1
+then
+    echo "The pushBench app failed." >&2
+    exit 1
+fi
+
+SHORT_ALLOCS=$(RunBench $SHORT_RUN) || exit 1
+LONG_ALLOCS=$(RunBench $LONG_RUN) || exit 1
+
+PER_PUSH=$(echo "scale=3; ($LONG_ALLOCS - $SHORT_ALLOCS) / ($LONG_RUN - $SHORT_RUN)" | bc)
+echo "Data Hub pool allocations per push: $PER_PUSH"
+
+if [ $LONG_ALLOCS -ne $SHORT_ALLOCS ]
+then
+    echo "FAILED: numeric pushes are allocating memory." >&2
+    exit 1
+fi
@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * Numeric push benchmark for the Data Hub.
+ *
+ * Pushes numeric samples through a 5-hop route (Input -> 4 Observations -> Output) and reports
+ * the push rate.  Each sample is only pushed after the previous one has come out of the end of
+ * the route, so there is never more than one sample in flight.
+ *
+ * Usage: pushBench [NUM_PUSHES]
+ *
+ * The app removes the route it created before it exits, so the Data Hub is left in the same
+ * state each time it is run.  test/pushBench.sh uses that to measure the number of Data Hub
+ * memory pool allocations per push.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+
+#define INPUT_NAME "value"
+#define OUTPUT_NAME "result"
+
+#define INPUT_PATH "/app/pushBench/" INPUT_NAME
+#define OUTPUT_PATH "/app/pushBench/" OUTPUT_NAME
+
+/// Number of pushes to do if not specified on the command line.
+#define DEFAULT_NUM_PUSHES 10000
+
+/// Number of pushes to do.
+static int NumPushes = DEFAULT_NUM_PUSHES;
+
+/// Time at which the first push was done.
+static le_clk_Time_t StartTime;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the route and exit.
+ */
+//--------------------------------------------------------------------------------------------------
+static void Finish
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), StartTime);
+    double seconds = (double)(elapsed.sec) + ((double)(elapsed.usec) / 1000000);
+
+    LE_INFO("%d pushes through 5 hops in %lf s (%lf pushes/s).",
+            NumPushes,
+            seconds,
+            NumPushes / seconds);
+    printf("%d pushes in %lf s (%lf pushes/s)\n", NumPushes, seconds, NumPushes / seconds);
+
+    admin_DeleteObs("bench1");
+    admin_DeleteObs("bench2");
+    admin_DeleteObs("bench3");
+    admin_DeleteObs("bench4");
+
+    exit(EXIT_SUCCESS);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Call-back function called when a sample comes out of the end of the route.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResultUpdateHandler
+(
+    double timestamp,
+    double value,
+    void* contextPtr    ///< not used
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (value >= NumPushes)
+    {
+        Finish();
+    }
+
+    io_PushNumeric(INPUT_NAME, IO_NOW, value + 1);
+}
+
+
+COMPONENT_INIT
+{
+    if (le_arg_NumArgs() > 0)
+    {
+        NumPushes = atoi(le_arg_GetArg(0));
+        LE_ASSERT(NumPushes > 0);
+    }
+
+    LE_ASSERT(io_CreateInput(INPUT_NAME, IO_DATA_TYPE_NUMERIC, "") == LE_OK);
+    LE_ASSERT(io_CreateOutput(OUTPUT_NAME, IO_DATA_TYPE_NUMERIC, "") == LE_OK);
+
+    LE_ASSERT(admin_CreateObs("bench1") == LE_OK);
+    LE_ASSERT(admin_CreateObs("bench2") == LE_OK);
+    LE_ASSERT(admin_CreateObs("bench3") == LE_OK);
+    LE_ASSERT(admin_CreateObs("bench4") == LE_OK);
+
+    LE_ASSERT(admin_SetSource("/obs/bench1", INPUT_PATH) == LE_OK);
+    LE_ASSERT(admin_SetSource("/obs/bench2", "/obs/bench1") == LE_OK);
+    LE_ASSERT(admin_SetSource("/obs/bench3", "/obs/bench2") == LE_OK);
+    LE_ASSERT(admin_SetSource("/obs/bench4", "/obs/bench3") == LE_OK);
+    LE_ASSERT(admin_SetSource(OUTPUT_PATH, "/obs/bench4") == LE_OK);
+
+    io_AddNumericPushHandler(OUTPUT_NAME, ResultUpdateHandler, NULL);
+
+    StartTime = le_clk_GetRelativeTime();
+
+    io_PushNumeric(INPUT_NAME, IO_NOW, 1);
+}